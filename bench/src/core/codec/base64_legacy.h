@@ -0,0 +1,17 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <string>
+#include <string_view>
+
+namespace legacy
+{
+
+// The scalar base64 functions that preceded the block kernels, kept as
+// the baseline for the base64 benchmarks.
+std::string base64_encode(std::string_view s, bool url = false);
+std::string base64_encode_mime(std::string_view s);
+std::string base64_decode(std::string_view s, bool remove_linebreaks = false);
+
+}; // legacy
@@ -0,0 +1,62 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include "core/codec/corpus/corpus.h"
+
+namespace bench
+{
+
+// Return the number of allocations made so far through `operator new`
+// and through `core::default_allocator()` (which the ZSTD and bzip2
+// engines use for their internal state).
+size_t allocations();
+
+// Track the bytes processed and the allocations made while running a
+// benchmark and report them as bytes/s and allocs/op.
+class Report {
+public:
+    Report(benchmark::State& state, size_t bytes_per_op)
+	: state_(state)
+	, bytes_(bytes_per_op)
+	, start_(allocations()) {
+    }
+
+    ~Report() {
+	auto ops = state_.iterations();
+	state_.SetBytesProcessed(ops * bytes_);
+	state_.counters["allocs/op"] = benchmark::Counter
+	    (double(allocations() - start_), benchmark::Counter::kAvgIterations);
+    }
+
+private:
+    benchmark::State& state_;
+    size_t bytes_, start_;
+};
+
+// Return `n` bytes of the log-like text corpus.
+inline std::string text(size_t n) {
+    return core::codec::corpus::log_text(n);
+}
+
+// Register `fn` once per corpus kind as `name/<kind>` passing the kind
+// as the second argument and return the registrations for further
+// configuration.
+template<class F>
+std::vector<benchmark::internal::Benchmark*> register_per_corpus(const std::string& name, F fn) {
+    std::vector<benchmark::internal::Benchmark*> marks;
+    for (auto kind : core::codec::corpus::Kinds) {
+	auto mark_name = name + "/" + std::string{core::codec::corpus::name(kind)};
+	marks.push_back(benchmark::RegisterBenchmark(mark_name.c_str(), fn, kind));
+    }
+    return marks;
+}
+
+// Return the path of a scratch file named `name` in the temporary
+// directory.
+std::string tmpfile(const std::string& name);
+
+}; // bench
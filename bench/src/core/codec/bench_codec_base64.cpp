@@ -0,0 +1,176 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include "bench_codec.h"
+#include "base64_legacy.h"
+#include "core/codec/base64.h"
+#include "core/codec/base64/codec.h"
+#include "core/codec/base64/kernels.h"
+
+static void BM_Base64Encode(benchmark::State& state) {
+    auto str = bench::text(state.range(0));
+    bench::Report report{state, str.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(base64_encode(str));
+}
+BENCHMARK(BM_Base64Encode)->ArgName("size")->Arg(64)->Arg(4096)->Arg(1 << 20);
+
+static void BM_Base64EncodeMime(benchmark::State& state) {
+    auto str = bench::text(state.range(0));
+    bench::Report report{state, str.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(base64_encode_mime(str));
+}
+BENCHMARK(BM_Base64EncodeMime)->ArgName("size")->Arg(4096)->Arg(1 << 20);
+
+static void BM_Base64Decode(benchmark::State& state) {
+    auto str = bench::text(state.range(0));
+    auto encoded = base64_encode(str);
+    bench::Report report{state, encoded.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(base64_decode(encoded));
+}
+BENCHMARK(BM_Base64Decode)->ArgName("size")->Arg(64)->Arg(4096)->Arg(1 << 20);
+
+static void BM_Base64DecodeMime(benchmark::State& state) {
+    auto str = bench::text(state.range(0));
+    auto encoded = base64_encode_mime(str);
+    bench::Report report{state, encoded.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(base64_decode(encoded, true));
+}
+BENCHMARK(BM_Base64DecodeMime)->ArgName("size")->Arg(4096)->Arg(1 << 20);
+
+static void BM_Base64EncodeLegacy(benchmark::State& state) {
+    auto str = bench::text(state.range(0));
+    bench::Report report{state, str.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(legacy::base64_encode(str));
+}
+BENCHMARK(BM_Base64EncodeLegacy)->ArgName("size")->Arg(64)->Arg(4096)->Arg(1 << 20);
+
+static void BM_Base64DecodeLegacy(benchmark::State& state) {
+    auto str = bench::text(state.range(0));
+    auto encoded = base64_encode(str);
+    bench::Report report{state, encoded.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(legacy::base64_decode(encoded));
+}
+BENCHMARK(BM_Base64DecodeLegacy)->ArgName("size")->Arg(64)->Arg(4096)->Arg(1 << 20);
+
+static void BM_Base64EncodeMimeLegacy(benchmark::State& state) {
+    auto str = bench::text(state.range(0));
+    bench::Report report{state, str.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(legacy::base64_encode_mime(str));
+}
+BENCHMARK(BM_Base64EncodeMimeLegacy)->ArgName("size")->Arg(4096)->Arg(1 << 20);
+
+static void BM_Base64DecodeMimeLegacy(benchmark::State& state) {
+    auto str = bench::text(state.range(0));
+    auto encoded = base64_encode_mime(str);
+    bench::Report report{state, encoded.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(legacy::base64_decode(encoded, true));
+}
+BENCHMARK(BM_Base64DecodeMimeLegacy)->ArgName("size")->Arg(4096)->Arg(1 << 20);
+
+static void BM_Base64DecodeInto(benchmark::State& state) {
+    auto encoded = base64_encode(bench::text(state.range(0)));
+    std::string out(base64::decoded_length(encoded), '\0');
+    bench::Report report{state, encoded.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(base64::decode_into(encoded, out));
+}
+BENCHMARK(BM_Base64DecodeInto)->ArgName("size")->Arg(64)->Arg(4096)->Arg(1 << 20);
+
+// Rejecting hostile input: an invalid character in the middle.
+static void BM_Base64DecodeInvalid(benchmark::State& state) {
+    auto encoded = base64_encode(bench::text(state.range(0)));
+    encoded[encoded.size() / 2] = '*';
+    bench::Report report{state, encoded.size()};
+    for (auto _ : state) {
+	try {
+	    benchmark::DoNotOptimize(base64_decode(encoded));
+	} catch (const std::runtime_error&) {
+	}
+    }
+}
+BENCHMARK(BM_Base64DecodeInvalid)->ArgName("size")->Arg(64)->Arg(4096);
+
+static void BM_Base64ValidateInvalid(benchmark::State& state) {
+    auto encoded = base64_encode(bench::text(state.range(0)));
+    encoded[encoded.size() / 2] = '*';
+    bench::Report report{state, encoded.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(base64::validate(encoded));
+}
+BENCHMARK(BM_Base64ValidateInvalid)->ArgName("size")->Arg(64)->Arg(4096);
+
+static void BM_Base64Validate(benchmark::State& state) {
+    auto encoded = base64_encode(bench::text(state.range(0)));
+    bench::Report report{state, encoded.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(base64::validate(encoded));
+}
+BENCHMARK(BM_Base64Validate)->ArgName("size")->Arg(64)->Arg(4096)->Arg(1 << 20);
+
+// Measure the parallel functions by thread count on 16 MiB.
+
+static void BM_Base64ParallelEncode(benchmark::State& state) {
+    auto str = bench::text(16 << 20);
+    std::string out(base64::encoded_length(str.size(), base64::Options::mime()), '\0');
+    base64::ParallelOptions parallel{size_t(state.range(0)), 0};
+    bench::Report report{state, str.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(base64::parallel_encode_into(str, out, base64::Options::mime(), parallel));
+}
+BENCHMARK(BM_Base64ParallelEncode)->ArgName("threads")->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+static void BM_Base64ParallelDecode(benchmark::State& state) {
+    auto encoded = base64_encode_mime(bench::text(16 << 20));
+    std::string out(base64::max_decoded_length(encoded.size()), '\0');
+    base64::ParallelOptions parallel{size_t(state.range(0)), 0};
+    bench::Report report{state, encoded.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(base64::parallel_decode_into(encoded, out, true, parallel));
+}
+BENCHMARK(BM_Base64ParallelDecode)->ArgName("threads")->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+// Measure the block kernels of each supported instruction set on
+// preallocated buffers.
+
+static void BM_Base64EncodeKernel(benchmark::State& state, base64::Isa isa) {
+    const auto& kernels = base64::kernels(isa);
+    auto str = bench::text(state.range(0) / 3 * 3);
+    std::string out(str.size() / 3 * 4, '\0');
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	kernels.encode(reinterpret_cast<const unsigned char*>(str.data()), str.size(), out.data(), false);
+	benchmark::DoNotOptimize(out.data());
+    }
+}
+
+static void BM_Base64DecodeKernel(benchmark::State& state, base64::Isa isa) {
+    const auto& kernels = base64::kernels(isa);
+    auto encoded = base64_encode(bench::text(state.range(0) / 3 * 3));
+    std::string out(encoded.size() / 4 * 3, '\0');
+    bench::Report report{state, encoded.size()};
+    for (auto _ : state) {
+	kernels.decode(encoded.data(), encoded.size(), reinterpret_cast<unsigned char*>(out.data()));
+	benchmark::DoNotOptimize(out.data());
+    }
+}
+
+static const auto registered = []() {
+    for (auto isa : base64::Isas) {
+	if (not base64::supported(isa))
+	    continue;
+	auto name = std::string{base64::name(isa)};
+	benchmark::RegisterBenchmark(("BM_Base64EncodeKernel/" + name).c_str(), BM_Base64EncodeKernel, isa)
+	    ->ArgName("size")->Arg(4096)->Arg(1 << 20);
+	benchmark::RegisterBenchmark(("BM_Base64DecodeKernel/" + name).c_str(), BM_Base64DecodeKernel, isa)
+	    ->ArgName("size")->Arg(4096)->Arg(1 << 20);
+    }
+    return true;
+}();
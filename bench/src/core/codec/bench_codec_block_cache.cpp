@@ -0,0 +1,113 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <fstream>
+#include "bench_codec.h"
+#include "core/codec/util/block_cache.h"
+#include "core/codec/zstd/compressor.h"
+#include "core/codec/zstd/decompressor.h"
+#include "core/codec/zstd/frame_file.h"
+#include "core/codec/zstd/line_index.h"
+
+static const size_t Count = 16 << 20;
+
+// Return the path of a file of the text corpus compressed as frames
+// of 256KiB.
+static const std::string& frame_file() {
+    static const std::string path = []() {
+	auto path = bench::tmpfile("block_cache");
+	auto str = bench::text(Count);
+	std::ofstream os{path, std::ios::binary};
+	zstd::Compressor c{os};
+	c.set_adaptive({.min_level = 3, .max_level = 3, .frame_size = size_t{1} << 18});
+	c.write(str.data(), str.size());
+	c.close();
+	return path;
+    }();
+    return path;
+}
+
+// Read 4KiB at random positions of the file with a cache of `budget`
+// bytes, reporting the hit rate.
+static void BM_FrameFileRandom(benchmark::State& state) {
+    core::codec::BlockCache cache{size_t(state.range(0))};
+    zstd::FrameFile file{frame_file(), cache};
+    cache.reset_stats();
+    std::string out(4096, '\0');
+    uint64_t i{0};
+    bench::Report report{state, out.size()};
+    for (auto _ : state) {
+	i = (i * 6364136223846793005ull + 1442695040888963407ull);
+	file.read((i >> 20) % (file.size() - out.size()), out.data(), out.size());
+	benchmark::DoNotOptimize(out.data());
+    }
+    state.counters["hit_rate"] = cache.stats().hit_rate();
+}
+BENCHMARK(BM_FrameFileRandom)->ArgName("budget")->Arg(0)->Arg(4 << 20)->Arg(64 << 20);
+
+// Scan the file with several readers sharing the cache, each file
+// being opened and indexed once.
+static void BM_FrameFileSharedScan(benchmark::State& state) {
+    core::codec::BlockCache cache{64 << 20};
+    zstd::FrameFile file{frame_file(), cache};
+    auto readers = size_t(state.range(0));
+    bench::Report report{state, readers * file.size()};
+    std::string out(1 << 16, '\0');
+    for (auto _ : state) {
+	for (size_t r = 0; r < readers; ++r) {
+	    zstd::FrameReader reader{file};
+	    while (reader.read_bytes(out.data(), out.size()) > 0)
+		benchmark::DoNotOptimize(out.data());
+	}
+    }
+    state.counters["hit_rate"] = cache.stats().hit_rate();
+}
+BENCHMARK(BM_FrameFileSharedScan)->ArgName("readers")->Arg(1)->Arg(4);
+
+// Read the line in the middle of the file by scanning the lines before
+// it and by seeking through the line index.
+
+static void BM_LineScan(benchmark::State& state) {
+    for (auto _ : state) {
+	std::ifstream is{frame_file(), std::ios::binary};
+	zstd::Decompressor d{is};
+	std::string line;
+	for (size_t n = 0; n < 100000 and d.read_line(line); ++n);
+	benchmark::DoNotOptimize(line.data());
+    }
+}
+BENCHMARK(BM_LineScan);
+
+static void BM_LineSeek(benchmark::State& state) {
+    core::codec::BlockCache cache{0};
+    zstd::FrameFile file{frame_file(), cache};
+    auto index = zstd::LineIndex::build(file);
+    zstd::LineReader reader{file, index};
+    std::string line;
+    for (auto _ : state) {
+	reader.seek_line(100000);
+	reader.read_line(line);
+	benchmark::DoNotOptimize(line.data());
+    }
+}
+BENCHMARK(BM_LineSeek);
+
+// Open the file and its line index, with and without taking the frame
+// sizes from the stored index, reporting the frames decompressed.
+static void BM_LineIndexOpen(benchmark::State& state) {
+    auto layout = state.range(0) != 0;
+    auto sidecar = zstd::LineIndex::sidecar(frame_file());
+    {
+	core::codec::BlockCache cache{0};
+	zstd::LineIndex::build(zstd::FrameFile{frame_file(), cache}).save(sidecar);
+    }
+    auto stored = zstd::LineIndex::stored(frame_file());
+    core::codec::BlockCache cache{0};
+    for (auto _ : state) {
+	zstd::FrameFile file{frame_file(), layout ? stored->layout() : std::vector<zstd::FrameInfo>{}, cache};
+	benchmark::DoNotOptimize(zstd::LineIndex::open(file).lines());
+    }
+    state.counters["misses/op"] = benchmark::Counter
+	(double(cache.stats().misses), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_LineIndexOpen)->ArgName("layout")->Arg(0)->Arg(1);
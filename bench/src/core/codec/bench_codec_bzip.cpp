@@ -0,0 +1,56 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <sstream>
+#include "bench_codec.h"
+#include "core/codec/bzip/compress.h"
+#include "core/codec/bzip/compressor.h"
+#include "core/codec/bzip/decompress.h"
+#include "core/codec/bzip/decompressor.h"
+
+static const size_t InputSize = 1 << 20;
+
+static void BM_BzipCompress(benchmark::State& state) {
+    auto str = bench::text(InputSize);
+    bench::Report report{state, str.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(bzip::compress(str));
+}
+BENCHMARK(BM_BzipCompress);
+
+static void BM_BzipDecompress(benchmark::State& state) {
+    auto str = bench::text(InputSize);
+    auto zstr = bzip::compress(str);
+    bench::Report report{state, str.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(bzip::decompress(zstr));
+}
+BENCHMARK(BM_BzipDecompress);
+
+static void BM_BzipCompressor(benchmark::State& state) {
+    auto str = bench::text(InputSize);
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	std::stringstream ss;
+	bzip::Compressor c{ss, size_t(state.range(0))};
+	c.write(str.data(), str.size());
+	c.close();
+	benchmark::DoNotOptimize(ss);
+    }
+}
+BENCHMARK(BM_BzipCompressor)->ArgName("n")->Arg(4096)->Arg(1 << 16)->Arg(1 << 20);
+
+static void BM_BzipDecompressor(benchmark::State& state) {
+    auto str = bench::text(InputSize);
+    auto zstr = bzip::compress(str);
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	std::stringstream ss{zstr};
+	bzip::Decompressor d{ss, size_t(state.range(0))};
+	size_t count{0};
+	while (d.underflow())
+	    count += d.view().size();
+	benchmark::DoNotOptimize(count);
+    }
+}
+BENCHMARK(BM_BzipDecompressor)->ArgName("n")->Arg(4096)->Arg(1 << 16)->Arg(1 << 20);
@@ -0,0 +1,61 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include "bench_codec.h"
+#include "core/codec/compressed_vector.h"
+
+static const size_t Count = 1 << 20;
+
+static core::codec::compressed_vector<int64_t> timestamps() {
+    return core::codec::compressed_vector<int64_t>{core::codec::corpus::timestamps(Count),
+	{4096, 4, 1, shuffle::Options::time_series()}};
+}
+
+static void BM_CompressedVectorBuild(benchmark::State& state) {
+    auto values = core::codec::corpus::timestamps(Count);
+    core::codec::CompressedVectorOptions options{4096, 4, 1, shuffle::Options::time_series(),
+						 size_t(state.range(0))};
+    bench::Report report{state, values.size() * sizeof(int64_t)};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(core::codec::compressed_vector<int64_t>{values, options});
+}
+BENCHMARK(BM_CompressedVectorBuild)->ArgName("threads")->Arg(1)->Arg(4)->UseRealTime();
+
+// Random access, mostly within the cached chunks.
+static void BM_CompressedVectorRandom(benchmark::State& state) {
+    auto vec = timestamps();
+    auto span = size_t(state.range(0));
+    size_t i{0};
+    int64_t sum{0};
+    for (auto _ : state) {
+	i = (i * 6364136223846793005ull + 1442695040888963407ull);
+	sum += vec[(i >> 20) % span];
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations());
+    state.counters["ratio"] = double(Count * sizeof(int64_t)) / vec.storage_size();
+}
+BENCHMARK(BM_CompressedVectorRandom)->ArgName("span")->Arg(16384)->Arg(Count);
+
+static void BM_CompressedVectorScan(benchmark::State& state) {
+    auto vec = timestamps();
+    bench::Report report{state, Count * sizeof(int64_t)};
+    for (auto _ : state) {
+	int64_t sum{0};
+	for (auto value : vec)
+	    sum += value;
+	benchmark::DoNotOptimize(sum);
+    }
+}
+BENCHMARK(BM_CompressedVectorScan);
+
+static void BM_CompressedVectorMaterialize(benchmark::State& state) {
+    auto vec = timestamps();
+    std::vector<int64_t> out(Count);
+    bench::Report report{state, Count * sizeof(int64_t)};
+    for (auto _ : state) {
+	vec.copy(0, vec.size(), out.data());
+	benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(BM_CompressedVectorMaterialize);
@@ -0,0 +1,53 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include "bench_codec.h"
+#include "core/codec/util/thread_pool.h"
+#include "core/codec/zstd/compress.h"
+#include "core/codec/zstd/compression_service.h"
+
+// Compress a batch of small messages through the service, whose
+// workers reuse their contexts, and as tasks of the shared pool each
+// creating a context per message.
+
+constexpr size_t Messages = 256;
+
+static void BM_ServiceMessages(benchmark::State& state) {
+    auto message = bench::text(state.range(0));
+    zstd::CompressionService service;
+    bench::Report report{state, Messages * message.size()};
+    for (auto _ : state) {
+	for (size_t i = 0; i < Messages; ++i)
+	    service.compress(message, [](std::string zstr, std::exception_ptr) {
+		benchmark::DoNotOptimize(zstr.data());
+	    });
+	service.drain();
+    }
+    state.counters["p99_us"] = service.stats().latency_p99_ns / 1e3;
+}
+BENCHMARK(BM_ServiceMessages)->ArgName("size")->Arg(256)->Arg(4096)->UseRealTime();
+
+static void BM_PoolMessages(benchmark::State& state) {
+    auto message = bench::text(state.range(0));
+    auto& pool = core::codec::ThreadPool::global();
+    bench::Report report{state, Messages * message.size()};
+    for (auto _ : state) {
+	std::vector<std::future<std::string>> futures;
+	for (size_t i = 0; i < Messages; ++i)
+	    futures.push_back(pool.async([&]() { return zstd::compress(message); }));
+	for (auto& future : futures)
+	    benchmark::DoNotOptimize(future.get().data());
+    }
+}
+BENCHMARK(BM_PoolMessages)->ArgName("size")->Arg(256)->Arg(4096)->UseRealTime();
+
+// Compress one large input split into parts of `split` bytes, or
+// whole if zero.
+static void BM_ServiceSplit(benchmark::State& state) {
+    auto text = bench::text(16 << 20);
+    zstd::CompressionService service{{.split_size = size_t(state.range(0))}};
+    bench::Report report{state, text.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(service.compress(text).get().data());
+}
+BENCHMARK(BM_ServiceSplit)->ArgName("split")->Arg(0)->Arg(1 << 20)->UseRealTime();
@@ -0,0 +1,98 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <sstream>
+#include "bench_codec.h"
+#include "core/codec/filter_comments.h"
+#include "core/codec/parallel_filter.h"
+
+static const size_t InputSize = 1 << 20;
+
+// Return text in which every `period`th line is a comment.
+static std::string commented_text(size_t n, size_t period) {
+    auto text = bench::text(n);
+    std::string str;
+    str.reserve(n + n / 16);
+    size_t line{0}, begin{0};
+    while (begin < text.size()) {
+	auto end = text.find('\n', begin);
+	end = end == std::string::npos ? text.size() : end + 1;
+	if (line++ % period == 0)
+	    str += "  // ";
+	str.append(text, begin, end - begin);
+	begin = end;
+    }
+    return str;
+}
+
+static void BM_FilterComments(benchmark::State& state) {
+    auto str = commented_text(InputSize, state.range(0));
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	std::stringstream ss{str};
+	auto fin = core::filter_comments(ss);
+	std::string line;
+	while (std::getline(fin, line))
+	    benchmark::DoNotOptimize(line);
+    }
+}
+BENCHMARK(BM_FilterComments)->ArgName("period")->Arg(2)->Arg(16);
+
+// Trailing and block comments with string literals.
+static void BM_FilterCommentsCpp(benchmark::State& state) {
+    auto text = commented_text(InputSize, 16);
+    std::string str;
+    for (size_t i = 0, begin = 0; begin < text.size(); ++i) {
+	auto end = std::min(text.find('\n', begin), text.size());
+	str.append(text, begin, end - begin);
+	str += i % 8 == 1 ? " /* \"block\"\n */ // trailing\n" : i % 8 == 5 ? " \"//\" // x\n" : "\n";
+	begin = end + 1;
+    }
+    bench::Report report{state, str.size()};
+    std::string buffer(1 << 16, '\0');
+    for (auto _ : state) {
+	std::stringstream ss{str};
+	auto fin = core::filter_comments(ss, core::CommentSyntax::cpp());
+	while (fin.read(buffer.data(), buffer.size()) or fin.gcount() > 0);
+    }
+}
+BENCHMARK(BM_FilterCommentsCpp);
+
+static void BM_FilterRead(benchmark::State& state) {
+    auto str = commented_text(InputSize, 16);
+    std::string buffer(1 << 16, '\0');
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	std::stringstream ss{str};
+	auto fin = core::filter_comments(ss);
+	while (fin.read(buffer.data(), buffer.size()) or fin.gcount() > 0);
+    }
+}
+BENCHMARK(BM_FilterRead);
+
+// Measure the stream buffer itself with a trivial filter.
+static void BM_FilterLines(benchmark::State& state) {
+    auto str = commented_text(InputSize, 16);
+    std::string buffer(1 << 16, '\0');
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	std::stringstream ss{str};
+	core::filter_istream fin(ss, [](std::string_view s) { return s.size() < 2 or s[2] != '/'; });
+	while (fin.read(buffer.data(), buffer.size()) or fin.gcount() > 0);
+    }
+}
+BENCHMARK(BM_FilterLines);
+
+// Measure the parallel filter by thread count on 16 MiB.
+static void BM_ParallelFilterComments(benchmark::State& state) {
+    auto str = commented_text(16 * InputSize, 16);
+    std::string buffer(1 << 16, '\0');
+    core::ParallelFilterOptions options{size_t(state.range(0)), size_t{1} << 20, 0};
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	std::stringstream ss{str};
+	core::parallel_filter_istream fin(ss, core::CommentFilter{}, options);
+	while (fin.read(buffer.data(), buffer.size()) or fin.gcount() > 0);
+    }
+}
+BENCHMARK(BM_ParallelFilterComments)->ArgName("threads")->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
@@ -0,0 +1,84 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <fstream>
+#include <regex>
+#include "bench_codec.h"
+#include "core/codec/grep.h"
+#include "core/codec/zstd/compressor.h"
+#include "core/codec/zstd/decompressor.h"
+
+static const size_t Count = 16 << 20;
+
+// Return the path of a file of the text corpus compressed as frames
+// of 256KiB.
+static const std::string& grep_file() {
+    static const std::string path = []() {
+	auto path = bench::tmpfile("grep");
+	auto str = bench::text(Count);
+	std::ofstream os{path, std::ios::binary};
+	zstd::Compressor c{os};
+	c.set_adaptive({.min_level = 3, .max_level = 3, .frame_size = size_t{1} << 18});
+	c.write(str.data(), str.size());
+	c.close();
+	return path;
+    }();
+    return path;
+}
+
+// Search the decompressed lines one at a time as the command line
+// pipeline of read_line and std::regex does.
+static void BM_GrepReadLine(benchmark::State& state) {
+    std::regex regex{"ERROR"};
+    bench::Report report{state, Count};
+    for (auto _ : state) {
+	std::ifstream is{grep_file(), std::ios::binary};
+	zstd::Decompressor d{is};
+	std::string line;
+	size_t n{0};
+	while (d.read_line(line))
+	    n += std::regex_search(line, regex);
+	benchmark::DoNotOptimize(n);
+    }
+}
+BENCHMARK(BM_GrepReadLine);
+
+// Search the file for a fixed string and for a regular expression with
+// a required literal, using the given number of threads.
+static void BM_GrepFile(benchmark::State& state, const char *pattern, bool fixed) {
+    grep::Matcher matcher{pattern, fixed};
+    grep::Options options;
+    options.threads = size_t(state.range(0));
+    bench::Report report{state, Count};
+    for (auto _ : state) {
+	size_t n{0};
+	grep::search_file(grep_file(), matcher, [&](const grep::Match& m) {
+	    n += m.text.size();
+	}, options);
+	benchmark::DoNotOptimize(n);
+    }
+}
+BENCHMARK_CAPTURE(BM_GrepFile, fixed, "ERROR", true)->ArgName("threads")->Arg(1)->Arg(4)->UseRealTime();
+BENCHMARK_CAPTURE(BM_GrepFile, regex, "user=[0-9]+ ERROR", false)->ArgName("threads")->Arg(1)->Arg(4)->UseRealTime();
+
+// Run the prefilter kernels over a block of text in memory.
+static void BM_GrepKernel(benchmark::State& state, grep::Isa isa, std::vector<std::string> literals) {
+    if (not grep::supported(isa)) {
+	state.SkipWithError("isa not supported");
+	return;
+    }
+    const auto& k = grep::kernels(isa);
+    grep::LiteralSet set{std::move(literals)};
+    auto str = bench::text(Count);
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	size_t n{0};
+	for (size_t i = 0; i < str.size(); ++i, ++n)
+	    i += k.find(str.data() + i, str.size() - i, set);
+	benchmark::DoNotOptimize(n);
+    }
+}
+BENCHMARK_CAPTURE(BM_GrepKernel, scalar_1, grep::Isa::Scalar, {"ERROR"});
+BENCHMARK_CAPTURE(BM_GrepKernel, avx2_1, grep::Isa::Avx2, {"ERROR"});
+BENCHMARK_CAPTURE(BM_GrepKernel, scalar_3, grep::Isa::Scalar, {"ERROR", "FATAL", "panic"});
+BENCHMARK_CAPTURE(BM_GrepKernel, avx2_3, grep::Isa::Avx2, {"ERROR", "FATAL", "panic"});
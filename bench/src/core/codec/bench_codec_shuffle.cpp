@@ -0,0 +1,120 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include "bench_codec.h"
+#include "core/codec/shuffle.h"
+#include "core/codec/shuffle/kernels.h"
+#include "core/codec/zstd/compress.h"
+#include "core/codec/zstd/decompress_to.h"
+
+static const size_t Count = 1 << 17;
+
+// The pre-filters measured, by index.
+static const shuffle::Options Filters[] = {
+    { shuffle::Shuffle::None, shuffle::Delta::None },
+    { shuffle::Shuffle::Byte, shuffle::Delta::None },
+    { shuffle::Shuffle::Bit, shuffle::Delta::None },
+    { shuffle::Shuffle::Byte, shuffle::Delta::Sub },
+    { shuffle::Shuffle::Bit, shuffle::Delta::Xor },
+};
+
+static void BM_ShuffleEncode(benchmark::State& state) {
+    auto values = core::codec::corpus::timestamps(Count);
+    std::string out(values.size() * sizeof(int64_t), '\0');
+    const auto& options = Filters[state.range(0)];
+    bench::Report report{state, out.size()};
+    for (auto _ : state) {
+	shuffle::encode((const char*)values.data(), out.size(), out.data(), sizeof(int64_t), options);
+	benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(BM_ShuffleEncode)->ArgName("filter")->DenseRange(1, 4);
+
+static void BM_ShuffleDecode(benchmark::State& state) {
+    auto values = core::codec::corpus::timestamps(Count);
+    std::string in(values.size() * sizeof(int64_t), '\0'), out(in.size(), '\0');
+    const auto& options = Filters[state.range(0)];
+    shuffle::encode((const char*)values.data(), in.size(), in.data(), sizeof(int64_t), options);
+    bench::Report report{state, out.size()};
+    for (auto _ : state) {
+	shuffle::decode(in.data(), in.size(), out.data(), sizeof(int64_t), options);
+	benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(BM_ShuffleDecode)->ArgName("filter")->DenseRange(1, 4);
+
+// Compress and decompress series through zstd with each pre-filter,
+// reporting the compression ratio.
+
+template<class T>
+static void zstd_compress(benchmark::State& state, const std::vector<T>& values) {
+    const auto& options = Filters[state.range(0)];
+    std::string compressed;
+    bench::Report report{state, values.size() * sizeof(T)};
+    for (auto _ : state) {
+	compressed = state.range(0) == 0 ? zstd::compress(values) : zstd::compress(values, options);
+	benchmark::DoNotOptimize(compressed.data());
+    }
+    state.counters["ratio"] = double(values.size() * sizeof(T)) / compressed.size();
+}
+
+template<class T>
+static void zstd_decompress(benchmark::State& state, const std::vector<T>& values) {
+    const auto& options = Filters[state.range(0)];
+    auto compressed = state.range(0) == 0 ? zstd::compress(values) : zstd::compress(values, options);
+    bench::Report report{state, values.size() * sizeof(T)};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(zstd::decompress_as<T>(compressed));
+}
+
+static void BM_ZstdTimestamps(benchmark::State& state) {
+    zstd_compress(state, core::codec::corpus::timestamps(Count));
+}
+BENCHMARK(BM_ZstdTimestamps)->ArgName("filter")->DenseRange(0, 4);
+
+static void BM_ZstdFloats(benchmark::State& state) {
+    zstd_compress(state, core::codec::corpus::floats(Count));
+}
+BENCHMARK(BM_ZstdFloats)->ArgName("filter")->DenseRange(0, 4);
+
+static void BM_ZstdTimestampsDecompress(benchmark::State& state) {
+    zstd_decompress(state, core::codec::corpus::timestamps(Count));
+}
+BENCHMARK(BM_ZstdTimestampsDecompress)->ArgName("filter")->DenseRange(0, 4);
+
+// Measure the kernels of each supported instruction set.
+
+static void BM_ShuffleKernel(benchmark::State& state, shuffle::Isa isa) {
+    const auto& kernels = shuffle::kernels(isa);
+    auto typesize = size_t(state.range(0));
+    auto in = core::codec::corpus::random_bytes(1 << 20);
+    std::string out(in.size(), '\0');
+    bench::Report report{state, in.size()};
+    for (auto _ : state) {
+	kernels.shuffle(in.data(), in.size() / typesize, out.data(), typesize);
+	benchmark::DoNotOptimize(out.data());
+    }
+}
+
+static void BM_BitTransposeKernel(benchmark::State& state, shuffle::Isa isa) {
+    const auto& kernels = shuffle::kernels(isa);
+    auto in = core::codec::corpus::random_bytes(1 << 20);
+    std::string out(in.size(), '\0');
+    bench::Report report{state, in.size()};
+    for (auto _ : state) {
+	kernels.bit_transpose(in.data(), in.size(), out.data());
+	benchmark::DoNotOptimize(out.data());
+    }
+}
+
+static const auto registered = []() {
+    for (auto isa : shuffle::Isas) {
+	if (not shuffle::supported(isa))
+	    continue;
+	auto name = std::string{shuffle::name(isa)};
+	benchmark::RegisterBenchmark(("BM_ShuffleKernel/" + name).c_str(), BM_ShuffleKernel, isa)
+	    ->ArgName("typesize")->Arg(4)->Arg(8);
+	benchmark::RegisterBenchmark(("BM_BitTransposeKernel/" + name).c_str(), BM_BitTransposeKernel, isa);
+    }
+    return true;
+}();
@@ -0,0 +1,166 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <iomanip>
+#include <sstream>
+#include "bench_codec.h"
+#include "core/codec/base16.h"
+#include "core/codec/base16/kernels.h"
+#include "core/codec/base32.h"
+#include "core/codec/base32/kernels.h"
+#include "core/codec/z85.h"
+#include "core/codec/z85/kernels.h"
+
+// Measure the whole buffer functions of the base16, base32 and Z85
+// codecs, and base16 against a typical ad hoc hex encoder.
+
+static void BM_Base16Encode(benchmark::State& state) {
+    auto str = bench::text(state.range(0));
+    bench::Report report{state, str.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(base16_encode(str));
+}
+BENCHMARK(BM_Base16Encode)->ArgName("size")->Arg(64)->Arg(4096)->Arg(1 << 20);
+
+static void BM_Base16EncodeAdHoc(benchmark::State& state) {
+    auto str = bench::text(state.range(0));
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	std::ostringstream ss;
+	ss << std::hex << std::setfill('0');
+	for (auto c : str)
+	    ss << std::setw(2) << int((unsigned char)c);
+	benchmark::DoNotOptimize(ss.str());
+    }
+}
+BENCHMARK(BM_Base16EncodeAdHoc)->ArgName("size")->Arg(64)->Arg(4096)->Arg(1 << 20);
+
+static void BM_Base16Decode(benchmark::State& state) {
+    auto encoded = base16_encode(bench::text(state.range(0)));
+    bench::Report report{state, encoded.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(base16_decode(encoded));
+}
+BENCHMARK(BM_Base16Decode)->ArgName("size")->Arg(64)->Arg(4096)->Arg(1 << 20);
+
+static void BM_Base32Encode(benchmark::State& state) {
+    auto str = bench::text(state.range(0));
+    bench::Report report{state, str.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(base32_encode(str));
+}
+BENCHMARK(BM_Base32Encode)->ArgName("size")->Arg(64)->Arg(4096)->Arg(1 << 20);
+
+static void BM_Base32Decode(benchmark::State& state) {
+    auto encoded = base32_encode(bench::text(state.range(0)));
+    bench::Report report{state, encoded.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(base32_decode(encoded));
+}
+BENCHMARK(BM_Base32Decode)->ArgName("size")->Arg(64)->Arg(4096)->Arg(1 << 20);
+
+static void BM_Z85Encode(benchmark::State& state) {
+    auto str = bench::text(state.range(0));
+    bench::Report report{state, str.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(z85_encode(str));
+}
+BENCHMARK(BM_Z85Encode)->ArgName("size")->Arg(64)->Arg(4096)->Arg(1 << 20);
+
+static void BM_Z85Decode(benchmark::State& state) {
+    auto encoded = z85_encode(bench::text(state.range(0)));
+    bench::Report report{state, encoded.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(z85_decode(encoded));
+}
+BENCHMARK(BM_Z85Decode)->ArgName("size")->Arg(64)->Arg(4096)->Arg(1 << 20);
+
+// Measure the block kernels of each supported instruction set on
+// preallocated buffers of 1 MiB.
+
+static constexpr size_t KernelSize = 1 << 20;
+
+static void BM_Base16EncodeKernel(benchmark::State& state, base16::Isa isa) {
+    const auto& kernels = base16::kernels(isa);
+    auto str = bench::text(KernelSize);
+    std::string out(2 * str.size(), '\0');
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	kernels.encode(reinterpret_cast<const unsigned char*>(str.data()), str.size(), out.data(), false);
+	benchmark::DoNotOptimize(out.data());
+    }
+}
+
+static void BM_Base16DecodeKernel(benchmark::State& state, base16::Isa isa) {
+    const auto& kernels = base16::kernels(isa);
+    auto encoded = base16_encode(bench::text(KernelSize));
+    std::string out(encoded.size() / 2, '\0');
+    bench::Report report{state, encoded.size()};
+    for (auto _ : state) {
+	kernels.decode(encoded.data(), encoded.size(), reinterpret_cast<unsigned char*>(out.data()));
+	benchmark::DoNotOptimize(out.data());
+    }
+}
+
+static void BM_Base32EncodeKernel(benchmark::State& state, base32::Isa isa) {
+    const auto& kernels = base32::kernels(isa);
+    auto str = bench::text(KernelSize / 5 * 5);
+    std::string out(str.size() / 5 * 8, '\0');
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	kernels.encode(reinterpret_cast<const unsigned char*>(str.data()), str.size(), out.data(), false);
+	benchmark::DoNotOptimize(out.data());
+    }
+}
+
+static void BM_Base32DecodeKernel(benchmark::State& state, base32::Isa isa) {
+    const auto& kernels = base32::kernels(isa);
+    auto encoded = base32_encode(bench::text(KernelSize / 5 * 5));
+    std::string out(encoded.size() / 8 * 5, '\0');
+    bench::Report report{state, encoded.size()};
+    for (auto _ : state) {
+	kernels.decode(encoded.data(), encoded.size(), reinterpret_cast<unsigned char*>(out.data()), false);
+	benchmark::DoNotOptimize(out.data());
+    }
+}
+
+static void BM_Z85EncodeKernel(benchmark::State& state, z85::Isa isa) {
+    const auto& kernels = z85::kernels(isa);
+    auto str = bench::text(KernelSize);
+    std::string out(str.size() / 4 * 5, '\0');
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	kernels.encode(reinterpret_cast<const unsigned char*>(str.data()), str.size(), out.data());
+	benchmark::DoNotOptimize(out.data());
+    }
+}
+
+static void BM_Z85DecodeKernel(benchmark::State& state, z85::Isa isa) {
+    const auto& kernels = z85::kernels(isa);
+    auto encoded = z85_encode(bench::text(KernelSize));
+    std::string out(encoded.size() / 5 * 4, '\0');
+    bench::Report report{state, encoded.size()};
+    for (auto _ : state) {
+	kernels.decode(encoded.data(), encoded.size(), reinterpret_cast<unsigned char*>(out.data()));
+	benchmark::DoNotOptimize(out.data());
+    }
+}
+
+static const auto registered = []() {
+    for (auto isa : base64::Isas) {
+	auto name = std::string{base64::name(isa)};
+	if (base16::supported(isa)) {
+	    benchmark::RegisterBenchmark(("BM_Base16EncodeKernel/" + name).c_str(), BM_Base16EncodeKernel, isa);
+	    benchmark::RegisterBenchmark(("BM_Base16DecodeKernel/" + name).c_str(), BM_Base16DecodeKernel, isa);
+	}
+	if (base32::supported(isa)) {
+	    benchmark::RegisterBenchmark(("BM_Base32EncodeKernel/" + name).c_str(), BM_Base32EncodeKernel, isa);
+	    benchmark::RegisterBenchmark(("BM_Base32DecodeKernel/" + name).c_str(), BM_Base32DecodeKernel, isa);
+	}
+	if (z85::supported(isa)) {
+	    benchmark::RegisterBenchmark(("BM_Z85EncodeKernel/" + name).c_str(), BM_Z85EncodeKernel, isa);
+	    benchmark::RegisterBenchmark(("BM_Z85DecodeKernel/" + name).c_str(), BM_Z85DecodeKernel, isa);
+	}
+    }
+    return true;
+}();
@@ -0,0 +1,46 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <thread>
+#include "bench_codec.h"
+#include "core/codec/grep.h"
+#include "core/codec/util/parallel.h"
+#include "core/codec/util/thread_pool.h"
+
+// Run a loop of `tasks` small tasks on the pool and on threads created
+// per call, as the parallel helpers did.
+
+static void BM_PoolParallelFor(benchmark::State& state) {
+    auto tasks = size_t(state.range(0));
+    std::vector<size_t> out(tasks);
+    for (auto _ : state) {
+	core::codec::parallel_for(tasks, tasks, [&](size_t i) { out[i] += i; });
+	benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(BM_PoolParallelFor)->ArgName("tasks")->Arg(2)->Arg(8)->UseRealTime();
+
+static void BM_SpawnParallelFor(benchmark::State& state) {
+    auto tasks = size_t(state.range(0));
+    std::vector<size_t> out(tasks);
+    for (auto _ : state) {
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < tasks; ++i)
+	    threads.emplace_back([&, i]() { out[i] += i; });
+	out[0] += 0;
+	for (auto& thread : threads)
+	    thread.join();
+	benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(BM_SpawnParallelFor)->ArgName("tasks")->Arg(2)->Arg(8)->UseRealTime();
+
+// Search a small text, which stays on the calling thread.
+static void BM_PoolSmallSearch(benchmark::State& state) {
+    auto text = bench::text(state.range(0));
+    grep::Matcher matcher{"ERROR", true};
+    bench::Report report{state, text.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(grep::search(text, matcher, [](const grep::Match&) { }));
+}
+BENCHMARK(BM_PoolSmallSearch)->ArgName("size")->Arg(4096)->Arg(1 << 16)->UseRealTime();
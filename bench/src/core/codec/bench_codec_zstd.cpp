@@ -0,0 +1,196 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <fstream>
+#include <sstream>
+#include "bench_codec.h"
+#include "core/codec/zstd/compress.h"
+#include "core/codec/zstd/compressor.h"
+#include "core/codec/zstd/decompress.h"
+#include "core/codec/zstd/decompressor.h"
+#include "core/cc/scoped_task.h"
+#include "core/cc/queue/lockfree_spsc.h"
+#include "core/cc/queue/sink_spsc.h"
+#include "core/codec/util/chunk_sink.h"
+
+namespace corpus = core::codec::corpus;
+
+static const size_t InputSize = 1 << 20;
+static const size_t WriteSize = 1 << 16;
+
+template<class C>
+void write_all(C& c, const std::string& str) {
+    for (size_t i = 0; i < str.size(); i += WriteSize)
+	c.write(str.data() + i, std::min(WriteSize, str.size() - i));
+}
+
+template<class D>
+size_t read_all(D& d) {
+    size_t count{0};
+    while (d.underflow())
+	count += d.view().size();
+    return count;
+}
+
+static void BM_ZstdCompress(benchmark::State& state, corpus::Kind kind) {
+    auto str = corpus::generate(kind, InputSize);
+    bench::Report report{state, str.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(zstd::compress(str, state.range(0)));
+}
+
+static void BM_ZstdDecompress(benchmark::State& state, corpus::Kind kind) {
+    auto str = corpus::generate(kind, InputSize);
+    auto zstr = zstd::compress(str, state.range(0));
+    bench::Report report{state, str.size()};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(zstd::decompress(zstr));
+}
+
+static const auto registered = []() {
+    for (auto mark : bench::register_per_corpus("BM_ZstdCompress", BM_ZstdCompress))
+	mark->ArgName("level")->Arg(-1)->Arg(1)->Arg(3)->Arg(9)->Arg(19);
+    for (auto mark : bench::register_per_corpus("BM_ZstdDecompress", BM_ZstdDecompress))
+	mark->ArgName("level")->Arg(-1)->Arg(1)->Arg(3)->Arg(9)->Arg(19);
+    return true;
+}();
+
+static void BM_ZstdCompressorStringStream(benchmark::State& state) {
+    auto str = bench::text(InputSize);
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	std::stringstream ss;
+	zstd::Compressor c{ss, size_t(state.range(1))};
+	c.set_level(state.range(0));
+	write_all(c, str);
+	c.close();
+	benchmark::DoNotOptimize(ss);
+    }
+}
+BENCHMARK(BM_ZstdCompressorStringStream)
+->ArgNames({"level", "n"})->ArgsProduct({{1, 3, 9}, {0, 4096, 1 << 16, 1 << 20}});
+
+static void BM_ZstdCompressorFile(benchmark::State& state) {
+    auto str = bench::text(InputSize);
+    auto file = bench::tmpfile("zstd");
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	zstd::Compressor c{std::ofstream{file}, size_t(state.range(1))};
+	c.set_level(state.range(0));
+	write_all(c, str);
+	c.close();
+    }
+    std::remove(file.c_str());
+}
+BENCHMARK(BM_ZstdCompressorFile)
+->ArgNames({"level", "n"})->ArgsProduct({{1, 3}, {0, 1 << 16}});
+
+static void BM_ZstdCompressorQueue(benchmark::State& state) {
+    auto str = bench::text(InputSize);
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	core::cc::queue::LockFreeSpSc<char> queue;
+	core::cc::scoped_task drain([&]() {
+	    char buffer[WriteSize];
+	    size_t count;
+	    while (queue.pop(buffer, buffer + sizeof(buffer), count));
+	});
+	zstd::Compressor c{queue, size_t(state.range(1))};
+	c.set_level(state.range(0));
+	write_all(c, str);
+	c.close();
+	drain.wait();
+    }
+}
+BENCHMARK(BM_ZstdCompressorQueue)
+->ArgNames({"level", "n"})->ArgsProduct({{1, 3}, {0, 4096, 1 << 16}})->UseRealTime();
+
+static void BM_ZstdDecompressorStringStream(benchmark::State& state) {
+    auto str = bench::text(InputSize);
+    auto zstr = zstd::compress(str, state.range(0));
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	std::stringstream ss{zstr};
+	zstd::Decompressor d{ss, size_t(state.range(1))};
+	benchmark::DoNotOptimize(read_all(d));
+    }
+}
+BENCHMARK(BM_ZstdDecompressorStringStream)
+->ArgNames({"level", "n"})->ArgsProduct({{1, 9}, {0, 4096, 1 << 16, 1 << 20}});
+
+static void BM_ZstdDecompressorFile(benchmark::State& state) {
+    auto str = bench::text(InputSize);
+    auto file = bench::tmpfile("zstd");
+    std::ofstream{file} << zstd::compress(str, state.range(0));
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	zstd::Decompressor d{std::ifstream{file}, size_t(state.range(1))};
+	benchmark::DoNotOptimize(read_all(d));
+    }
+    std::remove(file.c_str());
+}
+BENCHMARK(BM_ZstdDecompressorFile)
+->ArgNames({"level", "n"})->ArgsProduct({{1}, {0, 1 << 16}});
+
+static void BM_ZstdDecompressorQueue(benchmark::State& state) {
+    auto str = bench::text(InputSize);
+    auto zstr = zstd::compress(str, state.range(0));
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	core::cc::queue::LockFreeSpSc<char> queue;
+	core::cc::scoped_task fill([&]() {
+	    for (size_t i = 0; i < zstr.size(); i += WriteSize) {
+		auto n = std::min(WriteSize, zstr.size() - i);
+		queue.push(zstr.data() + i, zstr.data() + i + n);
+	    }
+	    queue.push_sentinel();
+	});
+	zstd::Decompressor d{queue, size_t(state.range(1))};
+	benchmark::DoNotOptimize(read_all(d));
+	fill.wait();
+    }
+}
+BENCHMARK(BM_ZstdDecompressorQueue)
+->ArgNames({"level", "n"})->ArgsProduct({{1}, {0, 4096, 1 << 16}})->UseRealTime();
+
+// Decompress a stream of unknown content size (as written by a
+// `Compressor`) into one growing string and into a chunk sink, with
+// and without coalescing the chunks.
+
+static std::string unknown_size(size_t n) {
+    std::stringstream ss;
+    zstd::Compressor c{ss};
+    write_all(c, bench::text(n));
+    c.close();
+    return ss.str();
+}
+
+static void BM_ZstdDecompressSinkSpSc(benchmark::State& state) {
+    auto zstr = unknown_size(state.range(0));
+    bench::Report report{state, size_t(state.range(0))};
+    for (auto _ : state) {
+	std::stringstream ss{zstr};
+	core::cc::queue::SinkSpSc<char> sink;
+	zstd::decompress((std::istream&)ss, sink);
+	benchmark::DoNotOptimize(sink.data().data());
+    }
+}
+BENCHMARK(BM_ZstdDecompressSinkSpSc)->ArgName("size")->Arg(InputSize)->Arg(64 << 20);
+
+static void BM_ZstdDecompressChunks(benchmark::State& state) {
+    auto zstr = unknown_size(state.range(0));
+    bench::Report report{state, size_t(state.range(0))};
+    for (auto _ : state) {
+	auto sink = zstd::decompress_chunks(zstr);
+	benchmark::DoNotOptimize(sink.blocks());
+    }
+}
+BENCHMARK(BM_ZstdDecompressChunks)->ArgName("size")->Arg(InputSize)->Arg(64 << 20);
+
+static void BM_ZstdDecompressCoalesce(benchmark::State& state) {
+    auto zstr = unknown_size(state.range(0));
+    bench::Report report{state, size_t(state.range(0))};
+    for (auto _ : state)
+	benchmark::DoNotOptimize(zstd::decompress(zstr));
+}
+BENCHMARK(BM_ZstdDecompressCoalesce)->ArgName("size")->Arg(InputSize)->Arg(64 << 20);
@@ -0,0 +1,52 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <sstream>
+#include "bench_codec.h"
+#include "core/codec/zstd/async.h"
+#include "core/codec/zstd/compress.h"
+
+static const size_t InputSize = 1 << 20;
+
+// Compare with BM_ZstdDecompressorStringStream and
+// BM_ZstdCompressorStringStream for the overhead of the coroutines
+// when the source or sink completes immediately.
+
+static core::codec::Task<size_t> read_all(zstd::AsyncDecompressor<std::stringstream&>& d) {
+    size_t count{0};
+    while (co_await d.async_underflow())
+	count += d.view().size();
+    co_return count;
+}
+
+static void BM_ZstdAsyncDecompressor(benchmark::State& state) {
+    auto str = bench::text(InputSize);
+    auto zstr = zstd::compress(str, 1);
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	std::stringstream ss{zstr};
+	zstd::AsyncDecompressor d{ss, size_t(state.range(0))};
+	benchmark::DoNotOptimize(core::codec::sync_wait(read_all(d)));
+    }
+}
+BENCHMARK(BM_ZstdAsyncDecompressor)->ArgName("n")->Arg(0)->Arg(4096);
+
+static core::codec::Task<> write_all(zstd::AsyncCompressor<std::stringstream&>& c,
+				     const std::string& str, size_t n) {
+    for (size_t i = 0; i < str.size(); i += n)
+	co_await c.async_write(str.data() + i, std::min(n, str.size() - i));
+    co_await c.async_close();
+}
+
+static void BM_ZstdAsyncCompressor(benchmark::State& state) {
+    auto str = bench::text(InputSize);
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	std::stringstream ss;
+	zstd::AsyncCompressor c{ss};
+	c.compressor().set_level(1);
+	core::codec::sync_wait(write_all(c, str, state.range(0)));
+	benchmark::DoNotOptimize(ss);
+    }
+}
+BENCHMARK(BM_ZstdAsyncCompressor)->ArgName("write")->Arg(4096)->Arg(1 << 16);
@@ -0,0 +1,69 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <sstream>
+#include "bench_codec.h"
+#include "core/codec/zstd/compress.h"
+#include "core/codec/zstd/zstd_stream.h"
+
+static const size_t InputSize = 1 << 20;
+
+// Compare with BM_ZstdCompressorStringStream for the overhead of the
+// streambuf layer.
+static void BM_ZstdOstream(benchmark::State& state) {
+    auto str = bench::text(InputSize);
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	std::stringstream ss;
+	{
+	    core::zstd_ostream zout(ss, state.range(0));
+	    zout.write(str.data(), str.size());
+	}
+	benchmark::DoNotOptimize(ss);
+    }
+}
+BENCHMARK(BM_ZstdOstream)->ArgName("n")->Arg(0)->Arg(4096)->Arg(1 << 16);
+
+static void BM_ZstdOstreamPut(benchmark::State& state) {
+    auto str = bench::text(InputSize);
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	std::stringstream ss;
+	{
+	    core::zstd_ostream zout(ss, state.range(0));
+	    for (auto c : str)
+		zout.put(c);
+	}
+	benchmark::DoNotOptimize(ss);
+    }
+}
+BENCHMARK(BM_ZstdOstreamPut)->ArgName("n")->Arg(0)->Arg(1 << 16);
+
+// Compare with BM_ZstdDecompressorStringStream for the overhead of the
+// streambuf layer.
+static void BM_ZstdIstream(benchmark::State& state) {
+    auto str = bench::text(InputSize);
+    auto zstr = zstd::compress(str);
+    std::string buffer(1 << 16, '\0');
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	std::stringstream ss{zstr};
+	core::zstd_istream zin(ss, state.range(0));
+	while (zin.read(buffer.data(), buffer.size()) or zin.gcount() > 0);
+    }
+}
+BENCHMARK(BM_ZstdIstream)->ArgName("n")->Arg(0)->Arg(4096)->Arg(1 << 16);
+
+static void BM_ZstdIstreamGetline(benchmark::State& state) {
+    auto str = bench::text(InputSize);
+    auto zstr = zstd::compress(str);
+    bench::Report report{state, str.size()};
+    for (auto _ : state) {
+	std::stringstream ss{zstr};
+	core::zstd_istream zin(ss, state.range(0));
+	std::string line;
+	while (std::getline(zin, line))
+	    benchmark::DoNotOptimize(line);
+    }
+}
+BENCHMARK(BM_ZstdIstreamGetline)->ArgName("n")->Arg(0)->Arg(1 << 16);
@@ -0,0 +1,72 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <unistd.h>
+#include "bench_codec.h"
+#include "core/codec/util/allocator.h"
+
+namespace {
+
+std::atomic<size_t> number_allocations{0};
+
+// Count the allocations made by the codec engines.
+class CountingAllocator : public core::Allocator {
+public:
+    void *allocate(size_t n) override {
+	number_allocations.fetch_add(1, std::memory_order_relaxed);
+	return core::malloc_allocator().allocate(n);
+    }
+
+    void deallocate(void *ptr) override {
+	core::malloc_allocator().deallocate(ptr);
+    }
+};
+
+}; // anonymous
+
+void *operator new(size_t n) {
+    number_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto ptr = std::malloc(n > 0 ? n : 1))
+	return ptr;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace bench
+{
+
+size_t allocations() {
+    return number_allocations.load(std::memory_order_relaxed);
+}
+
+std::string tmpfile(const std::string& name) {
+    auto path = std::filesystem::temp_directory_path();
+    path /= "codec_bench." + std::to_string(getpid()) + "." + name;
+    return path.string();
+}
+
+}; // bench
+
+int main(int argc, char *argv[])
+{
+    static CountingAllocator alloc;
+    core::set_default_allocator(alloc);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+	return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,149 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <string>
+#include <type_traits>
+#include <variant>
+#include "core/codec/format.h"
+#include "core/codec/util/peek_source.h"
+#include "core/codec/raw/decompressor.h"
+#include "core/codec/bzip/decompressor.h"
+#include "core/codec/zstd/decompressor.h"
+
+namespace core::codec
+{
+
+// Read bytes from a `Source` holding ZSTD, bzip2, base64 wrapped ZSTD
+// or bzip2, or uncompressed data, detecting the format from the
+// leading bytes without consuming them.
+//
+// The `Source` requirements are the same as for `zstd::Decompressor`.
+// The interface is the one shared by the decompressors:
+//
+// AnyDecompressor d{cin};
+// std::string line;
+// while (d.read_line(line))
+//    ...
+//
+// Each call dispatches on the detected format with a single switch.
+// For tight loops, `visit` hands the concrete decompressor to a
+// callable so that the loop runs without any dispatch:
+//
+// d.visit([&](auto& engine) {
+//     while (engine.underflow())
+//         process(engine.view());
+// });
+//
+template<class Source>
+class AnyDecompressor {
+public:
+    // Construct a decompressor that reads from stream `is` using a
+    // buffer of size `n` (defaults to the engine default).
+    explicit AnyDecompressor(std::add_rvalue_reference_t<Source> is, size_t n = 0)
+	: is_(std::forward<Source>(is))
+	, source_(is_) {
+	auto prefix = source_.peek(PeekSize);
+	format_ = detect_format(prefix);
+	if (format_ == Format::Raw and detect_base64(prefix)) {
+	    source_.decode_base64();
+	    format_ = detect_format(source_.peek(PeekSize));
+	}
+
+	switch (format_) {
+	case Format::Zstd:
+	    engine_.template emplace<ZstdEngine>(source_, n);
+	    break;
+	case Format::Bzip:
+	    engine_.template emplace<BzipEngine>(source_, n > 0 ? n : 65536);
+	    break;
+	default:
+	    engine_.template emplace<RawEngine>(source_, n);
+	    break;
+	}
+    }
+
+    AnyDecompressor(const AnyDecompressor&) = delete;
+    AnyDecompressor& operator=(const AnyDecompressor&) = delete;
+
+    // Return the detected format.
+    Format format() const { return format_; }
+
+    // Return true if the data was base64 wrapped.
+    bool base64() const { return source_.base64(); }
+
+    // Return a reference to the underlying stream.
+    Source& stream() { return is_; }
+
+    // Attempt to read the next decompressed line. Return `true` if a
+    // (possibly empty) line was read and place the characters in
+    // `line`. If there are no more characters to be read, return
+    // `false` and set `line` to nil.
+    bool read_line(std::string& line) {
+	return visit([&](auto& d) { return d.read_line(line); });
+    }
+
+    // Attempt to read up to `count` decompressed bytes placing them
+    // into buffer. Return the number of bytes read.
+    size_t read_bytes(char *buffer, size_t count) {
+	return visit([&](auto& d) { return d.read_bytes(buffer, count); });
+    }
+
+    // Attempt to read decompressed bytes representing the pod type T
+    // into `value`. Return `true` if the value is successfully read;
+    // otherwise, return `false`.
+    template<class T>
+    bool read_pod(T& value) { return read_bytes((char*)&value, sizeof(T)) == sizeof(T); }
+
+    // Attempt to read the next chunk of decompressed characters into
+    // the get area (discarding any existing characters). Return
+    // `true` if characters are successfully read, `false` otherwise.
+    bool underflow() {
+	return visit([&](auto& d) { return d.underflow(); });
+    }
+
+    // Return a view of the current get area, i.e. the characters that
+    // are ready to be read.
+    std::string_view view() const {
+	return visit([](const auto& d) { return d.view(); });
+    }
+
+    // Invoke `f` with a reference to the decompressor for the
+    // detected format and return the result.
+    template<class F>
+    decltype(auto) visit(F&& f) {
+	switch (format_) {
+	case Format::Zstd: return f(*std::get_if<ZstdEngine>(&engine_));
+	case Format::Bzip: return f(*std::get_if<BzipEngine>(&engine_));
+	default: return f(*std::get_if<RawEngine>(&engine_));
+	}
+    }
+
+    // Invoke `f` with a const reference to the decompressor for the
+    // detected format and return the result.
+    template<class F>
+    decltype(auto) visit(F&& f) const {
+	switch (format_) {
+	case Format::Zstd: return f(*std::get_if<ZstdEngine>(&engine_));
+	case Format::Bzip: return f(*std::get_if<BzipEngine>(&engine_));
+	default: return f(*std::get_if<RawEngine>(&engine_));
+	}
+    }
+
+private:
+    static constexpr size_t PeekSize = 64;
+
+    using RawEngine = raw::Decompressor<core::PeekSource&>;
+    using ZstdEngine = zstd::Decompressor<core::PeekSource&>;
+    using BzipEngine = bzip::Decompressor<core::PeekSource>;
+
+    Source is_;
+    core::PeekSource source_;
+    Format format_;
+    std::variant<std::monostate, RawEngine, ZstdEngine, BzipEngine> engine_;
+};
+
+template<class S> explicit AnyDecompressor(S&&) -> AnyDecompressor<S>;
+template<class S> explicit AnyDecompressor(S&&, size_t) -> AnyDecompressor<S>;
+
+}; // core::codec
@@ -0,0 +1,59 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <istream>
+#include "core/codec/any_decompressor.h"
+
+namespace core {
+
+template<class CharT = char, class TraitsT = std::char_traits<CharT>>
+class any_istreambuf : public std::streambuf {
+public:
+    any_istreambuf(std::istream& sin, size_t n = 0)
+	: d_(sin, n)
+    { }
+
+    virtual ~any_istreambuf() {
+    }
+
+    virtual int underflow() override {
+	if (d_.underflow())  {
+	    auto begin = (char*)d_.view().data();
+	    auto end = begin + d_.view().size();
+	    setg(begin, begin, end);
+	    return std::char_traits<CharT>::to_int_type(*this->gptr());
+	}
+	return std::char_traits<CharT>::eof();
+    }
+
+    // Return the detected format.
+    codec::Format format() const { return d_.format(); }
+
+private:
+    codec::AnyDecompressor<std::istream&> d_;
+};
+
+// Read ZSTD, bzip2, base64 wrapped or plain data from an input stream
+// as decompressed characters.
+//
+template<class CharT = char, class TraitT = std::char_traits<CharT>>
+class any_istream : public std::basic_istream<CharT, TraitT> {
+public:
+    any_istream(std::istream& sin, size_t n = 0)
+	: std::basic_istream<CharT, TraitT>::basic_istream(new any_istreambuf<CharT, TraitT>(sin, n))
+    { }
+
+    ~any_istream() {
+	delete this->rdbuf();
+    }
+
+    // Return the detected format.
+    codec::Format format() const {
+	return static_cast<any_istreambuf<CharT, TraitT>*>(this->rdbuf())->format();
+    }
+
+private:
+};
+
+}; // ns core
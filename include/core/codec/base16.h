@@ -0,0 +1,14 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <string>
+#include <string_view>
+
+// Return `s` encoded as base16 (hex), two digits per byte in lower or
+// upper case.
+std::string base16_encode(std::string_view s, bool upper = false);
+
+// Return the bytes decoded from the hex digits `s`, in either case.
+// Throw std::runtime_error if `s` is not valid base16.
+std::string base16_decode(std::string_view s);
@@ -0,0 +1,72 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include "core/codec/base64/codec.h"
+
+namespace base16
+{
+
+// Encode and decode base16 (hex) into caller provided buffers without
+// allocating or throwing. The string functions of `base16.h` are thin
+// wrappers over these.
+//
+// std::string out(base16::encoded_length(in.size()), '\0');
+// base16::encode_into(in, out);
+//
+
+// The same outcome as for base64.
+using base64::Status;
+using base64::Result;
+using base64::name;
+
+// The encoding options.
+struct Options {
+    // Use the upper case digits 'A' through 'F'.
+    bool upper{false};
+};
+
+// Return the number of characters encoding `n` bytes.
+constexpr size_t encoded_length(size_t n) { return 2 * n; }
+
+// Return the number of bytes decoded from `in`.
+constexpr size_t decoded_length(std::string_view in) { return in.size() / 2; }
+
+// Return an upper bound on the number of bytes decoded from `n`
+// characters.
+constexpr size_t max_decoded_length(size_t n) { return n / 2; }
+
+// Encode `in` into `out` which must hold at least
+// `encoded_length(in.size())` characters. Return the number of
+// characters written.
+Result encode_into(std::string_view in, std::span<char> out, const Options& options = {});
+
+// Decode `in`, an even number of hex digits in either case, into
+// `out` which must hold at least `decoded_length(in)` bytes. Return
+// the number of bytes written.
+Result decode_into(std::string_view in, std::span<char> out);
+
+// Return the result `decode_into` would return given a large enough
+// buffer without writing the decoded bytes anywhere.
+Result validate(std::string_view in);
+
+// The traits of base16 for the streaming `Encoder` and `Decoder` (see
+// core::codec::TextEncoder).
+struct Codec {
+    using Options = base16::Options;
+    static constexpr const char *Name = "base16";
+    static constexpr size_t Bytes = 1, Chars = 2;
+
+    static Result encode(std::string_view in, std::span<char> out, const Options& options) {
+	return encode_into(in, out, options);
+    }
+
+    static Result decode(std::string_view in, std::span<char> out, const Options&) {
+	return decode_into(in, out);
+    }
+};
+
+}; // base16
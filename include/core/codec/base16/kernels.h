@@ -0,0 +1,48 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <cstddef>
+#include "core/codec/base64/kernels.h"
+
+namespace base16
+{
+
+// The block kernels that do the bulk of the work of `base16_encode`
+// and `base16_decode`, selected at runtime as for base64 (see
+// base64/kernels.h).
+//
+
+using base64::Isa;
+using base64::Isas;
+using base64::name;
+
+// Return true if the kernels for `isa` were compiled in and can run
+// on this cpu.
+bool supported(Isa isa);
+
+// Return the most capable supported instruction set.
+Isa best_isa();
+
+struct Kernels {
+    Isa isa;
+
+    // Encode the `n` bytes at `in` as the `2n` hex digits at `out` in
+    // lower or upper case.
+    void (*encode)(const unsigned char *in, size_t n, char *out, bool upper);
+
+    // Decode the `n` hex digits at `in`, an even number, as the `n/2`
+    // bytes at `out` accepting either case. Return the number of
+    // digits decoded which is less than `n` if the pair at that
+    // offset contains any other character.
+    size_t (*decode)(const char *in, size_t n, unsigned char *out);
+};
+
+// Return the kernels for `isa` or throw std::runtime_error if it is
+// not supported.
+const Kernels& kernels(Isa isa);
+
+// Return the kernels for `best_isa()`.
+const Kernels& kernels();
+
+}; // base16
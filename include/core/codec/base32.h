@@ -0,0 +1,15 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <string>
+#include <string_view>
+
+// Return `s` encoded as base32 (RFC 4648) using the standard or
+// extended hex alphabet and padded with '='.
+std::string base32_encode(std::string_view s, bool hex = false);
+
+// Return the bytes decoded from the base32 `s` in the standard or
+// extended hex alphabet, in either case, padded or not. Throw
+// std::runtime_error if `s` is not valid base32.
+std::string base32_decode(std::string_view s, bool hex = false);
@@ -0,0 +1,76 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include "core/codec/base64/codec.h"
+
+namespace base32
+{
+
+// Encode and decode base32 (RFC 4648) into caller provided buffers
+// without allocating or throwing. The string functions of `base32.h`
+// are thin wrappers over these.
+//
+// std::string out(base32::encoded_length(in.size()), '\0');
+// base32::encode_into(in, out);
+//
+
+// The same outcome as for base64.
+using base64::Status;
+using base64::Result;
+using base64::name;
+
+// The encoding options.
+struct Options {
+    // Use the extended hex alphabet ("0123456789ABCDEFGHIJKLMNOPQRSTUV").
+    bool hex{false};
+
+    // Pad the final quantum to eight characters with '='.
+    bool pad{true};
+};
+
+// Return the number of characters encoding `n` bytes with `options`.
+size_t encoded_length(size_t n, const Options& options = {});
+
+// Return the number of bytes decoded from `in`, padded or not.
+size_t decoded_length(std::string_view in);
+
+// Return an upper bound on the number of bytes decoded from `n`
+// characters.
+constexpr size_t max_decoded_length(size_t n) { return (n + 7) / 8 * 5; }
+
+// Encode `in` into `out` which must hold at least
+// `encoded_length(in.size(), options)` characters. Return the number
+// of characters written.
+Result encode_into(std::string_view in, std::span<char> out, const Options& options = {});
+
+// Decode `in` in the alphabet of `options`, in either case, into `out`
+// which must hold at least `decoded_length(in)` bytes. The final
+// quantum may be padded or short, but not both. Return the number of
+// bytes written.
+Result decode_into(std::string_view in, std::span<char> out, const Options& options = {});
+
+// Return the result `decode_into` would return given a large enough
+// buffer without writing the decoded bytes anywhere.
+Result validate(std::string_view in, const Options& options = {});
+
+// The traits of base32 for the streaming `Encoder` and `Decoder` (see
+// core::codec::TextEncoder).
+struct Codec {
+    using Options = base32::Options;
+    static constexpr const char *Name = "base32";
+    static constexpr size_t Bytes = 5, Chars = 8;
+
+    static Result encode(std::string_view in, std::span<char> out, const Options& options) {
+	return encode_into(in, out, options);
+    }
+
+    static Result decode(std::string_view in, std::span<char> out, const Options& options) {
+	return decode_into(in, out, options);
+    }
+};
+
+}; // base32
@@ -0,0 +1,58 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <cstddef>
+#include "core/codec/base64/kernels.h"
+
+namespace base32
+{
+
+// The block kernels that do the bulk of the work of `base32_encode`
+// and `base32_decode`, selected at runtime as for base64 (see
+// base64/kernels.h).
+//
+
+using base64::Isa;
+using base64::Isas;
+using base64::name;
+
+// Return true if the kernels for `isa` were compiled in and can run
+// on this cpu.
+bool supported(Isa isa);
+
+// Return the most capable supported instruction set.
+Isa best_isa();
+
+struct Kernels {
+    Isa isa;
+
+    // Encode the `n` bytes at `in`, a multiple of five, as the `8n/5`
+    // characters at `out` using the standard or extended hex alphabet
+    // (no padding is involved).
+    void (*encode)(const unsigned char *in, size_t n, char *out, bool hex);
+
+    // Decode the `n` characters at `in`, a multiple of eight, as the
+    // `5n/8` bytes at `out` accepting the standard or extended hex
+    // alphabet in either case. Return the number of characters
+    // decoded which is less than `n` if the quantum at that offset
+    // contains any other character, including padding.
+    size_t (*decode)(const char *in, size_t n, unsigned char *out, bool hex);
+};
+
+// Return the kernels for `isa` or throw std::runtime_error if it is
+// not supported.
+const Kernels& kernels(Isa isa);
+
+// Return the kernels for `best_isa()`.
+const Kernels& kernels();
+
+// Return the 32 characters of the standard or extended hex alphabet.
+const char *alphabet(bool hex);
+
+// Return the 5-bit value of character `c` in the standard or extended
+// hex alphabet, in either case, or `Invalid`.
+inline constexpr unsigned char Invalid = 0xff;
+unsigned char value(char c, bool hex);
+
+}; // base32
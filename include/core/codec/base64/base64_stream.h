@@ -0,0 +1,92 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <istream>
+#include <ostream>
+#include "core/codec/base64/decoder.h"
+#include "core/codec/base64/encoder.h"
+#include "core/codec/util/buffer.h"
+
+namespace core {
+
+template<class CharT = char, class TraitsT = std::char_traits<CharT>>
+class base64_istreambuf : public std::streambuf {
+public:
+    base64_istreambuf(std::istream& sin, size_t n = 0)
+	: d_(sin, n)
+    { }
+
+    virtual ~base64_istreambuf() {
+    }
+
+    virtual int underflow() override {
+	if (d_.underflow())  {
+	    auto begin = (char*)d_.view().data();
+	    auto end = begin + d_.view().size();
+	    setg(begin, begin, end);
+	    return std::char_traits<CharT>::to_int_type(*this->gptr());
+	}
+	return std::char_traits<CharT>::eof();
+    }
+
+private:
+    base64::Decoder<std::istream&> d_;
+};
+
+template<class CharT = char, class TraitT = std::char_traits<CharT>>
+class base64_istream : public std::basic_istream<CharT, TraitT> {
+public:
+    base64_istream(std::istream& sin, size_t n = 0)
+	: std::basic_istream<CharT, TraitT>::basic_istream(new base64_istreambuf(sin, n))
+    { }
+
+    ~base64_istream() {
+	delete this->rdbuf();
+    }
+};
+
+template<class CharT = char, class TraitsT = std::char_traits<CharT>>
+class base64_ostreambuf : public std::streambuf {
+public:
+    base64_ostreambuf(std::ostream& sout, const base64::Options& options = {}, size_t n = 0)
+	: e_(sout, options, n)
+	, area_(n > 0 ? n : 65536)
+    {
+	clear();
+    }
+
+    virtual ~base64_ostreambuf() {
+	e_.write(pbase(), pptr());
+	e_.close();
+    }
+
+    virtual base64_ostreambuf::int_type overflow(base64_ostreambuf::int_type value) override {
+	*pptr() = traits_type::to_char_type(value);
+	e_.write(pbase(), pptr() + 1);
+	clear();
+	return traits_type::not_eof(value);
+    }
+
+private:
+    void clear() {
+	setp(area_.begin(), area_.end() - 1);
+    }
+
+    base64::Encoder<std::ostream&> e_;
+    core::BufferedArea area_;
+};
+
+template<class CharT = char, class TraitT = std::char_traits<CharT>>
+class base64_ostream : public std::basic_ostream<CharT, TraitT> {
+public:
+    base64_ostream(std::ostream& sout, const base64::Options& options = {}, size_t n = 0)
+	: std::basic_ostream<CharT, TraitT>::basic_ostream(new base64_ostreambuf(sout, options, n))
+    { }
+
+    ~base64_ostream() {
+	delete this->rdbuf();
+    }
+};
+
+}; // ns core
@@ -0,0 +1,137 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+namespace base64
+{
+
+// Encode and decode base64 into caller provided buffers without
+// allocating or throwing. The string functions of `base64.h` are thin
+// wrappers over these.
+//
+// std::string out(base64::encoded_length(in.size()), '\0');
+// base64::encode_into(in, out);
+//
+// std::string bytes(base64::decoded_length(out), '\0');
+// if (auto r = base64::decode_into(out, bytes); not r)
+//     return r.status;
+//
+
+// The encoding options.
+struct Options {
+    // Use the URL-safe alphabet and '.' for padding.
+    bool url{false};
+
+    // Break the output into lines of `line_length` characters
+    // separated by '\n' (without a trailing '\n'), or not at all if
+    // zero. Must be a multiple of four.
+    size_t line_length{0};
+
+    // Return the options of `base64_encode_pem`.
+    static Options pem() { return {false, 64}; }
+
+    // Return the options of `base64_encode_mime`.
+    static Options mime() { return {false, 76}; }
+};
+
+// The outcome of encoding, decoding or validating.
+enum class Status {
+    Ok,
+    InvalidCharacter,  // A character outside both alphabets.
+    InvalidLength,     // A final quantum of a single character.
+    InvalidLineLength, // A line length that is not a multiple of four.
+    OutputTooSmall     // The output buffer cannot hold the result.
+};
+
+// Return the name of `status`, e.g. "invalid character".
+std::string_view name(Status status);
+
+struct Result {
+    Status status{Status::Ok};
+
+    // The number of characters or bytes written (or, when validating,
+    // that would be written). On failure, the number written before
+    // the failure was detected.
+    size_t count{0};
+
+    explicit operator bool() const { return status == Status::Ok; }
+};
+
+// Return the number of characters encoding `n` bytes with `options`.
+size_t encoded_length(size_t n, const Options& options = {});
+
+// Return the number of bytes decoded from `in`, a single encoding
+// without line breaks. Padded quanta within `in`, i.e. concatenated
+// encodings, decode to fewer bytes so it is an upper bound in general.
+size_t decoded_length(std::string_view in);
+
+// Return an upper bound on the number of bytes decoded from `n`
+// characters including any line breaks.
+constexpr size_t max_decoded_length(size_t n) { return (n + 3) / 4 * 3; }
+
+// Encode `in` into `out` which must hold at least
+// `encoded_length(in.size(), options)` characters. Return the number
+// of characters written.
+Result encode_into(std::string_view in, std::span<char> out, const Options& options = {});
+
+// Decode `in`, in either alphabet, into `out` which must hold at
+// least `decoded_length(in)` bytes, or `max_decoded_length(in.size())`
+// with `skip_line_breaks` ('\n' optionally preceded by '\r'). Padded
+// quanta may appear anywhere, e.g. in concatenated encodings, and the
+// final quantum may be short. Return the number of bytes written.
+Result decode_into(std::string_view in, std::span<char> out, bool skip_line_breaks = false);
+
+// Return the result `decode_into` would return given a large enough
+// buffer without writing the decoded bytes anywhere.
+Result validate(std::string_view in, bool skip_line_breaks = false);
+
+// The options of the parallel functions.
+struct ParallelOptions {
+    // The number of threads, including the calling thread, or zero
+    // for the number of hardware threads.
+    size_t threads{0};
+
+    // The input size below which the work is done on the calling
+    // thread only.
+    size_t threshold{size_t{4} << 20};
+};
+
+// Return the result of `encode_into` splitting `in` on line (or
+// quantum) boundaries into chunks encoded concurrently into their
+// place in `out`.
+Result parallel_encode_into(std::string_view in, std::span<char> out, const Options& options = {},
+			    const ParallelOptions& parallel = {});
+
+// Return the result of `decode_into` splitting `in` on quantum
+// boundaries into chunks decoded concurrently into their place in
+// `out`. With `skip_line_breaks`, the characters of each chunk are
+// counted concurrently first to find the boundaries.
+Result parallel_decode_into(std::string_view in, std::span<char> out, bool skip_line_breaks = false,
+			    const ParallelOptions& parallel = {});
+
+// The traits of base64 for the streaming `Encoder` and `Decoder` (see
+// core::codec::TextEncoder). The encoder breaks the lines itself, so
+// the quanta are encoded without line breaks.
+struct Codec {
+    using Options = base64::Options;
+    static constexpr const char *Name = "base64";
+    static constexpr size_t Bytes = 3, Chars = 4;
+
+    static size_t line_length(const Options& options) {
+	return options.line_length;
+    }
+
+    static Result encode(std::string_view in, std::span<char> out, const Options& options) {
+	return encode_into(in, out, {options.url, 0});
+    }
+
+    static Result decode(std::string_view in, std::span<char> out, const Options&) {
+	return decode_into(in, out);
+    }
+};
+
+}; // base64
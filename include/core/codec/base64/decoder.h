@@ -0,0 +1,38 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include "core/codec/base64/codec.h"
+#include "core/codec/util/text_decoder.h"
+
+namespace base64
+{
+
+// Read bytes from a `Source` encoded as base64 (see
+// core::codec::TextDecoder).
+//
+// Either alphabet is accepted and the decoded bytes are identical to
+// `base64_decode` of the whole input (with the white space removed).
+//
+// base64::Decoder d{std::cin};
+// std::string line;
+// while (d.read_line(line))
+//     std::cout << line << std::endl;
+//
+template<class Source>
+class Decoder : public core::codec::TextDecoder<Codec, Source> {
+public:
+    // Construct a decoder that reads from stream `is` in chunks of
+    // `n` characters (defaults to 64k) using buffers allocated from
+    // `alloc` (defaults to `core::default_allocator()`).
+    explicit Decoder(std::add_rvalue_reference_t<Source> is, size_t n = 0,
+		     core::Allocator *alloc = nullptr)
+	: core::codec::TextDecoder<Codec, Source>(std::forward<Source>(is), {}, n, alloc) {
+    }
+};
+
+template<class S> explicit Decoder(S&&) -> Decoder<S>;
+template<class S> explicit Decoder(S&&, size_t) -> Decoder<S>;
+template<class S> explicit Decoder(S&&, size_t, core::Allocator*) -> Decoder<S>;
+
+}; // base64
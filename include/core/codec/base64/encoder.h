@@ -0,0 +1,33 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include "core/codec/base64/codec.h"
+#include "core/codec/util/text_encoder.h"
+
+namespace base64
+{
+
+// Write bytes to a `Sink` encoded as base64 (see
+// core::codec::TextEncoder).
+//
+// The output is identical to `base64_encode` (or, with line wrapping,
+// `base64_encode_pem` and `base64_encode_mime`) of the concatenated
+// input. The line length must be a multiple of four.
+//
+// base64::Encoder e{std::cout, base64::Options::pem()};
+// e.write(data, size);
+// e.close();
+//
+template<class Sink>
+class Encoder : public core::codec::TextEncoder<Codec, Sink> {
+public:
+    using core::codec::TextEncoder<Codec, Sink>::TextEncoder;
+};
+
+template<class S> explicit Encoder(S&&) -> Encoder<S>;
+template<class S> explicit Encoder(S&&, const Options&) -> Encoder<S>;
+template<class S> explicit Encoder(S&&, const Options&, size_t) -> Encoder<S>;
+template<class S> explicit Encoder(S&&, const Options&, size_t, core::Allocator*) -> Encoder<S>;
+
+}; // base64
@@ -0,0 +1,64 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <cstddef>
+#include <string_view>
+
+namespace base64
+{
+
+// The block kernels that do the bulk of the work of `base64_encode`
+// and `base64_decode`. Each instruction set has its own kernels and
+// the best supported by the cpu is selected at runtime, falling back
+// to the table driven scalar kernels.
+//
+
+// The instruction sets for which kernels are provided.
+enum class Isa { Scalar, Ssse3, Avx2, Avx512Vbmi };
+
+// All instruction sets from least to most capable.
+inline constexpr Isa Isas[] = { Isa::Scalar, Isa::Ssse3, Isa::Avx2, Isa::Avx512Vbmi };
+
+// Return the name of `isa`, e.g. "avx2".
+std::string_view name(Isa isa);
+
+// Return true if the kernels for `isa` were compiled in and can run
+// on this cpu.
+bool supported(Isa isa);
+
+// Return the most capable supported instruction set.
+Isa best_isa();
+
+struct Kernels {
+    Isa isa;
+
+    // Encode the `n` bytes at `in`, a multiple of three, as the
+    // `4n/3` characters at `out` using the standard or URL-safe
+    // alphabet (no padding is involved).
+    void (*encode)(const unsigned char *in, size_t n, char *out, bool url);
+
+    // Decode the `n` characters at `in`, a multiple of four, as the
+    // `3n/4` bytes at `out` accepting the characters of either
+    // alphabet. Return the number of characters decoded which is less
+    // than `n` if the quantum at that offset contains any other
+    // character, including padding or white space.
+    size_t (*decode)(const char *in, size_t n, unsigned char *out);
+};
+
+// Return the kernels for `isa` or throw std::runtime_error if it is
+// not supported.
+const Kernels& kernels(Isa isa);
+
+// Return the kernels for `best_isa()`.
+const Kernels& kernels();
+
+// Return the 64 characters of the standard or URL-safe alphabet.
+const char *alphabet(bool url);
+
+// Return the 6-bit value of character `c` in either alphabet, or
+// `Invalid`.
+inline constexpr unsigned char Invalid = 0xff;
+unsigned char value(char c);
+
+}; // base64
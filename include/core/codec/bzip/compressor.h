@@ -4,6 +4,7 @@
 #pragma once
 #include <bzlib.h>
 #include "core/codec/bzip/get_area.h"
+#include "core/codec/util/stats.h"
 
 namespace bzip {
 
@@ -13,8 +14,9 @@ template<class Sink>
 class Compressor {
 public:
     // Construct a compressor that will write to `sink` using a buffer
-    // of size `n`.
-    Compressor(Sink& sink, size_t n = 65536);
+    // of size `n`. The bzip2 state and the buffer are allocated from
+    // `alloc` (defaults to `core::default_allocator()`).
+    Compressor(Sink& sink, size_t n = 65536, core::Allocator *alloc = nullptr);
 
     // Flush any remaining data and free all resources.
     ~Compressor();
@@ -29,10 +31,19 @@ public:
     template<class T>
     void write_pod(T& value) { write(reinterpret_cast<const char*>(&value), sizeof(T)); }
 
+#ifdef CODEC_STATS
+    // Return the statistics collected for this stream.
+    const core::codec::Stats& stats() const { return stats_.data(); }
+#endif
+
 private:
+    // Write the get area to the sink.
+    void flush();
+
     Sink& sink_;
     std::unique_ptr<bz_stream> stream_;
     GetArea get_;
+    [[no_unique_address]] core::codec::StatsRecorder stats_;
 };
 
 }; // bzip
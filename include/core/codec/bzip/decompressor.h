@@ -5,6 +5,7 @@
 #include "core/codec/bzip/get_area.h"
 #include "core/codec/bzip/put_area.h"
 #include "core/codec/bzip/new_stream.h"
+#include "core/codec/util/stats.h"
 
 namespace bzip {
 
@@ -12,8 +13,9 @@ template<class Source>
 class Decompressor {
 public:
     // Construct a decompressor that reads from `source` using a
-    // buffer of size `n`.
-    Decompressor(Source& source, size_t n = 65536);
+    // buffer of size `n`. The bzip2 state and the buffers are
+    // allocated from `alloc` (defaults to `core::default_allocator()`).
+    Decompressor(Source& source, size_t n = 65536, core::Allocator *alloc = nullptr);
 
     // Destructs a dcompressor freeing any resources.
     ~Decompressor();
@@ -47,11 +49,17 @@ public:
     // are ready to be read.
     std::string_view view() const { return get_.view(); }
 
+#ifdef CODEC_STATS
+    // Return the statistics collected for this stream.
+    const core::codec::Stats& stats() const { return stats_.data(); }
+#endif
+
 private:
     Source& src_;
     std::unique_ptr<bz_stream> bz_;
     GetArea get_;
     PutArea put_;
+    [[no_unique_address]] core::codec::StatsRecorder stats_;
 };
 
 }; // bzip
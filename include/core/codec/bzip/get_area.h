@@ -13,8 +13,9 @@ namespace bzip {
 class GetArea : public core::GetArea {
 public:
     // Construct an area of the given `capacity` for managing the Bzip
-    // output.
-    GetArea(char *&next, unsigned int& avail, unsigned int capacity);
+    // output using memory from `alloc`.
+    GetArea(char *&next, unsigned int& avail, unsigned int capacity,
+	    core::Allocator *alloc = nullptr);
 
     // Prepare to recieve output from Bzip.
     void clear();
@@ -3,18 +3,31 @@
 
 #pragma once
 #include <bzlib.h>
+#include "core/codec/util/allocator.h"
 
 namespace bzip {
 
-inline bz_stream *new_stream() {
+// Return a new, zeroed `bz_stream` whose internal allocations are
+// routed through `alloc` (defaults to `core::default_allocator()`).
+// An allocation that throws fails with a null pointer, which libbzip2
+// reports as `BZ_MEM_ERROR`, rather than unwinding through libbzip2.
+inline bz_stream *new_stream(core::Allocator *alloc = nullptr) {
     auto stream = new bz_stream;
     stream->next_in = nullptr;
     stream->avail_in = 0;
     stream->next_out = nullptr;
     stream->avail_out = 0;
-    stream->bzalloc = nullptr;
-    stream->bzfree = nullptr;
-    stream->opaque = nullptr;
+    stream->bzalloc = [](void *opaque, int n, int m) -> void* {
+	try {
+	    return static_cast<core::Allocator*>(opaque)->allocate(size_t(n) * size_t(m));
+	} catch (...) {
+	    return nullptr;
+	}
+    };
+    stream->bzfree = [](void *opaque, void *ptr) {
+	static_cast<core::Allocator*>(opaque)->deallocate(ptr);
+    };
+    stream->opaque = alloc ? alloc : &core::default_allocator();
     return stream;
 }
 
@@ -11,9 +11,9 @@ namespace bzip {
 class PutArea : public core::BufferedArea {
 public:
     // Construct an area of the given `capacity` for holding the Bzip
-    // input and retain references to the Bzip library variables that
-    // describe the buffer.
-    PutArea(char *&next, uint& avail, uint capacity);
+    // input (using memory from `alloc`) and retain references to the
+    // Bzip library variables that describe the buffer.
+    PutArea(char *&next, uint& avail, uint capacity, core::Allocator *alloc = nullptr);
 
     // Return true if no more characters are available for the Bzip
     // library to read.
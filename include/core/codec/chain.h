@@ -0,0 +1,217 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <string>
+#include <string_view>
+#include "core/codec/util/byte_io.h"
+#include "core/codec/base64/decoder.h"
+#include "core/codec/base64/encoder.h"
+#include "core/codec/bzip/compressor.h"
+#include "core/codec/bzip/decompressor.h"
+#include "core/codec/zstd/adapter.h"
+#include "core/codec/zstd/compressor.h"
+#include "core/codec/zstd/decompressor.h"
+
+namespace core::codec
+{
+
+// Compose streaming codecs into chains through which data flows block
+// by block with bounded memory, i.e. without materializing any
+// intermediate result.
+//
+// An encoding chain is built from the terminal sink outward; each
+// stage encodes what it is written and writes the result to the next
+// stage. Closing the head of the chain flushes and closes every
+// stage. For example, to produce `base64(zstd(x))`:
+//
+// std::string out;
+// StringSink sink{out};
+// Base64Sink b64{sink};
+// ZstdSink zstd{b64};
+// zstd.write(x.data(), x.size());
+// zstd.close();
+//
+// A decoding chain is built from the originating source outward;
+// each stage reads from the previous stage and decodes:
+//
+// StringSource source{out};
+// Base64Source b64{source};
+// ZstdSource zstd{b64};
+// std::string x;
+// pipe(zstd, StringSink{x});
+//
+
+// Copy all bytes from `source` to `sink` in blocks of `n` bytes and
+// then close `sink`.
+void pipe(ByteSource& source, ByteSink&& sink, size_t n = 65536);
+void pipe(ByteSource& source, ByteSink& sink, size_t n = 65536);
+
+// Append the bytes to a string.
+class StringSink : public ByteSink {
+public:
+    explicit StringSink(std::string& str)
+	: str_(str) {
+    }
+
+    void write(const char *ptr, size_t count) override { str_.append(ptr, count); }
+    void close() override { }
+
+private:
+    std::string& str_;
+};
+
+// Read the bytes of a string, which must outlive the source.
+class StringSource : public ByteSource {
+public:
+    explicit StringSource(std::string_view str)
+	: str_(str) {
+    }
+
+    size_t read_bytes(char *ptr, size_t count) override;
+
+private:
+    std::string_view str_;
+};
+
+// Write to any stream or queue accepted by the compressors, i.e. any
+// `Sink` modeling `zstd::OutStreamAdapter`, which must outlive the
+// stage. Closing the stage finishes the sink.
+template<class Sink>
+class SinkRef : public ByteSink {
+public:
+    explicit SinkRef(Sink& sink)
+	: sink_(sink) {
+    }
+
+    void write(const char *ptr, size_t count) override {
+	zstd::OutStreamAdapter<Sink&>::write(sink_, ptr, count);
+    }
+
+    void close() override { zstd::OutStreamAdapter<Sink&>::finish(sink_); }
+
+private:
+    Sink& sink_;
+};
+
+// Read from any stream, queue or decompressor accepted by the
+// decompressors, i.e. any `Source` modeling `zstd::InStreamAdapter`,
+// which must outlive the stage.
+template<class Source>
+class SourceRef : public ByteSource {
+public:
+    explicit SourceRef(Source& source)
+	: source_(source) {
+    }
+
+    size_t read_bytes(char *ptr, size_t count) override {
+	return zstd::InStreamAdapter<Source&>::read(source_, ptr, count);
+    }
+
+private:
+    Source& source_;
+};
+
+// Compress using zstd streaming and write to the next stage.
+class ZstdSink : public ByteSink {
+public:
+    // Construct a stage writing to `next` using compression `level`
+    // (zero selects the zstd default).
+    explicit ZstdSink(ByteSink& next, int level = 0);
+
+    void write(const char *ptr, size_t count) override { compressor_.write(ptr, count); }
+    void close() override { compressor_.close(); }
+
+    // Return a reference to the underlying compressor.
+    zstd::Compressor<ByteSink&>& compressor() { return compressor_; }
+
+private:
+    zstd::Compressor<ByteSink&> compressor_;
+};
+
+// Read from the previous stage and decompress using zstd streaming.
+class ZstdSource : public ByteSource {
+public:
+    explicit ZstdSource(ByteSource& prev)
+	: decompressor_(prev) {
+    }
+
+    size_t read_bytes(char *ptr, size_t count) override;
+
+private:
+    zstd::Decompressor<ByteSource&> decompressor_;
+    bool eof_{false};
+};
+
+// Compress using bzip2 and write to the next stage.
+class BzipSink : public ByteSink {
+public:
+    explicit BzipSink(ByteSink& next)
+	: next_(next)
+	, compressor_(next) {
+    }
+
+    void write(const char *ptr, size_t count) override { compressor_.write(ptr, count); }
+    void close() override;
+
+private:
+    ByteSink& next_;
+    bzip::Compressor<ByteSink> compressor_;
+};
+
+// Read from the previous stage and decompress using bzip2.
+class BzipSource : public ByteSource {
+public:
+    explicit BzipSource(ByteSource& prev)
+	: decompressor_(prev) {
+    }
+
+    size_t read_bytes(char *ptr, size_t count) override {
+	return decompressor_.read_bytes(ptr, count);
+    }
+
+private:
+    bzip::Decompressor<ByteSource> decompressor_;
+};
+
+// Encode as (optionally URL-safe, line wrapped) base64 and write to
+// the next stage in blocks of at most 4096 characters (see
+// `base64::Encoder`).
+class Base64Sink : public ByteSink {
+public:
+    explicit Base64Sink(ByteSink& next, bool url = false)
+	: Base64Sink(next, base64::Options{url, 0}) {
+    }
+
+    Base64Sink(ByteSink& next, const base64::Options& options)
+	: encoder_(next, options, 4096) {
+    }
+
+    void write(const char *ptr, size_t count) override {
+	encoder_.write(ptr, count);
+    }
+
+    void close() override;
+
+private:
+    base64::Encoder<ByteSink&> encoder_;
+    bool closed_{false};
+};
+
+// Read base64 (ignoring line breaks and other white space) from the
+// previous stage and decode it (see `base64::Decoder`).
+class Base64Source : public ByteSource {
+public:
+    explicit Base64Source(ByteSource& prev)
+	: decoder_(prev, 4096) {
+    }
+
+    size_t read_bytes(char *ptr, size_t count) override {
+	return decoder_.read_bytes(ptr, count);
+    }
+
+private:
+    base64::Decoder<ByteSource&> decoder_;
+};
+
+}; // core::codec
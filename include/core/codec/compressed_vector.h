@@ -0,0 +1,351 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "core/codec/shuffle.h"
+#include "core/codec/util/parallel.h"
+
+namespace core::codec
+{
+
+// The options of `compressed_vector`.
+struct CompressedVectorOptions {
+    // The number of elements of each independently compressed chunk.
+    size_t chunk{size_t{1} << 14};
+
+    // The number of decompressed chunks cached for random access.
+    size_t cache{4};
+
+    // The zstd compression level.
+    int level{1};
+
+    // The pre-filter of each chunk, if any (see core/codec/shuffle.h).
+    std::optional<shuffle::Options> filter{shuffle::Options{}};
+
+    // The number of threads compressing or decompressing chunks in
+    // bulk, or zero for the number of hardware threads.
+    size_t threads{0};
+};
+
+// Compress and decompress the chunks of `compressed_vector`, arrays
+// of elements of `typesize` bytes.
+class ChunkCodec {
+public:
+    ChunkCodec(size_t typesize, const CompressedVectorOptions& options);
+
+    // Return the `n` bytes at `data` compressed.
+    std::string compress(const char *data, size_t n) const;
+
+    // Decompress `chunk` into the `n` bytes at `out`, or throw
+    // zstd::error if it does not decompress to `n` bytes.
+    void decompress(std::string_view chunk, char *out, size_t n) const;
+
+private:
+    size_t typesize_;
+    std::optional<shuffle::Options> filter_;
+    int level_;
+};
+
+// Store a sequence of trivially copyable values, e.g. a numeric
+// column, as independently compressed chunks of a fixed number of
+// elements, decompressed on demand.
+//
+// Random access decompresses the chunk of the element into a small
+// cache of the most recently used chunks, so accesses with locality
+// are cheap. Iterators hold on to the chunk they point into and
+// decompress each chunk once when scanning. `copy` and `to_vector`
+// decompress chunks concurrently without going through the cache.
+//
+// Appended elements are kept uncompressed until they fill a chunk,
+// or `shrink_to_fit` is called. Like the iterators of std::vector,
+// iterators into those elements are invalidated by `push_back`.
+//
+// The const members may be called concurrently; the cache is guarded
+// by a mutex held while looking up chunks but not while decompressing.
+//
+template<class T>
+class compressed_vector {
+    static_assert(std::is_trivially_copyable_v<T>, "compressed_vector: T must be trivially copyable");
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using Chunk = std::shared_ptr<const std::vector<T>>;
+
+    class const_iterator;
+    using iterator = const_iterator;
+
+    explicit compressed_vector(const CompressedVectorOptions& options = {})
+	: options_(normalize(options))
+	, codec_(sizeof(T), options_)
+	, cache_(std::make_unique<Cache>()) {
+    }
+
+    // Construct from `values`, compressing the chunks concurrently.
+    explicit compressed_vector(std::span<const T> values, const CompressedVectorOptions& options = {})
+	: compressed_vector(options) {
+	auto chunk = options_.chunk;
+	chunks_.resize((values.size() + chunk - 1) / chunk);
+	parallel_for(chunks_.size(), options_.threads, [&](size_t k) {
+	    auto n = std::min(chunk, values.size() - k * chunk);
+	    chunks_[k] = codec_.compress((const char*)(values.data() + k * chunk), n * sizeof(T));
+	});
+	size_ = values.size();
+    }
+
+    compressed_vector(compressed_vector&&) = default;
+    compressed_vector& operator=(compressed_vector&&) = default;
+
+    // Return the number of elements.
+    size_t size() const { return size_; }
+
+    // Return true if there are no elements.
+    bool empty() const { return size_ == 0; }
+
+    // Return the number of elements per chunk.
+    size_t chunk_size() const { return options_.chunk; }
+
+    // Return the number of bytes holding the elements, i.e. the
+    // compressed chunks and the uncompressed appended elements.
+    size_t storage_size() const {
+	size_t n = tail_.size() * sizeof(T);
+	for (const auto& chunk : chunks_)
+	    n += chunk.size();
+	return n;
+    }
+
+    // Return the element at `i`.
+    T operator[](size_t i) const {
+	auto k = i / options_.chunk;
+	if (k == chunks_.size())
+	    return tail_[i - k * options_.chunk];
+	return (*chunk(k))[i - k * options_.chunk];
+    }
+
+    // Return the element at `i` or throw std::out_of_range.
+    T at(size_t i) const {
+	if (i >= size_)
+	    throw std::out_of_range("compressed_vector::at: index out of range");
+	return (*this)[i];
+    }
+
+    T front() const { return (*this)[0]; }
+    T back() const { return (*this)[size_ - 1]; }
+
+    // Append `value`, compressing the appended elements once they fill
+    // a chunk.
+    void push_back(const T& value) {
+	if (tail_.empty() and size_ % options_.chunk != 0) {
+	    // Reopen the partial last chunk left by the constructor or
+	    // `shrink_to_fit`.
+	    auto last = chunk(chunks_.size() - 1);
+	    tail_.assign(last->begin(), last->end());
+	    chunks_.pop_back();
+	    forget(chunks_.size());
+	}
+	tail_.push_back(value);
+	++size_;
+	if (tail_.size() == options_.chunk)
+	    seal();
+    }
+
+    // Compress the appended elements that do not fill a chunk.
+    void shrink_to_fit() {
+	if (not tail_.empty())
+	    seal();
+    }
+
+    // Copy the elements [`first`, `last`) to `out`, decompressing the
+    // chunks concurrently.
+    void copy(size_t first, size_t last, T *out) const {
+	if (first >= last)
+	    return;
+	auto chunk = options_.chunk;
+	auto k0 = first / chunk, k1 = std::min((last - 1) / chunk + 1, chunks_.size());
+	parallel_for(k0 < k1 ? k1 - k0 : 0, options_.threads, [&](size_t j) {
+	    auto k = k0 + j;
+	    auto begin = std::max(first, k * chunk), end = std::min(last, (k + 1) * chunk);
+	    auto n = std::min(chunk, size_ - k * chunk);
+	    if (begin == k * chunk and end - begin == n) {
+		codec_.decompress(chunks_[k], (char*)(out + begin - first), n * sizeof(T));
+	    } else {
+		std::vector<T> buffer(n);
+		codec_.decompress(chunks_[k], (char*)buffer.data(), n * sizeof(T));
+		std::copy(buffer.begin() + (begin - k * chunk), buffer.begin() + (end - k * chunk),
+			  out + begin - first);
+	    }
+	});
+
+	auto base = chunks_.size() * chunk;
+	if (last > base) {
+	    auto begin = std::max(first, base);
+	    std::copy(tail_.begin() + (begin - base), tail_.begin() + (last - base), out + begin - first);
+	}
+    }
+
+    // Return all the elements, decompressing the chunks concurrently.
+    std::vector<T> to_vector() const {
+	std::vector<T> values(size_);
+	copy(0, size_, values.data());
+	return values;
+    }
+
+    const_iterator begin() const { return const_iterator{this, 0}; }
+    const_iterator end() const { return const_iterator{this, size_}; }
+
+    // Return the decompressed chunk `k`, through the cache.
+    Chunk chunk(size_t k) const;
+
+private:
+    struct Cache {
+	struct Entry {
+	    size_t k;
+	    Chunk data;
+	    size_t used;
+	};
+	std::mutex mutex;
+	std::vector<Entry> entries;
+	size_t tick{0};
+    };
+
+    static CompressedVectorOptions normalize(CompressedVectorOptions options) {
+	options.chunk = std::max<size_t>(options.chunk, 1);
+	return options;
+    }
+
+    // Compress the appended elements as the last chunk.
+    void seal() {
+	chunks_.push_back(codec_.compress((const char*)tail_.data(), tail_.size() * sizeof(T)));
+	tail_.clear();
+	tail_.shrink_to_fit();
+    }
+
+    // Drop chunk `k` from the cache.
+    void forget(size_t k) {
+	std::lock_guard lock(cache_->mutex);
+	std::erase_if(cache_->entries, [&](const auto& e) { return e.k == k; });
+    }
+
+    CompressedVectorOptions options_;
+    ChunkCodec codec_;
+    std::vector<std::string> chunks_;
+    std::vector<T> tail_;
+    size_t size_{0};
+    std::unique_ptr<Cache> cache_;
+};
+
+template<class T>
+typename compressed_vector<T>::Chunk compressed_vector<T>::chunk(size_t k) const {
+    auto& cache = *cache_;
+    {
+	std::lock_guard lock(cache.mutex);
+	for (auto& e : cache.entries) {
+	    if (e.k == k) {
+		e.used = ++cache.tick;
+		return e.data;
+	    }
+	}
+    }
+
+    auto n = std::min(options_.chunk, size_ - k * options_.chunk);
+    auto data = std::make_shared<std::vector<T>>(n);
+    codec_.decompress(chunks_[k], (char*)data->data(), n * sizeof(T));
+    if (options_.cache == 0)
+	return data;
+
+    // Replace the least recently used chunk, unless another thread
+    // decompressed the same chunk meanwhile.
+    std::lock_guard lock(cache.mutex);
+    for (auto& e : cache.entries)
+	if (e.k == k)
+	    return e.data;
+    if (cache.entries.size() < options_.cache) {
+	cache.entries.push_back({k, data, ++cache.tick});
+    } else {
+	auto lru = std::min_element(cache.entries.begin(), cache.entries.end(),
+				    [](const auto& a, const auto& b) { return a.used < b.used; });
+	*lru = {k, data, ++cache.tick};
+    }
+    return data;
+}
+
+// Iterate over the values of a `compressed_vector` holding on to the
+// decompressed chunk of the current element.
+template<class T>
+class compressed_vector<T>::const_iterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    const_iterator() = default;
+
+    const_iterator(const compressed_vector *vec, size_t i)
+	: vec_(vec)
+	, i_(i) {
+    }
+
+    // Return a reference to the element, valid until the iterator
+    // moves to another chunk.
+    reference operator*() const {
+	if (i_ < begin_ or i_ >= end_)
+	    load();
+	return data_[i_ - begin_];
+    }
+
+    pointer operator->() const { return &**this; }
+
+    const_iterator& operator++() {
+	++i_;
+	return *this;
+    }
+
+    const_iterator operator++(int) {
+	auto tmp = *this;
+	++i_;
+	return tmp;
+    }
+
+    // Return the index of the element.
+    size_t index() const { return i_; }
+
+    bool operator==(const const_iterator& other) const { return i_ == other.i_; }
+
+private:
+    void load() const {
+	auto chunk = vec_->options_.chunk;
+	auto k = i_ / chunk;
+	begin_ = k * chunk;
+	if (k == vec_->chunks_.size()) {
+	    chunk_.reset();
+	    data_ = vec_->tail_.data();
+	    end_ = begin_ + vec_->tail_.size();
+	} else {
+	    chunk_ = vec_->chunk(k);
+	    data_ = chunk_->data();
+	    end_ = begin_ + chunk_->size();
+	}
+    }
+
+    const compressed_vector *vec_{nullptr};
+    size_t i_{0};
+    mutable Chunk chunk_;
+    mutable const T *data_{nullptr};
+    mutable size_t begin_{0}, end_{0};
+};
+
+}; // core::codec
@@ -0,0 +1,104 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace core::codec::corpus
+{
+
+// Generate reproducible synthetic inputs for benchmarking, tuning
+// and testing the codecs.
+//
+// Every generator is a pure function of its size and `seed`. Only
+// integer arithmetic and exactly rounded IEEE-754 operations are
+// used (no standard library distributions, whose output is
+// implementation defined), and numeric corpora are serialized
+// little-endian, so the same arguments produce byte-identical output
+// on every platform, compiler and commit. Use `checksum` to verify.
+//
+// std::string text = corpus::generate(corpus::Kind::Log, 1 << 20, 42);
+// assert(corpus::checksum(text) == corpus::checksum(corpus::Kind::Log, 1 << 20, 42));
+//
+
+// The kinds of corpus available.
+enum class Kind {
+    Log,	// Timestamped, leveled log lines
+    Json,	// Newline delimited JSON records
+    SortedInts,	// Ascending int64_t values with small random gaps
+    Floats,	// double values following a random walk
+    Timestamps,	// int64_t nanosecond timestamps with jitter
+    Random,	// Uniformly random, incompressible bytes
+    Repetitive	// A short block repeated with rare mutations
+};
+
+// All kinds in declaration order.
+inline constexpr Kind Kinds[] = {
+    Kind::Log, Kind::Json, Kind::SortedInts, Kind::Floats,
+    Kind::Timestamps, Kind::Random, Kind::Repetitive
+};
+
+// Return the lower case name of `kind`, e.g. "log" or "sorted_ints".
+std::string_view name(Kind kind);
+
+// Return the kind named `str` or throw std::runtime_error.
+Kind parse_kind(std::string_view str);
+
+// Return exactly `size` bytes of corpus `kind` generated from `seed`.
+// Numeric kinds are the little-endian bytes of the values truncated
+// to `size`.
+std::string generate(Kind kind, size_t size, uint64_t seed = 0);
+
+// Return `size` bytes of log-like text.
+std::string log_text(size_t size, uint64_t seed = 0);
+
+// Return `size` bytes of newline delimited JSON records.
+std::string json_records(size_t size, uint64_t seed = 0);
+
+// Return `count` ascending integers.
+std::vector<int64_t> sorted_ints(size_t count, uint64_t seed = 0);
+
+// Return `count` prices (exact cents) following a random walk.
+std::vector<double> floats(size_t count, uint64_t seed = 0);
+
+// Return `count` ascending nanosecond timestamps.
+std::vector<int64_t> timestamps(size_t count, uint64_t seed = 0);
+
+// Return `size` uniformly random bytes.
+std::string random_bytes(size_t size, uint64_t seed = 0);
+
+// Return `size` bytes of highly repetitive data.
+std::string repetitive(size_t size, uint64_t seed = 0);
+
+// Return the 64-bit FNV-1a hash of `data`.
+uint64_t checksum(std::string_view data);
+
+// Return the checksum of `generate(kind, size, seed)`.
+inline uint64_t checksum(Kind kind, size_t size, uint64_t seed = 0) {
+    return checksum(generate(kind, size, seed));
+}
+
+// Provide the deterministic xoshiro256** generator used by the
+// corpora (seeded through splitmix64) for callers that need their own
+// reproducible choices.
+class Random {
+public:
+    explicit Random(uint64_t seed);
+
+    // Return the next 64 random bits.
+    uint64_t operator()();
+
+    // Return a value uniformly distributed in [0, n).
+    uint64_t below(uint64_t n);
+
+    // Return a value uniformly distributed in [lo, hi].
+    int64_t between(int64_t lo, int64_t hi) { return lo + int64_t(below(uint64_t(hi - lo) + 1)); }
+
+private:
+    uint64_t s_[4];
+};
+
+}; // core::codec::corpus
@@ -2,52 +2,135 @@
 //
 
 #pragma once
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <streambuf>
+#include <type_traits>
+#include <utility>
+#include "core/codec/util/buffer.h"
+#include "core/codec/zstd/adapter.h"
 
 namespace core {
 
-template<class Filter, class CharT = char, class TraitsT = std::char_traits<CharT>>
+// Apply `filter` (see `filter_streambuf`) to the lines of [`begin`,
+// `end`), compacting the accepted lines in place to the front. A
+// final line without a '\n' is left unprocessed unless `last`. Return
+// the end of the accepted lines and the start of the unprocessed
+// characters.
+template<class Filter>
+std::pair<char*, char*> filter_lines(Filter& filter, char *begin, char *end, bool last) {
+    auto out = begin, ptr = begin;
+    while (ptr < end) {
+	auto eol = static_cast<char*>(memchr(ptr, '\n', end - ptr));
+	if (not eol and not last)
+	    break;
+	auto next = eol ? eol + 1 : end;
+
+	std::string_view line{ptr, size_t(next - ptr)};
+	if constexpr (std::is_invocable_r_v<size_t, Filter&, std::string_view, char*>) {
+	    out += filter(line, out);
+	} else if (filter(line)) {
+	    if (out != ptr)
+		memmove(out, ptr, line.size());
+	    out += line.size();
+	}
+	ptr = next;
+    }
+    return {out, ptr};
+}
+
+// Provide a stream buffer of the lines of a `Source` accepted by
+// `filter`, a callable taking each line, including its terminating
+// '\n' if any, as a `std::string_view`.
+//
+// Alternatively, `filter` may edit the lines: called with each line
+// and an output pointer, e.g. `size_t filter(std::string_view line,
+// char *out)`, it writes the characters to keep to `out` and returns
+// their number (zero drops the line). The output never runs ahead of
+// the line, but may overlap it, so the characters must be written in
+// order and never ahead of those read.
+//
+// The `Source` object must either have a `read` method with the
+// signature read(char* data, size_t count), e.g. std::istream, or
+// implement a specialization of `zstd::InStreamAdapter`, e.g.
+// `zstd::Decompressor`.
+//
+// The source is read in blocks of `n` characters (default 65536) and
+// the accepted lines are compacted, in place, to the front of the
+// block which then becomes the get area. A partial line at the end
+// of the block is carried to the next block, which grows as needed
+// for lines longer than a block.
+//
+template<class Filter, class Source = std::istream&, class CharT = char,
+	 class TraitsT = std::char_traits<CharT>>
 class filter_streambuf : public std::streambuf {
 public:
-    filter_streambuf(std::istream& sin, Filter&& filter)
-	: sin_(sin)
+    filter_streambuf(std::add_rvalue_reference_t<Source> sin, Filter filter, size_t n = 0)
+	: sin_(std::forward<Source>(sin))
 	, filter_(std::move(filter))
+	, area_(n > 0 ? n : 65536)
     { }
-    
-    int underflow() {
-	if (this->gptr() == this->egptr()) {
-	    line_.clear();
-	    while (std::getline(sin_, line_)) {
-		if (sin_)
-		    line_ += "\n";
-		if (not filter_(line_)) {
-		    line_.clear();
-		    continue;
-		}
-		break;
-	    }
-
-	    this->setg(line_.data(), line_.data(), line_.data() + line_.size());
-	}
-	return this->gptr() == this->egptr()
-	    ? std::char_traits<CharT>::eof()
-	    : std::char_traits<CharT>::to_int_type(*this->gptr());
+
+    int underflow() override {
+	while (this->gptr() == this->egptr())
+	    if (not fill())
+		return std::char_traits<CharT>::eof();
+	return std::char_traits<CharT>::to_int_type(*this->gptr());
     }
-    
+
 private:
-    std::istream& sin_;
+    // Read the next block from the source after the carried partial
+    // line and set the get area to its accepted lines. Return false
+    // if there is no more input.
+    bool fill() {
+	size_t size = end_ - begin_;
+	if (eof_ and size == 0)
+	    return false;
+
+	if (size == area_.capacity()) {
+	    core::BufferedArea larger(2 * area_.capacity(), area_.allocator());
+	    memcpy(larger.begin(), area_.begin() + begin_, size);
+	    area_ = std::move(larger);
+	} else {
+	    memmove(area_.begin(), area_.begin() + begin_, size);
+	}
+	begin_ = 0;
+	end_ = size;
+
+	// A short read marks the end of the input (every adapter fills
+	// the request unless the source is exhausted), so the source
+	// is not read again, e.g. a closed `zstd::Decompressor`.
+	if (not eof_) {
+	    auto ptr = area_.begin() + end_;
+	    auto requested = area_.capacity() - end_;
+	    auto count = zstd::InStreamAdapter<Source>::read(sin_, ptr, requested);
+	    eof_ = count < requested;
+	    end_ += count;
+	}
+
+	auto [out, ptr] = filter_lines(filter_, area_.begin(), area_.begin() + end_, eof_);
+	begin_ = ptr - area_.begin();
+	this->setg(area_.begin(), area_.begin(), out);
+	return true;
+    }
+
+    Source sin_;
     Filter filter_;
-    std::string line_;
+    core::BufferedArea area_;
+    size_t begin_{0}, end_{0};
+    bool eof_{false};
 };
 
-template<class Filter, class CharT = char, class TraitT = std::char_traits<CharT>>
+template<class Filter, class Source = std::istream&, class CharT = char,
+	 class TraitT = std::char_traits<CharT>>
 class filter_istream : public std::basic_istream<CharT, TraitT> {
 public:
-    filter_istream(std::istream& sin, Filter&& filter)
+    filter_istream(std::add_rvalue_reference_t<Source> sin, Filter filter, size_t n = 0)
 	: std::basic_istream<CharT, TraitT>::basic_istream
-	(new filter_streambuf<Filter, CharT, TraitT>(sin, std::move(filter)))
+	(new filter_streambuf<Filter, Source, CharT, TraitT>
+	 (std::forward<Source>(sin), std::move(filter), n))
     { }
 
     ~filter_istream() {
@@ -57,4 +140,7 @@ public:
 private:
 };
 
+template<class S, class F> filter_istream(S&&, F) -> filter_istream<F, S>;
+template<class S, class F> filter_istream(S&&, F, size_t) -> filter_istream<F, S>;
+
 }; // ns core
@@ -2,16 +2,75 @@
 //
 
 #pragma once
-#include <regex>
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
 #include "core/codec/filter.h"
 
 namespace core {
 
-inline auto filter_comments(std::istream& is) {
-    std::regex comment("^[ \t]*//");
-    return core::filter_istream(is, [=](std::string_view s) {
-	return not std::regex_search(s.data(), comment);
-    });
+// The comment syntax recognized by `CommentFilter`.
+struct CommentSyntax {
+    // The markers of comments running to the end of the line, e.g.
+    // "//", "#" or "--".
+    std::vector<std::string> line{"//"};
+
+    // The delimiters of block comments, e.g. "/*" and "*/", which may
+    // span lines, or empty for none.
+    std::string block_begin{}, block_end{};
+
+    // Recognize comments following other text on the line. Otherwise,
+    // only comments preceded by blanks on the line are recognized.
+    bool trailing{false};
+
+    // The characters delimiting string literals, in which comment
+    // markers are not recognized, with '\\' escaping the next
+    // character. Only used with `trailing`.
+    std::string quotes{};
+
+    // C and C++: "//", "/* */", trailing comments and string literals.
+    static CommentSyntax cpp() { return {{"//"}, "/*", "*/", true, "\"'"}; }
+
+    // Shell, Python and configuration files: trailing "#" comments.
+    static CommentSyntax shell() { return {{"#"}, "", "", true, "\"'"}; }
+
+    // SQL: "--", "/* */", trailing comments and string literals.
+    static CommentSyntax sql() { return {{"--"}, "/*", "*/", true, "'\""}; }
+};
+
+// Remove the comments of `syntax` from lines, as an editing filter of
+// `filter_istream`. Lines left blank by the removal of a comment are
+// dropped, other lines keep their terminating '\n'. The state of an
+// open block comment is carried from one line to the next.
+class CommentFilter {
+public:
+    CommentFilter(CommentSyntax syntax = {});
+
+    // Write the characters of `line` outside of comments to `out`,
+    // which may overlap `line` (see `filter_streambuf`), and return
+    // their number, or zero if the line is dropped.
+    size_t operator()(std::string_view line, char *out);
+
+    // Return true if the end of the last line was inside a block
+    // comment.
+    bool in_block() const { return in_block_; }
+
+private:
+    enum Class : unsigned char { Other, Blank, Marker, Quote };
+
+    size_t edit(std::string_view line, char *out);
+
+    CommentSyntax syntax_;
+    std::array<Class, 256> class_;
+    bool in_block_{false};
+};
+
+// Return a stream of the lines of `is` with the comments of `syntax`
+// removed, by default the lines starting with "//".
+template<class Source>
+auto filter_comments(Source&& is, CommentSyntax syntax = {}, size_t n = 0) {
+    return core::filter_istream(std::forward<Source>(is), CommentFilter{std::move(syntax)}, n);
 }
 
 }; // ns core
@@ -0,0 +1,21 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <string_view>
+
+namespace core::codec {
+
+// The compressed formats recognized from their leading bytes.
+enum class Format { Raw, Zstd, Bzip };
+
+// Return the format of the data starting with `prefix`. Data that is
+// neither a ZSTD frame (including skippable frames) nor a bzip2
+// stream is reported as `Format::Raw`.
+Format detect_format(std::string_view prefix);
+
+// Return true if `prefix` is the base64 encoding (possibly preceded
+// by whitespace and wrapped across lines) of a ZSTD or bzip2 stream.
+bool detect_base64(std::string_view prefix);
+
+}; // core::codec
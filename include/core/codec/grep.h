@@ -0,0 +1,123 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "core/codec/grep/kernels.h"
+#include "core/codec/zstd/adapter.h"
+
+namespace grep
+{
+
+// A line matching the pattern of a search.
+struct Match {
+    uint64_t line{0};		// Zero-based number of the line
+    uint64_t position{0};	// Offset of the line in the (decompressed) input
+    std::string_view text;	// The line without its newline, valid during the callback
+};
+
+// The options of a search.
+struct Options {
+    // The number of threads decompressing and searching, the calling
+    // thread and workers of `core::codec::ThreadPool::global()`, or
+    // zero for the number of hardware threads. An input of a single
+    // frame or chunk is searched on the calling thread only.
+    size_t threads{0};
+
+    // The size of the chunks a stream is searched in.
+    size_t chunk{size_t{4} << 20};
+
+    // The number of frames or chunks in flight, or zero for twice the
+    // number of threads. The memory used is bounded by `window` frames
+    // or chunks.
+    size_t window{0};
+
+    // Stop after this many matching lines, or zero for no limit.
+    uint64_t max_count{0};
+};
+
+// Select the lines containing a pattern.
+//
+// The lines are found by running the prefilter kernels over whole
+// blocks of text for literals one of which any matching line
+// contains: the pattern itself when it is a fixed string or an
+// alternation of fixed strings, otherwise the longest literal the
+// regular expression requires. Only the lines holding a literal are
+// delimited and, if the pattern is not just literals, checked against
+// the regular expression. A pattern without a required literal checks
+// every line.
+//
+class Matcher {
+public:
+    // Match the lines containing `pattern`, an ECMAScript regular
+    // expression, or the fixed string `pattern` if `fixed`.
+    explicit Matcher(std::string_view pattern, bool fixed = false);
+
+    // Match the lines containing any of the fixed strings `literals`.
+    explicit Matcher(std::vector<std::string> literals);
+
+    ~Matcher();
+    Matcher(Matcher&&);
+
+    // Return the literals of the prefilter, empty if every line is a
+    // candidate.
+    const std::vector<std::string>& literals() const { return set_.literals; }
+
+    // Return true if the candidate lines are checked against a regular
+    // expression.
+    bool uses_regex() const { return regex_ != nullptr; }
+
+    // Return true if `line` matches.
+    bool match(std::string_view line) const;
+
+    // Return the offset of the first matching line of `text` starting
+    // at or after `pos`, a line start, or std::string_view::npos.
+    size_t find(std::string_view text, size_t pos = 0) const;
+
+private:
+    struct Regex;
+
+    LiteralSet set_;
+    std::unique_ptr<Regex> regex_;
+    bool all_{false};
+    const Kernels *kernels_;
+};
+
+// The function called with each matching line, in order.
+using OnMatch = std::function<void(const Match&)>;
+
+// Search the lines of `text` in chunks searched concurrently. Return
+// the number of matching lines.
+uint64_t search(std::string_view text, const Matcher& matcher, const OnMatch& on_match,
+		const Options& options = {});
+
+// Search the lines of the file at `path`. A zstd file of several
+// frames, e.g. written with a frame size, has its frames decompressed
+// and searched concurrently; a file of a single frame is decompressed
+// sequentially and searched concurrently in chunks; any other file is
+// searched as text. Return the number of matching lines.
+uint64_t search_file(const std::string& path, const Matcher& matcher, const OnMatch& on_match,
+		     const Options& options = {});
+
+// Search the lines read by `read(ptr, count)`, which returns fewer
+// than `count` bytes only at the end of its source, in chunks
+// searched concurrently. Return the number of matching lines.
+uint64_t search_reader(const std::function<size_t(char*, size_t)>& read, const Matcher& matcher,
+		       const OnMatch& on_match, const Options& options = {});
+
+// Search the lines of the decompressed bytes of `source`, e.g. a
+// `zstd::Decompressor`, or of any source read through
+// `zstd::InStreamAdapter`.
+template<class Source>
+uint64_t search_stream(Source& source, const Matcher& matcher, const OnMatch& on_match,
+		       const Options& options = {}) {
+    return search_reader([&](char *ptr, size_t count) {
+	return zstd::InStreamAdapter<Source>::read(source, ptr, count);
+    }, matcher, on_match, options);
+}
+
+}; // grep
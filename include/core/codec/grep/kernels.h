@@ -0,0 +1,64 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "core/codec/base64/kernels.h"
+
+namespace grep
+{
+
+// The prefilter kernels of `grep::Matcher`, finding the occurrences of
+// a small set of literals in a block of text, selected at runtime as
+// for base64 (see base64/kernels.h). The vector kernels compare the
+// first and the last byte of each literal against 32 positions at a
+// time and verify the candidates, as memchr does for a single byte.
+// They also count the lines of a block.
+//
+
+using base64::Isa;
+using base64::Isas;
+using base64::name;
+
+// Return true if the kernels for `isa` were compiled in and can run
+// on this cpu.
+bool supported(Isa isa);
+
+// Return the most capable supported instruction set.
+Isa best_isa();
+
+// A set of non-empty literals prepared for the kernels.
+struct LiteralSet {
+    LiteralSet() = default;
+    explicit LiteralSet(std::vector<std::string> literals);
+
+    std::vector<std::string> literals;
+    size_t max_size{0};
+
+    // True for the bytes that start a literal.
+    std::array<bool, 256> first{};
+};
+
+struct Kernels {
+    Isa isa;
+
+    // Return the offset of the first occurrence of any literal of `set`
+    // in the `n` bytes at `data`, or `n` if there is none.
+    size_t (*find)(const char *data, size_t n, const LiteralSet& set);
+
+    // Return the number of bytes equal to `c` in the `n` bytes at
+    // `data`, e.g. the newlines.
+    size_t (*count)(const char *data, size_t n, char c);
+};
+
+// Return the kernels for `isa` or throw std::runtime_error if it is
+// not supported.
+const Kernels& kernels(Isa isa);
+
+// Return the kernels for `best_isa()`.
+const Kernels& kernels();
+
+}; // grep
@@ -0,0 +1,274 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "core/codec/filter.h"
+#include "core/codec/util/parallel.h"
+
+namespace core {
+
+// The options of `parallel_filter_streambuf`.
+struct ParallelFilterOptions {
+    // The number of workers of the thread pool reading and running
+    // the filter, or zero for the number of hardware threads.
+    size_t threads{0};
+
+    // The size of the chunks the input is split into, or zero for 4
+    // MiB. A chunk grows as needed to hold a line longer than `chunk`.
+    size_t chunk{size_t{4} << 20};
+
+    // The number of chunks read, being filtered or waiting to be
+    // consumed at any time, or zero for twice the number of threads.
+    // The memory used is bounded by `window * chunk`.
+    size_t window{0};
+};
+
+// Provide a stream buffer of the lines of a `Source` accepted by
+// `filter`, as `filter_streambuf`, filtering the lines on several
+// threads while preserving their order.
+//
+// The source is split into chunks of whole lines, read in turn by one
+// thread at a time, which are filtered in place, each by the next free
+// thread, and exposed in turn as the get area. The threads are
+// workers of `codec::ThreadPool::global()` and the thread calling
+// `underflow`, which reads or filters the next chunk itself rather
+// than wait. The workers are only engaged once the first chunk turns
+// out not to be the last, so a short source is filtered on the
+// calling thread, and return to the pool whenever there is nothing to
+// read or filter, e.g. while the consumer pauses, being queued again
+// as chunks are consumed or read. Each thread calls its own copy of `filter` on the
+// lines of whole chunks at a time, so the filter must not depend on
+// lines it has not seen, e.g. the block comments of a
+// `CommentFilter`.
+//
+// An exception thrown by the source or the filter is rethrown by the
+// next call to `underflow`.
+//
+template<class Filter, class Source = std::istream&>
+class parallel_filter_streambuf : public std::streambuf {
+public:
+    parallel_filter_streambuf(std::add_rvalue_reference_t<Source> sin, Filter filter,
+			      const ParallelFilterOptions& options = {})
+	: sin_(std::forward<Source>(sin))
+	, filter_(std::move(filter))
+	, own_(filter_)
+	, chunk_(options.chunk > 0 ? options.chunk : ParallelFilterOptions{}.chunk)
+	, threads_(options.threads > 0 ? options.threads : codec::hardware_threads()) {
+	auto window = options.window > 0 ? options.window : 2 * threads_;
+	slots_.reserve(std::max<size_t>(window, 2));
+	while (slots_.size() < slots_.capacity())
+	    slots_.emplace_back(chunk_);
+    }
+
+    ~parallel_filter_streambuf() {
+	{
+	    std::lock_guard lock(mutex_);
+	    stop_ = true;
+	}
+	cv_.notify_all();
+	helpers_.close();
+    }
+
+    int underflow() override {
+	while (this->gptr() == this->egptr()) {
+	    std::unique_lock lock(mutex_);
+	    if (held_) {
+		slot(consumed_++).state = State::Empty;
+		held_ = false;
+		cv_.notify_all();
+		add_helpers(lock);
+	    }
+
+	    while (not (error_ or slot(consumed_).state == State::Filtered
+			or (done_ and consumed_ == read_)))
+		if (not step(lock, own_))
+		    cv_.wait(lock);
+	    if (error_)
+		std::rethrow_exception(error_);
+	    if (slot(consumed_).state != State::Filtered)
+		return std::char_traits<char>::eof();
+
+	    auto& s = slot(consumed_);
+	    held_ = true;
+	    this->setg(s.area.begin(), s.area.begin(), s.area.begin() + s.size);
+	}
+	return std::char_traits<char>::to_int_type(*this->gptr());
+    }
+
+private:
+    enum class State { Empty, Read, Filtered };
+
+    struct Slot {
+	Slot(size_t n) : area(n) { }
+	core::BufferedArea area;
+	size_t size{0};
+	State state{State::Empty};
+    };
+
+    Slot& slot(size_t seq) { return slots_[seq % slots_.size()]; }
+
+    // Return true if the next chunk may be read or a chunk read may be
+    // filtered; `mutex_` is held.
+    bool claimable() {
+	return filtered_ < read_
+	    or (not reading_ and not done_ and slot(read_).state == State::Empty);
+    }
+
+    // Read the next chunk into its slot, if it is free, or else filter
+    // the next chunk read, if any, with `filter`. Return false if there
+    // was nothing to do. `lock` holds `mutex_` on entry and on return.
+    bool step(std::unique_lock<std::mutex>& lock, Filter& filter) {
+	if (not reading_ and not done_ and slot(read_).state == State::Empty) {
+	    auto seq = read_;
+	    auto& s = slot(seq);
+	    reading_ = true;
+	    lock.unlock();
+
+	    bool eof{true};
+	    std::exception_ptr error;
+	    try {
+		eof = read(s);
+	    } catch (...) {
+		error = std::current_exception();
+	    }
+
+	    lock.lock();
+	    reading_ = false;
+	    if (error) {
+		if (not error_)
+		    error_ = error;
+	    } else {
+		s.state = State::Read;
+		++read_;
+	    }
+	    done_ = eof;
+	    if (seq == 0 and not eof and not error)
+		helped_ = true;
+	    cv_.notify_all();
+	    add_helpers(lock);
+	    return true;
+	}
+
+	if (filtered_ < read_) {
+	    auto& s = slot(filtered_++);
+	    lock.unlock();
+
+	    std::exception_ptr error;
+	    try {
+		auto [out, ptr] = filter_lines(filter, s.area.begin(), s.area.begin() + s.size, true);
+		s.size = out - s.area.begin();
+	    } catch (...) {
+		error = std::current_exception();
+	    }
+
+	    lock.lock();
+	    if (error and not error_)
+		error_ = error;
+	    s.state = State::Filtered;
+	    cv_.notify_all();
+	    return true;
+	}
+	return false;
+    }
+
+    // Read the source into `s`, ending at the last '\n' read and
+    // carrying the partial line to the next chunk. Return true at the
+    // end of the source.
+    bool read(Slot& s) {
+	if (s.area.capacity() < std::max(chunk_, 2 * carry_.size()))
+	    s.area = core::BufferedArea(std::max(chunk_, 2 * carry_.size()));
+	memcpy(s.area.begin(), carry_.data(), carry_.size());
+	size_t size = carry_.size(), end{0};
+	bool eof{false};
+	while (true) {
+	    // A short read marks the end of the input, as for
+	    // `filter_streambuf`.
+	    auto requested = s.area.capacity() - size;
+	    auto count = zstd::InStreamAdapter<Source>::read(sin_, s.area.begin() + size, requested);
+	    eof = count < requested;
+	    size += count;
+
+	    auto pos = std::string_view{s.area.begin(), size}.rfind('\n');
+	    end = eof ? size : pos + 1;
+	    if (eof or pos != std::string_view::npos)
+		break;
+
+	    core::BufferedArea larger(2 * s.area.capacity());
+	    memcpy(larger.begin(), s.area.begin(), size);
+	    s.area = std::move(larger);
+	}
+	carry_.assign(s.area.begin() + end, size - end);
+	s.size = end;
+	return eof;
+    }
+
+    // Read and filter chunks with a copy of the filter until there is
+    // nothing to do, then return to the pool.
+    void work() {
+	auto filter = filter_;
+	std::unique_lock lock(mutex_);
+	while (not stop_ and not error_ and step(lock, filter));
+	--helping_;
+    }
+
+    // Queue workers so that up to `threads_` read and filter chunks,
+    // once the first chunk has been read. `lock` holds `mutex_` on
+    // entry and on return but not while queueing, in case the pool
+    // runs the workers inline.
+    void add_helpers(std::unique_lock<std::mutex>& lock) {
+	if (not helped_ or stop_ or error_ or helping_ >= threads_ or not claimable())
+	    return;
+	auto n = threads_ - helping_;
+	helping_ += n;
+	lock.unlock();
+	for (size_t i = 0; i < n; ++i)
+	    helpers_.run([this]() { work(); });
+	lock.lock();
+    }
+
+    Source sin_;
+    Filter filter_, own_;
+    size_t chunk_, threads_;
+    std::vector<Slot> slots_;
+
+    // The partial line at the end of the last chunk read, owned by the
+    // thread reading.
+    std::string carry_;
+
+    // The sequence numbers of the next slot to read, filter and
+    // consume, guarded by `mutex_` with the slot states.
+    size_t read_{0}, filtered_{0}, consumed_{0}, helping_{0};
+    bool held_{false}, reading_{false}, done_{false}, stop_{false}, helped_{false};
+    std::exception_ptr error_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    // Last, so that the workers are done before the rest is destroyed.
+    codec::TaskGroup helpers_;
+};
+
+template<class Filter, class Source = std::istream&>
+class parallel_filter_istream : public std::istream {
+public:
+    parallel_filter_istream(std::add_rvalue_reference_t<Source> sin, Filter filter,
+			    const ParallelFilterOptions& options = {})
+	: std::istream(new parallel_filter_streambuf<Filter, Source>
+		       (std::forward<Source>(sin), std::move(filter), options))
+    { }
+
+    ~parallel_filter_istream() {
+	delete this->rdbuf();
+    }
+};
+
+template<class S, class F> parallel_filter_istream(S&&, F) -> parallel_filter_istream<F, S>;
+template<class S, class F> parallel_filter_istream(S&&, F, const ParallelFilterOptions&)
+    -> parallel_filter_istream<F, S>;
+
+}; // ns core
@@ -0,0 +1,75 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <string>
+#include <type_traits>
+#include "core/codec/raw/get_area.h"
+
+namespace raw
+{
+
+// Read uncompressed bytes from a `Source` through the same interface
+// as `zstd::Decompressor` and `bzip::Decompressor` so that plain data
+// can flow through code written for the decompressors.
+//
+// The `Source` object must either have a `read` method with the
+// signature read(char* data, size_t count), e.g. std::istream, or
+// implement a specialization of `zstd::InStreamAdapter`.
+//
+template<class Source>
+class Decompressor {
+public:
+    // Construct a reader for stream `is` using a buffer of size `n`
+    // (defaults to 64k) allocated from `alloc`.
+    explicit Decompressor(std::add_rvalue_reference_t<Source> is, size_t n = 0,
+			  core::Allocator *alloc = nullptr);
+
+    // Return a reference to the underlying stream.
+    Source& stream() { return is_; }
+
+    // Stop reading from the underlying stream.
+    void close() { closed_ = true; }
+
+    // Attempt to read the next line. Return `true` if a (possibly
+    // empty) line was read and place the characters in `line`. If
+    // there are no more characters to be read, return `false` and
+    // set `line` to nil.
+    bool read_line(std::string& line);
+
+    // Attempt to read up to `count` bytes placing them into
+    // buffer. Return the number of bytes read.
+    size_t read_bytes(char *buffer, size_t count);
+
+    // Attempt to read bytes representing the pod type T into
+    // `value`. Return `true` if the value is successfully read;
+    // otherwise, return `false`.
+    template<class T>
+    bool read_pod(T& value) { return read_bytes((char*)&value, sizeof(T)) == sizeof(T); }
+
+    // Attempt to read the next chunk of characters into the get area
+    // (discarding any existing characters). Return `true` if
+    // characters are successfully read, `false` otherwise.
+    bool underflow();
+
+    // Return a view of the current get area, i.e. the characters that
+    // are ready to be read.
+    std::string_view view() const { return get_.view(); }
+
+    // Return a reference to the get area.
+    GetArea& get() { return get_; }
+
+    // Return a reference to the get area.
+    const GetArea& get() const { return get_; }
+
+private:
+    Source is_;
+    GetArea get_;
+    bool closed_{false};
+};
+
+template<class S> explicit Decompressor(S&&) -> Decompressor<S>;
+template<class S> explicit Decompressor(S&&, size_t) -> Decompressor<S>;
+template<class S> explicit Decompressor(S&&, size_t, core::Allocator*) -> Decompressor<S>;
+
+}; // raw
@@ -0,0 +1,28 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include "core/codec/util/get_area.h"
+
+namespace raw
+{
+
+// Encapsulate uncompressed input read directly into the buffer (see
+// core::GetArea for the interface).
+//
+class GetArea : public core::GetArea {
+public:
+    // Create an area of the given `capacity` using memory from
+    // `alloc`.
+    GetArea(size_t capacity, core::Allocator *alloc = nullptr)
+	: core::GetArea(capacity, alloc) {
+    }
+
+    // Update the get area with `count` bytes read into the buffer.
+    void update(size_t count) {
+	ptr_ = begin();
+	end_ = ptr_ + count;
+    }
+};
+
+}; // raw
@@ -0,0 +1,78 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace shuffle
+{
+
+// Transform arrays of fixed size elements, e.g. doubles or integers,
+// so that they compress better, as the filters of Blosc. The bytes
+// (or bits) of the same significance in successive elements, which
+// usually vary slowly, are gathered into planes, optionally after
+// replacing each element by its difference with the previous one.
+//
+// The input is transformed in independent blocks. A final partial
+// element, or with `Shuffle::Bit` the final elements short of a
+// multiple of eight, are copied as is.
+//
+// std::string out(in.size(), '\0');
+// shuffle::encode(in.data(), in.size(), out.data(), sizeof(double), {});
+//
+
+// The transform gathering the bytes or bits of the elements.
+enum class Shuffle : uint8_t {
+    None,
+    Byte, // The i-th bytes of the elements, for each i.
+    Bit   // The i-th bits of the elements, for each i.
+};
+
+// The transform of the elements before shuffling.
+enum class Delta : uint8_t {
+    None,
+    Sub, // The difference with the previous element, wrapping around.
+    Xor  // The exclusive or with the previous element.
+};
+
+struct Options {
+    Shuffle shuffle{Shuffle::Byte};
+    Delta delta{Delta::None};
+
+    // The size of the blocks in bytes, rounded down to a multiple of
+    // eight elements.
+    size_t block{size_t{1} << 16};
+
+    // Return the options suited to slowly varying integer series,
+    // e.g. timestamps.
+    static Options time_series() { return {Shuffle::Byte, Delta::Sub}; }
+};
+
+// The transform applied to an array as recorded by `write_header`.
+struct Header {
+    size_t typesize{1};
+    Options options{};
+};
+
+// The size of the header, a zstd skippable frame ignored by plain
+// zstd decompression.
+inline constexpr size_t HeaderSize = 20;
+
+// Write `header` to the `HeaderSize` bytes at `out`.
+void write_header(const Header& header, char *out);
+
+// Return the header at the start of `in`, if any.
+std::optional<Header> read_header(std::string_view in);
+
+// Transform the `n` bytes at `in`, elements of `typesize` bytes, into
+// the `n` bytes at `out` which may be `in` but may not otherwise
+// overlap it.
+void encode(const char *in, size_t n, char *out, size_t typesize, const Options& options = {});
+
+// Reverse `encode` with the same `typesize` and `options`.
+void decode(const char *in, size_t n, char *out, size_t typesize, const Options& options = {});
+
+}; // shuffle
@@ -0,0 +1,55 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <cstddef>
+#include "core/codec/base64/kernels.h"
+
+namespace shuffle
+{
+
+// The kernels that do the bulk of the work of `shuffle::encode` and
+// `shuffle::decode`, selected at runtime as for base64 (see
+// base64/kernels.h). The vector kernels handle the common element
+// sizes of four and eight bytes and defer to the scalar kernels
+// otherwise.
+//
+
+using base64::Isa;
+using base64::Isas;
+using base64::name;
+
+// Return true if the kernels for `isa` were compiled in and can run
+// on this cpu.
+bool supported(Isa isa);
+
+// Return the most capable supported instruction set.
+Isa best_isa();
+
+struct Kernels {
+    Isa isa;
+
+    // Transpose the `n` elements of `typesize` bytes at `in` into the
+    // `typesize` planes of `n` bytes at `out`.
+    void (*shuffle)(const char *in, size_t n, char *out, size_t typesize);
+
+    // Reverse `shuffle`.
+    void (*unshuffle)(const char *in, size_t n, char *out, size_t typesize);
+
+    // Transpose the `n` bytes at `in`, a multiple of eight, into the
+    // eight planes of `n/8` bytes at `out` holding the bits of each
+    // significance, least first.
+    void (*bit_transpose)(const char *in, size_t n, char *out);
+
+    // Reverse `bit_transpose`.
+    void (*bit_untranspose)(const char *in, size_t n, char *out);
+};
+
+// Return the kernels for `isa` or throw std::runtime_error if it is
+// not supported.
+const Kernels& kernels(Isa isa);
+
+// Return the kernels for `best_isa()`.
+const Kernels& kernels();
+
+}; // shuffle
@@ -0,0 +1,53 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <cstddef>
+
+namespace core
+{
+
+// Provide a pluggable source of raw memory for the codec engines
+// (ZSTD contexts, bzip2 streams) and their buffers.
+//
+// The interface mirrors the ZSTD and bzip2 allocation hooks which
+// do not report the size of the block being freed, so
+// implementations must recover it themselves.
+//
+class Allocator {
+public:
+    virtual ~Allocator() = default;
+
+    // Return a pointer to at least `n` bytes suitably aligned for
+    // any fundamental type. The memory is not initialized.
+    virtual void *allocate(size_t n) = 0;
+
+    // Return the block at `ptr` which must have been obtained from
+    // `allocate` on this allocator (possibly on another thread).
+    virtual void deallocate(void *ptr) = 0;
+};
+
+// Return the allocator that forwards to `malloc` and `free`.
+Allocator& malloc_allocator();
+
+// Return the arena allocator. Freed blocks are cached in per-thread,
+// power-of-two size classes so that repeatedly creating and
+// destroying streams on a thread is served without touching the
+// global allocator. Blocks may be freed on any thread.
+Allocator& arena_allocator();
+
+// Return the process-wide pool backed by 2MB huge pages (falling
+// back to transparent huge pages, or to regular pages where neither
+// is available). Memory is carved into size classes and recycled,
+// never returned to the operating system.
+Allocator& huge_page_allocator();
+
+// Return the allocator used when none is explicitly given
+// (initially `malloc_allocator()`).
+Allocator& default_allocator();
+
+// Set the allocator used when none is explicitly given. The
+// allocator must outlive every object created while it is set.
+void set_default_allocator(Allocator& alloc);
+
+}; // core
@@ -0,0 +1,142 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace core::codec
+{
+
+// Identify a block of decompressed data: the file it was read from
+// (see `BlockCache::file_id`) and the offset of the compressed frame
+// or block within the file.
+struct BlockKey {
+    uint64_t file{0};
+    uint64_t offset{0};
+
+    bool operator==(const BlockKey&) const = default;
+};
+
+// The counters of a `BlockCache`.
+struct BlockCacheStats {
+    uint64_t hits{0};		// Lookups served from the cache
+    uint64_t waits{0};		// Part of hits that waited for another reader's load
+    uint64_t misses{0};		// Lookups that loaded the block
+    uint64_t evictions{0};	// Blocks evicted to stay within the capacity
+    uint64_t bytes{0};		// Bytes of the cached blocks
+    uint64_t blocks{0};		// Number of cached blocks
+    uint64_t capacity{0};	// Byte budget of the cache
+
+    // Return the fraction of lookups served from the cache.
+    double hit_rate() const {
+	auto n = hits + misses;
+	return n > 0 ? double(hits) / n : 0.0;
+    }
+};
+
+// Cache decompressed blocks shared by all the readers of a process
+// so hot data is decompressed once, e.g. the frames of a file opened
+// by several `zstd::FrameFile` readers.
+//
+// Blocks are immutable and handed out as shared pointers, so an
+// evicted block stays valid for the readers holding it. The cache
+// keeps the blocks within a byte budget evicting the least recently
+// used. Loads run outside the lock and concurrent lookups of a block
+// being loaded wait for that load rather than repeating it.
+//
+// auto& cache = core::codec::BlockCache::global();
+// auto block = cache.get({id, offset}, [&]() { return decompress_frame(offset); });
+//
+class BlockCache {
+public:
+    using Block = std::shared_ptr<const std::string>;
+
+    // The byte budget of the global cache.
+    static constexpr size_t DefaultCapacity = size_t{256} << 20;
+
+    // Construct a cache holding up to `capacity` bytes of blocks.
+    explicit BlockCache(size_t capacity = DefaultCapacity);
+
+    BlockCache(const BlockCache&) = delete;
+    BlockCache& operator=(const BlockCache&) = delete;
+
+    // Return the process-wide cache.
+    static BlockCache& global();
+
+    // Return an identifier of the file at `path` derived from its
+    // device, inode, size and modification time so a rewritten file
+    // does not hit the blocks of its previous contents. Throw
+    // std::runtime_error if the file cannot be examined.
+    static uint64_t file_id(const std::string& path);
+
+    // Return the block `key` if it is cached, or nullptr.
+    Block find(const BlockKey& key);
+
+    // Return the block `key` calling `load` to produce it if it is
+    // not cached. An exception thrown by `load` propagates to the
+    // callers waiting on the load and nothing is cached.
+    Block get(const BlockKey& key, const std::function<std::string()>& load);
+
+    // Cache `data` as the block `key` unless it is already cached,
+    // and return the cached block.
+    Block insert(const BlockKey& key, std::string data);
+
+    // Drop the cached blocks of `file`.
+    void erase(uint64_t file);
+
+    // Drop all the cached blocks.
+    void clear();
+
+    // Return the byte budget.
+    size_t capacity() const;
+
+    // Change the byte budget evicting blocks as necessary.
+    void set_capacity(size_t capacity);
+
+    // Return the counters and the current size.
+    BlockCacheStats stats() const;
+
+    // Zero the hit, wait, miss and eviction counters.
+    void reset_stats();
+
+private:
+    struct Hash {
+	size_t operator()(const BlockKey& key) const {
+	    return std::hash<uint64_t>{}(key.file * 0x9e3779b97f4a7c15ull ^ key.offset);
+	}
+    };
+
+    struct Entry {
+	BlockKey key;
+	Block data;
+    };
+    using Lru = std::list<Entry>;
+
+    // Return the cached block `key` (most recent first), or nullptr;
+    // `mutex_` must be held.
+    Block lookup(const BlockKey& key);
+
+    // Cache `data` as block `key` and evict blocks down to the
+    // capacity; `mutex_` must be held.
+    Block store(const BlockKey& key, Block data);
+
+    // Evict blocks until the size is within the capacity; `mutex_`
+    // must be held.
+    void evict();
+
+    mutable std::mutex mutex_;
+    Lru lru_;
+    std::unordered_map<BlockKey, Lru::iterator, Hash> index_;
+    std::unordered_map<BlockKey, std::shared_future<Block>, Hash> loading_;
+    size_t capacity_, bytes_{0};
+    uint64_t hits_{0}, waits_{0}, misses_{0}, evictions_{0};
+};
+
+}; // core::codec
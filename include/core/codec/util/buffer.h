@@ -5,6 +5,8 @@
 #include <utility>
 #include <cstdint>
 #include <algorithm>
+#include <memory>
+#include "core/codec/util/allocator.h"
 
 namespace core
 {
@@ -13,16 +15,26 @@ namespace core
 //
 class BufferedArea {
  public:
-    // Construct a character buffer of the given `capacity`.
-    BufferedArea(size_t capacity)
+    // Construct a character buffer of the given `capacity` obtained
+    // from `alloc` (defaults to `core::default_allocator()`). The
+    // buffer is not initialized.
+    BufferedArea(size_t capacity, Allocator *alloc = nullptr)
 	: capacity_(capacity)
-	, block_(std::make_unique<char[]>(capacity_))
-    { }
+	, block_(nullptr, Deleter{alloc ? alloc : &default_allocator()}) {
+	block_.reset(static_cast<char*>(block_.get_deleter().alloc->allocate(capacity_)));
+    }
 
     // Move from another buffer.
-    BufferedArea(BufferedArea&& other) noexcept {
-	std::swap(capacity_, other.capacity_);
-	std::swap(block_, other.block_);
+    BufferedArea(BufferedArea&& other) noexcept
+	: capacity_(std::exchange(other.capacity_, 0))
+	, block_(std::move(other.block_)) {
+    }
+
+    // Move assign from another buffer.
+    BufferedArea& operator=(BufferedArea&& other) noexcept {
+	capacity_ = std::exchange(other.capacity_, 0);
+	block_ = std::move(other.block_);
+	return *this;
     }
 
     // Return a pointer to the start of the buffer.
@@ -33,10 +45,18 @@ class BufferedArea {
 
     // Return the size of buffer.
     size_t capacity() const { return capacity_; }
-    
+
+    // Return the allocator that owns the buffer.
+    Allocator *allocator() const { return block_.get_deleter().alloc; }
+
  private:
+    struct Deleter {
+	Allocator *alloc;
+	void operator()(char *ptr) const { alloc->deallocate(ptr); }
+    };
+
     size_t capacity_;
-    std::unique_ptr<char[]> block_;
+    std::unique_ptr<char[], Deleter> block_;
 };
 
 
@@ -0,0 +1,39 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <cstddef>
+
+namespace core::codec
+{
+
+// The type-erased sink of a codec chain. A `ByteSink&` satisfies the
+// `zstd::OutStreamAdapter` model (`write` and `close`) so it can be
+// the `Sink` of any compressor.
+//
+class ByteSink {
+public:
+    virtual ~ByteSink() = default;
+
+    // Write the `count` bytes at `ptr`.
+    virtual void write(const char *ptr, size_t count) = 0;
+
+    // Flush any buffered bytes, write any trailer and close the rest
+    // of the chain.
+    virtual void close() = 0;
+};
+
+// The type-erased source of a codec chain. A `ByteSource&` satisfies
+// the `zstd::InStreamAdapter` model (`read_bytes`) so it can be the
+// `Source` of any decompressor.
+//
+class ByteSource {
+public:
+    virtual ~ByteSource() = default;
+
+    // Read up to `count` bytes into `ptr` returning the number of
+    // bytes read or zero at the end of the source.
+    virtual size_t read_bytes(char *ptr, size_t count) = 0;
+};
+
+}; // core::codec
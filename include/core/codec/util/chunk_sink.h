@@ -0,0 +1,121 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/uio.h>
+#include "core/codec/util/allocator.h"
+
+namespace core::codec
+{
+
+// Collect output of unknown size as a list of fixed-size blocks
+// instead of one contiguous, repeatedly reallocated string, so that
+// the bytes are copied once on the way in and at most once on the
+// way out.
+//
+// The blocks come from `alloc` (defaults to `core::arena_allocator()`
+// whose per-thread size classes recycle them across sinks). A
+// `ChunkSink&` satisfies the `zstd::OutStreamAdapter` model (`write`
+// and `close`) so it can be the `Sink` of any compressor. Producers
+// that can write in place, e.g. a decompressor, fill the area
+// returned by `prepare` and `commit` it.
+//
+class ChunkSink {
+public:
+    static constexpr size_t DefaultBlockSize = size_t{256} << 10;
+
+    // Construct an empty sink of blocks of `block_size` bytes
+    // allocated from `alloc`. Throw std::invalid_argument if
+    // `block_size` is zero.
+    explicit ChunkSink(size_t block_size = DefaultBlockSize, core::Allocator *alloc = nullptr);
+
+    ChunkSink(ChunkSink&& other);
+    ChunkSink& operator=(ChunkSink&& other);
+    ~ChunkSink();
+
+    // Append the `count` bytes at `ptr`.
+    void write(const char *ptr, size_t count);
+
+    // Append the bytes of `str`.
+    void write(std::string_view str) { write(str.data(), str.size()); }
+
+    // Nothing is buffered, so closing is a no-op. It makes the sink
+    // usable as the end of a codec chain.
+    void close() { }
+
+    // Return the writable area at the end of the sink, allocating a
+    // block if the last one is full. The area is at least one byte and
+    // at most a block.
+    std::span<char> prepare();
+
+    // Append the first `n` bytes of the area returned by `prepare`.
+    void commit(size_t n);
+
+    // Return the number of bytes in the sink.
+    size_t size() const { return size_; }
+
+    // Return true if the sink holds no bytes.
+    bool empty() const { return size_ == 0; }
+
+    // Return the size of the blocks.
+    size_t block_size() const { return block_size_; }
+
+    // Return the number of blocks, the last of which may be partly
+    // filled.
+    size_t blocks() const { return blocks_.size(); }
+
+    // Return the bytes of block `k`, valid until the sink is modified.
+    std::string_view block(size_t k) const;
+
+    // Return the blocks as an iovec array for `writev`, valid until
+    // the sink is modified.
+    std::vector<iovec> iovecs() const;
+
+    // Call `f(std::string_view)` with the bytes of each block in order.
+    template<class F>
+    void for_each(F&& f) const {
+	for (size_t k = 0; k < blocks(); ++k)
+	    f(block(k));
+    }
+
+    // Copy `count` bytes starting at byte `pos` of the sink into `out`.
+    // Throw std::out_of_range if they are not all in the sink.
+    void copy(size_t pos, char *out, size_t count) const;
+
+    // Write the bytes to the file descriptor `fd`, gathering the blocks
+    // in as few `writev` calls as the system allows (one for up to
+    // IOV_MAX blocks) and retrying partial writes. Throw
+    // std::system_error on failure.
+    void write_to(int fd) const;
+
+    // Return the bytes as one string.
+    std::string str() const;
+
+    // Return the bytes as one string, releasing each block as soon as
+    // it has been copied. The string is reserved, not filled, up front,
+    // so the peak is the blocks plus the string's reservation, of which
+    // only the part copied so far is touched. The sink is empty
+    // afterwards.
+    std::string take();
+
+    // Release the blocks.
+    void clear();
+
+private:
+    char *allocate();
+
+    size_t block_size_;
+    core::Allocator *alloc_;
+    std::vector<char*> blocks_;
+    size_t size_{0};
+
+    // The bytes used in the last block.
+    size_t last_{0};
+};
+
+}; // core::codec
@@ -12,10 +12,10 @@ namespace core
 //
 class GetArea : public core::BufferedArea {
 public:
-    // Allocate a buffer of `capacity` bytes, set `begin` to the
-    // start of the buffer and `count` to the capacity.
-    GetArea(unsigned int capacity)
-	: BufferedArea(capacity)
+    // Allocate a buffer of `capacity` bytes from `alloc`, set `begin`
+    // to the start of the buffer and `count` to the capacity.
+    GetArea(unsigned int capacity, Allocator *alloc = nullptr)
+	: BufferedArea(capacity, alloc)
 	, ptr_(nullptr)
 	, end_(nullptr) {
     }
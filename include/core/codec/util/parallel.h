@@ -0,0 +1,66 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include "core/codec/util/thread_pool.h"
+
+namespace core::codec
+{
+
+// Return the number of hardware threads, or one if unknown.
+inline size_t hardware_threads() {
+    auto n = std::thread::hardware_concurrency();
+    return n > 0 ? n : 1;
+}
+
+// Invoke `f(i)` for each `i` in [0, `n`) on up to `threads` threads
+// (defaults to `hardware_threads()`), the calling thread and workers
+// of `ThreadPool::global()`, each taking the next index as it becomes
+// free. Return once every invocation has finished, rethrowing the
+// first exception thrown, if any. A single index, or a single thread,
+// runs on the calling thread only.
+template<class F>
+void parallel_for(size_t n, size_t threads, F&& f) {
+    if (threads == 0)
+	threads = hardware_threads();
+    threads = std::min(threads, n);
+    if (threads <= 1) {
+	for (size_t i = 0; i < n; ++i)
+	    f(i);
+	return;
+    }
+
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    std::mutex mutex;
+    auto work = [&]() {
+	for (size_t i = next++; i < n; i = next++) {
+	    try {
+		f(i);
+	    } catch (...) {
+		std::lock_guard lock(mutex);
+		if (not error)
+		    error = std::current_exception();
+	    }
+	}
+    };
+
+    // The helpers still queued once the calling thread has claimed
+    // every index are dropped.
+    TaskGroup helpers;
+    for (size_t i = 1; i < threads; ++i)
+	helpers.run(work);
+    work();
+    helpers.close();
+
+    if (error)
+	std::rethrow_exception(error);
+}
+
+}; // core::codec
@@ -0,0 +1,89 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <memory>
+#include <string>
+#include <string_view>
+#include "core/codec/base64/decoder.h"
+#include "core/codec/util/byte_io.h"
+#include "core/codec/zstd/adapter.h"
+
+namespace core
+{
+
+// Provide a type-erased byte source that can look at the leading
+// bytes of an underlying source without consuming them and can
+// optionally decode the underlying bytes as (line wrapped) base64.
+//
+// The underlying source is read through `zstd::InStreamAdapter` so
+// any stream or queue accepted by the decompressors is accepted
+// here. Engines read from a `PeekSource` through `read_bytes`; the
+// peeked bytes are replayed before any further reads.
+//
+class PeekSource {
+public:
+    // Construct a peek source reading from `source` which must
+    // outlive this object.
+    template<class Source>
+    explicit PeekSource(Source& source)
+	: source_(&source)
+	, read_(&read_from<Source>) {
+    }
+
+    PeekSource(const PeekSource&) = delete;
+    PeekSource& operator=(const PeekSource&) = delete;
+
+    // Return a view of up to the first `n` unconsumed bytes reading
+    // from the underlying source as necessary. Fewer than `n` bytes
+    // are returned only at the end of the source.
+    std::string_view peek(size_t n);
+
+    // Interpret all unconsumed bytes, including any already peeked,
+    // as base64 and deliver the decoded bytes from now on.
+    void decode_base64();
+
+    // Return true if the bytes are being decoded as base64.
+    bool base64() const { return decoder_ != nullptr; }
+
+    // Read up to `count` bytes into `ptr` returning the number of
+    // bytes read or zero at the end of the source.
+    size_t read_bytes(char *ptr, size_t count);
+
+private:
+    template<class Source>
+    static size_t read_from(void *source, char *ptr, size_t count) {
+	return zstd::InStreamAdapter<Source>::read(*static_cast<Source*>(source), ptr, count);
+    }
+
+    // The undecoded bytes as the source of the base64 decoder.
+    class RawSource : public codec::ByteSource {
+    public:
+	explicit RawSource(PeekSource& peek)
+	    : peek_(peek) {
+	}
+
+	size_t read_bytes(char *ptr, size_t count) override {
+	    return peek_.read_raw(ptr, count);
+	}
+
+    private:
+	PeekSource& peek_;
+    };
+
+    // Read up to `count` undecoded bytes.
+    size_t read_raw(char *ptr, size_t count);
+
+    // Append the next decoded bytes to `pending_` returning false at
+    // the end of the source.
+    bool decode_more();
+
+    void *source_;
+    size_t (*read_)(void*, char*, size_t);
+    std::string raw_, pending_;
+    size_t raw_pos_{0}, pending_pos_{0};
+    RawSource raw_source_{*this};
+    std::unique_ptr<base64::Decoder<codec::ByteSource&>> decoder_;
+};
+
+}; // core
@@ -0,0 +1,151 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace core::codec
+{
+
+// Per-stream statistics collected by the `zstd` and `bzip`
+// compressors and decompressors when the library is built with
+// `CODEC_STATS` defined (cmake -DCODEC_STATS=ON). Otherwise the
+// collection code compiles away and the codecs do not provide a
+// `stats()` accessor.
+//
+// zstd::Compressor c{os};
+// ...
+// #ifdef CODEC_STATS
+// c.stats().visit([](const char *name, uint64_t value) { gauge(name, value); });
+// #endif
+//
+struct Stats {
+    uint64_t bytes_in{0};	// Bytes accepted (compress) or read from the source (decompress)
+    uint64_t bytes_out{0};	// Bytes written to the sink (compress) or produced (decompress)
+    uint64_t codec_calls{0};	// Calls into the codec, e.g. ZSTD_compressStream
+    uint64_t codec_ns{0};	// Time spent in the codec
+    uint64_t source_ns{0};	// Time spent reading from the source
+    uint64_t sink_ns{0};	// Time spent writing to the sink
+    uint64_t stall_ns{0};	// Part of source_ns and sink_ns spent blocked on a queue
+    uint64_t peak_memory{0};	// Peak bytes held by the codec state and buffers
+    uint64_t frames{0};		// Completed frames (zstd) or streams (bzip)
+    uint64_t frame_bytes{0};	// Uncompressed bytes in the current, incomplete frame
+    int64_t level{0};		// Compression level of the current frame (zstd compressors)
+    uint64_t level_changes{0};	// Changes of level made by the adaptive mode
+
+    // Call `f(name, value)` for each field, e.g. to export the
+    // statistics to a metrics system.
+    template<class F>
+    void visit(F&& f) const {
+	f("bytes_in", bytes_in);
+	f("bytes_out", bytes_out);
+	f("codec_calls", codec_calls);
+	f("codec_ns", codec_ns);
+	f("source_ns", source_ns);
+	f("sink_ns", sink_ns);
+	f("stall_ns", stall_ns);
+	f("peak_memory", peak_memory);
+	f("frames", frames);
+	f("frame_bytes", frame_bytes);
+	f("level", level);
+	f("level_changes", level_changes);
+    }
+
+    // Accumulate the statistics of `other`, e.g. across streams. The
+    // peak memory and level are the maximum of the two.
+    Stats& operator+=(const Stats& other) {
+	bytes_in += other.bytes_in;
+	bytes_out += other.bytes_out;
+	codec_calls += other.codec_calls;
+	codec_ns += other.codec_ns;
+	source_ns += other.source_ns;
+	sink_ns += other.sink_ns;
+	stall_ns += other.stall_ns;
+	peak_memory = std::max(peak_memory, other.peak_memory);
+	frames += other.frames;
+	frame_bytes += other.frame_bytes;
+	level = std::max(level, other.level);
+	level_changes += other.level_changes;
+	return *this;
+    }
+};
+
+#ifdef CODEC_STATS
+
+// Add the elapsed time of its lifetime to a `Stats` field and,
+// optionally, to a second field.
+class StatsTimer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    StatsTimer(uint64_t& ns, uint64_t *also = nullptr)
+	: ns_(ns)
+	, also_(also)
+	, start_(Clock::now()) {
+    }
+
+    StatsTimer(const StatsTimer&) = delete;
+
+    ~StatsTimer() {
+	auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_).count();
+	ns_ += ns;
+	if (also_)
+	    *also_ += ns;
+    }
+
+private:
+    uint64_t& ns_;
+    uint64_t *also_;
+    Clock::time_point start_;
+};
+
+// Collect `Stats` on behalf of a codec.
+class StatsRecorder {
+public:
+    const Stats& data() const { return stats_; }
+
+    StatsTimer time_codec() { ++stats_.codec_calls; return {stats_.codec_ns}; }
+    StatsTimer time_source(bool queue) { return {stats_.source_ns, queue ? &stats_.stall_ns : nullptr}; }
+    StatsTimer time_sink(bool queue) { return {stats_.sink_ns, queue ? &stats_.stall_ns : nullptr}; }
+
+    void add_in(uint64_t n) { stats_.bytes_in += n; }
+    void add_out(uint64_t n) { stats_.bytes_out += n; }
+    void add_frame_bytes(uint64_t n) { stats_.frame_bytes += n; }
+    void end_frame() { ++stats_.frames; stats_.frame_bytes = 0; }
+    void level(int level, bool adapted) { stats_.level = level; stats_.level_changes += adapted; }
+
+    // Update the peak memory with the byte count returned by `bytes`.
+    template<class F>
+    void memory(F&& bytes) { stats_.peak_memory = std::max<uint64_t>(stats_.peak_memory, bytes()); }
+
+private:
+    Stats stats_;
+};
+
+#else
+
+// The no-op counterparts used when statistics are compiled out.
+struct StatsTimer {
+    ~StatsTimer() {}
+};
+
+struct StatsRecorder {
+    StatsTimer time_codec() { return {}; }
+    StatsTimer time_source(bool) { return {}; }
+    StatsTimer time_sink(bool) { return {}; }
+
+    void add_in(uint64_t) {}
+    void add_out(uint64_t) {}
+    void add_frame_bytes(uint64_t) {}
+    void end_frame() {}
+    void level(int, bool) {}
+
+    template<class F>
+    void memory(F&&) {}
+};
+
+#endif
+
+}; // core::codec
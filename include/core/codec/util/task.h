@@ -0,0 +1,190 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace core::codec
+{
+
+namespace detail {
+
+template<class T>
+struct TaskResult {
+    std::optional<T> value;
+
+    template<class U>
+    void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+
+    T take() { return std::move(*value); }
+};
+
+template<>
+struct TaskResult<void> {
+    void return_void() { }
+    void take() { }
+};
+
+}; // detail
+
+// The lazily started coroutine returned by the asynchronous codec
+// operations, e.g. `zstd::AsyncDecompressor::async_underflow`.
+//
+// A task runs when awaited, `co_await task` resuming the awaiting
+// coroutine with the value returned by the task, or rethrowing the
+// exception it threw, as soon as the task completes. A task may be
+// awaited from any coroutine type, e.g. that of an event loop, and
+// completes on the thread that resumed its last suspension.
+//
+template<class T = void>
+class Task {
+public:
+    struct promise_type : detail::TaskResult<T> {
+	std::coroutine_handle<> continuation{std::noop_coroutine()};
+	std::exception_ptr error;
+
+	Task get_return_object() {
+	    return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+	}
+
+	std::suspend_always initial_suspend() noexcept { return {}; }
+
+	// Resume the awaiting coroutine in place of the task.
+	struct Final {
+	    bool await_ready() noexcept { return false; }
+	    std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+		return h.promise().continuation;
+	    }
+	    void await_resume() noexcept { }
+	};
+	Final final_suspend() noexcept { return {}; }
+
+	void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    Task(Task&& other) noexcept
+	: handle_(std::exchange(other.handle_, nullptr)) {
+    }
+
+    Task& operator=(Task&& other) noexcept {
+	if (this != &other) {
+	    if (handle_)
+		handle_.destroy();
+	    handle_ = std::exchange(other.handle_, nullptr);
+	}
+	return *this;
+    }
+
+    ~Task() {
+	if (handle_)
+	    handle_.destroy();
+    }
+
+    // Return true if the task has run to completion.
+    bool done() const { return handle_ and handle_.done(); }
+
+    auto operator co_await() && noexcept {
+	struct Awaiter {
+	    std::coroutine_handle<promise_type> handle;
+
+	    bool await_ready() noexcept { return handle.done(); }
+
+	    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+		handle.promise().continuation = awaiting;
+		return handle;
+	    }
+
+	    T await_resume() {
+		if (handle.promise().error)
+		    std::rethrow_exception(handle.promise().error);
+		return handle.promise().take();
+	    }
+	};
+	return Awaiter{handle_};
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle)
+	: handle_(handle) {
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// An awaitable completing immediately with `value`, e.g. the result of
+// a synchronous read adapted to an asynchronous interface.
+template<class T = void>
+struct Ready {
+    T value;
+
+    bool await_ready() const noexcept { return true; }
+    void await_suspend(std::coroutine_handle<>) const noexcept { }
+    T await_resume() { return std::move(value); }
+};
+
+template<>
+struct Ready<void> {
+    bool await_ready() const noexcept { return true; }
+    void await_suspend(std::coroutine_handle<>) const noexcept { }
+    void await_resume() const noexcept { }
+};
+
+namespace detail {
+
+struct SyncTask {
+    struct promise_type {
+	SyncTask get_return_object() { return {}; }
+	std::suspend_never initial_suspend() noexcept { return {}; }
+	std::suspend_never final_suspend() noexcept { return {}; }
+	void return_void() { }
+	void unhandled_exception() { std::terminate(); }
+    };
+};
+
+struct SyncState {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done{false};
+    std::exception_ptr error;
+};
+
+template<class T>
+SyncTask sync_run(Task<T>& task, SyncState& state, TaskResult<T>& result) {
+    try {
+	if constexpr (std::is_void_v<T>)
+	    co_await std::move(task);
+	else
+	    result.return_value(co_await std::move(task));
+    } catch (...) {
+	state.error = std::current_exception();
+    }
+    std::lock_guard lock(state.mutex);
+    state.done = true;
+    state.cv.notify_all();
+}
+
+}; // detail
+
+// Run `task` and block the calling thread until it completes, e.g.
+// from code that is not a coroutine. Return its value or rethrow its
+// exception. The task must be resumed by another thread if it
+// suspends.
+template<class T>
+T sync_wait(Task<T> task) {
+    detail::SyncState state;
+    detail::TaskResult<T> result;
+    detail::sync_run(task, state, result);
+    std::unique_lock lock(state.mutex);
+    state.cv.wait(lock, [&]() { return state.done; });
+    if (state.error)
+	std::rethrow_exception(state.error);
+    return result.take();
+}
+
+}; // core::codec
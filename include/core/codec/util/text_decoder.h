@@ -0,0 +1,114 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <string>
+#include <type_traits>
+#include "core/codec/util/get_area.h"
+
+namespace core::codec
+{
+
+// Return true if `c` is white space skipped between the characters of
+// encoded text, i.e. a line break, space or tab.
+inline bool is_space(char c) {
+    return c == '\n' or c == '\r' or c == ' ' or c == '\t';
+}
+
+// Encapsulate the bytes decoded from text (see core::GetArea for the
+// interface).
+//
+class TextGetArea : public core::GetArea {
+public:
+    // Create an area of the given `capacity` using memory from
+    // `alloc`.
+    TextGetArea(size_t capacity, core::Allocator *alloc = nullptr)
+	: core::GetArea(capacity, alloc) {
+    }
+
+    // Update the get area with `count` bytes decoded into the buffer.
+    void update(size_t count) {
+	ptr_ = begin();
+	end_ = ptr_ + count;
+    }
+};
+
+// Read bytes from a `Source` encoded as text by `Codec`, e.g.
+// `base16::Codec`, which decodes quanta of `Codec::Chars` characters
+// as `Codec::Bytes` bytes.
+//
+// The `Source` object must either have a `read` method with the
+// signature read(char* data, size_t count), e.g. std::istream, or
+// implement a specialization of `zstd::InStreamAdapter`, i.e. the
+// same sources as `zstd::Decompressor`.
+//
+// Line breaks and other white space are skipped. Up to
+// `Codec::Chars - 1` characters of a partial quantum are carried
+// between reads of the source so the decoded bytes are identical to
+// decoding the whole input (with the white space removed). Invalid
+// input throws std::runtime_error.
+//
+template<class Codec, class Source>
+class TextDecoder {
+public:
+    using Options = typename Codec::Options;
+
+    // Construct a decoder with `options` that reads from stream `is`
+    // in chunks of `n` characters (defaults to 64k) using buffers
+    // allocated from `alloc` (defaults to `core::default_allocator()`).
+    explicit TextDecoder(std::add_rvalue_reference_t<Source> is, const Options& options = {},
+			 size_t n = 0, core::Allocator *alloc = nullptr);
+
+    // Move construct from other.
+    TextDecoder(TextDecoder&& other);
+
+    // Return a reference to the underlying stream.
+    Source& stream() { return is_; }
+
+    // Stop reading from the underlying stream.
+    void close() { closed_ = true; }
+
+    // Attempt to read the next decoded line. Return `true` if a
+    // (possibly empty) line was read and place the characters in
+    // `line`. If there are no more characters to be read, return
+    // `false` and set `line` to nil.
+    bool read_line(std::string& line);
+
+    // Attempt to read up to `count` decoded bytes placing them into
+    // buffer. Return the number of bytes read.
+    size_t read_bytes(char *buffer, size_t count);
+
+    // Attempt to read decoded bytes representing the pod type T into
+    // `value`. Return `true` if the value is successfully read;
+    // otherwise, return `false`.
+    template<class T>
+    bool read_pod(T& value) { return read_bytes((char*)&value, sizeof(T)) == sizeof(T); }
+
+    // Attempt to decode the next chunk of characters into the get
+    // area (discarding any existing bytes). Return `true` if bytes
+    // are successfully decoded, `false` otherwise.
+    bool underflow();
+
+    // Return a view of the current get area, i.e. the bytes that are
+    // ready to be read.
+    std::string_view view() const { return get_.view(); }
+
+    // Return a reference to the get area.
+    TextGetArea& get() { return get_; }
+
+    // Return a reference to the get area.
+    const TextGetArea& get() const { return get_; }
+
+private:
+    // Decode `in` into `out` returning the number of bytes.
+    size_t decode(std::string_view in, char *out);
+
+    Source is_;
+    Options options_;
+    core::BufferedArea put_;
+    TextGetArea get_;
+    size_t ncarry_{0};
+    bool closed_{false};
+};
+
+}; // core::codec
@@ -0,0 +1,91 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include "core/codec/util/buffer.h"
+
+namespace core::codec
+{
+
+// Write bytes to a `Sink` encoded as text by `Codec`, e.g.
+// `base16::Codec`, which encodes quanta of `Codec::Bytes` bytes as
+// `Codec::Chars` characters.
+//
+// The `Sink` object must either have a `write(const char *data,
+// size_t count)` method, e.g. std::ostream, or implement a
+// specialization of `zstd::OutStreamAdapter`, i.e. the same sinks as
+// `zstd::Compressor`.
+//
+// Up to `Codec::Bytes - 1` bytes are carried between calls to `write`
+// so only whole quanta are encoded until `close` encodes the final
+// quantum. The output is identical to encoding the concatenated
+// input at once.
+//
+// If `Codec` has a `line_length(options)` that is not zero, e.g.
+// `base64::Codec`, the output is broken into lines of that many
+// characters separated by '\n' (without a trailing '\n').
+//
+template<class Codec, class Sink>
+class TextEncoder {
+public:
+    using Options = typename Codec::Options;
+
+    // Construct an encoder writing to `os` with `options` and an
+    // output buffer of `n` characters (default 65536) allocated from
+    // `alloc` (defaults to `core::default_allocator()`). Throw
+    // std::runtime_error if the line length is not a multiple of
+    // `Codec::Chars`.
+    explicit TextEncoder(std::add_rvalue_reference_t<Sink> os, const Options& options = {},
+			 size_t n = 0, core::Allocator *alloc = nullptr);
+
+    // Move construct from other.
+    TextEncoder(TextEncoder&& other);
+
+    // Encode and write any remaining bytes unless already closed.
+    ~TextEncoder();
+
+    // Return a reference to the underlying stream.
+    Sink& stream() { return os_; }
+
+    // Return the options.
+    const Options& options() const { return options_; }
+
+    // Encode the final quantum, flush the output and finish the sink.
+    void close();
+
+    // Return the number of characters written to the sink.
+    size_t count() const { return count_; }
+
+    // Encode the data from `begin` up to `end`.
+    void write(const char *begin, const char *end);
+
+    // Encode the data from `begin` to `begin` + `count`.
+    void write(const char *begin, size_t count) { write(begin, begin + count); }
+
+    // Encode the raw bytes representing the pod-type `value`.
+    template<class T>
+    void write_pod(T& value) { write(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+private:
+    // Encode the `n` bytes at `in`, a multiple of `Codec::Bytes`.
+    void encode(const char *in, size_t n);
+
+    // Write the line break due before the next character, if any.
+    void line_break();
+
+    // Write the buffered characters to the sink.
+    void flush();
+
+    Sink os_;
+    Options options_;
+    size_t line_length_;
+    core::BufferedArea area_;
+    size_t size_{0}, column_{0}, count_{0};
+    char carry_[Codec::Bytes];
+    size_t ncarry_{0};
+    bool closed_{false};
+};
+
+}; // core::codec
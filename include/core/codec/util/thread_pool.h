@@ -0,0 +1,125 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace core::codec
+{
+
+// A fixed set of worker threads running the tasks submitted to it in
+// order, shared by the parallel and pipelined helpers of the library
+// (`parallel_for`, `parallel_filter_streambuf`, `grep::search`, ...)
+// so that they do not create threads per call.
+//
+// The workers are started by the first task. Helpers only hand the
+// pool work that their calling thread would otherwise do itself (see
+// `TaskGroup`), so they make progress on a pool that is busy or has
+// no workers at all, and may be nested.
+//
+class ThreadPool {
+public:
+    // Construct a pool of `threads` workers.
+    explicit ThreadPool(size_t threads);
+
+    // Run the tasks already submitted and join the workers.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Return the pool used by the library, of `hardware_threads()`
+    // workers unless resized.
+    static ThreadPool& global();
+
+    // Return the number of workers.
+    size_t size() const;
+
+    // Set the number of workers to `threads`, waiting for the workers
+    // removed to finish their current task. The tasks left in the queue
+    // of a pool resized to no workers are run by the calling thread.
+    // Must not be called from a task of this pool.
+    void resize(size_t threads);
+
+    // Queue `task` to run on a worker, or run it on the calling thread
+    // if the pool has no workers. An exception escaping `task`
+    // terminates the program.
+    void submit(std::function<void()> task);
+
+    // Queue `f` and return the future of its result.
+    template<class F>
+    auto async(F&& f) -> std::future<std::invoke_result_t<F>> {
+	using R = std::invoke_result_t<F>;
+	auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+	auto future = task->get_future();
+	submit([task]() { (*task)(); });
+	return future;
+    }
+
+private:
+    void start(size_t id);
+    void work(size_t id);
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> tasks_;
+    std::vector<std::thread> workers_;
+    size_t size_;
+    bool stop_{false};
+};
+
+// Hand helper tasks to a pool on behalf of a calling thread that does
+// the same work itself, e.g. claiming the next index of a loop.
+//
+// The tasks a worker has not started by the time the group is closed
+// are dropped without running, so a group only ever waits for tasks
+// already running and never for the pool to become free.
+//
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& pool = ThreadPool::global());
+
+    // Close the group, ignoring any exception of its tasks.
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    // Queue `task` unless the group is closed or the pool has no
+    // workers. May be called from any thread, e.g. by a task of the
+    // group queueing another.
+    void run(std::function<void()> task);
+
+    // Return the number of tasks queued by `run`.
+    size_t size() const { return count_; }
+
+    // Drop the tasks not yet started and wait for the running ones to
+    // finish. Rethrow the first exception thrown by a task, if any.
+    void close();
+
+private:
+    struct State {
+	std::mutex mutex;
+	std::condition_variable cv;
+	size_t running{0};
+	bool closed{false};
+	std::exception_ptr error;
+    };
+
+    ThreadPool& pool_;
+    std::shared_ptr<State> state_;
+    std::atomic<size_t> count_{0};
+};
+
+}; // core::codec
@@ -0,0 +1,14 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <string>
+#include <string_view>
+
+// Return `s` encoded as Z85 (ZeroMQ RFC 32), extended to any length
+// (see z85/codec.h).
+std::string z85_encode(std::string_view s);
+
+// Return the bytes decoded from the Z85 `s`. Throw std::runtime_error
+// if `s` is not valid Z85.
+std::string z85_decode(std::string_view s);
@@ -0,0 +1,75 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include "core/codec/base64/codec.h"
+
+namespace z85
+{
+
+// Encode and decode Z85 (ZeroMQ RFC 32) into caller provided buffers
+// without allocating or throwing. The string functions of `z85.h` are
+// thin wrappers over these.
+//
+// Each quantum of four bytes, as a big-endian 32-bit value, is
+// encoded as five base 85 digits. As an extension, a final quantum of
+// `k` < 4 bytes is encoded as `k + 1` digits (as in Ascii85), so any
+// input can be encoded and inputs that are a multiple of four bytes
+// are encoded exactly as specified.
+//
+// std::string out(z85::encoded_length(in.size()), '\0');
+// z85::encode_into(in, out);
+//
+
+// The same outcome as for base64.
+using base64::Status;
+using base64::Result;
+using base64::name;
+
+// Return the number of characters encoding `n` bytes.
+constexpr size_t encoded_length(size_t n) { return n / 4 * 5 + (n % 4 ? n % 4 + 1 : 0); }
+
+// Return the number of bytes decoded from `in`.
+constexpr size_t decoded_length(std::string_view in) {
+    return in.size() / 5 * 4 + (in.size() % 5 ? in.size() % 5 - 1 : 0);
+}
+
+// Return an upper bound on the number of bytes decoded from `n`
+// characters.
+constexpr size_t max_decoded_length(size_t n) { return (n + 4) / 5 * 4; }
+
+// Encode `in` into `out` which must hold at least
+// `encoded_length(in.size())` characters. Return the number of
+// characters written.
+Result encode_into(std::string_view in, std::span<char> out);
+
+// Decode `in` into `out` which must hold at least `decoded_length(in)`
+// bytes. A quantum encoding a value that does not fit in 32 bits is
+// reported as an invalid character. Return the number of bytes
+// written.
+Result decode_into(std::string_view in, std::span<char> out);
+
+// Return the result `decode_into` would return given a large enough
+// buffer without writing the decoded bytes anywhere.
+Result validate(std::string_view in);
+
+// The traits of Z85 for the streaming `Encoder` and `Decoder` (see
+// core::codec::TextEncoder).
+struct Codec {
+    struct Options { };
+    static constexpr const char *Name = "z85";
+    static constexpr size_t Bytes = 4, Chars = 5;
+
+    static Result encode(std::string_view in, std::span<char> out, const Options&) {
+	return encode_into(in, out);
+    }
+
+    static Result decode(std::string_view in, std::span<char> out, const Options&) {
+	return decode_into(in, out);
+    }
+};
+
+}; // z85
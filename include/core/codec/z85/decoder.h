@@ -0,0 +1,25 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include "core/codec/z85/codec.h"
+#include "core/codec/util/text_decoder.h"
+
+namespace z85
+{
+
+// Read bytes from a `Source` encoded as Z85 (see
+// core::codec::TextDecoder).
+//
+template<class Source>
+class Decoder : public core::codec::TextDecoder<Codec, Source> {
+public:
+    using core::codec::TextDecoder<Codec, Source>::TextDecoder;
+};
+
+template<class S> explicit Decoder(S&&) -> Decoder<S>;
+template<class S> explicit Decoder(S&&, const Codec::Options&) -> Decoder<S>;
+template<class S> explicit Decoder(S&&, const Codec::Options&, size_t) -> Decoder<S>;
+template<class S> explicit Decoder(S&&, const Codec::Options&, size_t, core::Allocator*) -> Decoder<S>;
+
+}; // z85
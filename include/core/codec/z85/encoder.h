@@ -0,0 +1,29 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include "core/codec/z85/codec.h"
+#include "core/codec/util/text_encoder.h"
+
+namespace z85
+{
+
+// Write bytes to a `Sink` encoded as Z85 (see
+// core::codec::TextEncoder).
+//
+// z85::Encoder e{std::cout};
+// e.write(data, size);
+// e.close();
+//
+template<class Sink>
+class Encoder : public core::codec::TextEncoder<Codec, Sink> {
+public:
+    using core::codec::TextEncoder<Codec, Sink>::TextEncoder;
+};
+
+template<class S> explicit Encoder(S&&) -> Encoder<S>;
+template<class S> explicit Encoder(S&&, const Codec::Options&) -> Encoder<S>;
+template<class S> explicit Encoder(S&&, const Codec::Options&, size_t) -> Encoder<S>;
+template<class S> explicit Encoder(S&&, const Codec::Options&, size_t, core::Allocator*) -> Encoder<S>;
+
+}; // z85
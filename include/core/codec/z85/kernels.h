@@ -0,0 +1,56 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <cstddef>
+#include "core/codec/base64/kernels.h"
+
+namespace z85
+{
+
+// The block kernels that do the bulk of the work of `z85_encode` and
+// `z85_decode`, selected at runtime as for base64 (see
+// base64/kernels.h).
+//
+
+using base64::Isa;
+using base64::Isas;
+using base64::name;
+
+// Return true if the kernels for `isa` were compiled in and can run
+// on this cpu.
+bool supported(Isa isa);
+
+// Return the most capable supported instruction set.
+Isa best_isa();
+
+struct Kernels {
+    Isa isa;
+
+    // Encode the `n` bytes at `in`, a multiple of four, as the `5n/4`
+    // characters at `out`.
+    void (*encode)(const unsigned char *in, size_t n, char *out);
+
+    // Decode the `n` characters at `in`, a multiple of five, as the
+    // `4n/5` bytes at `out`. Return the number of characters decoded
+    // which is less than `n` if the quantum at that offset contains a
+    // character outside the alphabet or encodes a value that does not
+    // fit in 32 bits.
+    size_t (*decode)(const char *in, size_t n, unsigned char *out);
+};
+
+// Return the kernels for `isa` or throw std::runtime_error if it is
+// not supported.
+const Kernels& kernels(Isa isa);
+
+// Return the kernels for `best_isa()`.
+const Kernels& kernels();
+
+// Return the 85 characters of the alphabet.
+const char *alphabet();
+
+// Return the value of character `c` or `Invalid`.
+inline constexpr unsigned char Invalid = 0xff;
+unsigned char value(char c);
+
+}; // z85
@@ -2,6 +2,7 @@
 //
 
 #pragma once
+#include <concepts>
 #include <cstddef>
 
 namespace zstd {
@@ -27,6 +28,19 @@ struct InStreamAdapter<T> {
     }
 };
 
+template<class T>
+concept ByteRead = requires(T a, char *p, std::size_t c) {
+    { a.read_bytes(p, c) } -> std::convertible_to<std::size_t>;
+};
+
+template<class T>
+requires ByteRead<T>
+struct InStreamAdapter<T> {
+    static std::size_t read(T& source, char *ptr, std::size_t count) {
+	return source.read_bytes(ptr, count);
+    }
+};
+
 template<class T>
 struct OutStreamAdapter {
     static void write(T& os, const char *ptr, std::size_t count) { os.write(ptr, count); }
@@ -0,0 +1,76 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace zstd
+{
+
+// Options for adapting the compression level to the sink (see
+// `Compressor::set_adaptive`).
+struct AdaptOptions {
+    // The bounds of the compression level.
+    int min_level{1};
+    int max_level{19};
+
+    // The number of uncompressed bytes per frame, i.e. how often the
+    // level is reconsidered.
+    size_t frame_size{size_t{1} << 20};
+};
+
+// A change of compression level taking effect at the start of `frame`.
+struct LevelChange {
+    uint64_t frame;
+    int level;
+};
+
+// Choose the compression level of the next frame from the time spent
+// compressing and the time spent writing to the sink during the last
+// frame, similar to `zstd --adapt`.
+//
+// When the sink is the bottleneck (it is slow or exerting
+// backpressure, i.e. blocking on a full queue) the level is raised
+// using the idle CPU to write fewer bytes. When compression is the
+// bottleneck the level is lowered so the compressor keeps up. The
+// level moves at most one step per frame.
+//
+class LevelAdapter {
+public:
+    // Construct an adapter for the bounds in `options` starting from
+    // `level` (clamped to the bounds).
+    LevelAdapter(const AdaptOptions& options, int level);
+
+    // Return the options.
+    const AdaptOptions& options() const { return options_; }
+
+    // Return the level of the current frame.
+    int level() const { return level_; }
+
+    // Return the number of completed frames.
+    uint64_t frames() const { return frames_; }
+
+    // Return the level of every frame at which the level changed
+    // starting with the initial level at frame 0.
+    const std::vector<LevelChange>& history() const { return history_; }
+
+    // Add `ns` nanoseconds to the time spent compressing.
+    void add_codec_time(uint64_t ns) { codec_ns_ += ns; }
+
+    // Add `ns` nanoseconds to the time spent writing to the sink.
+    void add_sink_time(uint64_t ns) { sink_ns_ += ns; }
+
+    // Complete the current frame and return the level of the next.
+    int end_frame();
+
+private:
+    AdaptOptions options_;
+    int level_;
+    uint64_t frames_{0};
+    uint64_t codec_ns_{0}, sink_ns_{0};
+    std::vector<LevelChange> history_;
+};
+
+}; // zstd
@@ -0,0 +1,259 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include "core/codec/util/chunk_sink.h"
+#include "core/codec/util/task.h"
+#include "core/codec/zstd/adapter.h"
+#include "core/codec/zstd/compressor.h"
+#include "core/codec/zstd/decompressor.h"
+
+namespace zstd
+{
+
+// A source with an `async_read(ptr, count)` method returning an
+// awaitable of the number of bytes read, fewer than `count` only at
+// the end of the source.
+template<class T>
+concept AsyncByteRead = requires(T a, char *p, std::size_t c) { a.async_read(p, c); };
+
+// A sink with an `async_write(ptr, count)` method returning an
+// awaitable completing once the bytes are written, and optionally an
+// `async_close()` method returning an awaitable.
+template<class T>
+concept AsyncByteWrite = requires(T a, const char *p, std::size_t c) { a.async_write(p, c); };
+
+// Adapt a `Source` to the asynchronous reads of `AsyncDecompressor`,
+// as `InStreamAdapter` does for `Decompressor`. A source without
+// `async_read` is read synchronously through `InStreamAdapter`, the
+// read completing immediately.
+template<class T>
+struct AsyncInStreamAdapter {
+    static core::codec::Ready<std::size_t> read(T& is, char *ptr, std::size_t count) {
+	return {InStreamAdapter<T>::read(is, ptr, count)};
+    }
+};
+
+template<class T>
+requires AsyncByteRead<T>
+struct AsyncInStreamAdapter<T> {
+    static auto read(T& source, char *ptr, std::size_t count) {
+	return source.async_read(ptr, count);
+    }
+};
+
+// Adapt a `Sink` to the asynchronous writes of `AsyncCompressor`, as
+// `OutStreamAdapter` does for `Compressor`. A sink without
+// `async_write` is written synchronously through `OutStreamAdapter`.
+template<class T>
+struct AsyncOutStreamAdapter {
+    static core::codec::Ready<> write(T& os, const char *ptr, std::size_t count) {
+	OutStreamAdapter<T>::write(os, ptr, count);
+	return {};
+    }
+
+    static core::codec::Ready<> finish(T& os) {
+	OutStreamAdapter<T>::finish(os);
+	return {};
+    }
+};
+
+template<class T>
+requires AsyncByteWrite<T>
+struct AsyncOutStreamAdapter<T> {
+    static auto write(T& sink, const char *ptr, std::size_t count) {
+	return sink.async_write(ptr, count);
+    }
+
+    static core::codec::Task<> finish(T& sink) {
+	if constexpr (requires { sink.async_close(); })
+	    co_await sink.async_close();
+    }
+};
+
+// Read bytes compressed using ZSTD streaming from a `Source` read
+// asynchronously, so that many streams can be multiplexed on a few
+// threads, e.g. those of an event loop, instead of a thread blocking
+// on each source.
+//
+// Each operation returns a `core::codec::Task` to `co_await`, which
+// suspends the awaiting coroutine only while the source does. The
+// decompression itself runs on the thread resuming the task.
+//
+// AsyncDecompressor d{socket};
+// while (co_await d.async_underflow())
+//     consume(d.view());
+//
+template<class Source>
+class AsyncDecompressor {
+public:
+    // Construct a decompressor reading from `is` with the buffers and
+    // allocator of `Decompressor`.
+    explicit AsyncDecompressor(std::add_rvalue_reference_t<Source> is, size_t n = 0,
+			       core::Allocator *alloc = nullptr)
+	: is_(std::forward<Source>(is))
+	, d_(NoSource{}, n, alloc) {
+    }
+
+    // Return a reference to the underlying stream.
+    Source& stream() { return is_; }
+
+    // Return the decompressor driven by this object, e.g. for its
+    // statistics.
+    Decompressor<NoSource>& decompressor() { return d_; }
+
+    // Read the next chunk of decompressed characters into the get area
+    // as `Decompressor::underflow`. Complete with `true` if characters
+    // are available, `false` at the end of the source.
+    core::codec::Task<bool> async_underflow() {
+	if (not d_.is_open())
+	    throw zstd::error("attempt to read from closed stream");
+	while (true) {
+	    if (d_.needs_input()) {
+		auto area = d_.input_area();
+		auto count = co_await AsyncInStreamAdapter<Source>::read(is_, area.data(), area.size());
+		if (not d_.supply(count))
+		    co_return false;
+	    }
+	    if (d_.decompress())
+		co_return true;
+	}
+    }
+
+    // Read up to `count` decompressed bytes into `buffer` as
+    // `Decompressor::read_bytes`. Complete with the number of bytes
+    // read.
+    core::codec::Task<size_t> async_read_bytes(char *buffer, size_t count) {
+	size_t n{0};
+	while (n < count) {
+	    if (not d_.get().available()) {
+		if (not d_.is_open() or not co_await async_underflow())
+		    break;
+	    }
+	    auto k = std::min(count - n, d_.get().size());
+	    memcpy(buffer + n, d_.get().data(), k);
+	    n += k;
+	    d_.get().discard(k);
+	}
+	co_return n;
+    }
+
+    // Read the next decompressed line into `line` as
+    // `Decompressor::read_line`. Complete with `true` if a (possibly
+    // empty) line was read.
+    core::codec::Task<bool> async_read_line(std::string& line) {
+	line.clear();
+	while (d_.is_open()) {
+	    while (d_.get().available()) {
+		auto c = d_.get().consume();
+		if (c == '\n')
+		    co_return true;
+		line.push_back(c);
+	    }
+	    if (not co_await async_underflow())
+		break;
+	}
+	co_return line.size() > 0;
+    }
+
+    // Return a view of the current get area.
+    std::string_view view() const { return d_.view(); }
+
+    // Return a reference to the get area.
+    GetArea& get() { return d_.get(); }
+
+    // Return a reference to the get area.
+    const GetArea& get() const { return d_.get(); }
+
+private:
+    Source is_;
+    Decompressor<NoSource> d_;
+};
+
+template<class S> explicit AsyncDecompressor(S&&) -> AsyncDecompressor<S>;
+template<class S> explicit AsyncDecompressor(S&&, size_t) -> AsyncDecompressor<S>;
+template<class S> explicit AsyncDecompressor(S&&, size_t, core::Allocator*) -> AsyncDecompressor<S>;
+
+// Write bytes compressed using ZSTD streaming to a `Sink` written
+// asynchronously, as `AsyncDecompressor` reads.
+//
+// Each write is compressed on the thread resuming the task into
+// blocks (see `core::codec::ChunkSink`) which are then written to the
+// sink in order, so the memory held is that of the compressed output
+// of one write. The stream must be ended with `async_close` since
+// the destructor cannot wait for the sink.
+//
+// AsyncCompressor c{socket};
+// co_await c.async_write(data, size);
+// co_await c.async_close();
+//
+template<class Sink>
+class AsyncCompressor {
+public:
+    // Construct a compressor writing to `os` with the buffer and
+    // allocator of `Compressor`.
+    explicit AsyncCompressor(std::add_rvalue_reference_t<Sink> os, size_t n = 0,
+			     core::Allocator *alloc = nullptr)
+	: os_(std::forward<Sink>(os))
+	, c_(pending_, n, alloc) {
+    }
+
+    AsyncCompressor(const AsyncCompressor&) = delete;
+    AsyncCompressor& operator=(const AsyncCompressor&) = delete;
+
+    // Return a reference to the underlying stream.
+    Sink& stream() { return os_; }
+
+    // Return the compressor driven by this object, e.g. to set the
+    // level. An adaptive level only sees the time spent compressing.
+    Compressor<core::codec::ChunkSink&>& compressor() { return c_; }
+
+    // Compress `count` bytes at `begin` and write the compressed bytes
+    // produced, if any, to the sink.
+    core::codec::Task<> async_write(const char *begin, size_t count) {
+	c_.write(begin, count);
+	co_await drain();
+    }
+
+    // Compress the raw bytes of the pod-type `value`.
+    template<class T>
+    core::codec::Task<> async_write_pod(const T& value) {
+	return async_write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    // End the stream, write the remaining compressed bytes and finish
+    // the sink (calling its `async_close`, if any).
+    core::codec::Task<> async_close() {
+	c_.close();
+	co_await drain();
+	co_await AsyncOutStreamAdapter<Sink>::finish(os_);
+    }
+
+    // Return the number of compressed bytes produced.
+    size_t count() const { return c_.count(); }
+
+private:
+    core::codec::Task<> drain() {
+	for (size_t k = 0; k < pending_.blocks(); ++k) {
+	    auto block = pending_.block(k);
+	    if (not block.empty())
+		co_await AsyncOutStreamAdapter<Sink>::write(os_, block.data(), block.size());
+	}
+	pending_.clear();
+    }
+
+    Sink os_;
+    core::codec::ChunkSink pending_;
+    Compressor<core::codec::ChunkSink&> c_;
+};
+
+template<class S> explicit AsyncCompressor(S&&) -> AsyncCompressor<S>;
+template<class S> explicit AsyncCompressor(S&&, size_t) -> AsyncCompressor<S>;
+template<class S> explicit AsyncCompressor(S&&, size_t, core::Allocator*) -> AsyncCompressor<S>;
+
+}; // zstd
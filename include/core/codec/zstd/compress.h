@@ -3,6 +3,8 @@
 
 #pragma once
 #include <ostream>
+#include <type_traits>
+#include "core/codec/shuffle.h"
 
 namespace zstd
 {
@@ -11,14 +13,16 @@ namespace zstd
 ///
 /// \param input_buffer Pointer to the input bytes.
 /// \param input_size Number of input bytes.
+/// \param level The compression level.
 /// \return The compressed bytes as a std::string
-std::string compress(const char *input_buffer, size_t input_size);
+std::string compress(const char *input_buffer, size_t input_size, int level = 1);
 
 /// Compress the inpuit using the **Zstandard** algorithm.
 ///
 /// \param str A std::string_view representing the input bytes.
+/// \param level The compression level.
 /// \return The compressed bytes as a std::string
-std::string compress(std::string_view str);
+std::string compress(std::string_view str, int level = 1);
 
 /// Compress the input using the **Zstandard** algorithm.
 ///
@@ -27,6 +31,7 @@ std::string compress(std::string_view str);
 /// \param is The input stream (source of input bytes).
 /// \param os The output stream (sink of output bytes).
 template<class InStream, class OutStream>
+requires (not std::is_same_v<std::remove_const_t<OutStream>, shuffle::Options>)
 void compress(InStream& is, OutStream& os);
 
 /// Compress the input using the **Zstandard** algorithm.
@@ -37,6 +42,33 @@ void compress(InStream& is, OutStream& os);
 /// \return The compressed bytes as a std::string
 template<template <class> class C, class T>
 std::string compress(const C<T>& storage)
-{ return compress((const char*)storage.data(), storage.size()); }
+{ return compress((const char*)storage.data(), storage.size() * sizeof(T)); }
+
+/// Compress the input using the **Zstandard** algorithm after
+/// transforming its elements with the pre-filters of `options` (see
+/// core/codec/shuffle.h), recorded in a leading skippable frame which
+/// `decompress_as` and `decompress_to` use to reverse the transform.
+///
+/// \param input_buffer Pointer to the input bytes.
+/// \param input_size Number of input bytes.
+/// \param typesize The size of the elements in bytes.
+/// \param options The pre-filters.
+/// \param level The compression level.
+/// \return The compressed bytes as a std::string
+std::string compress(const char *input_buffer, size_t input_size, size_t typesize,
+		     const shuffle::Options& options, int level = 1);
+
+/// Compress the elements of a container using the **Zstandard**
+/// algorithm after the pre-filters of `options`.
+///
+/// \tparam C Container template class
+/// \tparam T Container value type
+/// \param storage A container of the input elements.
+/// \param options The pre-filters.
+/// \param level The compression level.
+/// \return The compressed bytes as a std::string
+template<template <class> class C, class T>
+std::string compress(const C<T>& storage, const shuffle::Options& options, int level = 1)
+{ return compress((const char*)storage.data(), storage.size() * sizeof(T), sizeof(T), options, level); }
 
 }; // zstd
@@ -0,0 +1,164 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "core/codec/util/allocator.h"
+
+namespace zstd
+{
+
+// The configuration of a `CompressionService`.
+struct ServiceOptions {
+    size_t threads{0};			// Workers, `hardware_threads()` if zero
+    int level{1};			// Compression level of the inputs submitted without one
+    size_t split_size{size_t{1} << 20};	// Split larger inputs into frames of this size, never if zero
+    core::Allocator *alloc{nullptr};	// Allocator of the contexts, `core::default_allocator()` if null
+};
+
+// The counters of a `CompressionService`. The latencies, from the
+// submission of an input to the delivery of its result, are the
+// percentiles of the last `CompressionService::LatencyWindow` inputs
+// completed by each worker.
+struct ServiceStats {
+    uint64_t submitted{0};	// Inputs submitted
+    uint64_t completed{0};	// Inputs whose result, or error, was delivered
+    uint64_t failed{0};		// Part of completed delivered with an error
+    uint64_t split{0};		// Inputs split into several jobs
+    uint64_t jobs{0};		// Jobs run, one per input or per part of a split input
+    uint64_t steals{0};		// Part of jobs taken from the queue of another worker
+    uint64_t queue_depth{0};	// Jobs queued and not yet started
+    uint64_t max_queue_depth{0};	// Largest queue_depth seen
+    uint64_t bytes_in{0};	// Uncompressed bytes completed
+    uint64_t bytes_out{0};	// Compressed bytes delivered
+    uint64_t latency_p50_ns{0};
+    uint64_t latency_p90_ns{0};
+    uint64_t latency_p99_ns{0};
+    uint64_t latency_max_ns{0};
+
+    // Call `f(name, value)` for each field, e.g. to export the
+    // statistics to a metrics system.
+    template<class F>
+    void visit(F&& f) const {
+	f("submitted", submitted);
+	f("completed", completed);
+	f("failed", failed);
+	f("split", split);
+	f("jobs", jobs);
+	f("steals", steals);
+	f("queue_depth", queue_depth);
+	f("max_queue_depth", max_queue_depth);
+	f("bytes_in", bytes_in);
+	f("bytes_out", bytes_out);
+	f("latency_p50_ns", latency_p50_ns);
+	f("latency_p90_ns", latency_p90_ns);
+	f("latency_p99_ns", latency_p99_ns);
+	f("latency_max_ns", latency_max_ns);
+    }
+};
+
+// Compress many independent inputs, e.g. the messages or records of a
+// server, on a set of workers dedicated to the service.
+//
+// Each worker owns a queue of jobs and a compression context reused by
+// every job it runs, so a small input costs a queue operation and a
+// call into the codec instead of a context and a thread. A worker
+// takes the jobs of its own queue newest first and, once it is empty,
+// steals the oldest jobs of the others, so the work spreads over the
+// workers whichever queue it was submitted to. An input larger than
+// `ServiceOptions::split_size` is split into parts queued as separate
+// jobs, compressed in parallel as independent frames and concatenated,
+// which `zstd::decompress` reads as one input.
+//
+// zstd::CompressionService service;
+// auto future = service.compress(std::move(message));
+// service.compress(std::move(record), [](std::string zstr, std::exception_ptr error) {
+//     ...
+// });
+//
+class CompressionService {
+public:
+    // The number of latencies kept per worker for the percentiles.
+    static constexpr size_t LatencyWindow = 4096;
+
+    // Called on a worker with the compressed bytes, or the exception
+    // thrown compressing, of an input. It should be short since it
+    // holds up the worker, and must not throw.
+    using Callback = std::function<void(std::string, std::exception_ptr)>;
+
+    // Construct a service and start its workers.
+    explicit CompressionService(const ServiceOptions& options = ServiceOptions{});
+
+    // Complete the jobs queued, then join the workers.
+    ~CompressionService();
+
+    CompressionService(const CompressionService&) = delete;
+    CompressionService& operator=(const CompressionService&) = delete;
+
+    // Queue `input` for compression at the level of the options, or at
+    // `level`, and return the future of the compressed bytes.
+    std::future<std::string> compress(std::string input);
+    std::future<std::string> compress(std::string input, int level);
+
+    // Queue `input` for compression and call `done` with the result.
+    void compress(std::string input, Callback done);
+    void compress(std::string input, int level, Callback done);
+
+    // Return the number of workers.
+    size_t size() const { return workers_.size(); }
+
+    // Return the number of jobs queued and not yet started.
+    size_t queue_depth() const { return queued_.load(std::memory_order_relaxed); }
+
+    // Block until every input submitted so far has completed. Must not
+    // be called from a callback.
+    void drain();
+
+    // Return the counters of the service.
+    ServiceStats stats() const;
+
+private:
+    struct Request;
+    struct Job {
+	std::shared_ptr<Request> request;
+	size_t part{0};
+    };
+
+    struct Worker;
+    void submit(std::string input, int level, Callback done);
+    void push(Worker& worker, Job job);
+    bool pop(Worker& worker, Job& job);
+    bool steal(Worker& worker, Job& job);
+    void run(Worker& worker, Job& job);
+    void finish(Worker& worker, Request& request);
+    void work(Worker& worker);
+
+    // The worker running on the calling thread, if any.
+    static thread_local Worker *current_;
+
+    ServiceOptions options_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> next_{0};
+    std::atomic<size_t> queued_{0};
+    std::atomic<size_t> pending_{0};
+    std::atomic<size_t> sleeping_{0};
+    std::atomic<uint64_t> submitted_{0};
+    std::atomic<uint64_t> split_{0};
+    std::atomic<uint64_t> max_queue_depth_{0};
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable drained_;
+    bool stop_{false};
+};
+
+}; // zstd
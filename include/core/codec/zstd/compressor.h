@@ -5,9 +5,11 @@
 #include <memory>
 #include <type_traits>
 #include <zstd.h>
+#include "core/codec/zstd/adaptive.h"
 #include "core/codec/zstd/get_area.h"
 #include "core/codec/zstd/put_area.h"
 #include "core/codec/zstd/exception.h"
+#include "core/codec/util/stats.h"
 
 namespace zstd
 {
@@ -27,8 +29,10 @@ class Compressor {
 public:
     // Construct a compressor that will write to the output stream
     // <os> using a buffer of size `n` (defaults to size suggested by
-    // ZSTD library).
-    explicit Compressor(std::add_rvalue_reference_t<Sink> os, size_t n = 0);
+    // ZSTD library). The ZSTD context and the buffer are allocated
+    // from `alloc` (defaults to `core::default_allocator()`).
+    explicit Compressor(std::add_rvalue_reference_t<Sink> os, size_t n = 0,
+			core::Allocator *alloc = nullptr);
 
     // Move construct from other.
     Compressor(Compressor&& other);
@@ -44,9 +48,28 @@ public:
     // internal allocations.
     void close();
 
+    // Set the compression level used from the next frame on, i.e. for
+    // the whole stream when called before the first `write`.
+    void set_level(int level);
+
+    // Adapt the compression level to the throughput of the sink
+    // within the bounds of `options`, ending a frame every
+    // `options.frame_size` uncompressed bytes and choosing the level
+    // of the next frame (see `zstd::LevelAdapter`). Must be called
+    // before the first `write`.
+    void set_adaptive(const AdaptOptions& options = {});
+
+    // Return the level adapter if adaptive, nullptr otherwise.
+    const LevelAdapter *adapter() const { return adapter_.get(); }
+
     // Return the number of bytes appended to the output stream.
     size_t count() const { return count_; }
 
+#ifdef CODEC_STATS
+    // Return the statistics collected for this stream.
+    const core::codec::Stats& stats() const { return stats_.data(); }
+#endif
+
     // Write the data from `begin` up to `end` to `Sink` using ZSTD
     // streaming compression.
     void write(const char *begin, const char *end);
@@ -72,14 +95,28 @@ public:
     const GetArea& get() const { return get_; }
 
 private:
+    // Compress the data from `begin` up to `end` without ending the
+    // frame.
+    void compress(const char *begin, const char *end);
+
+    // End the current frame and choose the level of the next.
+    void end_frame();
+
+    // Write the get area to the sink and clear it.
+    void flush();
+
     Sink os_;
     ZSTD_CStream *zsc_;
     UnbufferedPutArea put_;
     GetArea get_;
     size_t count_{0};
+    std::unique_ptr<LevelAdapter> adapter_;
+    size_t frame_in_{0};
+    [[no_unique_address]] core::codec::StatsRecorder stats_;
 };
 
 template<class S> explicit Compressor(S&&) -> Compressor<S>;
 template<class S> explicit Compressor(S&&, size_t) -> Compressor<S>;
+template<class S> explicit Compressor(S&&, size_t, core::Allocator*) -> Compressor<S>;
 
 }; // zstd
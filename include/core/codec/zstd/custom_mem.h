@@ -0,0 +1,32 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#define ZSTD_STATIC_LINKING_ONLY
+#include <zstd.h>
+#include "core/codec/util/allocator.h"
+
+namespace zstd
+{
+
+// Return the ZSTD memory hooks that route the internal allocations
+// of a ZSTD context through `alloc`. An allocation that throws fails
+// with a null pointer, which ZSTD reports as an error, since the
+// exception must not unwind through the C frames of ZSTD.
+inline ZSTD_customMem custom_mem(core::Allocator& alloc) {
+    ZSTD_customMem mem;
+    mem.customAlloc = [](void *opaque, size_t n) -> void* {
+	try {
+	    return static_cast<core::Allocator*>(opaque)->allocate(n);
+	} catch (...) {
+	    return nullptr;
+	}
+    };
+    mem.customFree = [](void *opaque, void *ptr) {
+	static_cast<core::Allocator*>(opaque)->deallocate(ptr);
+    };
+    mem.opaque = &alloc;
+    return mem;
+}
+
+}; // zstd
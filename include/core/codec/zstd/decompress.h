@@ -3,6 +3,7 @@
 
 #pragma once
 #include <istream>
+#include "core/codec/util/chunk_sink.h"
 
 namespace zstd
 {
@@ -10,6 +11,15 @@ namespace zstd
 std::string decompress(const char *input_buffer, size_t input_size);
 std::string decompress(std::string_view str);
 
+// Decompress the `input_size` bytes at `input_buffer`, one or more
+// frames of known or unknown size, appending the output to the blocks
+// of `sink` without an intermediate buffer.
+void decompress(const char *input_buffer, size_t input_size, core::codec::ChunkSink& sink);
+
+// Return the decompressed bytes of `str` as a chunk sink, e.g. to
+// write them with `ChunkSink::write_to` without coalescing.
+core::codec::ChunkSink decompress_chunks(std::string_view str);
+
 template<class InStream, class OutStream>
 void decompress(InStream& source, OutStream& sink);
 
@@ -3,26 +3,46 @@
 
 #pragma once
 #include <istream>
+#include <optional>
+#include <type_traits>
+#include <vector>
+#include "core/codec/shuffle.h"
+#include "core/codec/util/chunk_sink.h"
+#include "core/codec/util/peek_source.h"
 #include "core/codec/zstd/decompress.h"
-#include "core/cc/scoped_task.h"
+#include "core/codec/zstd/decompressor.h"
 #include "core/cc/queue/lockfree_spsc.h"
 
 namespace zstd
 {
 
+// Return the elements of `buffer`, reversing the pre-filters recorded
+// by `header`, if any (see `compress(..., shuffle::Options)`).
 template<class T>
-std::vector<T> decompress_as(std::string_view zdata)
+std::vector<T> unfilter_as(std::string_view buffer, const std::optional<shuffle::Header>& header)
 {
-    auto buffer = decompress(zdata);
     auto nelems = buffer.size() / sizeof(T);
     if (nelems * sizeof(T) != buffer.size())
  	throw std::runtime_error("decompress_as: non-integral number of elements");
+    if (header and header->typesize != sizeof(T))
+	throw std::runtime_error("decompress_as: element size differs from the compressed elements");
     std::vector<T> vec(nelems);
-    std::copy(buffer.begin(), buffer.end(), reinterpret_cast<char*>(&vec[0]));
+    auto out = reinterpret_cast<char*>(vec.data());
+    if (header)
+	shuffle::decode(buffer.data(), buffer.size(), out, sizeof(T), header->options);
+    else
+	std::copy(buffer.begin(), buffer.end(), out);
     return vec;
 }
 
+template<class T>
+std::vector<T> decompress_as(std::string_view zdata)
+{
+    return unfilter_as<T>(decompress(zdata), shuffle::read_header(zdata));
+}
+
 template<class SourceQ, class T>
+requires (not std::is_base_of_v<std::istream, SourceQ>)
 void decompress_to(SourceQ& source, std::vector<T>& container, size_t block_size = 1024)
 {
     container.resize(block_size);
@@ -42,10 +62,15 @@ void decompress_to(SourceQ& source, std::vector<T>& container, size_t block_size
 template<class T>
 void decompress_to(std::istream& is, std::vector<T>& container)
 {
-    core::cc::queue::LockFreeSpSc<char> queue;
-    core::cc::scoped_task task([&]() { decompress(is, queue); });
-    decompress(queue, container);
-    task.wait();
+    // The header of any pre-filters is a skippable frame which the
+    // decompressor skips, so it is only peeked at.
+    core::PeekSource source{is};
+    auto header = shuffle::read_header(source.peek(shuffle::HeaderSize));
+    Decompressor<core::PeekSource&> d{source};
+    core::codec::ChunkSink sink;
+    while (d.underflow())
+	sink.write(d.view());
+    container = unfilter_as<T>(sink.take(), header);
 }
 
 }; // zstd
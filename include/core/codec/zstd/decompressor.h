@@ -2,8 +2,10 @@
 //
 
 #pragma once
+#include <span>
 #include "core/codec/zstd/get_area.h"
 #include "core/codec/zstd/put_area.h"
+#include "core/codec/util/stats.h"
 
 namespace zstd
 {
@@ -34,14 +36,29 @@ namespace zstd
 // std::string s;
 // while (d.underflow())
 //     s += std::string_view{d.get().ptr_base(), d.get().ptr_position()};
-// 
+//
+// Non-blocking interface:
+//
+// The caller reads the source itself, e.g. asynchronously (see
+// `zstd::AsyncDecompressor`), as `underflow` does.
+//
+// Decompressor d{zstd::NoSource{}};
+// while (true) {
+//     if (d.needs_input() and not d.supply(read(d.input_area())))
+//         break;
+//     if (d.decompress())
+//         s += d.view();
+// }
+//
 template<class Source>
 class Decompressor {
 public:
     // Construct a decompressor that reads from stream `is` using a
     // buffer of size `n` (defaults to the buffer size suggested by
-    // the ZSTD library).
-    explicit Decompressor(std::add_rvalue_reference_t<Source> is, size_t n = 0);
+    // the ZSTD library). The ZSTD context and the buffers are
+    // allocated from `alloc` (defaults to `core::default_allocator()`).
+    explicit Decompressor(std::add_rvalue_reference_t<Source> is, size_t n = 0,
+			  core::Allocator *alloc = nullptr);
 
     // Destruct a decompressor.
     ~Decompressor();
@@ -80,6 +97,27 @@ public:
     // characters are successfully read, `false` otherwise.
     bool underflow();
 
+    // Return true if the input read so far has been consumed, so that
+    // `supply` must be called before `decompress`.
+    bool needs_input() const { return put_.empty(); }
+
+    // Return the area to read the next input into.
+    std::span<char> input_area() { return {put_.begin(), put_.capacity()}; }
+
+    // Record `count` bytes read into the input area. A `count` of zero
+    // marks the end of the source and closes the decompressor. Return
+    // true if there was input.
+    bool supply(size_t count);
+
+    // Decompress the next chunk of the input into the get area
+    // (discarding any existing characters). Return true if characters
+    // are available, otherwise more input may be needed.
+    bool decompress();
+
+    // Return true until the decompressor is closed, e.g. at the end of
+    // the source.
+    bool is_open() const { return zsd_ != nullptr; }
+
     // Return a view of the current get area, i.e. the characters that
     // are ready to be read.
     std::string_view view() const { return get_.view(); }
@@ -90,6 +128,11 @@ public:
     // Return a reference to tht get area for writing data.
     const GetArea& get() const { return get_; }
 
+#ifdef CODEC_STATS
+    // Return the statistics collected for this stream.
+    const core::codec::Stats& stats() const { return stats_.data(); }
+#endif
+
 private:
     // Return a reference to the put area for writing data.
     PutArea& put() { return put_; }
@@ -101,9 +144,17 @@ private:
     ZSTD_DStream *zsd_;
     PutArea put_;
     GetArea get_;
+    [[no_unique_address]] core::codec::StatsRecorder stats_;
+};
+
+// The source of a decompressor used through its non-blocking interface
+// only. Reading from it throws `zstd::error`.
+struct NoSource {
+    size_t read_bytes(char *ptr, size_t count);
 };
 
 template<class S> explicit Decompressor(S&&) -> Decompressor<S>;
 template<class S> explicit Decompressor(S&&, size_t) -> Decompressor<S>;
+template<class S> explicit Decompressor(S&&, size_t, core::Allocator*) -> Decompressor<S>;
 
 }; // zstd
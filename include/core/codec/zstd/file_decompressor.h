@@ -8,6 +8,10 @@
 namespace zstd
 {
 
+// Decompress the file `file` sequentially. To read a file of several
+// frames by random access, or to share its decompressed frames with
+// the other readers of the process, see `FrameFile` and `FrameReader`
+// in core/codec/zstd/frame_file.h.
 class FileDecompressor : public Decompressor<std::ifstream> {
 public:
     using Base = Decompressor<std::ifstream>;
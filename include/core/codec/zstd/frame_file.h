@@ -0,0 +1,173 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include "core/codec/util/block_cache.h"
+
+namespace zstd
+{
+
+// The location of a frame of a `FrameFile`.
+struct FrameInfo {
+    // The `content_size` of a frame whose header does not record it.
+    static constexpr uint64_t UnknownSize = ~uint64_t{0};
+
+    uint64_t offset{0};		// Offset of the compressed frame in the file
+    uint64_t size{0};		// Compressed bytes of the frame
+    uint64_t position{0};	// Offset of the decompressed bytes in the file's contents
+    uint64_t content_size{0};	// Decompressed bytes of the frame
+};
+
+// Read a file of concatenated zstd frames by random access, e.g. a
+// file written by `zstd::Compressor` with a frame size or by the
+// seekable format of the zstd contrib directory (its seek table is
+// a skippable frame and is skipped).
+//
+// Opening the file indexes its frames by walking their headers.
+// Frames whose header does not record their decompressed size, e.g.
+// those written by `zstd::Compressor`, are decompressed once,
+// concurrently, while indexing, unless their sizes are supplied, e.g.
+// by a stored `LineIndex`. Frames are decompressed whole
+// into the `core::codec::BlockCache` shared with the other readers
+// of the process, keyed by the file identity and frame offset, so a
+// hot frame is decompressed once however many readers open the file.
+//
+// The const members may be called concurrently.
+//
+// zstd::FrameFile file{"data.zst"};
+// auto bytes = file.read(position, 4096);
+//
+class FrameFile {
+public:
+    using Block = core::codec::BlockCache::Block;
+
+    // Open and index the file at `path`, caching frames in `cache`.
+    // Throw zstd::error if the file is not a sequence of zstd frames.
+    explicit FrameFile(const std::string& path,
+		       core::codec::BlockCache& cache = core::codec::BlockCache::global());
+
+    // Open and index the file at `path` taking the decompressed sizes
+    // of its frames from `layout`, the offset, position and size of
+    // each non-empty frame in order (e.g. `LineIndex::layout`), instead
+    // of decompressing the frames whose header does not record theirs.
+    // The compressed size of an entry spans the empty frames up to the
+    // next entry. A `layout` that is empty, does not match the frame
+    // headers or does not reach the last frame, e.g. that of a file
+    // appended to since, is ignored.
+    FrameFile(const std::string& path, const std::vector<FrameInfo>& layout,
+	      core::codec::BlockCache& cache = core::codec::BlockCache::global());
+    ~FrameFile();
+
+    FrameFile(FrameFile&& other);
+    FrameFile(const FrameFile&) = delete;
+    FrameFile& operator=(const FrameFile&) = delete;
+
+    // Return the path of the file.
+    const std::string& path() const { return path_; }
+
+    // Return the identity of the file in the cache.
+    uint64_t id() const { return id_; }
+
+    // Return the cache holding the decompressed frames.
+    core::codec::BlockCache& cache() const { return *cache_; }
+
+    // Return the number of decompressed bytes.
+    uint64_t size() const { return size_; }
+
+    // Return the number of frames.
+    size_t frames() const { return frames_.size(); }
+
+    // Return the location of frame `k`.
+    const FrameInfo& frame_info(size_t k) const { return frames_[k]; }
+
+    // Return the index of the frame holding the decompressed byte at
+    // `position`, or `frames()` past the end.
+    size_t frame_at(uint64_t position) const;
+
+    // Return the decompressed frame `k`, through the cache.
+    Block frame(size_t k) const;
+
+    // Return the decompressed frame `k` bypassing the cache, e.g. to
+    // scan a file once without evicting the blocks of other readers.
+    std::string decompress(size_t k) const;
+
+    // Copy up to `n` decompressed bytes starting at `position` into
+    // `out`. Return the number of bytes copied, fewer than `n` only
+    // at the end of the file.
+    size_t read(uint64_t position, char *out, size_t n) const;
+
+    // Return up to `n` decompressed bytes starting at `position`.
+    std::string read(uint64_t position, size_t n) const;
+
+private:
+    // Read the `n` bytes at `offset` of the file into `out` or throw
+    // zstd::error.
+    void pread(uint64_t offset, char *out, size_t n) const;
+
+    // Append the frames of the file to the index, taking the sizes
+    // not in the frame headers from `layout` if it matches.
+    void index(const std::vector<FrameInfo>& layout);
+
+    std::string path_;
+    core::codec::BlockCache *cache_;
+    int fd_{-1};
+    uint64_t id_{0}, file_size_{0}, size_{0};
+    std::vector<FrameInfo> frames_;
+};
+
+// Return the frames of the zstd file at `path` by walking their
+// headers, without decompressing them or caching them. The size of a
+// frame whose header does not record it is `FrameInfo::UnknownSize`
+// and the positions are zero. Throw zstd::error if the file is not a
+// sequence of zstd frames.
+std::vector<FrameInfo> scan_frames(const std::string& path);
+
+// Return the compressed `frame` decompressed, using a decompression
+// context of the calling thread. Throw zstd::error if it does not
+// decompress to `content_size` bytes, unless that is unknown.
+std::string decompress_frame(std::string_view frame, uint64_t content_size = FrameInfo::UnknownSize);
+
+// Read the decompressed bytes of a `FrameFile` sequentially through
+// the cache. A `FrameReader` has the reading interface of
+// `zstd::Decompressor` (`read_line`, `read_bytes`, `underflow` and
+// `view`) so it can replace a `FileDecompressor`, e.g. as the source
+// of a `core::filter_istream`, and it can `seek`.
+//
+class FrameReader {
+public:
+    // Construct a reader of `file`, which must outlive it, positioned
+    // at the decompressed byte `position`.
+    explicit FrameReader(const FrameFile& file, uint64_t position = 0);
+
+    // Return the decompressed position of the next byte to be read.
+    uint64_t tell() const { return position_ - (end_ - pos_); }
+
+    // Position the reader at the decompressed byte `position`.
+    void seek(uint64_t position);
+
+    // Attempt to read the next line (without the newline). Return
+    // `false` with `line` empty if there are no more characters.
+    bool read_line(std::string& line);
+
+    // Attempt to read up to `count` bytes into `buffer`. Return the
+    // number of bytes read.
+    size_t read_bytes(char *buffer, size_t count);
+
+    // Make the rest of the next frame the current view, discarding
+    // the current view. Return `false` at the end of the file.
+    bool underflow();
+
+    // Return the bytes ready to be read.
+    std::string_view view() const { return {pos_, size_t(end_ - pos_)}; }
+
+private:
+    const FrameFile *file_;
+    FrameFile::Block block_;
+    const char *pos_{nullptr}, *end_{nullptr};
+    uint64_t position_{0};
+};
+
+}; // zstd
@@ -16,8 +16,8 @@ namespace zstd
 class GetArea : public core::GetArea {
 public:
     // Create an area of the given `capacity` for holding the ZSTD
-    // output.
-    GetArea(size_t capacity);
+    // output using memory from `alloc`.
+    GetArea(size_t capacity, core::Allocator *alloc = nullptr);
 
     // Prepare to receive output from ZSTD.
     void clear();
@@ -0,0 +1,147 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#pragma once
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "core/codec/zstd/frame_file.h"
+
+namespace zstd
+{
+
+// The decompressed position and the number of lines before the start
+// of a frame of a `FrameFile`, where decompression can start.
+struct LineCheckpoint {
+    uint64_t offset{0};		// Offset of the compressed frame in the file
+    uint64_t position{0};	// Offset of the frame's decompressed bytes
+    uint64_t line{0};		// Newlines before `position`
+};
+
+// Index the lines of a compressed text file by its frames so line `n`
+// is reached by decompressing one frame instead of every line before
+// it. A file compressed as a single frame has a single checkpoint;
+// write files meant to be indexed with a frame size, e.g. with
+// `zstd::Compressor::set_adaptive({.frame_size = ...})`.
+//
+// The index is stored either in a sidecar file or appended to the
+// compressed file as a skippable frame, which zstd decompressors and
+// `FrameFile` skip. A stored index also records the decompressed
+// sizes of the frames, which `FrameFile` otherwise decompresses every
+// frame to learn when the frame headers do not record them, as those
+// written by `zstd::Compressor` do not.
+//
+// auto stored = zstd::LineIndex::stored("app.log.zst");
+// zstd::FrameFile file{"app.log.zst", stored ? stored->layout() : std::vector<zstd::FrameInfo>{}};
+// auto index = zstd::LineIndex::open(file);
+// zstd::LineReader reader{file, index};
+// auto lines = reader.read_lines(48'000'000, 100);
+//
+class LineIndex {
+public:
+    LineIndex() = default;
+
+    // Build the index of `file` counting the newlines of its frames
+    // using `threads` threads (zero for the number of hardware
+    // threads). The frames are decompressed bypassing the cache.
+    static LineIndex build(const FrameFile& file, size_t threads = 0);
+
+    // Return the index of `file` read from its trailing skippable
+    // frame, else from its sidecar file `sidecar(file.path())`, else
+    // built from the file. An index that does not match the frames of
+    // the file is ignored.
+    static LineIndex open(const FrameFile& file, size_t threads = 0);
+
+    // Return the index stored for the compressed file at `path`, read
+    // from its trailing skippable frame, else from its sidecar file,
+    // or std::nullopt. The index is not checked against the file.
+    static std::optional<LineIndex> stored(const std::string& path);
+
+    // Return the path of the sidecar file of the compressed file at
+    // `path`.
+    static std::string sidecar(const std::string& path) { return path + ".lidx"; }
+
+    // Return the index serialized as a zstd skippable frame.
+    std::string serialize() const;
+
+    // Return the index serialized in `bytes` if it holds an index at
+    // its end, or std::nullopt.
+    static std::optional<LineIndex> parse(std::string_view bytes);
+
+    // Write the index to the file at `path`, e.g. a sidecar file.
+    void save(const std::string& path) const;
+
+    // Return the index saved in the file at `path`, or std::nullopt if
+    // it does not exist or does not hold an index.
+    static std::optional<LineIndex> load(const std::string& path);
+
+    // Append the index to the compressed file at `path`, which must
+    // not already have one.
+    void append_to(const std::string& path) const;
+
+    // Return the index appended to the compressed file at `path`, or
+    // std::nullopt.
+    static std::optional<LineIndex> read_trailer(const std::string& path);
+
+    // Return true if the index describes the frames of `file`.
+    bool matches(const FrameFile& file) const;
+
+    // Return the checkpoints in the order of the file.
+    const std::vector<LineCheckpoint>& checkpoints() const { return checkpoints_; }
+
+    // Return the offset, position and decompressed size of the
+    // non-empty frames of the file, e.g. to open a `FrameFile` without
+    // decompressing its frames. The compressed size of a frame spans
+    // any empty frames up to the next one, or to the end of the frames
+    // indexed.
+    std::vector<FrameInfo> layout() const;
+
+    // Return the number of lines, including a last line without a
+    // newline.
+    uint64_t lines() const { return lines_; }
+
+    // Return the number of decompressed bytes.
+    uint64_t size() const { return size_; }
+
+    // Return the checkpoint from which to scan for the start of line
+    // `n`, which must be positive: the last one preceded by fewer
+    // than `n` newlines.
+    const LineCheckpoint& checkpoint(uint64_t n) const;
+
+private:
+    std::vector<LineCheckpoint> checkpoints_;
+    uint64_t lines_{0}, size_{0}, data_size_{0};
+};
+
+// Read the lines of a `FrameFile` starting at any line number, using
+// a `LineIndex` to start decompressing at the frame of the line.
+class LineReader {
+public:
+    // Construct a reader of `file` positioned at the first line. The
+    // file and the index must outlive the reader.
+    LineReader(const FrameFile& file, const LineIndex& index);
+
+    // Position the reader at the start of line `n` (zero-based).
+    // Return false, positioning the reader at the end, if there are
+    // not that many lines.
+    bool seek_line(uint64_t n);
+
+    // Return the number of the line `read_line` reads next.
+    uint64_t line() const { return line_; }
+
+    // Attempt to read the next line (without the newline). Return
+    // `false` if there are no more lines.
+    bool read_line(std::string& line);
+
+    // Return up to `count` lines starting at line `first`.
+    std::vector<std::string> read_lines(uint64_t first, size_t count);
+
+private:
+    const FrameFile *file_;
+    const LineIndex *index_;
+    FrameReader reader_;
+    uint64_t line_{0};
+};
+
+}; // zstd
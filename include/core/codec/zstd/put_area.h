@@ -14,8 +14,8 @@ namespace zstd
 class PutArea : public core::BufferedArea {
 public:
     // Construct an area of the given `capacity` for holding the ZSTD
-    // input.
-    PutArea(size_t capacity);
+    // input using memory from `alloc`.
+    PutArea(size_t capacity, core::Allocator *alloc = nullptr);
 
     // Return true if ZSTD has consumed all the input data.
     bool empty() const;
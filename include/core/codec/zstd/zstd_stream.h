@@ -50,7 +50,7 @@ class zstd_ostreambuf : public std::streambuf {
 public:
     zstd_ostreambuf(std::ostream& sout, size_t n = 0)
 	: c_(sout, n)
-	, area_(n)
+	, area_(n > 0 ? n : ZSTD_CStreamInSize())
     {
 	clear();
     }
@@ -0,0 +1,19 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <stdexcept>
+#include "core/codec/base16.h"
+#include "core/codec/base16/codec.h"
+
+std::string base16_encode(std::string_view s, bool upper) {
+    std::string ret(base16::encoded_length(s.size()), '\0');
+    base16::encode_into(s, ret, {upper});
+    return ret;
+}
+
+std::string base16_decode(std::string_view s) {
+    std::string ret(base16::decoded_length(s), '\0');
+    if (not base16::decode_into(s, ret))
+	throw std::runtime_error("Input is not valid base16-encoded data.");
+    return ret;
+}
@@ -0,0 +1,54 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <algorithm>
+#include "core/codec/base16/codec.h"
+#include "core/codec/base16/kernels.h"
+
+namespace base16
+{
+
+namespace {
+
+// The number of characters validated per block.
+constexpr size_t BlockSize = 4096;
+
+}; // anonymous
+
+Result encode_into(std::string_view in, std::span<char> out, const Options& options) {
+    auto length = encoded_length(in.size());
+    if (length > out.size())
+	return {Status::OutputTooSmall, 0};
+    kernels().encode(reinterpret_cast<const unsigned char*>(in.data()), in.size(), out.data(),
+		     options.upper);
+    return {Status::Ok, length};
+}
+
+Result decode_into(std::string_view in, std::span<char> out) {
+    if (in.size() % 2 != 0)
+	return {Status::InvalidLength, 0};
+    if (decoded_length(in) > out.size())
+	return {Status::OutputTooSmall, 0};
+
+    auto n = kernels().decode(in.data(), in.size(), reinterpret_cast<unsigned char*>(out.data()));
+    if (n < in.size())
+	return {Status::InvalidCharacter, n / 2};
+    return {Status::Ok, n / 2};
+}
+
+Result validate(std::string_view in) {
+    if (in.size() % 2 != 0)
+	return {Status::InvalidLength, 0};
+
+    char scratch[BlockSize / 2];
+    size_t count{0};
+    for (size_t pos = 0; pos < in.size(); pos += BlockSize) {
+	auto r = decode_into(in.substr(pos, BlockSize), scratch);
+	count += r.count;
+	if (not r)
+	    return {r.status, count};
+    }
+    return {Status::Ok, count};
+}
+
+}; // base16
@@ -0,0 +1,219 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include "core/codec/base16/kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CODEC_BASE16_X86 1
+#include <immintrin.h>
+#endif
+
+namespace base16
+{
+
+namespace {
+
+constexpr const char *Digits[2] = { "0123456789abcdef", "0123456789ABCDEF" };
+
+// Map every byte to the pair of hex digits encoding it.
+constexpr std::array<char, 512> make_pairs(const char *digits) {
+    std::array<char, 512> pairs{};
+    for (int i = 0; i < 256; ++i) {
+	pairs[2 * i] = digits[i >> 4];
+	pairs[2 * i + 1] = digits[i & 0x0f];
+    }
+    return pairs;
+}
+
+constexpr std::array<char, 512> Pairs[2] = { make_pairs(Digits[0]), make_pairs(Digits[1]) };
+
+// Map every byte to its value as a hex digit in either case, or
+// `Invalid`.
+constexpr unsigned char Invalid = 0xff;
+constexpr std::array<unsigned char, 256> make_values() {
+    std::array<unsigned char, 256> values{};
+    for (auto& v : values)
+	v = Invalid;
+    for (int i = 0; i < 10; ++i)
+	values['0' + i] = i;
+    for (int i = 0; i < 6; ++i)
+	values['a' + i] = values['A' + i] = 10 + i;
+    return values;
+}
+
+constexpr auto Values = make_values();
+
+void encode_scalar(const unsigned char *in, size_t n, char *out, bool upper) {
+    const auto& pairs = Pairs[upper];
+    for (size_t i = 0; i < n; ++i, out += 2) {
+	out[0] = pairs[2 * in[i]];
+	out[1] = pairs[2 * in[i] + 1];
+    }
+}
+
+size_t decode_scalar(const char *in, size_t n, unsigned char *out) {
+    size_t i = 0;
+    for (; i < n; i += 2) {
+	uint32_t a = Values[(unsigned char)in[i]];
+	uint32_t b = Values[(unsigned char)in[i + 1]];
+	if ((a | b) > 15)
+	    break;
+	*out++ = (a << 4) | b;
+    }
+    return i;
+}
+
+#ifdef CODEC_BASE16_X86
+
+// The encoders look up the digit of each nibble with a byte shuffle
+// and interleave the high and low digits. The decoders classify the
+// characters by range, folding the case of letters, and combine the
+// pairs of nibbles with a multiply-add.
+
+__attribute__((target("ssse3")))
+void encode_ssse3(const unsigned char *in, size_t n, char *out, bool upper) {
+    const auto digits = _mm_loadu_si128((const __m128i*)Digits[upper]);
+    const auto mask = _mm_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16, out += 32) {
+	auto x = _mm_loadu_si128((const __m128i*)(in + i));
+	auto hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(x, 4), mask));
+	auto lo = _mm_shuffle_epi8(digits, _mm_and_si128(x, mask));
+	_mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi8(hi, lo));
+	_mm_storeu_si128((__m128i*)(out + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    encode_scalar(in + i, n - i, out, upper);
+}
+
+// Return the mask of the bytes of `c` in [lo, hi] (ASCII only).
+__attribute__((target("ssse3")))
+__m128i in_range_ssse3(__m128i c, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8(lo - 1)),
+			 _mm_cmpgt_epi8(_mm_set1_epi8(hi + 1), c));
+}
+
+// Translate the hex digits `c` into their values returning false if
+// any character is not a hex digit.
+__attribute__((target("ssse3")))
+bool values_ssse3(__m128i c, __m128i& values) {
+    auto digit = in_range_ssse3(c, '0', '9');
+    auto folded = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    auto alpha = in_range_ssse3(folded, 'a', 'f');
+    if (_mm_movemask_epi8(_mm_or_si128(digit, alpha)) != 0xffff)
+	return false;
+    values = _mm_or_si128(_mm_and_si128(digit, _mm_sub_epi8(c, _mm_set1_epi8('0'))),
+			  _mm_and_si128(alpha, _mm_sub_epi8(folded, _mm_set1_epi8('a' - 10))));
+    return true;
+}
+
+__attribute__((target("ssse3")))
+size_t decode_ssse3(const char *in, size_t n, unsigned char *out) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16, out += 8) {
+	__m128i values;
+	if (not values_ssse3(_mm_loadu_si128((const __m128i*)(in + i)), values))
+	    break;
+	auto bytes = _mm_maddubs_epi16(values, _mm_set1_epi16(0x0110));
+	_mm_storel_epi64((__m128i*)out, _mm_packus_epi16(bytes, bytes));
+    }
+    return i + decode_scalar(in + i, n - i, out);
+}
+
+__attribute__((target("avx2")))
+void encode_avx2(const unsigned char *in, size_t n, char *out, bool upper) {
+    const auto digits = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)Digits[upper]));
+    const auto mask = _mm256_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32, out += 64) {
+	auto x = _mm256_loadu_si256((const __m256i*)(in + i));
+	auto hi = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(x, 4), mask));
+	auto lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(x, mask));
+	auto a = _mm256_unpacklo_epi8(hi, lo), b = _mm256_unpackhi_epi8(hi, lo);
+	_mm256_storeu_si256((__m256i*)out, _mm256_permute2x128_si256(a, b, 0x20));
+	_mm256_storeu_si256((__m256i*)(out + 32), _mm256_permute2x128_si256(a, b, 0x31));
+    }
+    // Clear the upper halves before the legacy SSE encoded tail to
+    // avoid the AVX-SSE transition penalty.
+    _mm256_zeroupper();
+    encode_ssse3(in + i, n - i, out, upper);
+}
+
+__attribute__((target("avx2")))
+__m256i in_range_avx2(__m256i c, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8(lo - 1)),
+			    _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), c));
+}
+
+__attribute__((target("avx2")))
+bool values_avx2(__m256i c, __m256i& values) {
+    auto digit = in_range_avx2(c, '0', '9');
+    auto folded = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+    auto alpha = in_range_avx2(folded, 'a', 'f');
+    if (_mm256_movemask_epi8(_mm256_or_si256(digit, alpha)) != -1)
+	return false;
+    values = _mm256_or_si256(_mm256_and_si256(digit, _mm256_sub_epi8(c, _mm256_set1_epi8('0'))),
+			     _mm256_and_si256(alpha, _mm256_sub_epi8(folded, _mm256_set1_epi8('a' - 10))));
+    return true;
+}
+
+__attribute__((target("avx2")))
+size_t decode_avx2(const char *in, size_t n, unsigned char *out) {
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64, out += 32) {
+	__m256i a, b;
+	if (not values_avx2(_mm256_loadu_si256((const __m256i*)(in + i)), a)
+	    or not values_avx2(_mm256_loadu_si256((const __m256i*)(in + i + 32)), b))
+	    break;
+	a = _mm256_maddubs_epi16(a, _mm256_set1_epi16(0x0110));
+	b = _mm256_maddubs_epi16(b, _mm256_set1_epi16(0x0110));
+	auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8);
+	_mm256_storeu_si256((__m256i*)out, packed);
+    }
+    _mm256_zeroupper();
+    return i + decode_ssse3(in + i, n - i, out);
+}
+
+#endif // CODEC_BASE16_X86
+
+const Kernels AllKernels[] = {
+    { Isa::Scalar, encode_scalar, decode_scalar },
+#ifdef CODEC_BASE16_X86
+    { Isa::Ssse3, encode_ssse3, decode_ssse3 },
+    { Isa::Avx2, encode_avx2, decode_avx2 },
+#endif
+};
+
+}; // anonymous
+
+bool supported(Isa isa) {
+    for (const auto& k : AllKernels)
+	if (k.isa == isa)
+	    return base64::supported(isa);
+    return false;
+}
+
+Isa best_isa() {
+    auto best = Isa::Scalar;
+    for (auto isa : Isas)
+	if (base16::supported(isa))
+	    best = isa;
+    return best;
+}
+
+const Kernels& kernels(Isa isa) {
+    if (base16::supported(isa))
+	for (const auto& k : AllKernels)
+	    if (k.isa == isa)
+		return k;
+    throw std::runtime_error("base16: kernels not supported: " + std::string{name(isa)});
+}
+
+const Kernels& kernels() {
+    static const Kernels& best = base16::kernels(best_isa());
+    return best;
+}
+
+}; // base16
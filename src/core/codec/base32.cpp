@@ -0,0 +1,19 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <stdexcept>
+#include "core/codec/base32.h"
+#include "core/codec/base32/codec.h"
+
+std::string base32_encode(std::string_view s, bool hex) {
+    std::string ret(base32::encoded_length(s.size(), {hex}), '\0');
+    base32::encode_into(s, ret, {hex});
+    return ret;
+}
+
+std::string base32_decode(std::string_view s, bool hex) {
+    std::string ret(base32::decoded_length(s), '\0');
+    if (not base32::decode_into(s, ret, {hex}))
+	throw std::runtime_error("Input is not valid base32-encoded data.");
+    return ret;
+}
@@ -0,0 +1,111 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <algorithm>
+#include "core/codec/base32/codec.h"
+#include "core/codec/base32/kernels.h"
+
+namespace base32
+{
+
+namespace {
+
+// The number of characters validated per block.
+constexpr size_t BlockSize = 4096;
+
+// The number of characters encoding the bytes of a short final
+// quantum, indexed by the number of bytes.
+constexpr size_t TailChars[5] = { 0, 2, 4, 5, 7 };
+
+// Return the number of trailing padding characters of `in`.
+size_t padding(std::string_view in) {
+    size_t n{0};
+    while (n < in.size() and in[in.size() - n - 1] == '=')
+	++n;
+    return n;
+}
+
+// Decode `in` into `out` unless null, i.e. only validate.
+Result decode(std::string_view in, unsigned char *out, size_t capacity, bool hex) {
+    auto pad = padding(in);
+    auto n = in.size() - pad, tail = n % 8;
+    if (tail == 1 or tail == 3 or tail == 6 or (pad > 0 and (pad > 6 or in.size() % 8 != 0)))
+	return {Status::InvalidLength, 0};
+    if (out and decoded_length(in) > capacity)
+	return {Status::OutputTooSmall, 0};
+
+    // The whole quanta are decoded by the kernels, into the scratch
+    // buffer a block at a time when validating.
+    auto& k = kernels();
+    unsigned char scratch[BlockSize / 8 * 5];
+    size_t pos{0}, count{0}, body = n - tail;
+    while (pos < body) {
+	auto m = std::min(body - pos, out ? body : BlockSize);
+	auto decoded = k.decode(in.data() + pos, m, out ? out + count : scratch, hex);
+	pos += decoded;
+	count += decoded / 8 * 5;
+	if (decoded < m)
+	    return {Status::InvalidCharacter, count};
+    }
+
+    uint64_t bits{0};
+    for (size_t i = 0; i < tail; ++i) {
+	auto v = value(in[pos + i], hex);
+	if (v == Invalid)
+	    return {Status::InvalidCharacter, count};
+	bits = (bits << 5) | v;
+    }
+    bits <<= 5 * (8 - tail);
+    for (size_t i = 0; i < tail * 5 / 8; ++i, ++count)
+	if (out)
+	    out[count] = bits >> (32 - 8 * i);
+    return {Status::Ok, count};
+}
+
+}; // anonymous
+
+size_t encoded_length(size_t n, const Options& options) {
+    if (options.pad)
+	return (n + 4) / 5 * 8;
+    return n / 5 * 8 + TailChars[n % 5];
+}
+
+size_t decoded_length(std::string_view in) {
+    auto n = in.size() - padding(in);
+    return n / 8 * 5 + n % 8 * 5 / 8;
+}
+
+Result encode_into(std::string_view in, std::span<char> out, const Options& options) {
+    auto length = encoded_length(in.size(), options);
+    if (length > out.size())
+	return {Status::OutputTooSmall, 0};
+
+    auto ptr = reinterpret_cast<const unsigned char*>(in.data());
+    auto whole = in.size() / 5 * 5;
+    kernels().encode(ptr, whole, out.data(), options.hex);
+
+    // Encode the final quantum padded with zero bytes, then keep the
+    // characters that encode the input bytes.
+    if (auto tail = in.size() - whole; tail > 0) {
+	unsigned char quantum[5]{};
+	std::copy(ptr + whole, ptr + in.size(), quantum);
+	char chars[8];
+	base32::kernels(Isa::Scalar).encode(quantum, 5, chars, options.hex);
+
+	auto dst = out.data() + whole / 5 * 8;
+	std::copy(chars, chars + TailChars[tail], dst);
+	if (options.pad)
+	    std::fill(dst + TailChars[tail], dst + 8, '=');
+    }
+    return {Status::Ok, length};
+}
+
+Result decode_into(std::string_view in, std::span<char> out, const Options& options) {
+    return decode(in, reinterpret_cast<unsigned char*>(out.data()), out.size(), options.hex);
+}
+
+Result validate(std::string_view in, const Options& options) {
+    return decode(in, nullptr, 0, options.hex);
+}
+
+}; // base32
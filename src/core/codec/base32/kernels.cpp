@@ -0,0 +1,211 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include "core/codec/base32/kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CODEC_BASE32_X86 1
+#include <immintrin.h>
+#endif
+
+namespace base32
+{
+
+namespace {
+
+constexpr const char *Alphabets[2] = {
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567",
+    "0123456789ABCDEFGHIJKLMNOPQRSTUV"
+};
+
+// Map every byte to its 5-bit value in the alphabet, in either case,
+// or `Invalid`.
+constexpr std::array<unsigned char, 256> make_values(const char *alphabet) {
+    std::array<unsigned char, 256> values{};
+    for (auto& v : values)
+	v = Invalid;
+    for (int i = 0; i < 32; ++i) {
+	auto c = alphabet[i];
+	values[(unsigned char)c] = i;
+	if (c >= 'A' and c <= 'Z')
+	    values[(unsigned char)(c - 'A' + 'a')] = i;
+    }
+    return values;
+}
+
+constexpr std::array<unsigned char, 256> Values[2] = { make_values(Alphabets[0]),
+						       make_values(Alphabets[1]) };
+
+void encode_scalar(const unsigned char *in, size_t n, char *out, bool hex) {
+    auto chars = Alphabets[hex];
+    for (size_t i = 0; i < n; i += 5, out += 8) {
+	uint64_t bits = (uint64_t(in[i]) << 32) | (uint64_t(in[i + 1]) << 24)
+	    | (uint64_t(in[i + 2]) << 16) | (uint64_t(in[i + 3]) << 8) | in[i + 4];
+	for (int k = 0; k < 8; ++k)
+	    out[k] = chars[(bits >> (35 - 5 * k)) & 0x1f];
+    }
+}
+
+size_t decode_scalar(const char *in, size_t n, unsigned char *out, bool hex) {
+    const auto& values = Values[hex];
+    size_t i = 0;
+    for (; i < n; i += 8, out += 5) {
+	uint64_t bits{0};
+	unsigned invalid{0};
+	for (int k = 0; k < 8; ++k) {
+	    auto v = values[(unsigned char)in[i + k]];
+	    invalid |= v;
+	    bits = (bits << 5) | (v & 0x1f);
+	}
+	if (invalid > 31)
+	    break;
+	for (int k = 0; k < 5; ++k)
+	    out[k] = bits >> (32 - 8 * k);
+    }
+    return i;
+}
+
+#ifdef CODEC_BASE32_X86
+
+// The AVX-512 VBMI kernels place each quantum of five bytes in a
+// 64-bit lane, extract (or insert) its 5-bit fields with a
+// multishift (or multiply-adds) and look up the characters (or
+// values) with byte permutes. There are no SSSE3 or AVX2 kernels
+// since without byte permutes they gain little over the scalar ones.
+
+// GCC 12 reports its own _mm512_undefined_epi32 as maybe uninitialized.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+constexpr unsigned long long Mask40 = (1ull << 40) - 1;
+
+// The byte permutes between eight quanta of five bytes in (big-endian)
+// order and the low five bytes of the eight 64-bit lanes.
+alignas(64) constexpr auto Spread = []() {
+    std::array<char, 64> spread{};
+    for (int i = 0; i < 8; ++i)
+	for (int p = 0; p < 5; ++p)
+	    spread[8 * i + p] = 5 * i + 4 - p;
+    return spread;
+}();
+
+alignas(64) constexpr auto Gather = []() {
+    std::array<char, 64> gather{};
+    for (int i = 0; i < 8; ++i)
+	for (int p = 0; p < 5; ++p)
+	    gather[5 * i + p] = 8 * i + 4 - p;
+    return gather;
+}();
+
+// The alphabets repeated to cover the 6-bit indices of a permute.
+alignas(64) constexpr auto Lookup = []() {
+    std::array<std::array<char, 64>, 2> lookup{};
+    for (int a = 0; a < 2; ++a)
+	for (int i = 0; i < 64; ++i)
+	    lookup[a][i] = Alphabets[a][i % 32];
+    return lookup;
+}();
+
+// The values of the 128 ASCII characters with the high bit set for
+// invalid characters.
+alignas(64) constexpr auto Lookup128 = []() {
+    std::array<std::array<char, 128>, 2> lookup{};
+    for (int a = 0; a < 2; ++a)
+	for (int i = 0; i < 128; ++i)
+	    lookup[a][i] = Values[a][i] == Invalid ? char(0x80) : char(Values[a][i]);
+    return lookup;
+}();
+
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+void encode_avx512vbmi(const unsigned char *in, size_t n, char *out, bool hex) {
+    const auto lookup = _mm512_load_si512(Lookup[hex].data());
+    const auto spread = _mm512_load_si512(Spread.data());
+    const auto shifts = _mm512_set1_epi64(0x00050a0f14191e23ull);
+    size_t i = 0;
+    for (; i + 40 <= n; i += 40, out += 64) {
+	auto x = _mm512_permutexvar_epi8(spread, _mm512_maskz_loadu_epi8(Mask40, in + i));
+	auto indices = _mm512_multishift_epi64_epi8(shifts, x);
+	_mm512_storeu_si512(out, _mm512_permutexvar_epi8(indices, lookup));
+    }
+    encode_scalar(in + i, n - i, out, hex);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+size_t decode_avx512vbmi(const char *in, size_t n, unsigned char *out, bool hex) {
+    const auto lookup_lo = _mm512_load_si512(Lookup128[hex].data());
+    const auto lookup_hi = _mm512_load_si512(Lookup128[hex].data() + 64);
+    const auto gather = _mm512_load_si512(Gather.data());
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64, out += 40) {
+	auto c = _mm512_loadu_si512(in + i);
+	auto values = _mm512_permutex2var_epi8(lookup_lo, c, lookup_hi);
+	if (_mm512_movepi8_mask(_mm512_or_si512(values, c)) != 0)
+	    break;
+
+	// Merge pairs of 5-bit values, then pairs of 10-bit values and
+	// finally the two 20-bit values of each lane.
+	auto ab = _mm512_maddubs_epi16(values, _mm512_set1_epi16(0x0120));
+	auto abcd = _mm512_madd_epi16(ab, _mm512_set1_epi32(0x00010400));
+	auto bits = _mm512_or_si512(_mm512_slli_epi64(abcd, 20), _mm512_srli_epi64(abcd, 32));
+	_mm512_mask_storeu_epi8(out, Mask40, _mm512_permutexvar_epi8(gather, bits));
+    }
+    return i + decode_scalar(in + i, n - i, out, hex);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // CODEC_BASE32_X86
+
+const Kernels AllKernels[] = {
+    { Isa::Scalar, encode_scalar, decode_scalar },
+#ifdef CODEC_BASE32_X86
+    { Isa::Avx512Vbmi, encode_avx512vbmi, decode_avx512vbmi },
+#endif
+};
+
+}; // anonymous
+
+bool supported(Isa isa) {
+    for (const auto& k : AllKernels)
+	if (k.isa == isa)
+	    return base64::supported(isa);
+    return false;
+}
+
+Isa best_isa() {
+    auto best = Isa::Scalar;
+    for (auto isa : Isas)
+	if (base32::supported(isa))
+	    best = isa;
+    return best;
+}
+
+const Kernels& kernels(Isa isa) {
+    if (base32::supported(isa))
+	for (const auto& k : AllKernels)
+	    if (k.isa == isa)
+		return k;
+    throw std::runtime_error("base32: kernels not supported: " + std::string{name(isa)});
+}
+
+const Kernels& kernels() {
+    static const Kernels& best = base32::kernels(best_isa());
+    return best;
+}
+
+const char *alphabet(bool hex) {
+    return Alphabets[hex];
+}
+
+unsigned char value(char c, bool hex) {
+    return Values[hex][(unsigned char)c];
+}
+
+}; // base32
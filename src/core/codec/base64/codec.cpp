@@ -0,0 +1,406 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "core/codec/base64/codec.h"
+#include "core/codec/base64/kernels.h"
+#include "core/codec/util/parallel.h"
+
+namespace base64
+{
+
+namespace {
+
+// The number of characters gathered, or validated, per block.
+constexpr size_t BlockSize = 4096;
+
+bool is_pad(char c) {
+    return c == '=' or c == '.';
+}
+
+// Encode the `n` bytes at `in` as `(n + 2) / 3 * 4` characters at
+// `out` padding the final quantum.
+void encode_padded(const unsigned char *in, size_t n, char *out, bool url) {
+    auto whole = n / 3 * 3;
+    kernels().encode(in, whole, out, url);
+    if (whole == n)
+	return;
+
+    const char *chars = alphabet(url);
+    const char pad = url ? '.' : '=';
+    in += whole;
+    out += whole / 3 * 4;
+    out[0] = chars[in[0] >> 2];
+    if (n - whole == 2) {
+	out[1] = chars[((in[0] & 0x03) << 4) | (in[1] >> 4)];
+	out[2] = chars[(in[1] & 0x0f) << 2];
+    } else {
+	out[1] = chars[(in[0] & 0x03) << 4];
+	out[2] = pad;
+    }
+    out[3] = pad;
+}
+
+// Decode the `n` characters at `in` into `out` with the semantics of
+// the original `base64_decode` (R. Nyffenegger): every quantum may be
+// padded and the final quantum may be short. All but the final
+// quantum are decoded by the kernels, falling back to the quantum at
+// a time decoding below for the quanta they reject.
+Result decode_block(const char *in, size_t n, unsigned char *out) {
+    auto start = out;
+    auto body = n > 0 ? (n - 1) / 4 * 4 : 0;
+    auto& k = kernels();
+
+    size_t pos = 0;
+    while (pos < n) {
+	if (pos < body) {
+	    auto m = k.decode(in + pos, body - pos, out);
+	    pos += m;
+	    out += m / 4 * 3;
+	}
+
+	if (pos + 1 >= n)
+	    return {Status::InvalidLength, size_t(out - start)};
+
+	auto v0 = value(in[pos]), v1 = value(in[pos + 1]);
+	if (v0 == Invalid or v1 == Invalid)
+	    return {Status::InvalidCharacter, size_t(out - start)};
+	*out++ = (v0 << 2) | ((v1 & 0x30) >> 4);
+
+	if (pos + 2 < n and not is_pad(in[pos + 2])) {
+	    auto v2 = value(in[pos + 2]);
+	    if (v2 == Invalid)
+		return {Status::InvalidCharacter, size_t(out - start)};
+	    *out++ = ((v1 & 0x0f) << 4) | ((v2 & 0x3c) >> 2);
+
+	    if (pos + 3 < n and not is_pad(in[pos + 3])) {
+		auto v3 = value(in[pos + 3]);
+		if (v3 == Invalid)
+		    return {Status::InvalidCharacter, size_t(out - start)};
+		*out++ = ((v2 & 0x03) << 6) | v3;
+	    }
+	}
+	pos += 4;
+    }
+    return {Status::Ok, size_t(out - start)};
+}
+
+// Decode `in` skipping the line breaks ('\n' optionally preceded by
+// '\r') by gathering the characters into blocks of whole quanta for
+// the kernels, which are much slower when called once per line. Write
+// to `out` unless null, i.e. only validate. The first `skip`
+// characters are skipped and the characters of `tail` are appended,
+// which lets a chunk of a larger input start and end on a quantum.
+Result decode_lines(std::string_view in, unsigned char *out, size_t capacity,
+		    size_t skip = 0, std::string_view tail = {}) {
+    char block[BlockSize];
+    unsigned char scratch[BlockSize / 4 * 3];
+    size_t nblock{0}, count{0};
+
+    auto decode = [&](bool final) {
+	auto dst = out ? out + count : scratch;
+	if (out) {
+	    auto need = final ? decoded_length({block, nblock}) : nblock / 4 * 3;
+	    if (count + need > capacity)
+		return Result{Status::OutputTooSmall, count};
+	}
+	auto r = decode_block(block, nblock, dst);
+	count += r.count;
+	nblock = 0;
+	return Result{r.status, count};
+    };
+
+    auto ptr = in.data(), end = ptr + in.size();
+    while (ptr < end) {
+	auto eol = static_cast<const char*>(memchr(ptr, '\n', end - ptr));
+	auto next = eol ? eol + 1 : end;
+	if (eol and eol > ptr and eol[-1] == '\r')
+	    --eol;
+	if (not eol)
+	    eol = end;
+
+	if (skip > 0) {
+	    auto n = std::min<size_t>(eol - ptr, skip);
+	    ptr += n;
+	    skip -= n;
+	}
+
+	while (ptr < eol) {
+	    auto n = std::min<size_t>(eol - ptr, BlockSize - nblock);
+	    memcpy(block + nblock, ptr, n);
+	    nblock += n;
+	    ptr += n;
+	    if (nblock == BlockSize) {
+		if (auto r = decode(false); not r)
+		    return r;
+	    }
+	}
+	ptr = next;
+    }
+
+    if (nblock + tail.size() > BlockSize) {
+	if (auto r = decode(false); not r)
+	    return r;
+    }
+    memcpy(block + nblock, tail.data(), tail.size());
+    nblock += tail.size();
+    return decode(true);
+}
+
+// The smallest chunk worth handing to another thread.
+constexpr size_t MinChunkSize = 256 * 1024;
+
+// Return the number of threads and chunks to use for `n` bytes or
+// characters; a single chunk means the work is not worth splitting.
+std::pair<size_t, size_t> split(size_t n, const ParallelOptions& parallel) {
+    auto threads = parallel.threads > 0 ? parallel.threads : core::codec::hardware_threads();
+    if (threads <= 1 or n < parallel.threshold)
+	return {1, 1};
+    return {threads, std::clamp<size_t>(n / MinChunkSize, 1, 4 * threads)};
+}
+
+// Return the number of characters of `in` that are not line breaks.
+size_t count_chars(std::string_view in) {
+    auto count = in.size();
+    auto ptr = in.data(), end = ptr + in.size();
+    while (auto eol = static_cast<const char*>(memchr(ptr, '\n', end - ptr))) {
+	count -= (eol > in.data() and eol[-1] == '\r') ? 2 : 1;
+	ptr = eol + 1;
+    }
+    return count;
+}
+
+// Copy up to the first `n` characters of `in` that are not line
+// breaks to `out`, returning the number copied.
+size_t take_chars(std::string_view in, char *out, size_t n) {
+    size_t count{0};
+    for (size_t i = 0; i < in.size() and count < n; ++i) {
+	if (in[i] == '\n' or (in[i] == '\r' and i + 1 < in.size() and in[i + 1] == '\n'))
+	    continue;
+	out[count++] = in[i];
+    }
+    return count;
+}
+
+// Move the output of each chunk, decoded at `offsets`, down to follow
+// the output of the previous chunk, closing the gaps left by padded
+// quanta within the input. Return the combined result up to the first
+// failed chunk.
+Result compact(const std::vector<Result>& results, const std::vector<size_t>& offsets, char *out) {
+    size_t count{0};
+    for (size_t i = 0; i < results.size(); ++i) {
+	if (count != offsets[i])
+	    memmove(out + count, out + offsets[i], results[i].count);
+	count += results[i].count;
+	if (not results[i])
+	    return {results[i].status, count};
+    }
+    return {Status::Ok, count};
+}
+
+}; // anonymous
+
+std::string_view name(Status status) {
+    switch (status) {
+    case Status::Ok: return "ok";
+    case Status::InvalidCharacter: return "invalid character";
+    case Status::InvalidLength: return "invalid length";
+    case Status::InvalidLineLength: return "invalid line length";
+    case Status::OutputTooSmall: return "output too small";
+    }
+    return "unknown";
+}
+
+size_t encoded_length(size_t n, const Options& options) {
+    auto len = (n + 2) / 3 * 4;
+    if (options.line_length > 0 and len > 0)
+	len += (len - 1) / options.line_length;
+    return len;
+}
+
+size_t decoded_length(std::string_view in) {
+    auto n = in.size();
+    if (n == 0)
+	return 0;
+
+    // The bytes of the final quantum as decoded by `decode_block`.
+    auto tail = n % 4 ? n % 4 : 4;
+    size_t bytes{0};
+    if (tail >= 2) {
+	bytes = 1;
+	if (tail >= 3 and not is_pad(in[n - tail + 2])) {
+	    bytes = 2;
+	    if (tail == 4 and not is_pad(in[n - 1]))
+		bytes = 3;
+	}
+    }
+    return (n - tail) / 4 * 3 + bytes;
+}
+
+Result encode_into(std::string_view in, std::span<char> out, const Options& options) {
+    const auto line_length = options.line_length;
+    if (line_length % 4 != 0)
+	return {Status::InvalidLineLength, 0};
+
+    auto need = encoded_length(in.size(), options);
+    if (need > out.size())
+	return {Status::OutputTooSmall, 0};
+
+    auto ptr = reinterpret_cast<const unsigned char*>(in.data());
+    auto n = in.size();
+    auto dst = out.data();
+    if (line_length == 0) {
+	encode_padded(ptr, n, dst, options.url);
+	return {Status::Ok, need};
+    }
+
+    // Blocks of short lines are encoded by a single kernel call into a
+    // small buffer and copied line by line.
+    auto& k = kernels();
+    const size_t bytes_per_line = line_length / 4 * 3;
+    const size_t lines_per_block = std::max<size_t>(BlockSize / line_length, 1);
+    char block[BlockSize];
+    while (n > bytes_per_line) {
+	auto lines = std::min((n - 1) / bytes_per_line, lines_per_block);
+	if (line_length > BlockSize) {
+	    k.encode(ptr, bytes_per_line, dst, options.url);
+	    dst += line_length;
+	    *dst++ = '\n';
+	} else {
+	    k.encode(ptr, lines * bytes_per_line, block, options.url);
+	    for (size_t i = 0; i < lines; ++i) {
+		memcpy(dst, block + i * line_length, line_length);
+		dst[line_length] = '\n';
+		dst += line_length + 1;
+	    }
+	}
+	ptr += lines * bytes_per_line;
+	n -= lines * bytes_per_line;
+    }
+    encode_padded(ptr, n, dst, options.url);
+    return {Status::Ok, need};
+}
+
+Result decode_into(std::string_view in, std::span<char> out, bool skip_line_breaks) {
+    auto dst = reinterpret_cast<unsigned char*>(out.data());
+    if (skip_line_breaks)
+	return decode_lines(in, dst, out.size());
+
+    if (decoded_length(in) > out.size())
+	return {Status::OutputTooSmall, 0};
+    return decode_block(in.data(), in.size(), dst);
+}
+
+Result validate(std::string_view in, bool skip_line_breaks) {
+    if (skip_line_breaks)
+	return decode_lines(in, nullptr, 0);
+
+    // The blocks are whole quanta, so decoding them one at a time into
+    // the scratch buffer is equivalent to decoding all of `in`.
+    unsigned char scratch[BlockSize / 4 * 3];
+    size_t count{0};
+    for (size_t pos = 0; pos < in.size(); pos += BlockSize) {
+	auto r = decode_block(in.data() + pos, std::min(BlockSize, in.size() - pos), scratch);
+	count += r.count;
+	if (not r)
+	    return {r.status, count};
+    }
+    return {Status::Ok, count};
+}
+
+Result parallel_encode_into(std::string_view in, std::span<char> out, const Options& options,
+			    const ParallelOptions& parallel) {
+    auto [threads, nchunks] = split(in.size(), parallel);
+    if (nchunks == 1 or options.line_length % 4 != 0)
+	return encode_into(in, out, options);
+
+    auto need = encoded_length(in.size(), options);
+    if (need > out.size())
+	return {Status::OutputTooSmall, 0};
+
+    // The chunks are whole lines so that each chunk is encoded exactly
+    // as it appears in the output followed by a line break.
+    const auto line_length = options.line_length;
+    const size_t unit = line_length > 0 ? line_length / 4 * 3 : 3;
+    auto chunk = (in.size() / nchunks + unit - 1) / unit * unit;
+    nchunks = (in.size() + chunk - 1) / chunk;
+
+    core::codec::parallel_for(nchunks, threads, [&](size_t i) {
+	auto begin = i * chunk;
+	auto piece = in.substr(begin, chunk);
+	auto offset = begin / 3 * 4 + (line_length > 0 ? begin / unit : 0);
+	auto length = encoded_length(piece.size(), options);
+	encode_into(piece, out.subspan(offset, length), options);
+	if (line_length > 0 and i + 1 < nchunks)
+	    out[offset + length] = '\n';
+    });
+    return {Status::Ok, need};
+}
+
+Result parallel_decode_into(std::string_view in, std::span<char> out, bool skip_line_breaks,
+			    const ParallelOptions& parallel) {
+    auto [threads, nchunks] = split(in.size(), parallel);
+    if (nchunks == 1)
+	return decode_into(in, out, skip_line_breaks);
+
+    auto dst = reinterpret_cast<unsigned char*>(out.data());
+    std::vector<Result> results(nchunks);
+    std::vector<size_t> offsets(nchunks);
+
+    if (not skip_line_breaks) {
+	if (decoded_length(in) > out.size())
+	    return {Status::OutputTooSmall, 0};
+
+	auto chunk = (in.size() / nchunks + 3) / 4 * 4;
+	nchunks = (in.size() + chunk - 1) / chunk;
+	results.resize(nchunks);
+	offsets.resize(nchunks);
+	core::codec::parallel_for(nchunks, threads, [&](size_t i) {
+	    auto piece = in.substr(i * chunk, chunk);
+	    offsets[i] = i * chunk / 4 * 3;
+	    results[i] = decode_block(piece.data(), piece.size(), dst + offsets[i]);
+	});
+	return compact(results, offsets, out.data());
+    }
+
+    // Split the raw input, without splitting a "\r\n", and count the
+    // characters of each chunk to find where its quanta start.
+    std::vector<size_t> raw(nchunks + 1), chars(nchunks + 1);
+    for (size_t i = 1; i < nchunks; ++i) {
+	auto pos = i * (in.size() / nchunks);
+	if (in[pos - 1] == '\r' and in[pos] == '\n')
+	    ++pos;
+	raw[i] = pos;
+    }
+    raw[nchunks] = in.size();
+    core::codec::parallel_for(nchunks, threads, [&](size_t i) {
+	chars[i + 1] = count_chars(in.substr(raw[i], raw[i + 1] - raw[i]));
+    });
+    for (size_t i = 0; i < nchunks; ++i)
+	chars[i + 1] += chars[i];
+
+    // Chunk `i` decodes the quanta starting within it, skipping the
+    // characters that complete the last quantum of the previous chunk
+    // and taking those that complete its own from the next.
+    auto total = chars[nchunks];
+    auto quantum = [&](size_t i) { return std::min((chars[i] + 3) / 4 * 4, total); };
+    core::codec::parallel_for(nchunks, threads, [&](size_t i) {
+	auto start = quantum(i), end = quantum(i + 1);
+	offsets[i] = start / 4 * 3;
+	if (start >= end or offsets[i] > out.size()) {
+	    results[i] = {start < end ? Status::OutputTooSmall : Status::Ok, 0};
+	    return;
+	}
+
+	char tail[3];
+	auto ntail = take_chars(in.substr(raw[i + 1]), tail, end - std::max(start, chars[i + 1]));
+	auto capacity = std::min(out.size() - offsets[i], (end - start + 3) / 4 * 3);
+	auto piece = in.substr(raw[i], raw[i + 1] - raw[i]);
+	results[i] = decode_lines(piece, dst + offsets[i], capacity, start - chars[i], {tail, ntail});
+    });
+    return compact(results, offsets, out.data());
+}
+
+}; // base64
@@ -0,0 +1,372 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include "core/codec/base64/kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CODEC_BASE64_X86 1
+#include <immintrin.h>
+#endif
+
+namespace base64
+{
+
+namespace {
+
+const char *Alphabets[2] = {
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/",
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"
+};
+
+// Map every byte to its 6-bit value in either alphabet or `Invalid`.
+constexpr std::array<unsigned char, 256> make_values() {
+    std::array<unsigned char, 256> values{};
+    for (auto& v : values)
+	v = Invalid;
+    for (int i = 0; i < 26; ++i) {
+	values['A' + i] = i;
+	values['a' + i] = 26 + i;
+    }
+    for (int i = 0; i < 10; ++i)
+	values['0' + i] = 52 + i;
+    values['+'] = values['-'] = 62;
+    values['/'] = values['_'] = 63;
+    return values;
+}
+
+constexpr auto Values = make_values();
+
+void encode_scalar(const unsigned char *in, size_t n, char *out, bool url) {
+    auto chars = Alphabets[url];
+    for (size_t i = 0; i < n; i += 3, out += 4) {
+	uint32_t bits = (uint32_t(in[i]) << 16) | (uint32_t(in[i + 1]) << 8) | in[i + 2];
+	out[0] = chars[bits >> 18];
+	out[1] = chars[(bits >> 12) & 0x3f];
+	out[2] = chars[(bits >> 6) & 0x3f];
+	out[3] = chars[bits & 0x3f];
+    }
+}
+
+size_t decode_scalar(const char *in, size_t n, unsigned char *out) {
+    size_t i = 0;
+    for (; i < n; i += 4, out += 3) {
+	uint32_t a = Values[(unsigned char)in[i]];
+	uint32_t b = Values[(unsigned char)in[i + 1]];
+	uint32_t c = Values[(unsigned char)in[i + 2]];
+	uint32_t d = Values[(unsigned char)in[i + 3]];
+	if ((a | b | c | d) > 63)
+	    break;
+	uint32_t bits = (a << 18) | (b << 12) | (c << 6) | d;
+	out[0] = bits >> 16;
+	out[1] = bits >> 8;
+	out[2] = bits;
+    }
+    return i;
+}
+
+#ifdef CODEC_BASE64_X86
+
+// The SSSE3 and AVX2 kernels follow W. Muła and D. Lemire, "Faster
+// Base64 Encoding and Decoding Using AVX2 Instructions" (2018). The
+// decoders classify characters by range rather than by nibble lookup
+// so that both alphabets are accepted, as by the scalar decoder.
+
+// Return the shuffle table mapping the translated range of a 6-bit
+// value to the offset of its character (see `translate`).
+#define CODEC_BASE64_SHIFT_LUT(url)					\
+    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,	\
+	'0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,		\
+	(url ? '-' : '+') - 62, (url ? '_' : '/') - 63, 'A', 0, 0
+
+__attribute__((target("ssse3")))
+__m128i translate_ssse3(__m128i indices, __m128i shift_lut) {
+    auto result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    auto less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+    return _mm_add_epi8(_mm_shuffle_epi8(shift_lut, result), indices);
+}
+
+__attribute__((target("ssse3")))
+void encode_ssse3(const unsigned char *in, size_t n, char *out, bool url) {
+    const auto shift_lut = _mm_setr_epi8(CODEC_BASE64_SHIFT_LUT(url));
+    const auto shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 12, out += 16) {
+	auto x = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + i)), shuffle);
+	auto t0 = _mm_mulhi_epu16(_mm_and_si128(x, _mm_set1_epi32(0x0fc0fc00)),
+				  _mm_set1_epi32(0x04000040));
+	auto t1 = _mm_mullo_epi16(_mm_and_si128(x, _mm_set1_epi32(0x003f03f0)),
+				  _mm_set1_epi32(0x01000010));
+	_mm_storeu_si128((__m128i*)out, translate_ssse3(_mm_or_si128(t0, t1), shift_lut));
+    }
+    encode_scalar(in + i, n - i, out, url);
+}
+
+// Return the mask of the bytes of `c` in [lo, hi] (ASCII only).
+__attribute__((target("ssse3")))
+__m128i in_range_ssse3(__m128i c, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8(lo - 1)),
+			 _mm_cmpgt_epi8(_mm_set1_epi8(hi + 1), c));
+}
+
+// Translate the characters `c` into their 6-bit values returning
+// false if any character is not in either alphabet.
+__attribute__((target("ssse3")))
+bool values_ssse3(__m128i c, __m128i& values) {
+    auto upper = in_range_ssse3(c, 'A', 'Z');
+    auto lower = in_range_ssse3(c, 'a', 'z');
+    auto digit = in_range_ssse3(c, '0', '9');
+    auto v62 = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('+')), _mm_cmpeq_epi8(c, _mm_set1_epi8('-')));
+    auto v63 = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('/')), _mm_cmpeq_epi8(c, _mm_set1_epi8('_')));
+    auto special = _mm_or_si128(v62, v63);
+    auto valid = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, special));
+    if (_mm_movemask_epi8(valid) != 0xffff)
+	return false;
+
+    auto shift = _mm_or_si128(_mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-65)),
+					   _mm_and_si128(lower, _mm_set1_epi8(-71))),
+			      _mm_and_si128(digit, _mm_set1_epi8(4)));
+    values = _mm_or_si128(_mm_andnot_si128(special, _mm_add_epi8(c, shift)),
+			  _mm_or_si128(_mm_and_si128(v62, _mm_set1_epi8(62)),
+				       _mm_and_si128(v63, _mm_set1_epi8(63))));
+    return true;
+}
+
+// Pack the 6-bit values of each 32-bit lane into its low three bytes
+// (in big-endian order).
+__attribute__((target("ssse3")))
+__m128i merge_ssse3(__m128i values) {
+    auto ab_bc = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    return _mm_madd_epi16(ab_bc, _mm_set1_epi32(0x00011000));
+}
+
+__attribute__((target("ssse3")))
+size_t decode_ssse3(const char *in, size_t n, unsigned char *out) {
+    const auto pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    size_t i = 0;
+    // Each iteration stores 16 bytes of which 12 are decoded.
+    for (; i + 24 <= n; i += 16, out += 12) {
+	__m128i values;
+	if (not values_ssse3(_mm_loadu_si128((const __m128i*)(in + i)), values))
+	    break;
+	_mm_storeu_si128((__m128i*)out, _mm_shuffle_epi8(merge_ssse3(values), pack));
+    }
+    return i + decode_scalar(in + i, n - i, out);
+}
+
+__attribute__((target("avx2")))
+__m256i translate_avx2(__m256i indices, __m256i shift_lut) {
+    auto result = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    auto less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+    result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+    return _mm256_add_epi8(_mm256_shuffle_epi8(shift_lut, result), indices);
+}
+
+__attribute__((target("avx2")))
+void encode_avx2(const unsigned char *in, size_t n, char *out, bool url) {
+    const auto shift_lut = _mm256_setr_epi8(CODEC_BASE64_SHIFT_LUT(url), CODEC_BASE64_SHIFT_LUT(url));
+    const auto shuffle = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+					 10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    size_t i = 0;
+    // Each lane loads 16 bytes of which 12 are encoded.
+    for (; i + 28 <= n; i += 24, out += 32) {
+	auto lo = _mm_loadu_si128((const __m128i*)(in + i));
+	auto hi = _mm_loadu_si128((const __m128i*)(in + i + 12));
+	auto x = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+	x = _mm256_shuffle_epi8(x, shuffle);
+	auto t0 = _mm256_mulhi_epu16(_mm256_and_si256(x, _mm256_set1_epi32(0x0fc0fc00)),
+				     _mm256_set1_epi32(0x04000040));
+	auto t1 = _mm256_mullo_epi16(_mm256_and_si256(x, _mm256_set1_epi32(0x003f03f0)),
+				     _mm256_set1_epi32(0x01000010));
+	_mm256_storeu_si256((__m256i*)out, translate_avx2(_mm256_or_si256(t0, t1), shift_lut));
+    }
+    // Clear the upper halves before the legacy SSE encoded tail to
+    // avoid the AVX-SSE transition penalty.
+    _mm256_zeroupper();
+    encode_ssse3(in + i, n - i, out, url);
+}
+
+__attribute__((target("avx2")))
+__m256i in_range_avx2(__m256i c, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8(lo - 1)),
+			    _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), c));
+}
+
+__attribute__((target("avx2")))
+bool values_avx2(__m256i c, __m256i& values) {
+    auto upper = in_range_avx2(c, 'A', 'Z');
+    auto lower = in_range_avx2(c, 'a', 'z');
+    auto digit = in_range_avx2(c, '0', '9');
+    auto v62 = _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('+')),
+			       _mm256_cmpeq_epi8(c, _mm256_set1_epi8('-')));
+    auto v63 = _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('/')),
+			       _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_')));
+    auto special = _mm256_or_si256(v62, v63);
+    auto valid = _mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(digit, special));
+    if (_mm256_movemask_epi8(valid) != -1)
+	return false;
+
+    auto shift = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(upper, _mm256_set1_epi8(-65)),
+						 _mm256_and_si256(lower, _mm256_set1_epi8(-71))),
+				 _mm256_and_si256(digit, _mm256_set1_epi8(4)));
+    values = _mm256_or_si256(_mm256_andnot_si256(special, _mm256_add_epi8(c, shift)),
+			     _mm256_or_si256(_mm256_and_si256(v62, _mm256_set1_epi8(62)),
+					     _mm256_and_si256(v63, _mm256_set1_epi8(63))));
+    return true;
+}
+
+__attribute__((target("avx2")))
+size_t decode_avx2(const char *in, size_t n, unsigned char *out) {
+    const auto pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+				       2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const auto compact = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1);
+    size_t i = 0;
+    // Each iteration stores 32 bytes of which 24 are decoded.
+    for (; i + 48 <= n; i += 32, out += 24) {
+	__m256i values;
+	if (not values_avx2(_mm256_loadu_si256((const __m256i*)(in + i)), values))
+	    break;
+	auto ab_bc = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+	auto merged = _mm256_madd_epi16(ab_bc, _mm256_set1_epi32(0x00011000));
+	auto packed = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(merged, pack), compact);
+	_mm256_storeu_si256((__m256i*)out, packed);
+    }
+    _mm256_zeroupper();
+    return i + decode_ssse3(in + i, n - i, out);
+}
+
+// The AVX-512 VBMI kernels use byte permutes for both the reshuffling
+// and the character lookups (after W. Muła, "Base64 encoding and
+// decoding with AVX512BW and AVX512VBMI", 2016).
+
+// GCC 12 reports its own _mm512_undefined_epi32 as maybe uninitialized.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+constexpr unsigned long long Mask48 = (1ull << 48) - 1;
+
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+void encode_avx512vbmi(const unsigned char *in, size_t n, char *out, bool url) {
+    const auto lookup = _mm512_loadu_si512(Alphabets[url]);
+    const auto shuffle = _mm512_setr_epi32(0x01020001, 0x04050304, 0x07080607, 0x0a0b090a,
+					   0x0d0e0c0d, 0x10110f10, 0x13141213, 0x16171516,
+					   0x191a1819, 0x1c1d1b1c, 0x1f201e1f, 0x22232122,
+					   0x25262425, 0x28292728, 0x2b2c2a2b, 0x2e2f2d2e);
+    const auto shifts = _mm512_set1_epi64(0x3036242a1016040aull);
+    size_t i = 0;
+    for (; i + 48 <= n; i += 48, out += 64) {
+	auto x = _mm512_permutexvar_epi8(shuffle, _mm512_maskz_loadu_epi8(Mask48, in + i));
+	auto indices = _mm512_multishift_epi64_epi8(shifts, x);
+	_mm512_storeu_si512(out, _mm512_permutexvar_epi8(indices, lookup));
+    }
+    encode_avx2(in + i, n - i, out, url);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+size_t decode_avx512vbmi(const char *in, size_t n, unsigned char *out) {
+    // The values of the 128 ASCII characters with the high bit set
+    // for invalid characters.
+    alignas(64) static const auto Lookup = []() {
+	std::array<char, 128> lookup;
+	for (size_t i = 0; i < lookup.size(); ++i)
+	    lookup[i] = Values[i] == Invalid ? char(0x80) : char(Values[i]);
+	return lookup;
+    }();
+    const auto lookup_lo = _mm512_loadu_si512(Lookup.data());
+    const auto lookup_hi = _mm512_loadu_si512(Lookup.data() + 64);
+    const auto pack = _mm512_setr_epi32(0x06000102, 0x090a0405, 0x0c0d0e08, 0x16101112,
+					0x191a1415, 0x1c1d1e18, 0x26202122, 0x292a2425,
+					0x2c2d2e28, 0x36303132, 0x393a3435, 0x3c3d3e38,
+					0, 0, 0, 0);
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64, out += 48) {
+	auto c = _mm512_loadu_si512(in + i);
+	auto values = _mm512_permutex2var_epi8(lookup_lo, c, lookup_hi);
+	if (_mm512_movepi8_mask(_mm512_or_si512(values, c)) != 0)
+	    break;
+	auto ab_bc = _mm512_maddubs_epi16(values, _mm512_set1_epi32(0x01400140));
+	auto merged = _mm512_madd_epi16(ab_bc, _mm512_set1_epi32(0x00011000));
+	_mm512_mask_storeu_epi8(out, Mask48, _mm512_permutexvar_epi8(pack, merged));
+    }
+    return i + decode_avx2(in + i, n - i, out);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // CODEC_BASE64_X86
+
+const Kernels AllKernels[] = {
+    { Isa::Scalar, encode_scalar, decode_scalar },
+#ifdef CODEC_BASE64_X86
+    { Isa::Ssse3, encode_ssse3, decode_ssse3 },
+    { Isa::Avx2, encode_avx2, decode_avx2 },
+    { Isa::Avx512Vbmi, encode_avx512vbmi, decode_avx512vbmi },
+#endif
+};
+
+}; // anonymous
+
+std::string_view name(Isa isa) {
+    switch (isa) {
+    case Isa::Scalar: return "scalar";
+    case Isa::Ssse3: return "ssse3";
+    case Isa::Avx2: return "avx2";
+    case Isa::Avx512Vbmi: return "avx512vbmi";
+    }
+    return "unknown";
+}
+
+bool supported(Isa isa) {
+    switch (isa) {
+    case Isa::Scalar:
+	return true;
+#ifdef CODEC_BASE64_X86
+    case Isa::Ssse3:
+	return __builtin_cpu_supports("ssse3");
+    case Isa::Avx2:
+	return __builtin_cpu_supports("avx2");
+    case Isa::Avx512Vbmi:
+	return __builtin_cpu_supports("avx512bw") and __builtin_cpu_supports("avx512vbmi");
+#endif
+    default:
+	return false;
+    }
+}
+
+Isa best_isa() {
+    auto best = Isa::Scalar;
+    for (auto isa : Isas)
+	if (supported(isa))
+	    best = isa;
+    return best;
+}
+
+const Kernels& kernels(Isa isa) {
+    if (supported(isa))
+	for (const auto& k : AllKernels)
+	    if (k.isa == isa)
+		return k;
+    throw std::runtime_error("base64: kernels not supported: " + std::string{name(isa)});
+}
+
+const Kernels& kernels() {
+    static const Kernels& best = kernels(best_isa());
+    return best;
+}
+
+const char *alphabet(bool url) {
+    return Alphabets[url];
+}
+
+unsigned char value(char c) {
+    return Values[(unsigned char)c];
+}
+
+}; // base64
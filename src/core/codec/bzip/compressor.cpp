@@ -5,18 +5,25 @@
 #include <sstream>
 #include "core/codec/bzip/compressor.h"
 #include "core/codec/bzip/new_stream.h"
+#include "core/codec/zstd/adapter.h"
+#include "core/codec/util/byte_io.h"
 
 namespace bzip {
 
+// The state allocated by libbzip2 for compressing with 100k blocks
+// (400k + 8 x block size per the libbzip2 manual).
+static constexpr size_t CompressStateSize = 400'000 + 8 * 100'000;
+
 template<class Sink>
-Compressor<Sink>::Compressor(Sink& sink, size_t n)
+Compressor<Sink>::Compressor(Sink& sink, size_t n, core::Allocator *alloc)
     : sink_(sink)
-    , stream_(new_stream())
-    , get_(stream_->next_out, stream_->avail_out, n)
+    , stream_(new_stream(alloc))
+    , get_(stream_->next_out, stream_->avail_out, n, alloc)
 {
     auto rc = BZ2_bzCompressInit(stream_.get(), 1, 0, 0);
     if (rc != BZ_OK)
 	throw std::runtime_error(fmt::format("BZ2_bzCompressInit: failed with {}", rc));
+    stats_.memory([&]() { return CompressStateSize + get_.capacity(); });
 }
 
 template<class Sink>
@@ -33,13 +40,17 @@ void Compressor<Sink>::close() {
     while (true) {
 	get_.clear();
 	
-	auto rc = BZ2_bzCompress(stream_.get(), BZ_FINISH);
+	int rc;
+	{
+	    auto timer = stats_.time_codec();
+	    rc = BZ2_bzCompress(stream_.get(), BZ_FINISH);
+	}
 	if (rc != BZ_FINISH_OK and rc != BZ_STREAM_END)
 	    throw std::runtime_error
 		(fmt::format("BZ2_bzCompress(stream, BZ_FINISH): failed with {}", rc));
 
 	get_.update();
-	sink_.write(get_.data(), get_.size());
+	flush();
 	
 	if (rc == BZ_STREAM_END)
 	    break;
@@ -49,20 +60,35 @@ void Compressor<Sink>::close() {
 	throw std::runtime_error
 	    (fmt::format("BZ2_bzCompressEnd: failed with {}", rc));
     stream_.reset();
+    stats_.end_frame();
+}
+
+template<class Sink>
+void Compressor<Sink>::flush() {
+    auto timer = stats_.time_sink(zstd::QueuePush<Sink&>);
+    sink_.write(get_.data(), get_.size());
+    stats_.add_out(get_.size());
 }
 
 template<class Sink>
 void Compressor<Sink>::write(const char *input, size_t input_len) {
     stream_->next_in = (char*)input;
     stream_->avail_in = input_len;
+    stats_.add_in(input_len);
+    stats_.add_frame_bytes(input_len);
     
     while (stream_->avail_in > 0) {
 	get_.clear();
-	auto rc = BZ2_bzCompress(stream_.get(), BZ_RUN);
+	int rc;
+	{
+	    auto timer = stats_.time_codec();
+	    rc = BZ2_bzCompress(stream_.get(), BZ_RUN);
+	}
 	if (rc != BZ_RUN_OK)
 	    throw std::runtime_error
 		(fmt::format("BZ2_bzCompress: failed with {}", rc));
-	sink_.write(get_.data(), get_.size());
+	get_.update();
+	flush();
     }
 }
 
@@ -70,5 +96,6 @@ void Compressor<Sink>::write(const char *input, size_t input_len) {
 
 template class bzip::Compressor<std::ostream>;
 template class bzip::Compressor<std::stringstream>;
+template class bzip::Compressor<core::codec::ByteSink>;
 
 
@@ -6,19 +6,26 @@
 #include <sstream>
 #include "core/codec/bzip/decompressor.h"
 #include "core/codec/zstd/adapter.h"
+#include "core/codec/util/byte_io.h"
+#include "core/codec/util/peek_source.h"
 
 namespace bzip {
 
+// The state allocated by libbzip2 for decompressing 100k blocks
+// (100k + 4 x block size per the libbzip2 manual).
+static constexpr size_t DecompressStateSize = 100'000 + 4 * 100'000;
+
 template<class Source>
-Decompressor<Source>::Decompressor(Source& source, size_t n)
+Decompressor<Source>::Decompressor(Source& source, size_t n, core::Allocator *alloc)
     : src_(source)
-    , bz_(new_stream())
-    , get_(bz_->next_out, bz_->avail_out, n)
-    , put_(bz_->next_in, bz_->avail_in, n)
+    , bz_(new_stream(alloc))
+    , get_(bz_->next_out, bz_->avail_out, n, alloc)
+    , put_(bz_->next_in, bz_->avail_in, n, alloc)
 {
     auto rc = BZ2_bzDecompressInit(bz_.get(), 0, 0);
     if (rc != BZ_OK)
 	throw std::runtime_error(fmt::format("BZ2_bzDecompressInit: failed with {}", rc));
+    stats_.memory([&]() { return DecompressStateSize + get_.capacity() + put_.capacity(); });
 }
 
 template<class Source>
@@ -83,8 +90,13 @@ bool Decompressor<Source>::underflow() {
 
     while (true) {
 	if (put_.empty()) {
-	    auto count = zstd::InStreamAdapter<Source>::read(src_, put_.begin(), put_.capacity());
+	    size_t count;
+	    {
+		auto timer = stats_.time_source(zstd::QueuePop<Source&>);
+		count = zstd::InStreamAdapter<Source>::read(src_, put_.begin(), put_.capacity());
+	    }
 	    put_.update(count);
+	    stats_.add_in(count);
 	    
 	    if (count == 0) {
 		close();
@@ -94,11 +106,19 @@ bool Decompressor<Source>::underflow() {
 	
 	get_.clear();
 	
-	auto rc = BZ2_bzDecompress(bz_.get());
+	int rc;
+	{
+	    auto timer = stats_.time_codec();
+	    rc = BZ2_bzDecompress(bz_.get());
+	}
 	if (rc != BZ_OK and rc != BZ_STREAM_END)
 	    throw std::runtime_error(fmt::format("BZ2_bzDecompress: failed with {}", rc));
 
 	get_.update();
+	stats_.add_out(get_.size());
+	stats_.add_frame_bytes(get_.size());
+	if (rc == BZ_STREAM_END)
+	    stats_.end_frame();
 	
 	if (get_.available())
 	    return true;
@@ -109,3 +129,5 @@ bool Decompressor<Source>::underflow() {
 
 template class bzip::Decompressor<std::istream>;
 template class bzip::Decompressor<std::stringstream>;
+template class bzip::Decompressor<core::PeekSource>;
+template class bzip::Decompressor<core::codec::ByteSource>;
@@ -5,8 +5,9 @@
 
 namespace bzip {
 
-GetArea::GetArea(char *&next, unsigned int& avail, unsigned int capacity)
-    : core::GetArea(capacity)
+GetArea::GetArea(char *&next, unsigned int& avail, unsigned int capacity,
+		 core::Allocator *alloc)
+    : core::GetArea(capacity, alloc)
     , next_(next)
     , avail_(avail) {
     next_ = begin();
@@ -7,8 +7,8 @@
 
 namespace bzip {
 
-PutArea::PutArea(char *&next, uint& avail, uint capacity)
-    : core::BufferedArea(capacity)
+PutArea::PutArea(char *&next, uint& avail, uint capacity, core::Allocator *alloc)
+    : core::BufferedArea(capacity, alloc)
     , next_(next)
     , avail_(avail) {
 }
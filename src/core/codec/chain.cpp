@@ -0,0 +1,55 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <algorithm>
+#include <cstring>
+#include "core/codec/chain.h"
+
+namespace core::codec
+{
+
+void pipe(ByteSource& source, ByteSink& sink, size_t n) {
+    std::string buffer(n, '\0');
+    while (auto count = source.read_bytes(buffer.data(), buffer.size()))
+	sink.write(buffer.data(), count);
+    sink.close();
+}
+
+void pipe(ByteSource& source, ByteSink&& sink, size_t n) {
+    pipe(source, sink, n);
+}
+
+size_t StringSource::read_bytes(char *ptr, size_t count) {
+    auto n = std::min(count, str_.size());
+    memcpy(ptr, str_.data(), n);
+    str_.remove_prefix(n);
+    return n;
+}
+
+ZstdSink::ZstdSink(ByteSink& next, int level)
+    : compressor_(next) {
+    if (level != 0)
+	compressor_.set_level(level);
+}
+
+size_t ZstdSource::read_bytes(char *ptr, size_t count) {
+    if (eof_)
+	return 0;
+    auto n = decompressor_.read_bytes(ptr, count);
+    eof_ = n < count;
+    return n;
+}
+
+void BzipSink::close() {
+    compressor_.close();
+    next_.close();
+}
+
+void Base64Sink::close() {
+    if (closed_)
+	return;
+    closed_ = true;
+    encoder_.close();
+}
+
+}; // core::codec
@@ -0,0 +1,70 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include "core/codec/compressed_vector.h"
+#include "core/codec/zstd/custom_mem.h"
+#include "core/codec/zstd/exception.h"
+
+namespace core::codec
+{
+
+namespace {
+
+// The zstd contexts and scratch buffers of the calling thread, reused
+// across chunks.
+struct Contexts {
+    Contexts()
+	: cctx(ZSTD_createCCtx_advanced(zstd::custom_mem(core::default_allocator())))
+	, dctx(ZSTD_createDCtx_advanced(zstd::custom_mem(core::default_allocator()))) {
+    }
+
+    ~Contexts() {
+	ZSTD_freeCCtx(cctx);
+	ZSTD_freeDCtx(dctx);
+    }
+
+    ZSTD_CCtx *cctx;
+    ZSTD_DCtx *dctx;
+    std::string filtered, compressed;
+};
+
+Contexts& contexts() {
+    static thread_local Contexts ctx;
+    return ctx;
+}
+
+}; // anonymous
+
+ChunkCodec::ChunkCodec(size_t typesize, const CompressedVectorOptions& options)
+    : typesize_(typesize)
+    , filter_(options.filter)
+    , level_(options.level) {
+}
+
+std::string ChunkCodec::compress(const char *data, size_t n) const {
+    auto& ctx = contexts();
+    if (filter_) {
+	ctx.filtered.resize(n);
+	shuffle::encode(data, n, ctx.filtered.data(), typesize_, *filter_);
+	data = ctx.filtered.data();
+    }
+
+    // Compress into scratch so the chunk is allocated to its size.
+    ctx.compressed.resize(ZSTD_compressBound(n));
+    auto size = ZSTD_compressCCtx(ctx.cctx, ctx.compressed.data(), ctx.compressed.size(), data, n, level_);
+    if (ZSTD_isError(size))
+	throw zstd::error("compressed_vector: %s", ZSTD_getErrorName(size));
+    return std::string{ctx.compressed.data(), size};
+}
+
+void ChunkCodec::decompress(std::string_view chunk, char *out, size_t n) const {
+    auto size = ZSTD_decompressDCtx(contexts().dctx, out, n, chunk.data(), chunk.size());
+    if (ZSTD_isError(size))
+	throw zstd::error("compressed_vector: %s", ZSTD_getErrorName(size));
+    if (size != n)
+	throw zstd::error("compressed_vector: chunk of %d bytes instead of %d", size, n);
+    if (filter_)
+	shuffle::decode(out, n, out, typesize_, *filter_);
+}
+
+}; // core::codec
@@ -0,0 +1,289 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include "core/codec/corpus/corpus.h"
+
+namespace core::codec::corpus
+{
+
+namespace {
+
+constexpr int64_t StartMillis = 1647216000000;	// 2022-03-14T00:00:00Z
+
+const char *Names[] = {
+    "log", "json", "sorted_ints", "floats", "timestamps", "random", "repetitive"
+};
+
+const char *Levels[] = { "INFO ", "INFO ", "INFO ", "INFO ", "INFO ", "INFO ", "INFO ",
+			 "DEBUG", "DEBUG", "WARN ", "ERROR" };
+
+const char *Components[] = { "http", "db", "cache", "scheduler", "auth", "storage" };
+
+const char *Methods[] = { "GET", "GET", "GET", "POST", "PUT", "DELETE" };
+
+const char *Paths[] = { "orders", "users", "items", "sessions", "reports" };
+
+const char *Events[] = { "view", "click", "purchase", "login", "logout", "search" };
+
+const char *Countries[] = { "US", "DE", "FR", "JP", "BR", "IN", "GB", "CA" };
+
+template<class T, size_t N>
+const T& pick(Random& rng, const T (&array)[N]) {
+    return array[rng.below(N)];
+}
+
+uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// Format `millis` since the epoch as an ISO-8601 UTC timestamp using
+// integer arithmetic only (days to civil date after H. Hinnant).
+void format_time(char *buffer, size_t n, int64_t millis) {
+    auto secs = millis / 1000;
+    auto days = secs / 86400;
+    auto rem = secs % 86400;
+    auto z = days + 719468;
+    auto era = z / 146097;
+    auto doe = z - era * 146097;
+    auto yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    auto doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    auto mp = (5 * doy + 2) / 153;
+    auto day = doy - (153 * mp + 2) / 5 + 1;
+    auto month = mp < 10 ? mp + 3 : mp - 9;
+    auto year = yoe + era * 400 + (month <= 2);
+    snprintf(buffer, n, "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
+	     int(year), int(month), int(day), int(rem / 3600), int(rem / 60 % 60),
+	     int(rem % 60), int(millis % 1000));
+}
+
+template<class T>
+std::string to_bytes(const std::vector<T>& values, size_t size) {
+    std::string bytes;
+    bytes.reserve(values.size() * sizeof(T));
+    for (auto value : values) {
+	uint64_t bits;
+	if constexpr (std::is_same_v<T, double>)
+	    memcpy(&bits, &value, sizeof(bits));
+	else
+	    bits = uint64_t(value);
+	for (size_t i = 0; i < sizeof(T); ++i)
+	    bytes.push_back(char((bits >> (8 * i)) & 0xff));
+    }
+    bytes.resize(size);
+    return bytes;
+}
+
+size_t count_for(size_t size, size_t elem_size) {
+    return (size + elem_size - 1) / elem_size;
+}
+
+}; // anonymous
+
+Random::Random(uint64_t seed) {
+    for (auto& s : s_)
+	s = splitmix64(seed);
+}
+
+uint64_t Random::operator()() {
+    auto result = rotl(s_[1] * 5, 7) * 9;
+    auto t = s_[1] << 17;
+    s_[2] ^= s_[0];
+    s_[3] ^= s_[1];
+    s_[1] ^= s_[2];
+    s_[0] ^= s_[3];
+    s_[2] ^= t;
+    s_[3] = rotl(s_[3], 45);
+    return result;
+}
+
+uint64_t Random::below(uint64_t n) {
+    return uint64_t((__uint128_t((*this)()) * n) >> 64);
+}
+
+std::string_view name(Kind kind) {
+    return Names[int(kind)];
+}
+
+Kind parse_kind(std::string_view str) {
+    for (auto kind : Kinds)
+	if (name(kind) == str)
+	    return kind;
+    throw std::runtime_error("corpus: unknown kind: " + std::string{str});
+}
+
+std::string generate(Kind kind, size_t size, uint64_t seed) {
+    switch (kind) {
+    case Kind::Log: return log_text(size, seed);
+    case Kind::Json: return json_records(size, seed);
+    case Kind::SortedInts: return to_bytes(sorted_ints(count_for(size, 8), seed), size);
+    case Kind::Floats: return to_bytes(floats(count_for(size, 8), seed), size);
+    case Kind::Timestamps: return to_bytes(timestamps(count_for(size, 8), seed), size);
+    case Kind::Random: return random_bytes(size, seed);
+    case Kind::Repetitive: return repetitive(size, seed);
+    }
+    throw std::runtime_error("corpus: bad kind");
+}
+
+std::string log_text(size_t size, uint64_t seed) {
+    Random rng{seed};
+    std::string str;
+    str.reserve(size + 256);
+
+    // The random values are drawn into locals in a fixed order since
+    // the evaluation order of function arguments is unspecified.
+    char stamp[64], line[256];
+    auto millis = StartMillis;
+    while (str.size() < size) {
+	millis += rng.below(250);
+	format_time(stamp, sizeof(stamp), millis);
+	auto level = pick(rng, Levels);
+	auto component = pick(rng, Components);
+	unsigned worker = rng.below(16);
+	unsigned a = rng.below(100000), b = rng.below(65536), c = rng.below(1000);
+	int n{0};
+	switch (rng.below(5)) {
+	case 0: {
+	    auto id = (unsigned long long)rng();
+	    auto method = pick(rng, Methods);
+	    auto path = pick(rng, Paths);
+	    auto status = rng.below(20) == 0 ? 500u : 200u;
+	    n = snprintf(line, sizeof(line),
+			 "%s %s [%s-%u] request id=%016llx method=%s path=/api/v1/%s/%u "
+			 "status=%u latency_ms=%u\n",
+			 stamp, level, component, worker, id, method, path, a, status, c);
+	    break;
+	}
+	case 1:
+	    n = snprintf(line, sizeof(line), "%s %s [%s-%u] cache miss key=user:%u shard=%u\n",
+			 stamp, level, component, worker, a, b % 64);
+	    break;
+	case 2:
+	    n = snprintf(line, sizeof(line), "%s %s [%s-%u] connection from 10.%u.%u.%u:%u accepted\n",
+			 stamp, level, component, worker, b >> 8, b & 0xff, c % 256, 1024 + a % 64512);
+	    break;
+	case 3:
+	    n = snprintf(line, sizeof(line), "%s %s [%s-%u] retrying job %u attempt %u of 5\n",
+			 stamp, level, component, worker, a, 1 + c % 5);
+	    break;
+	default:
+	    n = snprintf(line, sizeof(line),
+			 "%s %s [%s-%u] flushed %u records to segment %06u in %u ms\n",
+			 stamp, level, component, worker, a % 50000, b, c);
+	    break;
+	}
+	str.append(line, n);
+    }
+    str.resize(size);
+    return str;
+}
+
+std::string json_records(size_t size, uint64_t seed) {
+    Random rng{seed};
+    std::string str;
+    str.reserve(size + 256);
+
+    char record[256];
+    auto millis = StartMillis;
+    for (unsigned long long id = 1; str.size() < size; ++id) {
+	millis += rng.below(1000);
+	auto cents = (unsigned long long)rng.below(rng.below(100000) + 1);
+	unsigned user = rng.below(50000);
+	auto event = pick(rng, Events);
+	auto country = pick(rng, Countries);
+	auto mobile = rng.below(3) == 0 ? "true" : "false";
+	auto n = snprintf(record, sizeof(record),
+			  "{\"id\":%llu,\"ts\":%lld,\"user\":\"user_%u\",\"event\":\"%s\","
+			  "\"amount\":%llu.%02llu,\"country\":\"%s\",\"mobile\":%s}\n",
+			  id, (long long)millis, user, event, cents / 100, cents % 100, country, mobile);
+	str.append(record, n);
+    }
+    str.resize(size);
+    return str;
+}
+
+std::vector<int64_t> sorted_ints(size_t count, uint64_t seed) {
+    Random rng{seed};
+    std::vector<int64_t> values(count);
+    int64_t value = rng.below(1000000);
+    for (auto& v : values) {
+	value += rng.below(64);
+	v = value;
+    }
+    return values;
+}
+
+std::vector<double> floats(size_t count, uint64_t seed) {
+    Random rng{seed};
+    std::vector<double> values(count);
+    int64_t cents = 10000 + rng.below(100000);
+    for (auto& v : values) {
+	cents = std::max<int64_t>(1, cents + rng.between(-25, 25));
+	v = double(cents) / 100.0;
+    }
+    return values;
+}
+
+std::vector<int64_t> timestamps(size_t count, uint64_t seed) {
+    Random rng{seed};
+    std::vector<int64_t> values(count);
+    int64_t nanos = StartMillis * 1000000;
+    for (auto& v : values) {
+	nanos += 1000000 + rng.between(-50000, 50000);
+	v = nanos;
+    }
+    return values;
+}
+
+std::string random_bytes(size_t size, uint64_t seed) {
+    Random rng{seed};
+    std::string str(size, '\0');
+    for (size_t i = 0; i < size; i += 8) {
+	auto bits = rng();
+	for (size_t j = i; j < std::min(i + 8, size); ++j, bits >>= 8)
+	    str[j] = char(bits & 0xff);
+    }
+    return str;
+}
+
+std::string repetitive(size_t size, uint64_t seed) {
+    constexpr size_t BlockSize = 256;
+    Random rng{seed};
+    char block[BlockSize];
+    for (auto& c : block)
+	c = char(' ' + rng.below(95));
+
+    std::string str;
+    str.reserve(size + BlockSize);
+    while (str.size() < size) {
+	if (rng.below(16) == 0) {
+	    auto idx = rng.below(BlockSize);
+	    block[idx] = char(' ' + rng.below(95));
+	}
+	str.append(block, BlockSize);
+    }
+    str.resize(size);
+    return str;
+}
+
+uint64_t checksum(std::string_view data) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (unsigned char c : data) {
+	hash ^= c;
+	hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+}; // core::codec::corpus
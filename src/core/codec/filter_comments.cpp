@@ -0,0 +1,141 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <cstring>
+#include "core/codec/filter_comments.h"
+
+namespace core {
+
+CommentFilter::CommentFilter(CommentSyntax syntax)
+    : syntax_(std::move(syntax)) {
+    class_.fill(Other);
+    for (auto c : {' ', '\t', '\r'})
+	class_[(unsigned char)c] = Blank;
+    for (const auto& marker : syntax_.line)
+	if (not marker.empty())
+	    class_[(unsigned char)marker[0]] = Marker;
+    if (not syntax_.block_begin.empty())
+	class_[(unsigned char)syntax_.block_begin[0]] = Marker;
+    if (syntax_.trailing)
+	for (auto c : syntax_.quotes)
+	    class_[(unsigned char)c] = Quote;
+}
+
+size_t CommentFilter::operator()(std::string_view line, char *out) {
+    // Most lines have no comment: with trailing comments, a line
+    // without a marker or quote character, otherwise a line that does
+    // not start with one. Such lines are kept as is.
+    if (not in_block_) {
+	auto p = line.data();
+	size_t i{0}, n = line.size();
+	if (syntax_.trailing) {
+	    while (i < n and class_[(unsigned char)p[i]] < Marker)
+		++i;
+	} else {
+	    while (i < n and class_[(unsigned char)p[i]] == Blank)
+		++i;
+	    if (i < n and class_[(unsigned char)p[i]] != Marker)
+		i = n;
+	}
+	if (i == n) {
+	    if (out != p)
+		memmove(out, p, n);
+	    return n;
+	}
+    }
+    return edit(line, out);
+}
+
+size_t CommentFilter::edit(std::string_view line, char *out) {
+    auto p = line.data();
+    size_t n = line.size();
+    std::string_view eol;
+    if (n > 0 and p[n - 1] == '\n') {
+	eol = n > 1 and p[n - 2] == '\r' ? "\r\n" : "\n";
+	n -= eol.size();
+    }
+    line = line.substr(0, n);
+
+    auto o = out;
+    bool blank{true}, comment{in_block_};
+    char quote{0};
+    size_t i{0};
+    while (i < n) {
+	if (in_block_) {
+	    comment = true;
+	    auto pos = line.find(syntax_.block_end, i);
+	    if (pos == std::string_view::npos)
+		break;
+	    in_block_ = false;
+	    i = pos + syntax_.block_end.size();
+	    continue;
+	}
+
+	// Copy the run of characters up to the next marker or quote.
+	if (not quote and syntax_.trailing) {
+	    auto j = i;
+	    for (; j < n and class_[(unsigned char)p[j]] < Marker; ++j)
+		blank = blank and class_[(unsigned char)p[j]] == Blank;
+	    if (o != p + i)
+		memmove(o, p + i, j - i);
+	    o += j - i;
+	    i = j;
+	    if (i == n)
+		break;
+	}
+
+	auto c = p[i];
+	auto k = class_[(unsigned char)c];
+	if (quote) {
+	    *o++ = c;
+	    ++i;
+	    if (c == quote)
+		quote = 0;
+	    else if (c == '\\' and i < n)
+		*o++ = p[i++];
+	    continue;
+	}
+
+	if (k == Marker and (blank or syntax_.trailing)) {
+	    auto rest = line.substr(i);
+	    if (not syntax_.block_begin.empty() and rest.starts_with(syntax_.block_begin)) {
+		in_block_ = true;
+		comment = true;
+		i += syntax_.block_begin.size();
+		continue;
+	    }
+	    bool matched{false};
+	    for (const auto& marker : syntax_.line)
+		matched = matched or (not marker.empty() and rest.starts_with(marker));
+	    if (matched) {
+		comment = true;
+		break;
+	    }
+	} else if (k == Quote) {
+	    quote = c;
+	} else if (not blank and not syntax_.trailing) {
+	    // Nothing else can be recognized on this line.
+	    memmove(o, p + i, n - i);
+	    o += n - i;
+	    break;
+	}
+
+	if (k != Blank)
+	    blank = false;
+	*o++ = c;
+	++i;
+    }
+
+    // Drop the blanks left before a comment ending the line, and the
+    // line if nothing else is left.
+    if (comment and blank)
+	return 0;
+    if (comment)
+	while (o > out and class_[(unsigned char)o[-1]] == Blank)
+	    --o;
+    memcpy(o, eol.data(), eol.size());
+    o += eol.size();
+    return o - out;
+}
+
+}; // ns core
@@ -0,0 +1,56 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <cstdint>
+#include <cstring>
+#include "core/codec/base64.h"
+#include "core/codec/format.h"
+#include "core/codec/util/text_decoder.h"
+
+namespace core::codec {
+
+namespace {
+
+constexpr uint32_t ZstdMagic = 0xFD2FB528;
+constexpr uint32_t ZstdSkippableMagic = 0x184D2A50;
+constexpr uint32_t ZstdSkippableMask = 0xFFFFFFF0;
+
+bool is_base64(char c) {
+    return (c >= 'A' and c <= 'Z') or (c >= 'a' and c <= 'z') or (c >= '0' and c <= '9')
+	or c == '+' or c == '/' or c == '-' or c == '_';
+}
+
+}; // anonymous
+
+Format detect_format(std::string_view prefix) {
+    if (prefix.size() >= 4) {
+	auto p = reinterpret_cast<const unsigned char*>(prefix.data());
+	uint32_t magic = p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24);
+	if (magic == ZstdMagic or (magic & ZstdSkippableMask) == ZstdSkippableMagic)
+	    return Format::Zstd;
+	if (prefix.starts_with("BZh") and p[3] >= '1' and p[3] <= '9')
+	    return Format::Bzip;
+    }
+    return Format::Raw;
+}
+
+bool detect_base64(std::string_view prefix) {
+    // Eight base64 characters decode to six bytes which covers the
+    // four byte magic numbers of both formats.
+    char quanta[8];
+    size_t count{0};
+    for (auto c : prefix) {
+	if (is_space(c))
+	    continue;
+	if (not is_base64(c))
+	    return false;
+	quanta[count++] = c;
+	if (count == sizeof(quanta))
+	    break;
+    }
+    if (count < sizeof(quanta))
+	return false;
+    return detect_format(base64_decode(std::string_view{quanta, count})) != Format::Raw;
+}
+
+}; // core::codec
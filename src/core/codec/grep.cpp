@@ -0,0 +1,556 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <regex>
+#include <unistd.h>
+#include "core/codec/grep.h"
+#include "core/codec/util/parallel.h"
+#include "core/codec/zstd/file_decompressor.h"
+#include "core/codec/zstd/frame_file.h"
+#include "core/codec/zstd/exception.h"
+
+namespace grep
+{
+
+struct Matcher::Regex {
+    std::regex re;
+};
+
+namespace {
+
+constexpr auto npos = std::string_view::npos;
+
+bool is_meta(char c) {
+    return c != '\0' and strchr("\\^$.|?*+()[]{}", c) != nullptr;
+}
+
+// Return true if the escape sequence `\c` stands for the character
+// `c`, e.g. `\.`, rather than a class or an assertion, e.g. `\d`.
+bool escapes_literal(char c) {
+    return ispunct((unsigned char)c);
+}
+
+// Return the number of characters following the escape `\c` that are
+// part of it, e.g. the two hex digits of `\xhh`, so that they are not
+// taken for literals.
+size_t escape_operands(std::string_view pattern, size_t i) {
+    switch (pattern[i]) {
+    case 'x': return 2;
+    case 'u': return 4;
+    case 'c': return 1;
+    default: break;
+    }
+
+    // The digits of a back reference.
+    size_t n{0};
+    if (isdigit((unsigned char)pattern[i]))
+	while (i + 1 + n < pattern.size() and isdigit((unsigned char)pattern[i + 1 + n]))
+	    ++n;
+    return n;
+}
+
+// Return the alternatives of `pattern` if it is an alternation of
+// literals (or a single literal), otherwise std::nullopt.
+std::optional<std::vector<std::string>> literal_alternatives(std::string_view pattern) {
+    std::vector<std::string> alternatives(1);
+    for (size_t i = 0; i < pattern.size(); ++i) {
+	auto c = pattern[i];
+	if (c == '|')
+	    alternatives.emplace_back();
+	else if (c == '\\' and i + 1 < pattern.size() and escapes_literal(pattern[i + 1]))
+	    alternatives.back() += pattern[++i];
+	else if (is_meta(c))
+	    return std::nullopt;
+	else
+	    alternatives.back() += c;
+    }
+    return alternatives;
+}
+
+// Return the longest literal every match of `pattern` contains, or
+// the empty string if there is none (e.g. for a top-level alternation)
+// or the pattern is not understood. Groups and classes are skipped and
+// a character made optional by a quantifier ends a literal.
+std::string required_literal(std::string_view pattern) {
+    std::string best, run;
+    auto end_run = [&]() {
+	if (run.size() > best.size())
+	    best = run;
+	run.clear();
+    };
+
+    int depth{0};
+    for (size_t i = 0; i < pattern.size(); ++i) {
+	auto c = pattern[i];
+	if (c == '\\') {
+	    if (i + 1 == pattern.size())
+		return "";
+	    auto d = pattern[++i];
+	    if (depth == 0 and escapes_literal(d))
+		run += d;
+	    else {
+		end_run();
+		i += escape_operands(pattern, i);
+	    }
+	} else if (c == '[') {
+	    end_run();
+	    // Skip the class, whose first character may be `]`.
+	    ++i;
+	    if (i < pattern.size() and pattern[i] == '^')
+		++i;
+	    if (i < pattern.size() and pattern[i] == ']')
+		++i;
+	    while (i < pattern.size() and pattern[i] != ']')
+		i += pattern[i] == '\\' ? 2 : 1;
+	} else if (c == '(') {
+	    end_run();
+	    ++depth;
+	} else if (c == ')') {
+	    end_run();
+	    --depth;
+	} else if (c == '|') {
+	    if (depth == 0)
+		return "";
+	} else if (c == '?' or c == '*' or c == '{') {
+	    // The preceding character is optional.
+	    if (not run.empty())
+		run.pop_back();
+	    end_run();
+	    if (c == '{')
+		while (i < pattern.size() and pattern[i] != '}')
+		    ++i;
+	} else if (is_meta(c)) {
+	    end_run();
+	} else if (depth == 0) {
+	    run += c;
+	}
+    }
+    end_run();
+    return best;
+}
+
+// The part of a stream, a frame or a chunk, searched by a thread.
+struct Unit {
+    // A line found by the thread: the newlines before it and its range.
+    struct Hit {
+	uint64_t newlines;
+	size_t begin, end;
+    };
+
+    std::string storage;
+    std::string_view data;
+    size_t first_newline{npos}, last_newline{npos};
+    uint64_t newlines{0};
+    std::vector<Hit> hits;
+    std::exception_ptr error;
+    bool ready{false}, end{false};
+
+    // Set by the load when no unit follows.
+    bool last{false};
+};
+
+// Search the units produced by `load(k, unit)` on several threads and
+// deliver the matching lines in order on the calling thread.
+//
+// Each thread claims the next unit, loads it and finds the matching
+// lines among the lines wholly within it. The lines spanning units
+// are assembled from the partial lines at the ends of the units and
+// checked while delivering. A `serial` load is called in the order of
+// the units, e.g. reading a stream, otherwise the units are loaded
+// concurrently, e.g. decompressing independent frames.
+//
+// The calling thread claims units itself while it waits, and the
+// helpers of the thread pool are only started once the first unit
+// turns out not to be the last, so a small input is searched without
+// handing work to another thread. A helper returns to the pool as soon
+// as the window is full rather than wait for the calling thread to
+// consume a unit, which then queues helpers again, so a paused search
+// does not hold the workers of the pool.
+//
+class Search {
+public:
+    using Load = std::function<bool(size_t k, Unit& unit)>;
+
+    Search(const Matcher& matcher, const Options& options, bool serial, Load load)
+	: matcher_(matcher)
+	, options_(options)
+	, serial_(serial)
+	, load_(std::move(load))
+	, threads_(options.threads > 0 ? options.threads : core::codec::hardware_threads()) {
+	auto window = options.window > 0 ? options.window : 2 * threads_;
+	units_.resize(std::max<size_t>(window, 2));
+    }
+
+    ~Search() {
+	{
+	    std::lock_guard lock(mutex_);
+	    stop_ = true;
+	}
+	cv_.notify_all();
+	helpers_.close();
+    }
+
+    uint64_t run(const OnMatch& on_match) {
+	uint64_t lines{0}, position{0}, count{0};
+	std::string carry;
+	uint64_t carry_position{0};
+
+	auto deliver = [&](uint64_t line, uint64_t where, std::string_view text) {
+	    on_match(Match{line, where, text});
+	    return ++count == options_.max_count;
+	};
+
+	for (size_t k = 0; ; ++k) {
+	    auto& unit = units_[k % units_.size()];
+	    {
+		std::unique_lock lock(mutex_);
+		while (not unit.ready) {
+		    if (not ended_ and claimable())
+			step(lock);
+		    else
+			cv_.wait(lock);
+		}
+	    }
+	    if (unit.error)
+		std::rethrow_exception(unit.error);
+	    if (unit.end)
+		break;
+
+	    auto data = unit.data;
+	    if (unit.first_newline == npos) {
+		if (carry.empty())
+		    carry_position = position;
+		carry.append(data);
+	    } else {
+		// The line ending in this unit.
+		auto head = data.substr(0, unit.first_newline);
+		auto where = carry.empty() ? position : carry_position;
+		std::string_view line = head;
+		if (not carry.empty())
+		    line = carry.append(head);
+		if (matcher_.match(line) and deliver(lines, where, line))
+		    return count;
+		carry.clear();
+
+		for (const auto& hit : unit.hits)
+		    if (deliver(lines + hit.newlines, position + hit.begin,
+				data.substr(hit.begin, hit.end - hit.begin)))
+			return count;
+
+		auto tail = data.substr(unit.last_newline + 1);
+		carry_position = position + unit.last_newline + 1;
+		carry.assign(tail);
+	    }
+	    lines += unit.newlines;
+	    position += data.size();
+
+	    size_t helpers{0};
+	    {
+		std::lock_guard lock(mutex_);
+		unit.ready = false;
+		++consumed_;
+		cv_.notify_all();
+		helpers = missing_helpers();
+	    }
+	    add_helpers(helpers);
+	}
+
+	if (not carry.empty() and matcher_.match(carry))
+	    deliver(lines, carry_position, carry);
+	return count;
+    }
+
+private:
+    // Return true if the next unit has a free slot; `mutex_` is held.
+    bool claimable() const {
+	return next_ < consumed_ + units_.size();
+    }
+
+    // Claim units until none is claimable, then return to the pool.
+    void work() {
+	std::unique_lock lock(mutex_);
+	while (not stop_ and not ended_ and claimable())
+	    step(lock);
+	--helping_;
+    }
+
+    // Claim, load and scan the next unit, `lock` holding `mutex_` on
+    // entry and on return.
+    void step(std::unique_lock<std::mutex>& lock) {
+	auto k = next_++;
+	auto& unit = units_[k % units_.size()];
+	if (serial_) {
+	    // A unit past the end, or past a failed load, is not loaded but
+	    // ends the input in case the calling thread waits for it.
+	    cv_.wait(lock, [&]() { return stop_ or ended_ or turn_ == k; });
+	    if (stop_ or ended_) {
+		unit.end = true;
+		unit.ready = true;
+		cv_.notify_all();
+		return;
+	    }
+	}
+	lock.unlock();
+
+	bool loaded{false};
+	try {
+	    loaded = load_(k, unit);
+	} catch (...) {
+	    unit.error = std::current_exception();
+	}
+	if (serial_) {
+	    // Pass the turn even if the load failed so that no thread waits
+	    // for it forever.
+	    std::lock_guard guard(mutex_);
+	    if (not loaded or unit.error)
+		ended_ = true;
+	    ++turn_;
+	    cv_.notify_all();
+	}
+
+	if (loaded and not unit.error) {
+	    try {
+		if (k == 0 and not unit.last) {
+		    size_t helpers{0};
+		    {
+			std::lock_guard guard(mutex_);
+			helped_ = true;
+			helpers = missing_helpers();
+		    }
+		    add_helpers(helpers);
+		}
+		scan(unit, grep::kernels());
+	    } catch (...) {
+		unit.error = std::current_exception();
+	    }
+	}
+
+	lock.lock();
+	unit.end = not loaded;
+	if (unit.end or unit.error)
+	    ended_ = true;
+	unit.ready = true;
+	cv_.notify_all();
+    }
+
+    // Return the number of helpers to queue so that up to `threads_ -
+    // 1` claim the units of the window, counting them as queued, once
+    // the first unit has been loaded; `mutex_` is held.
+    size_t missing_helpers() {
+	if (not helped_ or stop_ or ended_ or not claimable() or helping_ + 1 >= threads_)
+	    return 0;
+	auto n = threads_ - 1 - helping_;
+	helping_ += n;
+	return n;
+    }
+
+    // Queue `n` helpers, without holding `mutex_` in case the pool runs
+    // them inline.
+    void add_helpers(size_t n) {
+	for (size_t i = 0; i < n; ++i)
+	    helpers_.run([this]() { work(); });
+    }
+
+    // Find the matching lines wholly within `unit`.
+    void scan(Unit& unit, const Kernels& kernels) {
+	auto data = unit.data;
+	unit.hits.clear();
+	unit.first_newline = data.find('\n');
+	if (unit.first_newline == npos) {
+	    unit.last_newline = npos;
+	    unit.newlines = 0;
+	    return;
+	}
+	unit.last_newline = data.rfind('\n');
+
+	auto text = data.substr(0, unit.last_newline + 1);
+	uint64_t newlines{1};
+	size_t counted{unit.first_newline + 1}, pos{counted};
+	while ((pos = matcher_.find(text, pos)) != npos) {
+	    newlines += kernels.count(text.data() + counted, pos - counted, '\n');
+	    counted = pos;
+	    auto end = text.find('\n', pos);
+	    unit.hits.push_back({newlines, pos, end});
+	    pos = end + 1;
+	}
+	unit.newlines = newlines + kernels.count(text.data() + counted, text.size() - counted, '\n');
+    }
+
+    const Matcher& matcher_;
+    Options options_;
+    bool serial_;
+    Load load_;
+    size_t threads_;
+    std::vector<Unit> units_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    size_t next_{0}, consumed_{0}, turn_{0}, helping_{0};
+    bool stop_{false}, ended_{false}, helped_{false};
+
+    // Last, so that the helpers are done before the rest is destroyed.
+    core::codec::TaskGroup helpers_;
+};
+
+// Return true if the file at `path` starts with a zstd frame.
+bool is_zstd(const std::string& path) {
+    char magic[4];
+    std::ifstream is{path, std::ios::binary};
+    if (not is.read(magic, sizeof(magic)))
+	return false;
+    uint32_t value{0};
+    for (int i = 0; i < 4; ++i)
+	value |= uint32_t((unsigned char)magic[i]) << (8 * i);
+    return value == ZSTD_MAGICNUMBER
+	or (value & ZSTD_MAGIC_SKIPPABLE_MASK) == ZSTD_MAGIC_SKIPPABLE_START;
+}
+
+// Search the frames of the zstd file at `path`, decompressing them
+// concurrently.
+uint64_t search_frames(const std::string& path, const std::vector<zstd::FrameInfo>& frames,
+		       const Matcher& matcher, const OnMatch& on_match, const Options& options) {
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+	throw zstd::error("grep: cannot open %s", path);
+    try {
+	Search search{matcher, options, false, [&](size_t k, Unit& unit) {
+	    if (k >= frames.size())
+		return false;
+	    const auto& info = frames[k];
+	    static thread_local std::string frame;
+	    frame.resize(info.size);
+	    if (::pread(fd, frame.data(), frame.size(), info.offset) != ssize_t(frame.size()))
+		throw zstd::error("grep: %s: read error at %d", path, info.offset);
+	    unit.storage = zstd::decompress_frame(frame, info.content_size);
+	    unit.data = unit.storage;
+	    unit.last = k + 1 == frames.size();
+	    return true;
+	}};
+	auto count = search.run(on_match);
+	::close(fd);
+	return count;
+    } catch (...) {
+	::close(fd);
+	throw;
+    }
+}
+
+}; // anonymous
+
+Matcher::Matcher(std::string_view pattern, bool fixed)
+    : kernels_(&grep::kernels()) {
+    std::vector<std::string> literals;
+    if (fixed) {
+	literals.emplace_back(pattern);
+    } else if (auto alternatives = literal_alternatives(pattern)) {
+	literals = std::move(*alternatives);
+    } else {
+	regex_ = std::make_unique<Regex>(Regex{std::regex{pattern.begin(), pattern.end(),
+							  std::regex::ECMAScript | std::regex::optimize}});
+	if (auto literal = required_literal(pattern); not literal.empty())
+	    set_ = LiteralSet{{literal}};
+	return;
+    }
+
+    all_ = std::any_of(literals.begin(), literals.end(), [](const auto& s) { return s.empty(); });
+    if (not all_)
+	set_ = LiteralSet{std::move(literals)};
+}
+
+Matcher::Matcher(std::vector<std::string> literals)
+    : kernels_(&grep::kernels()) {
+    all_ = std::any_of(literals.begin(), literals.end(), [](const auto& s) { return s.empty(); });
+    if (not all_)
+	set_ = LiteralSet{std::move(literals)};
+}
+
+Matcher::~Matcher() = default;
+Matcher::Matcher(Matcher&&) = default;
+
+bool Matcher::match(std::string_view line) const {
+    if (all_)
+	return true;
+    if (not set_.literals.empty() and kernels_->find(line.data(), line.size(), set_) == line.size())
+	return false;
+    return not regex_ or std::regex_search(line.begin(), line.end(), regex_->re);
+}
+
+size_t Matcher::find(std::string_view text, size_t pos) const {
+    auto data = text.data(), end = data + text.size();
+    while (pos < text.size()) {
+	size_t begin{pos};
+	if (not set_.literals.empty()) {
+	    auto c = pos + kernels_->find(data + pos, text.size() - pos, set_);
+	    if (c == text.size())
+		return npos;
+	    if (auto nl = (const char*)memrchr(data + pos, '\n', c - pos))
+		begin = nl + 1 - data;
+	    pos = c;
+	}
+	auto nl = (const char*)memchr(data + pos, '\n', end - (data + pos));
+	auto stop = nl ? size_t(nl - data) : text.size();
+	if (all_ or not regex_ or std::regex_search(data + begin, data + stop, regex_->re))
+	    return begin;
+	pos = stop + 1;
+    }
+    return npos;
+}
+
+uint64_t search(std::string_view text, const Matcher& matcher, const OnMatch& on_match,
+		const Options& options) {
+    auto chunk = std::max<size_t>(options.chunk, 1);
+    auto units = (text.size() + chunk - 1) / chunk;
+    Search search{matcher, options, false, [&](size_t k, Unit& unit) {
+	if (k >= units)
+	    return false;
+	unit.data = text.substr(k * chunk, chunk);
+	unit.last = k + 1 == units;
+	return true;
+    }};
+    return search.run(on_match);
+}
+
+uint64_t search_reader(const std::function<size_t(char*, size_t)>& read, const Matcher& matcher,
+		       const OnMatch& on_match, const Options& options) {
+    auto chunk = std::max<size_t>(options.chunk, 1);
+    bool eof{false};
+    Search search{matcher, options, true, [&](size_t, Unit& unit) {
+	size_t count{0};
+	unit.storage.resize(chunk);
+	while (not eof and count < chunk) {
+	    auto n = read(unit.storage.data() + count, chunk - count);
+	    eof = n < chunk - count;
+	    count += n;
+	}
+	unit.storage.resize(count);
+	unit.data = unit.storage;
+	unit.last = eof;
+	return count > 0;
+    }};
+    return search.run(on_match);
+}
+
+uint64_t search_file(const std::string& path, const Matcher& matcher, const OnMatch& on_match,
+		     const Options& options) {
+    if (is_zstd(path)) {
+	auto frames = zstd::scan_frames(path);
+	if (frames.size() > 1)
+	    return search_frames(path, frames, matcher, on_match, options);
+	zstd::FileDecompressor decompressor{path};
+	return search_stream(decompressor, matcher, on_match, options);
+    }
+
+    std::ifstream is{path, std::ios::binary};
+    if (not is)
+	throw std::runtime_error("grep: cannot open " + path);
+    return search_stream(is, matcher, on_match, options);
+}
+
+}; // grep
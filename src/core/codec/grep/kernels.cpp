@@ -0,0 +1,151 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include "core/codec/grep/kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CODEC_GREP_X86 1
+#include <immintrin.h>
+#endif
+
+namespace grep
+{
+
+LiteralSet::LiteralSet(std::vector<std::string> strs)
+    : literals(std::move(strs)) {
+    for (const auto& literal : literals) {
+	if (literal.empty())
+	    throw std::runtime_error("grep: empty literal");
+	max_size = std::max(max_size, literal.size());
+	first[(unsigned char)literal[0]] = true;
+    }
+}
+
+namespace {
+
+// Return true if a literal of `set` occurs at `p`, `end` bounding the
+// text.
+bool literal_at(const char *p, const char *end, const LiteralSet& set) {
+    for (const auto& literal : set.literals)
+	if (size_t(end - p) >= literal.size() and memcmp(p, literal.data(), literal.size()) == 0)
+	    return true;
+    return false;
+}
+
+size_t find_scalar(const char *data, size_t n, const LiteralSet& set) {
+    if (set.literals.size() == 1) {
+	auto i = std::string_view{data, n}.find(set.literals[0]);
+	return i == std::string_view::npos ? n : i;
+    }
+    for (size_t i = 0; i < n; ++i)
+	if (set.first[(unsigned char)data[i]] and literal_at(data + i, data + n, set))
+	    return i;
+    return n;
+}
+
+size_t count_scalar(const char *data, size_t n, char c) {
+    size_t count{0};
+    for (auto end = data + n; (data = (const char*)memchr(data, c, end - data)); ++data)
+	++count;
+    return count;
+}
+
+#ifdef CODEC_GREP_X86
+
+// The number of literals compared by the vector kernel; larger sets
+// are left to the scalar kernel.
+constexpr size_t MaxVectorLiterals = 8;
+
+__attribute__((target("avx2")))
+size_t find_avx2(const char *data, size_t n, const LiteralSet& set) {
+    auto m = set.literals.size();
+    if (m == 0 or m > MaxVectorLiterals)
+	return find_scalar(data, n, set);
+
+    __m256i first[MaxVectorLiterals], last[MaxVectorLiterals];
+    size_t offset[MaxVectorLiterals];
+    for (size_t j = 0; j < m; ++j) {
+	const auto& literal = set.literals[j];
+	first[j] = _mm256_set1_epi8(literal.front());
+	last[j] = _mm256_set1_epi8(literal.back());
+	offset[j] = literal.size() - 1;
+    }
+
+    size_t i = 0;
+    for (; i + set.max_size - 1 + 32 <= n; i += 32) {
+	auto block = _mm256_loadu_si256((const __m256i*)(data + i));
+	uint32_t mask = 0;
+	for (size_t j = 0; j < m; ++j) {
+	    auto a = _mm256_cmpeq_epi8(block, first[j]);
+	    auto b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + i + offset[j])), last[j]);
+	    mask |= _mm256_movemask_epi8(_mm256_and_si256(a, b));
+	}
+	while (mask) {
+	    auto p = i + __builtin_ctz(mask);
+	    if (literal_at(data + p, data + n, set)) {
+		_mm256_zeroupper();
+		return p;
+	    }
+	    mask &= mask - 1;
+	}
+    }
+    _mm256_zeroupper();
+    return i + find_scalar(data + i, n - i, set);
+}
+
+__attribute__((target("avx2,popcnt")))
+size_t count_avx2(const char *data, size_t n, char c) {
+    auto v = _mm256_set1_epi8(c);
+    size_t count{0}, i{0};
+    for (; i + 32 <= n; i += 32) {
+	auto x = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + i)), v);
+	count += _mm_popcnt_u32(_mm256_movemask_epi8(x));
+    }
+    _mm256_zeroupper();
+    return count + count_scalar(data + i, n - i, c);
+}
+
+#endif // CODEC_GREP_X86
+
+const Kernels AllKernels[] = {
+    { Isa::Scalar, find_scalar, count_scalar },
+#ifdef CODEC_GREP_X86
+    { Isa::Avx2, find_avx2, count_avx2 },
+#endif
+};
+
+}; // anonymous
+
+bool supported(Isa isa) {
+    for (const auto& k : AllKernels)
+	if (k.isa == isa)
+	    return base64::supported(isa);
+    return false;
+}
+
+Isa best_isa() {
+    auto best = Isa::Scalar;
+    for (auto isa : Isas)
+	if (grep::supported(isa))
+	    best = isa;
+    return best;
+}
+
+const Kernels& kernels(Isa isa) {
+    if (grep::supported(isa))
+	for (const auto& k : AllKernels)
+	    if (k.isa == isa)
+		return k;
+    throw std::runtime_error("grep: kernels not supported: " + std::string{name(isa)});
+}
+
+const Kernels& kernels() {
+    static const Kernels& best = grep::kernels(best_isa());
+    return best;
+}
+
+}; // grep
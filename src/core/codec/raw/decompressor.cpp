@@ -0,0 +1,77 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include "core/codec/raw/decompressor.h"
+#include "core/codec/zstd/adapter.h"
+#include "core/codec/util/peek_source.h"
+
+namespace raw
+{
+
+template<class Source>
+Decompressor<Source>::Decompressor(std::add_rvalue_reference_t<Source> is, size_t n,
+				   core::Allocator *alloc)
+    : is_(std::forward<Source>(is))
+    , get_(n > 0 ? n : 65536, alloc)
+{ }
+
+template<class Source>
+bool Decompressor<Source>::read_line(std::string& line) {
+    line.clear();
+
+    while (true) {
+	if (auto v = get_.view(); not v.empty()) {
+	    if (auto ptr = (const char*)memchr(v.data(), '\n', v.size())) {
+		line.append(v.data(), ptr);
+		get_.discard(ptr - v.data() + 1);
+		return true;
+	    }
+	    line.append(v);
+	    get_.discard(v.size());
+	}
+
+	if (not underflow())
+	    return line.size() > 0;
+    }
+}
+
+template<class Source>
+size_t Decompressor<Source>::read_bytes(char *buffer, size_t requested) {
+    size_t count{0};
+    while (count < requested) {
+	if (not get_.available()) {
+	    if (not underflow())
+		break;
+	}
+
+	auto n = std::min(requested - count, get_.size());
+	memcpy(buffer + count, get_.data(), n);
+	count += n;
+	get_.discard(n);
+    }
+    return count;
+}
+
+template<class Source>
+bool Decompressor<Source>::underflow() {
+    if (closed_) {
+	get_.update(0);
+	return false;
+    }
+
+    auto count = zstd::InStreamAdapter<Source>::read(is_, get_.begin(), get_.capacity());
+    get_.update(count);
+    if (count == 0)
+	close();
+    return count > 0;
+}
+
+template class Decompressor<std::istream&>;
+template class Decompressor<std::ifstream&>;
+template class Decompressor<std::stringstream&>;
+template class Decompressor<core::PeekSource&>;
+
+}; // raw
@@ -0,0 +1,217 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include "core/codec/shuffle.h"
+#include "core/codec/shuffle/kernels.h"
+#include "core/codec/util/buffer.h"
+
+namespace shuffle
+{
+
+namespace {
+
+// The header is a zstd skippable frame (magic number and payload
+// size) holding a tag, a version and the transform.
+constexpr uint32_t SkippableMagic = 0x184d2a5e;
+constexpr char Tag[4] = { 'S', 'H', 'U', 'F' };
+constexpr uint8_t Version = 1;
+
+void put32(char *out, uint32_t value) {
+    for (int i = 0; i < 4; ++i)
+	out[i] = char(value >> (8 * i));
+}
+
+uint32_t get32(const char *in) {
+    uint32_t value{0};
+    for (int i = 0; i < 4; ++i)
+	value |= uint32_t((unsigned char)in[i]) << (8 * i);
+    return value;
+}
+
+// Return the size of the blocks, a multiple of eight elements.
+size_t block_size(size_t typesize, size_t block) {
+    auto unit = 8 * typesize;
+    return std::max(unit, block / unit * unit);
+}
+
+// Replace the `count` elements of `U` at `in` by their differences
+// with the previous element into `out`.
+template<class U>
+void sub_encode(const char *in, size_t count, char *out) {
+    U prev{0};
+    for (size_t i = 0; i < count; ++i) {
+	U x;
+	memcpy(&x, in + i * sizeof(U), sizeof(U));
+	U d = x - prev;
+	memcpy(out + i * sizeof(U), &d, sizeof(U));
+	prev = x;
+    }
+}
+
+template<class U>
+void sub_decode(const char *in, size_t count, char *out) {
+    U prev{0};
+    for (size_t i = 0; i < count; ++i) {
+	U d;
+	memcpy(&d, in + i * sizeof(U), sizeof(U));
+	prev += d;
+	memcpy(out + i * sizeof(U), &prev, sizeof(U));
+    }
+}
+
+// Apply `delta` to the `count` elements at `in` into `out`, which may
+// be `in` when decoding. Differences of other sizes than the integer
+// types are taken byte by byte.
+void delta_encode(const char *in, size_t count, char *out, size_t typesize, Delta delta) {
+    if (delta == Delta::Sub and typesize == 2)
+	return sub_encode<uint16_t>(in, count, out);
+    if (delta == Delta::Sub and typesize == 4)
+	return sub_encode<uint32_t>(in, count, out);
+    if (delta == Delta::Sub and typesize == 8)
+	return sub_encode<uint64_t>(in, count, out);
+
+    auto n = count * typesize;
+    memcpy(out, in, std::min(typesize, n));
+    for (size_t k = typesize; k < n; ++k)
+	out[k] = delta == Delta::Sub ? char(in[k] - in[k - typesize]) : char(in[k] ^ in[k - typesize]);
+}
+
+void delta_decode(const char *in, size_t count, char *out, size_t typesize, Delta delta) {
+    if (delta == Delta::Sub and typesize == 2)
+	return sub_decode<uint16_t>(in, count, out);
+    if (delta == Delta::Sub and typesize == 4)
+	return sub_decode<uint32_t>(in, count, out);
+    if (delta == Delta::Sub and typesize == 8)
+	return sub_decode<uint64_t>(in, count, out);
+
+    auto n = count * typesize;
+    if (out != in)
+	memcpy(out, in, std::min(typesize, n));
+    for (size_t k = typesize; k < n; ++k)
+	out[k] = delta == Delta::Sub ? char(in[k] + out[k - typesize]) : char(in[k] ^ out[k - typesize]);
+}
+
+// Transform the `n` bytes of a block using the two scratch blocks.
+void encode_block(const char *in, size_t n, char *out, size_t typesize, const Options& options,
+		  char *scratch, char *planes) {
+    const auto& k = kernels();
+    auto count = n / typesize, whole = count * typesize;
+
+    auto src = in;
+    if (options.delta != Delta::None) {
+	delta_encode(in, count, scratch, typesize, options.delta);
+	src = scratch;
+    } else if (in == out and options.shuffle != Shuffle::None) {
+	memcpy(scratch, in, whole);
+	src = scratch;
+    }
+
+    if (options.shuffle == Shuffle::None) {
+	if (src != out)
+	    memcpy(out, src, whole);
+    } else if (options.shuffle == Shuffle::Byte) {
+	k.shuffle(src, count, out, typesize);
+    } else {
+	auto m = count / 8 * 8;
+	k.shuffle(src, m, planes, typesize);
+	for (size_t j = 0; j < typesize; ++j)
+	    k.bit_transpose(planes + j * m, m, out + j * m);
+	memcpy(out + m * typesize, src + m * typesize, (count - m) * typesize);
+    }
+
+    if (in != out)
+	memcpy(out + whole, in + whole, n - whole);
+}
+
+void decode_block(const char *in, size_t n, char *out, size_t typesize, const Options& options,
+		  char *scratch, char *planes) {
+    const auto& k = kernels();
+    auto count = n / typesize, whole = count * typesize;
+
+    // Unshuffle into `out` unless the delta needs a copy of the input
+    // or `out` is the input.
+    auto dst = options.delta == Delta::None and in != out ? out : scratch;
+    auto src = in;
+    if (options.shuffle == Shuffle::Byte) {
+	k.unshuffle(in, count, dst, typesize);
+	src = dst;
+    } else if (options.shuffle == Shuffle::Bit) {
+	auto m = count / 8 * 8;
+	for (size_t j = 0; j < typesize; ++j)
+	    k.bit_untranspose(in + j * m, m, planes + j * m);
+	k.unshuffle(planes, m, dst, typesize);
+	memcpy(dst + m * typesize, in + m * typesize, (count - m) * typesize);
+	src = dst;
+    }
+
+    if (options.delta != Delta::None)
+	delta_decode(src, count, out, typesize, options.delta);
+    else if (src != out)
+	memcpy(out, src, whole);
+
+    if (in != out)
+	memcpy(out + whole, in + whole, n - whole);
+}
+
+// Apply `fn` to each block of the `n` bytes at `in` and `out`.
+template<class F>
+void for_each_block(const char *in, size_t n, char *out, size_t typesize, const Options& options, F fn) {
+    if (typesize == 0)
+	throw std::runtime_error("shuffle: element size of zero");
+    if (n == 0)
+	return;
+    auto block = std::min(n, block_size(typesize, options.block));
+    core::BufferedArea scratch(2 * block);
+    for (size_t pos = 0; pos < n; pos += block)
+	fn(in + pos, std::min(block, n - pos), out + pos, typesize, options,
+	   scratch.begin(), scratch.begin() + block);
+}
+
+}; // anonymous
+
+void write_header(const Header& header, char *out) {
+    auto block = block_size(header.typesize, header.options.block);
+    if (header.typesize == 0 or header.typesize > std::numeric_limits<uint8_t>::max()
+	or block > std::numeric_limits<uint32_t>::max())
+	throw std::runtime_error("shuffle: element or block size out of range for the header");
+
+    put32(out, SkippableMagic);
+    put32(out + 4, HeaderSize - 8);
+    memcpy(out + 8, Tag, sizeof(Tag));
+    out[12] = char(Version);
+    out[13] = char(header.typesize);
+    out[14] = char(header.options.shuffle);
+    out[15] = char(header.options.delta);
+    put32(out + 16, uint32_t(block));
+}
+
+std::optional<Header> read_header(std::string_view in) {
+    if (in.size() < HeaderSize or get32(in.data()) != SkippableMagic
+	or get32(in.data() + 4) != HeaderSize - 8 or in.substr(8, 4) != std::string_view{Tag, 4}
+	or uint8_t(in[12]) != Version)
+	return std::nullopt;
+
+    Header header;
+    header.typesize = uint8_t(in[13]);
+    auto shuffle = uint8_t(in[14]), delta = uint8_t(in[15]);
+    if (header.typesize == 0 or shuffle > uint8_t(Shuffle::Bit) or delta > uint8_t(Delta::Xor))
+	return std::nullopt;
+    header.options.shuffle = Shuffle(shuffle);
+    header.options.delta = Delta(delta);
+    header.options.block = get32(in.data() + 16);
+    return header;
+}
+
+void encode(const char *in, size_t n, char *out, size_t typesize, const Options& options) {
+    for_each_block(in, n, out, typesize, options, encode_block);
+}
+
+void decode(const char *in, size_t n, char *out, size_t typesize, const Options& options) {
+    for_each_block(in, n, out, typesize, options, decode_block);
+}
+
+}; // shuffle
@@ -0,0 +1,300 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include "core/codec/shuffle/kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CODEC_SHUFFLE_X86 1
+#include <immintrin.h>
+#endif
+
+namespace shuffle
+{
+
+namespace {
+
+// Shuffle the elements from `begin` on, the planes being `n` bytes.
+void shuffle_from(const char *in, size_t n, char *out, size_t typesize, size_t begin) {
+    for (size_t j = 0; j < typesize; ++j) {
+	auto plane = out + j * n;
+	for (size_t i = begin; i < n; ++i)
+	    plane[i] = in[i * typesize + j];
+    }
+}
+
+void unshuffle_from(const char *in, size_t n, char *out, size_t typesize, size_t begin) {
+    for (size_t j = 0; j < typesize; ++j) {
+	auto plane = in + j * n;
+	for (size_t i = begin; i < n; ++i)
+	    out[i * typesize + j] = plane[i];
+    }
+}
+
+// Transpose the 8x8 bit matrix whose rows are the bytes of `x`, i.e.
+// exchange bit `c` of byte `r` with bit `r` of byte `c`.
+uint64_t transpose8(uint64_t x) {
+    auto t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaull;
+    x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000cccc0000ccccull;
+    x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ull;
+    x ^= t ^ (t << 28);
+    return x;
+}
+
+// Bit transpose the groups of eight bytes from byte `begin` on, a
+// multiple of eight.
+void bit_transpose_from(const char *in, size_t n, char *out, size_t begin) {
+    auto m = n / 8;
+    for (size_t g = begin / 8; g < m; ++g) {
+	uint64_t x;
+	memcpy(&x, in + 8 * g, 8);
+	x = transpose8(x);
+	for (size_t b = 0; b < 8; ++b)
+	    out[b * m + g] = char(x >> (8 * b));
+    }
+}
+
+void bit_untranspose_from(const char *in, size_t n, char *out, size_t begin) {
+    auto m = n / 8;
+    for (size_t g = begin / 8; g < m; ++g) {
+	uint64_t x{0};
+	for (size_t b = 0; b < 8; ++b)
+	    x |= uint64_t((unsigned char)in[b * m + g]) << (8 * b);
+	x = transpose8(x);
+	memcpy(out + 8 * g, &x, 8);
+    }
+}
+
+void shuffle_scalar(const char *in, size_t n, char *out, size_t typesize) {
+    shuffle_from(in, n, out, typesize, 0);
+}
+
+void unshuffle_scalar(const char *in, size_t n, char *out, size_t typesize) {
+    unshuffle_from(in, n, out, typesize, 0);
+}
+
+void bit_transpose_scalar(const char *in, size_t n, char *out) {
+    bit_transpose_from(in, n, out, 0);
+}
+
+void bit_untranspose_scalar(const char *in, size_t n, char *out) {
+    bit_untranspose_from(in, n, out, 0);
+}
+
+#ifdef CODEC_SHUFFLE_X86
+
+// The byte shuffles gather the bytes of each significance of the
+// elements of each 128-bit lane into 32 or 16-bit words, permute the
+// words across lanes so that each vector holds the planes of its
+// elements in order, and transpose the words of the vectors with
+// unpacks. Every step is its own inverse or has a simple one, in
+// particular a transpose, so the unshuffles replay them backwards.
+
+// Transpose the 4x4 matrix of 64-bit words of `v`.
+__attribute__((target("avx2")))
+void transpose_epi64_avx2(__m256i *v) {
+    auto t0 = _mm256_unpacklo_epi64(v[0], v[1]), t1 = _mm256_unpackhi_epi64(v[0], v[1]);
+    auto t2 = _mm256_unpacklo_epi64(v[2], v[3]), t3 = _mm256_unpackhi_epi64(v[2], v[3]);
+    v[0] = _mm256_permute2x128_si256(t0, t2, 0x20);
+    v[1] = _mm256_permute2x128_si256(t1, t3, 0x20);
+    v[2] = _mm256_permute2x128_si256(t0, t2, 0x31);
+    v[3] = _mm256_permute2x128_si256(t1, t3, 0x31);
+}
+
+// Transpose the 8x8 matrix of 32-bit words of `v`.
+__attribute__((target("avx2")))
+void transpose_epi32_avx2(__m256i *v) {
+    __m256i t[8], u[8];
+    for (int i = 0; i < 8; i += 2) {
+	t[i] = _mm256_unpacklo_epi32(v[i], v[i + 1]);
+	t[i + 1] = _mm256_unpackhi_epi32(v[i], v[i + 1]);
+    }
+    for (int i = 0; i < 8; i += 4) {
+	u[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+	u[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+	u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+	u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+    }
+    for (int i = 0; i < 4; ++i) {
+	v[i] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+	v[i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+    }
+}
+
+// Transpose each 4x4 byte matrix of the lanes.
+__attribute__((target("avx2")))
+__m256i transpose4x4_epi8_avx2(__m256i v) {
+    const auto t = _mm256_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+				    0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    return _mm256_shuffle_epi8(v, t);
+}
+
+// Shuffle 32 elements of four bytes at a time.
+__attribute__((target("avx2")))
+size_t shuffle4_avx2(const char *in, size_t n, char *out, bool inverse) {
+    const auto p = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    const auto q = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+	__m256i v[4];
+	if (not inverse) {
+	    for (int r = 0; r < 4; ++r) {
+		auto x = _mm256_loadu_si256((const __m256i*)(in + 4 * i + 32 * r));
+		v[r] = _mm256_permutevar8x32_epi32(transpose4x4_epi8_avx2(x), p);
+	    }
+	    transpose_epi64_avx2(v);
+	    for (int j = 0; j < 4; ++j)
+		_mm256_storeu_si256((__m256i*)(out + j * n + i), v[j]);
+	} else {
+	    for (int j = 0; j < 4; ++j)
+		v[j] = _mm256_loadu_si256((const __m256i*)(in + j * n + i));
+	    transpose_epi64_avx2(v);
+	    for (int r = 0; r < 4; ++r) {
+		auto x = transpose4x4_epi8_avx2(_mm256_permutevar8x32_epi32(v[r], q));
+		_mm256_storeu_si256((__m256i*)(out + 4 * i + 32 * r), x);
+	    }
+	}
+    }
+    return i;
+}
+
+// Shuffle 32 elements of eight bytes at a time.
+__attribute__((target("avx2")))
+size_t shuffle8_avx2(const char *in, size_t n, char *out, bool inverse) {
+    const auto f = _mm256_setr_epi8(0, 1, 2, 3, 8, 9, 10, 11, 4, 5, 6, 7, 12, 13, 14, 15,
+				    0, 1, 2, 3, 8, 9, 10, 11, 4, 5, 6, 7, 12, 13, 14, 15);
+    const auto p = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+	__m256i v[8];
+	if (not inverse) {
+	    for (int r = 0; r < 8; ++r) {
+		auto x = _mm256_loadu_si256((const __m256i*)(in + 8 * i + 32 * r));
+		x = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(x, f), p);
+		v[r] = transpose4x4_epi8_avx2(x);
+	    }
+	    transpose_epi32_avx2(v);
+	    for (int j = 0; j < 8; ++j)
+		_mm256_storeu_si256((__m256i*)(out + j * n + i), v[j]);
+	} else {
+	    for (int j = 0; j < 8; ++j)
+		v[j] = _mm256_loadu_si256((const __m256i*)(in + j * n + i));
+	    transpose_epi32_avx2(v);
+	    for (int r = 0; r < 8; ++r) {
+		auto x = _mm256_permutevar8x32_epi32(transpose4x4_epi8_avx2(v[r]), p);
+		_mm256_storeu_si256((__m256i*)(out + 8 * i + 32 * r), _mm256_shuffle_epi8(x, f));
+	    }
+	}
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+void shuffle_avx2(const char *in, size_t n, char *out, size_t typesize) {
+    size_t i = 0;
+    if (typesize == 4)
+	i = shuffle4_avx2(in, n, out, false);
+    else if (typesize == 8)
+	i = shuffle8_avx2(in, n, out, false);
+    _mm256_zeroupper();
+    shuffle_from(in, n, out, typesize, i);
+}
+
+__attribute__((target("avx2")))
+void unshuffle_avx2(const char *in, size_t n, char *out, size_t typesize) {
+    size_t i = 0;
+    if (typesize == 4)
+	i = shuffle4_avx2(in, n, out, true);
+    else if (typesize == 8)
+	i = shuffle8_avx2(in, n, out, true);
+    _mm256_zeroupper();
+    unshuffle_from(in, n, out, typesize, i);
+}
+
+// Collect the bits of each significance of 32 bytes with a mask of
+// their top bits, shifting the next bit to the top.
+__attribute__((target("avx2")))
+void bit_transpose_avx2(const char *in, size_t n, char *out) {
+    auto m = n / 8;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+	auto x = _mm256_loadu_si256((const __m256i*)(in + i));
+	for (int b = 7; b >= 0; --b) {
+	    uint32_t mask = _mm256_movemask_epi8(x);
+	    memcpy(out + b * m + i / 8, &mask, 4);
+	    x = _mm256_add_epi8(x, x);
+	}
+    }
+    _mm256_zeroupper();
+    bit_transpose_from(in, n, out, i);
+}
+
+// Spread the 32 bits of each significance over the bytes, selecting
+// the bit of each byte with a mask.
+__attribute__((target("avx2")))
+void bit_untranspose_avx2(const char *in, size_t n, char *out) {
+    const auto spread = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+					 2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+    const auto select = _mm256_set1_epi64x(0x8040201008040201ll);
+    auto m = n / 8;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+	auto acc = _mm256_setzero_si256();
+	for (int b = 0; b < 8; ++b) {
+	    uint32_t bits;
+	    memcpy(&bits, in + b * m + i / 8, 4);
+	    auto x = _mm256_shuffle_epi8(_mm256_set1_epi32(bits), spread);
+	    x = _mm256_cmpeq_epi8(_mm256_and_si256(x, select), select);
+	    acc = _mm256_or_si256(acc, _mm256_and_si256(x, _mm256_set1_epi8(char(1 << b))));
+	}
+	_mm256_storeu_si256((__m256i*)(out + i), acc);
+    }
+    _mm256_zeroupper();
+    bit_untranspose_from(in, n, out, i);
+}
+
+#endif // CODEC_SHUFFLE_X86
+
+const Kernels AllKernels[] = {
+    { Isa::Scalar, shuffle_scalar, unshuffle_scalar, bit_transpose_scalar, bit_untranspose_scalar },
+#ifdef CODEC_SHUFFLE_X86
+    { Isa::Avx2, shuffle_avx2, unshuffle_avx2, bit_transpose_avx2, bit_untranspose_avx2 },
+#endif
+};
+
+}; // anonymous
+
+bool supported(Isa isa) {
+    for (const auto& k : AllKernels)
+	if (k.isa == isa)
+	    return base64::supported(isa);
+    return false;
+}
+
+Isa best_isa() {
+    auto best = Isa::Scalar;
+    for (auto isa : Isas)
+	if (shuffle::supported(isa))
+	    best = isa;
+    return best;
+}
+
+const Kernels& kernels(Isa isa) {
+    if (shuffle::supported(isa))
+	for (const auto& k : AllKernels)
+	    if (k.isa == isa)
+		return k;
+    throw std::runtime_error("shuffle: kernels not supported: " + std::string{name(isa)});
+}
+
+const Kernels& kernels() {
+    static const Kernels& best = shuffle::kernels(best_isa());
+    return best;
+}
+
+}; // shuffle
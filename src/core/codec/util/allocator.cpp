@@ -0,0 +1,274 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <sys/mman.h>
+#include "core/codec/util/allocator.h"
+
+namespace core
+{
+
+namespace {
+
+// Every block handed out by the arena and the huge page pool is
+// preceded by a header recording its size class so that it can be
+// recycled without the caller supplying the size.
+struct alignas(16) Header {
+    uint32_t cls;
+    uint64_t size;
+};
+
+constexpr size_t MinClassBits = 6;
+constexpr size_t NumberClasses = 21;
+constexpr uint32_t LargeClass = ~0u;
+
+// Return the smallest size class holding `n` bytes.
+size_t class_of(size_t n) {
+    if (n <= (size_t{1} << MinClassBits))
+	return 0;
+    return std::bit_width(n - 1) - MinClassBits;
+}
+
+// Return the number of payload bytes in size class `cls`.
+size_t class_size(size_t cls) {
+    return size_t{1} << (cls + MinClassBits);
+}
+
+void *payload(Header *h) {
+    return h + 1;
+}
+
+Header *header(void *ptr) {
+    return reinterpret_cast<Header*>(ptr) - 1;
+}
+
+// Cached blocks are chained through their first payload bytes.
+Header*& next(Header *h) {
+    return *reinterpret_cast<Header**>(payload(h));
+}
+
+class MallocAllocator : public Allocator {
+public:
+    void *allocate(size_t n) override {
+	auto ptr = std::malloc(n > 0 ? n : 1);
+	if (ptr == nullptr)
+	    throw std::bad_alloc{};
+	return ptr;
+    }
+
+    void deallocate(void *ptr) override {
+	std::free(ptr);
+    }
+};
+
+// Per-thread free lists of the arena allocator.
+class ArenaCache {
+public:
+    static constexpr size_t MaxCachedBytes = size_t{64} << 20;
+
+    ArenaCache() { state() = Alive; }
+
+    ~ArenaCache() {
+	for (auto head : free_) {
+	    while (head) {
+		auto h = head;
+		head = next(h);
+		std::free(h);
+	    }
+	}
+	state() = Destroyed;
+    }
+
+    // Return the calling thread's cache or nullptr once the thread
+    // is exiting and the cache has been destroyed.
+    static ArenaCache *instance() {
+	if (state() == Destroyed)
+	    return nullptr;
+	static thread_local ArenaCache cache;
+	return &cache;
+    }
+
+    Header *pop(size_t cls) {
+	auto h = free_[cls];
+	if (h) {
+	    free_[cls] = next(h);
+	    cached_ -= class_size(cls);
+	}
+	return h;
+    }
+
+    bool push(Header *h) {
+	if (cached_ + class_size(h->cls) > MaxCachedBytes)
+	    return false;
+	next(h) = free_[h->cls];
+	free_[h->cls] = h;
+	cached_ += class_size(h->cls);
+	return true;
+    }
+
+private:
+    enum State { Uninitialized = 0, Alive, Destroyed };
+
+    static int& state() {
+	static thread_local int value{Uninitialized};
+	return value;
+    }
+
+    std::array<Header*, NumberClasses> free_{};
+    size_t cached_{0};
+};
+
+class ArenaAllocator : public Allocator {
+public:
+    void *allocate(size_t n) override {
+	auto cls = class_of(n);
+	if (cls >= NumberClasses)
+	    return payload(new_block(LargeClass, n));
+
+	if (auto cache = ArenaCache::instance())
+	    if (auto h = cache->pop(cls))
+		return payload(h);
+	return payload(new_block(cls, class_size(cls)));
+    }
+
+    void deallocate(void *ptr) override {
+	if (ptr == nullptr)
+	    return;
+	auto h = header(ptr);
+	if (h->cls != LargeClass)
+	    if (auto cache = ArenaCache::instance(); cache and cache->push(h))
+		return;
+	std::free(h);
+    }
+
+private:
+    static Header *new_block(uint32_t cls, size_t n) {
+	auto h = static_cast<Header*>(std::malloc(sizeof(Header) + n));
+	if (h == nullptr)
+	    throw std::bad_alloc{};
+	h->cls = cls;
+	h->size = n;
+	return h;
+    }
+};
+
+class HugePagePool : public Allocator {
+public:
+    static constexpr size_t PageSize = size_t{2} << 20;
+    static constexpr size_t RegionSize = 16 * PageSize;
+
+    void *allocate(size_t n) override {
+	auto cls = class_of(n);
+	if (cls >= NumberClasses or class_size(cls) > RegionSize / 2) {
+	    auto size = round_up(sizeof(Header) + n);
+	    auto h = static_cast<Header*>(map(size));
+	    h->cls = LargeClass;
+	    h->size = size;
+	    return payload(h);
+	}
+
+	std::lock_guard lock(mutex_);
+	if (auto h = free_[cls]) {
+	    free_[cls] = next(h);
+	    return payload(h);
+	}
+
+	auto need = sizeof(Header) + class_size(cls);
+	if (size_t(end_ - ptr_) < need) {
+	    ptr_ = static_cast<char*>(map(RegionSize));
+	    end_ = ptr_ + RegionSize;
+	}
+	auto h = reinterpret_cast<Header*>(ptr_);
+	ptr_ += need;
+	h->cls = cls;
+	h->size = class_size(cls);
+	return payload(h);
+    }
+
+    void deallocate(void *ptr) override {
+	if (ptr == nullptr)
+	    return;
+	auto h = header(ptr);
+	if (h->cls == LargeClass) {
+	    munmap(h, h->size);
+	    return;
+	}
+	std::lock_guard lock(mutex_);
+	next(h) = free_[h->cls];
+	free_[h->cls] = h;
+    }
+
+private:
+    static size_t round_up(size_t n) {
+	return (n + PageSize - 1) / PageSize * PageSize;
+    }
+
+    // Map `size` bytes (a multiple of the huge page size) preferring
+    // explicit huge pages, then page-aligned transparent huge pages.
+    static void *map(size_t size) {
+	constexpr int prot = PROT_READ | PROT_WRITE;
+	constexpr int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_HUGETLB
+	if (auto ptr = mmap(nullptr, size, prot, flags | MAP_HUGETLB, -1, 0); ptr != MAP_FAILED)
+	    return ptr;
+#endif
+	auto raw = mmap(nullptr, size + PageSize, prot, flags, -1, 0);
+	if (raw == MAP_FAILED)
+	    throw std::bad_alloc{};
+
+	auto base = reinterpret_cast<uintptr_t>(raw);
+	auto aligned = (base + PageSize - 1) / PageSize * PageSize;
+	if (aligned > base)
+	    munmap(raw, aligned - base);
+	if (auto tail = base + size + PageSize - (aligned + size); tail > 0)
+	    munmap(reinterpret_cast<void*>(aligned + size), tail);
+
+	auto ptr = reinterpret_cast<void*>(aligned);
+#ifdef MADV_HUGEPAGE
+	madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+	return ptr;
+    }
+
+    std::mutex mutex_;
+    std::array<Header*, NumberClasses> free_{};
+    char *ptr_{nullptr}, *end_{nullptr};
+};
+
+std::atomic<Allocator*>& default_allocator_ptr() {
+    static std::atomic<Allocator*> ptr{&malloc_allocator()};
+    return ptr;
+}
+
+}; // anonymous
+
+Allocator& malloc_allocator() {
+    static MallocAllocator alloc;
+    return alloc;
+}
+
+Allocator& arena_allocator() {
+    static ArenaAllocator alloc;
+    return alloc;
+}
+
+Allocator& huge_page_allocator() {
+    static HugePagePool alloc;
+    return alloc;
+}
+
+Allocator& default_allocator() {
+    return *default_allocator_ptr().load(std::memory_order_acquire);
+}
+
+void set_default_allocator(Allocator& alloc) {
+    default_allocator_ptr().store(&alloc, std::memory_order_release);
+}
+
+}; // core
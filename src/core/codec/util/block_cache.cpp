@@ -0,0 +1,170 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <optional>
+#include <stdexcept>
+#include <sys/stat.h>
+#include "core/codec/util/block_cache.h"
+
+namespace core::codec
+{
+
+namespace {
+
+uint64_t mix(uint64_t h, uint64_t value) {
+    h ^= value + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+}; // anonymous
+
+BlockCache::BlockCache(size_t capacity)
+    : capacity_(capacity) {
+}
+
+BlockCache& BlockCache::global() {
+    static BlockCache cache;
+    return cache;
+}
+
+uint64_t BlockCache::file_id(const std::string& path) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0)
+	throw std::runtime_error("BlockCache::file_id: cannot stat " + path);
+    uint64_t h = 0;
+    h = mix(h, st.st_dev);
+    h = mix(h, st.st_ino);
+    h = mix(h, st.st_size);
+    h = mix(h, st.st_mtim.tv_sec);
+    h = mix(h, st.st_mtim.tv_nsec);
+    return h;
+}
+
+BlockCache::Block BlockCache::find(const BlockKey& key) {
+    std::lock_guard lock(mutex_);
+    auto block = lookup(key);
+    if (block)
+	++hits_;
+    return block;
+}
+
+BlockCache::Block BlockCache::get(const BlockKey& key, const std::function<std::string()>& load) {
+    std::optional<std::promise<Block>> promise;
+    {
+	std::unique_lock lock(mutex_);
+	if (auto block = lookup(key)) {
+	    ++hits_;
+	    return block;
+	}
+
+	// Wait for the reader already loading the block.
+	if (auto iter = loading_.find(key); iter != loading_.end()) {
+	    auto future = iter->second;
+	    ++hits_;
+	    ++waits_;
+	    lock.unlock();
+	    return future.get();
+	}
+	++misses_;
+	promise.emplace();
+	loading_.emplace(key, promise->get_future().share());
+    }
+
+    Block block;
+    try {
+	block = std::make_shared<const std::string>(load());
+    } catch (...) {
+	std::lock_guard lock(mutex_);
+	loading_.erase(key);
+	promise->set_exception(std::current_exception());
+	throw;
+    }
+
+    {
+	std::lock_guard lock(mutex_);
+	loading_.erase(key);
+	block = store(key, std::move(block));
+    }
+    promise->set_value(block);
+    return block;
+}
+
+BlockCache::Block BlockCache::insert(const BlockKey& key, std::string data) {
+    auto block = std::make_shared<const std::string>(std::move(data));
+    std::lock_guard lock(mutex_);
+    if (auto cached = lookup(key))
+	return cached;
+    return store(key, std::move(block));
+}
+
+void BlockCache::erase(uint64_t file) {
+    std::lock_guard lock(mutex_);
+    for (auto iter = lru_.begin(); iter != lru_.end(); ) {
+	if (iter->key.file == file) {
+	    bytes_ -= iter->data->size();
+	    index_.erase(iter->key);
+	    iter = lru_.erase(iter);
+	} else {
+	    ++iter;
+	}
+    }
+}
+
+void BlockCache::clear() {
+    std::lock_guard lock(mutex_);
+    lru_.clear();
+    index_.clear();
+    bytes_ = 0;
+}
+
+size_t BlockCache::capacity() const {
+    std::lock_guard lock(mutex_);
+    return capacity_;
+}
+
+void BlockCache::set_capacity(size_t capacity) {
+    std::lock_guard lock(mutex_);
+    capacity_ = capacity;
+    evict();
+}
+
+BlockCacheStats BlockCache::stats() const {
+    std::lock_guard lock(mutex_);
+    return { hits_, waits_, misses_, evictions_, bytes_, lru_.size(), capacity_ };
+}
+
+void BlockCache::reset_stats() {
+    std::lock_guard lock(mutex_);
+    hits_ = waits_ = misses_ = evictions_ = 0;
+}
+
+BlockCache::Block BlockCache::lookup(const BlockKey& key) {
+    auto iter = index_.find(key);
+    if (iter == index_.end())
+	return nullptr;
+    lru_.splice(lru_.begin(), lru_, iter->second);
+    return iter->second->data;
+}
+
+BlockCache::Block BlockCache::store(const BlockKey& key, Block data) {
+    // A block inserted while it was loaded, e.g. by `insert`, wins.
+    if (auto cached = lookup(key))
+	return cached;
+    lru_.push_front({key, data});
+    index_.emplace(key, lru_.begin());
+    bytes_ += data->size();
+    evict();
+    return data;
+}
+
+void BlockCache::evict() {
+    while (bytes_ > capacity_ and not lru_.empty()) {
+	auto& entry = lru_.back();
+	bytes_ -= entry.data->size();
+	index_.erase(entry.key);
+	lru_.pop_back();
+	++evictions_;
+    }
+}
+
+}; // core::codec
@@ -0,0 +1,166 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <unistd.h>
+#include "core/codec/util/chunk_sink.h"
+
+namespace core::codec
+{
+
+ChunkSink::ChunkSink(size_t block_size, core::Allocator *alloc)
+    : block_size_(block_size)
+    , alloc_(alloc ? alloc : &core::arena_allocator()) {
+    if (block_size_ == 0)
+	throw std::invalid_argument("ChunkSink: block size must be positive");
+}
+
+ChunkSink::ChunkSink(ChunkSink&& other)
+    : block_size_(other.block_size_)
+    , alloc_(other.alloc_)
+    , blocks_(std::move(other.blocks_))
+    , size_(std::exchange(other.size_, 0))
+    , last_(std::exchange(other.last_, 0)) {
+    other.blocks_.clear();
+}
+
+ChunkSink& ChunkSink::operator=(ChunkSink&& other) {
+    if (this != &other) {
+	clear();
+	block_size_ = other.block_size_;
+	alloc_ = other.alloc_;
+	blocks_ = std::move(other.blocks_);
+	other.blocks_.clear();
+	size_ = std::exchange(other.size_, 0);
+	last_ = std::exchange(other.last_, 0);
+    }
+    return *this;
+}
+
+ChunkSink::~ChunkSink() {
+    clear();
+}
+
+char *ChunkSink::allocate() {
+    auto ptr = static_cast<char*>(alloc_->allocate(block_size_));
+    try {
+	blocks_.push_back(ptr);
+    } catch (...) {
+	alloc_->deallocate(ptr);
+	throw;
+    }
+    last_ = 0;
+    return ptr;
+}
+
+void ChunkSink::write(const char *ptr, size_t count) {
+    while (count > 0) {
+	auto area = prepare();
+	auto n = std::min(count, area.size());
+	memcpy(area.data(), ptr, n);
+	commit(n);
+	ptr += n;
+	count -= n;
+    }
+}
+
+std::span<char> ChunkSink::prepare() {
+    if (blocks_.empty() or last_ == block_size_)
+	allocate();
+    return {blocks_.back() + last_, block_size_ - last_};
+}
+
+void ChunkSink::commit(size_t n) {
+    if (blocks_.empty() or n > block_size_ - last_)
+	throw std::out_of_range("ChunkSink: commit beyond the prepared area");
+    last_ += n;
+    size_ += n;
+}
+
+std::string_view ChunkSink::block(size_t k) const {
+    if (k >= blocks_.size())
+	throw std::out_of_range("ChunkSink: block out of range");
+    return {blocks_[k], k + 1 < blocks_.size() ? block_size_ : last_};
+}
+
+std::vector<iovec> ChunkSink::iovecs() const {
+    std::vector<iovec> iov;
+    iov.reserve(blocks_.size());
+    for_each([&](std::string_view b) {
+	if (not b.empty())
+	    iov.push_back({const_cast<char*>(b.data()), b.size()});
+    });
+    return iov;
+}
+
+void ChunkSink::copy(size_t pos, char *out, size_t count) const {
+    if (pos > size_ or count > size_ - pos)
+	throw std::out_of_range("ChunkSink: copy beyond the end of the sink");
+    while (count > 0) {
+	auto b = block(pos / block_size_);
+	auto offset = pos % block_size_;
+	auto n = std::min(count, b.size() - offset);
+	memcpy(out, b.data() + offset, n);
+	out += n;
+	pos += n;
+	count -= n;
+    }
+}
+
+void ChunkSink::write_to(int fd) const {
+    auto iov = iovecs();
+    size_t i{0};
+    while (i < iov.size()) {
+	auto n = std::min<size_t>(iov.size() - i, IOV_MAX);
+	auto r = ::writev(fd, iov.data() + i, n);
+	if (r < 0) {
+	    if (errno == EINTR)
+		continue;
+	    throw std::system_error(errno, std::generic_category(), "ChunkSink: writev");
+	}
+
+	// Skip the vectors written and trim a partly written one.
+	auto written = size_t(r);
+	while (i < iov.size() and written >= iov[i].iov_len)
+	    written -= iov[i++].iov_len;
+	if (written > 0) {
+	    iov[i].iov_base = static_cast<char*>(iov[i].iov_base) + written;
+	    iov[i].iov_len -= written;
+	}
+    }
+}
+
+std::string ChunkSink::str() const {
+    std::string out;
+    out.reserve(size_);
+    for_each([&](std::string_view b) { out.append(b); });
+    return out;
+}
+
+std::string ChunkSink::take() {
+    std::string out;
+    out.reserve(size_);
+    for (size_t k = 0; k < blocks_.size(); ++k) {
+	auto b = block(k);
+	out.append(b.data(), b.size());
+	alloc_->deallocate(std::exchange(blocks_[k], nullptr));
+    }
+    blocks_.clear();
+    size_ = last_ = 0;
+    return out;
+}
+
+void ChunkSink::clear() {
+    for (auto ptr : blocks_)
+	alloc_->deallocate(ptr);
+    blocks_.clear();
+    size_ = last_ = 0;
+}
+
+}; // core::codec
@@ -0,0 +1,85 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <algorithm>
+#include <cstring>
+#include "core/codec/util/peek_source.h"
+
+namespace core
+{
+
+std::string_view PeekSource::peek(size_t n) {
+    if (decoder_) {
+	while (pending_.size() - pending_pos_ < n and decode_more());
+	auto count = std::min(n, pending_.size() - pending_pos_);
+	return {pending_.data() + pending_pos_, count};
+    }
+
+    while (raw_.size() - raw_pos_ < n) {
+	auto have = raw_.size();
+	raw_.resize(raw_pos_ + n);
+	auto count = read_(source_, raw_.data() + have, raw_.size() - have);
+	raw_.resize(have + count);
+	if (count == 0)
+	    break;
+    }
+    auto count = std::min(n, raw_.size() - raw_pos_);
+    return {raw_.data() + raw_pos_, count};
+}
+
+void PeekSource::decode_base64() {
+    if (not decoder_)
+	decoder_ = std::make_unique<base64::Decoder<codec::ByteSource&>>(raw_source_);
+}
+
+size_t PeekSource::read_bytes(char *ptr, size_t count) {
+    if (not decoder_)
+	return read_raw(ptr, count);
+
+    // The peeked bytes are replayed before reading from the decoder.
+    if (pending_pos_ < pending_.size()) {
+	auto n = std::min(count, pending_.size() - pending_pos_);
+	memcpy(ptr, pending_.data() + pending_pos_, n);
+	pending_pos_ += n;
+	if (pending_pos_ == pending_.size()) {
+	    pending_.clear();
+	    pending_pos_ = 0;
+	}
+	return n;
+    }
+
+    // Deliver what one read of the source decodes, like the other
+    // sources, rather than waiting for `count` bytes.
+    auto& get = decoder_->get();
+    if (not get.available() and not decoder_->underflow())
+	return 0;
+    auto n = std::min(count, get.size());
+    memcpy(ptr, get.data(), n);
+    get.discard(n);
+    return n;
+}
+
+size_t PeekSource::read_raw(char *ptr, size_t count) {
+    if (raw_pos_ < raw_.size()) {
+	auto n = std::min(count, raw_.size() - raw_pos_);
+	memcpy(ptr, raw_.data() + raw_pos_, n);
+	raw_pos_ += n;
+	if (raw_pos_ == raw_.size()) {
+	    raw_.clear();
+	    raw_pos_ = 0;
+	}
+	return n;
+    }
+    return read_(source_, ptr, count);
+}
+
+bool PeekSource::decode_more() {
+    if (not decoder_->underflow())
+	return false;
+    auto v = decoder_->view();
+    pending_.append(v);
+    decoder_->get().discard(v.size());
+    return true;
+}
+
+}; // core
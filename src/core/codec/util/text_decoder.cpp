@@ -0,0 +1,150 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include "core/codec/util/text_decoder.h"
+#include "core/codec/base16/codec.h"
+#include "core/codec/base32/codec.h"
+#include "core/codec/base64/codec.h"
+#include "core/codec/z85/codec.h"
+#include "core/codec/zstd/adapter.h"
+#include "core/cc/queue/lockfree_spsc.h"
+#include "core/cc/queue/source_spsc.h"
+#include "core/codec/util/byte_io.h"
+
+namespace core::codec
+{
+
+// The carried partial quantum is kept at the front of `put_` followed
+// by the next chunk read from the source.
+template<class Codec, class Source>
+TextDecoder<Codec, Source>::TextDecoder(std::add_rvalue_reference_t<Source> is,
+					const Options& options, size_t n, core::Allocator *alloc)
+    : is_(std::forward<Source>(is))
+    , options_(options)
+    , put_((n > 0 ? n : 65536) + Codec::Chars - 1, alloc)
+    , get_((put_.capacity() + Codec::Chars - 1) / Codec::Chars * Codec::Bytes, alloc)
+{ }
+
+template<class Codec, class Source>
+TextDecoder<Codec, Source>::TextDecoder(TextDecoder&& other)
+    : is_(std::forward<Source>(other.is_))
+    , options_(other.options_)
+    , put_(std::move(other.put_))
+    , get_(std::move(other.get_))
+    , ncarry_(other.ncarry_)
+    , closed_(std::exchange(other.closed_, true)) {
+}
+
+template<class Codec, class Source>
+bool TextDecoder<Codec, Source>::read_line(std::string& line) {
+    line.clear();
+
+    while (true) {
+	if (auto v = get_.view(); not v.empty()) {
+	    if (auto ptr = (const char*)memchr(v.data(), '\n', v.size())) {
+		line.append(v.data(), ptr);
+		get_.discard(ptr - v.data() + 1);
+		return true;
+	    }
+	    line.append(v);
+	    get_.discard(v.size());
+	}
+
+	if (not underflow())
+	    return line.size() > 0;
+    }
+}
+
+template<class Codec, class Source>
+size_t TextDecoder<Codec, Source>::read_bytes(char *buffer, size_t requested) {
+    size_t count{0};
+    while (count < requested) {
+	if (not get_.available()) {
+	    if (not underflow())
+		break;
+	}
+
+	auto n = std::min(requested - count, get_.size());
+	memcpy(buffer + count, get_.data(), n);
+	count += n;
+	get_.discard(n);
+    }
+    return count;
+}
+
+template<class Codec, class Source>
+bool TextDecoder<Codec, Source>::underflow() {
+    auto out = get_.begin();
+    while (not closed_) {
+	auto begin = put_.begin() + ncarry_;
+	auto count = zstd::InStreamAdapter<Source>::read(is_, begin, put_.capacity() - ncarry_);
+
+	// The final quantum may be short.
+	if (count == 0) {
+	    close();
+	    get_.update(decode({put_.begin(), ncarry_}, out));
+	    ncarry_ = 0;
+	    return get_.available();
+	}
+
+	auto end = std::remove_if(begin, begin + count, is_space);
+	size_t size = end - put_.begin();
+	auto whole = size / Codec::Chars * Codec::Chars;
+	if (whole > 0) {
+	    get_.update(decode({put_.begin(), whole}, out));
+	    ncarry_ = size - whole;
+	    memmove(put_.begin(), put_.begin() + whole, ncarry_);
+	    return true;
+	}
+	ncarry_ = size;
+    }
+    get_.update(0);
+    return false;
+}
+
+template<class Codec, class Source>
+size_t TextDecoder<Codec, Source>::decode(std::string_view in, char *out) {
+    auto r = Codec::decode(in, {out, get_.capacity()}, options_);
+    if (not r)
+	throw std::runtime_error(std::string{"Input is not valid "} + Codec::Name + "-encoded data.");
+    return r.count;
+}
+
+template class TextDecoder<base16::Codec, std::istream&>;
+template class TextDecoder<base16::Codec, std::ifstream&>;
+template class TextDecoder<base16::Codec, std::stringstream&>;
+template class TextDecoder<base16::Codec, core::cc::queue::LockFreeSpSc<char>&>;
+template class TextDecoder<base16::Codec, core::cc::queue::SourceSpSc<char>&>;
+template class TextDecoder<base16::Codec, ByteSource&>;
+template class TextDecoder<base16::Codec, std::ifstream>;
+
+template class TextDecoder<base64::Codec, std::istream&>;
+template class TextDecoder<base64::Codec, std::ifstream&>;
+template class TextDecoder<base64::Codec, std::stringstream&>;
+template class TextDecoder<base64::Codec, core::cc::queue::LockFreeSpSc<char>&>;
+template class TextDecoder<base64::Codec, core::cc::queue::SourceSpSc<char>&>;
+template class TextDecoder<base64::Codec, ByteSource&>;
+template class TextDecoder<base64::Codec, std::ifstream>;
+
+template class TextDecoder<base32::Codec, std::istream&>;
+template class TextDecoder<base32::Codec, std::ifstream&>;
+template class TextDecoder<base32::Codec, std::stringstream&>;
+template class TextDecoder<base32::Codec, core::cc::queue::LockFreeSpSc<char>&>;
+template class TextDecoder<base32::Codec, core::cc::queue::SourceSpSc<char>&>;
+template class TextDecoder<base32::Codec, ByteSource&>;
+template class TextDecoder<base32::Codec, std::ifstream>;
+
+template class TextDecoder<z85::Codec, std::istream&>;
+template class TextDecoder<z85::Codec, std::ifstream&>;
+template class TextDecoder<z85::Codec, std::stringstream&>;
+template class TextDecoder<z85::Codec, core::cc::queue::LockFreeSpSc<char>&>;
+template class TextDecoder<z85::Codec, core::cc::queue::SourceSpSc<char>&>;
+template class TextDecoder<z85::Codec, ByteSource&>;
+template class TextDecoder<z85::Codec, std::ifstream>;
+
+}; // core::codec
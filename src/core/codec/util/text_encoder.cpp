@@ -0,0 +1,184 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <cstring>
+#include <fmt/format.h>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "core/codec/util/text_encoder.h"
+#include "core/codec/base16/codec.h"
+#include "core/codec/base32/codec.h"
+#include "core/codec/base64/codec.h"
+#include "core/codec/z85/codec.h"
+#include "core/codec/zstd/adapter.h"
+#include "core/cc/queue/lockfree_spsc.h"
+#include "core/cc/queue/sink_spsc.h"
+#include "core/codec/util/byte_io.h"
+
+namespace core::codec
+{
+
+namespace {
+
+// Return the line length of `options`, zero if `Codec` does not break
+// lines.
+template<class Codec>
+size_t line_length(const typename Codec::Options& options) {
+    if constexpr (requires { Codec::line_length(options); })
+	return Codec::line_length(options);
+    else
+	return 0;
+}
+
+}; // anonymous
+
+template<class Codec, class Sink>
+TextEncoder<Codec, Sink>::TextEncoder(std::add_rvalue_reference_t<Sink> os, const Options& options,
+				      size_t n, core::Allocator *alloc)
+    : os_(std::forward<Sink>(os))
+    , options_(options)
+    , line_length_(line_length<Codec>(options))
+    , area_(std::max<size_t>(n > 0 ? n : 65536, 2 * Codec::Chars), alloc) {
+    if (line_length_ % Codec::Chars != 0)
+	throw std::runtime_error(fmt::format("{}: line length must be a multiple of {}",
+					     Codec::Name, Codec::Chars));
+}
+
+template<class Codec, class Sink>
+TextEncoder<Codec, Sink>::TextEncoder(TextEncoder&& other)
+    : os_(std::forward<Sink>(other.os_))
+    , options_(other.options_)
+    , line_length_(other.line_length_)
+    , area_(std::move(other.area_))
+    , size_(other.size_)
+    , column_(other.column_)
+    , count_(other.count_)
+    , ncarry_(other.ncarry_)
+    , closed_(std::exchange(other.closed_, true)) {
+    memcpy(carry_, other.carry_, sizeof(carry_));
+}
+
+template<class Codec, class Sink>
+TextEncoder<Codec, Sink>::~TextEncoder() {
+    if (not closed_)
+	close();
+}
+
+template<class Codec, class Sink>
+void TextEncoder<Codec, Sink>::write(const char *begin, const char *end) {
+    if (closed_)
+	throw std::runtime_error(std::string{Codec::Name} + ": attempt to write to closed stream");
+
+    size_t count = end - begin;
+    if (ncarry_ > 0) {
+	auto n = std::min(Codec::Bytes - ncarry_, count);
+	memcpy(carry_ + ncarry_, begin, n);
+	ncarry_ += n;
+	begin += n;
+	count -= n;
+	if (ncarry_ < Codec::Bytes)
+	    return;
+	encode(carry_, Codec::Bytes);
+	ncarry_ = 0;
+    }
+
+    auto whole = count / Codec::Bytes * Codec::Bytes;
+    encode(begin, whole);
+    memcpy(carry_, begin + whole, count - whole);
+    ncarry_ = count - whole;
+}
+
+template<class Codec, class Sink>
+void TextEncoder<Codec, Sink>::encode(const char *in, size_t n) {
+    while (n > 0) {
+	line_break();
+	if (area_.capacity() - size_ < Codec::Chars)
+	    flush();
+	auto chars = std::min(n / Codec::Bytes * Codec::Chars,
+			      (area_.capacity() - size_) / Codec::Chars * Codec::Chars);
+	if (line_length_ > 0)
+	    chars = std::min(chars, line_length_ - column_);
+
+	auto bytes = chars / Codec::Chars * Codec::Bytes;
+	std::span<char> out{area_.begin() + size_, area_.capacity() - size_};
+	size_ += Codec::encode({in, bytes}, out, options_).count;
+	column_ += chars;
+	in += bytes;
+	n -= bytes;
+    }
+}
+
+template<class Codec, class Sink>
+void TextEncoder<Codec, Sink>::line_break() {
+    // The line break is written lazily, i.e. before the next
+    // character, so that the output never ends with one.
+    if (line_length_ > 0 and column_ == line_length_) {
+	if (size_ == area_.capacity())
+	    flush();
+	area_.begin()[size_++] = '\n';
+	column_ = 0;
+    }
+}
+
+template<class Codec, class Sink>
+void TextEncoder<Codec, Sink>::flush() {
+    if (size_ > 0)
+	zstd::OutStreamAdapter<Sink>::write(os_, area_.begin(), size_);
+    count_ += size_;
+    size_ = 0;
+}
+
+template<class Codec, class Sink>
+void TextEncoder<Codec, Sink>::close() {
+    if (closed_)
+	throw std::runtime_error(std::string{Codec::Name} + ": attempt to close already closed stream");
+    closed_ = true;
+
+    if (ncarry_ > 0) {
+	line_break();
+	if (area_.capacity() - size_ < Codec::Chars)
+	    flush();
+	std::span<char> out{area_.begin() + size_, area_.capacity() - size_};
+	size_ += Codec::encode({carry_, ncarry_}, out, options_).count;
+	column_ += Codec::Chars;
+	ncarry_ = 0;
+    }
+    flush();
+    zstd::OutStreamAdapter<Sink>::finish(os_);
+}
+
+template class TextEncoder<base16::Codec, std::ostream&>;
+template class TextEncoder<base16::Codec, std::ofstream&>;
+template class TextEncoder<base16::Codec, std::stringstream&>;
+template class TextEncoder<base16::Codec, core::cc::queue::LockFreeSpSc<char>&>;
+template class TextEncoder<base16::Codec, core::cc::queue::SinkSpSc<char>&>;
+template class TextEncoder<base16::Codec, ByteSink&>;
+template class TextEncoder<base16::Codec, std::ofstream>;
+
+template class TextEncoder<base64::Codec, std::ostream&>;
+template class TextEncoder<base64::Codec, std::ofstream&>;
+template class TextEncoder<base64::Codec, std::stringstream&>;
+template class TextEncoder<base64::Codec, core::cc::queue::LockFreeSpSc<char>&>;
+template class TextEncoder<base64::Codec, core::cc::queue::SinkSpSc<char>&>;
+template class TextEncoder<base64::Codec, ByteSink&>;
+template class TextEncoder<base64::Codec, std::ofstream>;
+
+template class TextEncoder<base32::Codec, std::ostream&>;
+template class TextEncoder<base32::Codec, std::ofstream&>;
+template class TextEncoder<base32::Codec, std::stringstream&>;
+template class TextEncoder<base32::Codec, core::cc::queue::LockFreeSpSc<char>&>;
+template class TextEncoder<base32::Codec, core::cc::queue::SinkSpSc<char>&>;
+template class TextEncoder<base32::Codec, ByteSink&>;
+template class TextEncoder<base32::Codec, std::ofstream>;
+
+template class TextEncoder<z85::Codec, std::ostream&>;
+template class TextEncoder<z85::Codec, std::ofstream&>;
+template class TextEncoder<z85::Codec, std::stringstream&>;
+template class TextEncoder<z85::Codec, core::cc::queue::LockFreeSpSc<char>&>;
+template class TextEncoder<z85::Codec, core::cc::queue::SinkSpSc<char>&>;
+template class TextEncoder<z85::Codec, ByteSink&>;
+template class TextEncoder<z85::Codec, std::ofstream>;
+
+}; // core::codec
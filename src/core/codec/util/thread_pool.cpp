@@ -0,0 +1,156 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <utility>
+#include "core/codec/util/parallel.h"
+#include "core/codec/util/thread_pool.h"
+
+namespace core::codec
+{
+
+ThreadPool::ThreadPool(size_t threads)
+    : size_(threads) {
+}
+
+ThreadPool::~ThreadPool() {
+    {
+	std::lock_guard lock(mutex_);
+	stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_)
+	worker.join();
+}
+
+ThreadPool& ThreadPool::global() {
+    static ThreadPool pool{hardware_threads()};
+    return pool;
+}
+
+size_t ThreadPool::size() const {
+    std::lock_guard lock(mutex_);
+    return size_;
+}
+
+void ThreadPool::resize(size_t threads) {
+    std::vector<std::thread> removed;
+    {
+	std::lock_guard lock(mutex_);
+	size_ = threads;
+	if (workers_.size() > threads) {
+	    removed.assign(std::make_move_iterator(workers_.begin() + threads),
+			   std::make_move_iterator(workers_.end()));
+	    workers_.resize(threads);
+	}
+	else if (not workers_.empty())
+	    while (workers_.size() < threads)
+		start(workers_.size());
+    }
+    cv_.notify_all();
+    for (auto& worker : removed)
+	worker.join();
+
+    // Without workers, the tasks left are run here.
+    while (threads == 0) {
+	std::function<void()> task;
+	{
+	    std::lock_guard lock(mutex_);
+	    if (tasks_.empty())
+		break;
+	    task = std::move(tasks_.front());
+	    tasks_.pop_front();
+	}
+	task();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+	std::lock_guard lock(mutex_);
+	if (size_ > 0) {
+	    // The workers are started by the first task.
+	    while (workers_.size() < size_)
+		start(workers_.size());
+	    tasks_.push_back(std::move(task));
+	    task = nullptr;
+	}
+    }
+    if (task)
+	task();
+    else
+	cv_.notify_one();
+}
+
+// Start worker `id`; `mutex_` is held.
+void ThreadPool::start(size_t id) {
+    workers_.emplace_back([this, id]() { work(id); });
+}
+
+void ThreadPool::work(size_t id) {
+    while (true) {
+	std::function<void()> task;
+	{
+	    std::unique_lock lock(mutex_);
+	    cv_.wait(lock, [&]() { return stop_ or id >= size_ or not tasks_.empty(); });
+	    if (id >= size_ or tasks_.empty())
+		return;
+	    task = std::move(tasks_.front());
+	    tasks_.pop_front();
+	}
+	task();
+    }
+}
+
+TaskGroup::TaskGroup(ThreadPool& pool)
+    : pool_(pool)
+    , state_(std::make_shared<State>()) {
+}
+
+TaskGroup::~TaskGroup() {
+    try {
+	close();
+    } catch (...) {
+    }
+}
+
+void TaskGroup::run(std::function<void()> task) {
+    {
+	std::lock_guard lock(state_->mutex);
+	if (state_->closed)
+	    return;
+    }
+
+    // The calling thread does the work of the tasks of a pool without
+    // workers, so they are not run inline.
+    if (pool_.size() == 0)
+	return;
+    ++count_;
+    pool_.submit([state = state_, task = std::move(task)]() {
+	{
+	    std::lock_guard lock(state->mutex);
+	    if (state->closed)
+		return;
+	    ++state->running;
+	}
+	try {
+	    task();
+	} catch (...) {
+	    std::lock_guard lock(state->mutex);
+	    if (not state->error)
+		state->error = std::current_exception();
+	}
+	std::lock_guard lock(state->mutex);
+	if (--state->running == 0)
+	    state->cv.notify_all();
+    });
+}
+
+void TaskGroup::close() {
+    std::unique_lock lock(state_->mutex);
+    state_->closed = true;
+    state_->cv.wait(lock, [&]() { return state_->running == 0; });
+    if (auto error = std::exchange(state_->error, nullptr))
+	std::rethrow_exception(error);
+}
+
+}; // core::codec
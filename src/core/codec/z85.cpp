@@ -0,0 +1,19 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <stdexcept>
+#include "core/codec/z85.h"
+#include "core/codec/z85/codec.h"
+
+std::string z85_encode(std::string_view s) {
+    std::string ret(z85::encoded_length(s.size()), '\0');
+    z85::encode_into(s, ret);
+    return ret;
+}
+
+std::string z85_decode(std::string_view s) {
+    std::string ret(z85::decoded_length(s), '\0');
+    if (not z85::decode_into(s, ret))
+	throw std::runtime_error("Input is not valid z85-encoded data.");
+    return ret;
+}
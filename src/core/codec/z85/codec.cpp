@@ -0,0 +1,84 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <algorithm>
+#include "core/codec/z85/codec.h"
+#include "core/codec/z85/kernels.h"
+
+namespace z85
+{
+
+namespace {
+
+// The number of characters validated per block.
+constexpr size_t BlockSize = 4000;
+
+// Decode `in` into `out` unless null, i.e. only validate.
+Result decode(std::string_view in, unsigned char *out, size_t capacity) {
+    auto tail = in.size() % 5;
+    if (tail == 1)
+	return {Status::InvalidLength, 0};
+    if (out and decoded_length(in) > capacity)
+	return {Status::OutputTooSmall, 0};
+
+    // The whole quanta are decoded by the kernels, into the scratch
+    // buffer a block at a time when validating.
+    auto& k = kernels();
+    unsigned char scratch[BlockSize / 5 * 4];
+    size_t pos{0}, count{0}, body = in.size() - tail;
+    while (pos < body) {
+	auto m = std::min(body - pos, out ? body : BlockSize);
+	auto decoded = k.decode(in.data() + pos, m, out ? out + count : scratch);
+	pos += decoded;
+	count += decoded / 5 * 4;
+	if (decoded < m)
+	    return {Status::InvalidCharacter, count};
+    }
+
+    // Pad the final quantum with the largest digit, which decodes to
+    // the bytes of the quantum followed by ignored bytes.
+    if (tail > 0) {
+	char chars[5] = { '#', '#', '#', '#', '#' };
+	std::copy(in.data() + pos, in.data() + in.size(), chars);
+	unsigned char bytes[4];
+	if (z85::kernels(Isa::Scalar).decode(chars, 5, bytes) < 5)
+	    return {Status::InvalidCharacter, count};
+	if (out)
+	    std::copy(bytes, bytes + tail - 1, out + count);
+	count += tail - 1;
+    }
+    return {Status::Ok, count};
+}
+
+}; // anonymous
+
+Result encode_into(std::string_view in, std::span<char> out) {
+    auto length = encoded_length(in.size());
+    if (length > out.size())
+	return {Status::OutputTooSmall, 0};
+
+    auto ptr = reinterpret_cast<const unsigned char*>(in.data());
+    auto whole = in.size() / 4 * 4;
+    kernels().encode(ptr, whole, out.data());
+
+    // Encode the final quantum padded with zero bytes, then keep the
+    // digits that encode the input bytes.
+    if (auto tail = in.size() - whole; tail > 0) {
+	unsigned char quantum[4]{};
+	std::copy(ptr + whole, ptr + in.size(), quantum);
+	char chars[5];
+	z85::kernels(Isa::Scalar).encode(quantum, 4, chars);
+	std::copy(chars, chars + tail + 1, out.data() + whole / 4 * 5);
+    }
+    return {Status::Ok, length};
+}
+
+Result decode_into(std::string_view in, std::span<char> out) {
+    return decode(in, reinterpret_cast<unsigned char*>(out.data()), out.size());
+}
+
+Result validate(std::string_view in) {
+    return decode(in, nullptr, 0);
+}
+
+}; // z85
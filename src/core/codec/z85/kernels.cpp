@@ -0,0 +1,254 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include "core/codec/z85/kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CODEC_Z85_X86 1
+#include <immintrin.h>
+#endif
+
+namespace z85
+{
+
+namespace {
+
+constexpr const char *Alphabet =
+    "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ.-:+=^!/*?&<>()[]{}@%$#";
+
+// Map every byte to its value or `Invalid`.
+constexpr std::array<unsigned char, 256> make_values() {
+    std::array<unsigned char, 256> values{};
+    for (auto& v : values)
+	v = Invalid;
+    for (int i = 0; i < 85; ++i)
+	values[(unsigned char)Alphabet[i]] = i;
+    return values;
+}
+
+constexpr auto Values = make_values();
+
+// The value of the leading digit of a quantum (85^4).
+constexpr uint32_t Power4 = 85 * 85 * 85 * 85;
+
+void encode_scalar(const unsigned char *in, size_t n, char *out) {
+    for (size_t i = 0; i < n; i += 4, out += 5) {
+	uint32_t v = (uint32_t(in[i]) << 24) | (uint32_t(in[i + 1]) << 16)
+	    | (uint32_t(in[i + 2]) << 8) | in[i + 3];
+	for (int k = 4; k >= 0; --k, v /= 85)
+	    out[k] = Alphabet[v % 85];
+    }
+}
+
+size_t decode_scalar(const char *in, size_t n, unsigned char *out) {
+    size_t i = 0;
+    for (; i < n; i += 5, out += 4) {
+	uint64_t v{0};
+	unsigned invalid{0};
+	for (int k = 0; k < 5; ++k) {
+	    auto d = Values[(unsigned char)in[i + k]];
+	    invalid |= d;
+	    v = 85 * v + d;
+	}
+	if (invalid == Invalid or v > 0xffffffff)
+	    break;
+	out[0] = v >> 24;
+	out[1] = v >> 16;
+	out[2] = v >> 8;
+	out[3] = v;
+    }
+    return i;
+}
+
+#ifdef CODEC_Z85_X86
+
+// The AVX-512 VBMI kernels convert sixteen quanta at a time, dividing
+// by 85 with a multiply-high (x / 85 == x * 0xc0c0c0c1 >> 38 for all
+// 32-bit x) and looking up the 85 characters (or values) with two
+// register byte permutes. There are no SSSE3 or AVX2 kernels since
+// without byte permutes the lookups dominate.
+
+// GCC 12 reports its own _mm512_undefined_epi32 as maybe uninitialized.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// The characters, and the values of the 128 ASCII characters with the
+// high bit set for invalid characters, for the byte permutes.
+alignas(64) constexpr auto Chars = []() {
+    std::array<char, 128> chars{};
+    for (int i = 0; i < 85; ++i)
+	chars[i] = Alphabet[i];
+    return chars;
+}();
+
+alignas(64) constexpr auto Lookup = []() {
+    std::array<char, 128> lookup{};
+    for (int i = 0; i < 128; ++i)
+	lookup[i] = Values[i] == Invalid ? char(0x80) : char(Values[i]);
+    return lookup;
+}();
+
+// The byte permutes between the five digits of each of sixteen
+// quanta in order, i.e. the 80 characters, and the digits in planes:
+// the first four digits of each quantum in the first register and
+// the last in the second.
+alignas(64) constexpr auto Interleave = []() {
+    std::array<char, 128> interleave{};
+    for (int p = 0; p < 80; ++p)
+	interleave[p] = p % 5 < 4 ? 16 * (p % 5) + p / 5 : 64 + p / 5;
+    return interleave;
+}();
+
+alignas(64) constexpr auto Planes = []() {
+    std::array<char, 128> planes{};
+    for (int q = 0; q < 64; ++q)
+	planes[q] = 5 * (q % 16) + q / 16;
+    for (int j = 0; j < 16; ++j)
+	planes[64 + j] = 5 * j + 4;
+    return planes;
+}();
+
+// Swap the bytes of each 32-bit lane, i.e. to and from big-endian.
+__attribute__((target("avx512f,avx512bw")))
+__m512i bswap32(__m512i x) {
+    return _mm512_shuffle_epi8(x, _mm512_set4_epi32(0x0c0d0e0f, 0x08090a0b, 0x04050607, 0x00010203));
+}
+
+__attribute__((target("avx512f")))
+__m512i div85(__m512i x) {
+    const auto m = _mm512_set1_epi32(int(0xc0c0c0c1));
+    auto even = _mm512_srli_epi64(_mm512_mul_epu32(x, m), 38);
+    auto odd = _mm512_srli_epi64(_mm512_mul_epu32(_mm512_srli_epi64(x, 32), m), 38);
+    return _mm512_or_si512(even, _mm512_slli_epi64(odd, 32));
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+void encode_avx512vbmi(const unsigned char *in, size_t n, char *out) {
+    const auto chars_lo = _mm512_load_si512(Chars.data());
+    const auto chars_hi = _mm512_load_si512(Chars.data() + 64);
+    const auto interleave0 = _mm512_load_si512(Interleave.data());
+    const auto interleave1 = _mm512_load_si512(Interleave.data() + 64);
+    const auto v85 = _mm512_set1_epi32(85);
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64, out += 80) {
+	// The digits from last to first.
+	auto x = bswap32(_mm512_loadu_si512(in + i));
+	__m128i digits[5];
+	for (int k = 4; k > 0; --k) {
+	    auto q = div85(x);
+	    digits[k] = _mm512_cvtepi32_epi8(_mm512_sub_epi32(x, _mm512_mullo_epi32(q, v85)));
+	    x = q;
+	}
+	digits[0] = _mm512_cvtepi32_epi8(x);
+
+	auto a = _mm512_castsi128_si512(digits[0]);
+	a = _mm512_inserti32x4(a, digits[1], 1);
+	a = _mm512_inserti32x4(a, digits[2], 2);
+	a = _mm512_inserti32x4(a, digits[3], 3);
+	auto b = _mm512_castsi128_si512(digits[4]);
+	a = _mm512_permutex2var_epi8(chars_lo, a, chars_hi);
+	b = _mm512_permutex2var_epi8(chars_lo, b, chars_hi);
+	_mm512_storeu_si512(out, _mm512_permutex2var_epi8(a, interleave0, b));
+	_mm512_mask_storeu_epi8(out + 64, 0xffff, _mm512_permutex2var_epi8(a, interleave1, b));
+    }
+    encode_scalar(in + i, n - i, out);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+size_t decode_avx512vbmi(const char *in, size_t n, unsigned char *out) {
+    const auto lookup_lo = _mm512_load_si512(Lookup.data());
+    const auto lookup_hi = _mm512_load_si512(Lookup.data() + 64);
+    const auto planes0 = _mm512_load_si512(Planes.data());
+    const auto planes1 = _mm512_load_si512(Planes.data() + 64);
+    const auto v85 = _mm512_set1_epi32(85);
+    size_t i = 0;
+    for (; i + 80 <= n; i += 80, out += 64) {
+	auto c0 = _mm512_loadu_si512(in + i);
+	auto c1 = _mm512_maskz_loadu_epi8(0xffff, in + i + 64);
+	auto v0 = _mm512_permutex2var_epi8(lookup_lo, c0, lookup_hi);
+	auto v1 = _mm512_permutex2var_epi8(lookup_lo, c1, lookup_hi);
+	auto invalid = _mm512_movepi8_mask(_mm512_or_si512(v0, c0))
+	    | (_mm512_movepi8_mask(_mm512_or_si512(v1, c1)) & 0xffff);
+	if (invalid)
+	    break;
+
+	auto a = _mm512_permutex2var_epi8(v0, planes0, v1);
+	auto b = _mm512_permutex2var_epi8(v0, planes1, v1);
+	auto d0 = _mm512_cvtepu8_epi32(_mm512_castsi512_si128(a));
+	auto low = _mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(a, 1));
+	low = _mm512_add_epi32(_mm512_mullo_epi32(low, v85),
+			       _mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(a, 2)));
+	low = _mm512_add_epi32(_mm512_mullo_epi32(low, v85),
+			       _mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(a, 3)));
+	low = _mm512_add_epi32(_mm512_mullo_epi32(low, v85),
+			       _mm512_cvtepu8_epi32(_mm512_castsi512_si128(b)));
+
+	// The value overflows if the leading digit is too large or the
+	// sum wraps.
+	auto v = _mm512_add_epi32(_mm512_mullo_epi32(d0, _mm512_set1_epi32(Power4)), low);
+	auto overflow = _mm512_cmpgt_epu32_mask(d0, _mm512_set1_epi32(0xffffffffu / Power4))
+	    | _mm512_cmplt_epu32_mask(v, low);
+	if (overflow)
+	    break;
+	_mm512_storeu_si512(out, bswap32(v));
+    }
+    return i + decode_scalar(in + i, n - i, out);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // CODEC_Z85_X86
+
+const Kernels AllKernels[] = {
+    { Isa::Scalar, encode_scalar, decode_scalar },
+#ifdef CODEC_Z85_X86
+    { Isa::Avx512Vbmi, encode_avx512vbmi, decode_avx512vbmi },
+#endif
+};
+
+}; // anonymous
+
+bool supported(Isa isa) {
+    for (const auto& k : AllKernels)
+	if (k.isa == isa)
+	    return base64::supported(isa);
+    return false;
+}
+
+Isa best_isa() {
+    auto best = Isa::Scalar;
+    for (auto isa : Isas)
+	if (z85::supported(isa))
+	    best = isa;
+    return best;
+}
+
+const Kernels& kernels(Isa isa) {
+    if (z85::supported(isa))
+	for (const auto& k : AllKernels)
+	    if (k.isa == isa)
+		return k;
+    throw std::runtime_error("z85: kernels not supported: " + std::string{name(isa)});
+}
+
+const Kernels& kernels() {
+    static const Kernels& best = z85::kernels(best_isa());
+    return best;
+}
+
+const char *alphabet() {
+    return Alphabet;
+}
+
+unsigned char value(char c) {
+    return Values[(unsigned char)c];
+}
+
+}; // z85
@@ -0,0 +1,43 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <algorithm>
+#include "core/codec/zstd/adaptive.h"
+#include "core/codec/zstd/exception.h"
+
+namespace zstd
+{
+
+// The level is raised when the sink takes longer than compression and
+// lowered when compression takes more than `LowerRatio` times as long
+// as the sink. The band in between avoids oscillating every frame.
+static constexpr uint64_t LowerRatio = 4;
+
+LevelAdapter::LevelAdapter(const AdaptOptions& options, int level)
+    : options_(options)
+    , level_(std::clamp(level, options.min_level, options.max_level)) {
+    if (options_.min_level > options_.max_level)
+	throw zstd::error("adaptive: min_level %d exceeds max_level %d",
+			  options_.min_level, options_.max_level);
+    if (options_.frame_size == 0)
+	throw zstd::error("adaptive: frame_size must be positive");
+    history_.push_back({0, level_});
+}
+
+int LevelAdapter::end_frame() {
+    ++frames_;
+    auto level = level_;
+    if (sink_ns_ > codec_ns_)
+	level = std::min(level + 1, options_.max_level);
+    else if (codec_ns_ > LowerRatio * sink_ns_)
+	level = std::max(level - 1, options_.min_level);
+    codec_ns_ = sink_ns_ = 0;
+
+    if (level != level_) {
+	level_ = level;
+	history_.push_back({frames_, level_});
+    }
+    return level_;
+}
+
+}; // zstd
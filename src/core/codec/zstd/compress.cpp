@@ -7,7 +7,9 @@
 #include "core/codec/zstd/compress.h"
 #include "core/codec/zstd/compressor.h"
 #include "core/codec/zstd/adapter.h"
+#include "core/codec/zstd/custom_mem.h"
 #include "core/codec/zstd/exception.h"
+#include "core/codec/util/chunk_sink.h"
 #include "core/cc/queue/lockfree_spsc.h"
 #include "core/cc/queue/sink_spsc.h"
 #include "core/cc/queue/source_spsc.h"
@@ -19,32 +21,60 @@
 namespace zstd
 {
 
-std::string compress(const char *input_buffer, size_t input_size)
+namespace {
+
+// Compress the `input_size` bytes at `input_buffer` into `out` which
+// holds at least `ZSTD_compressBound(input_size)` bytes, returning the
+// compressed size.
+size_t compress_into(char *out, const char *input_buffer, size_t input_size, int level)
 {
-    auto max_size = ZSTD_compressBound(input_size);
-    std::string buffer;
-    buffer.resize(max_size);
-    
-    auto final_size = ZSTD_compress(&buffer[0], max_size, input_buffer, input_size, 1);
+    auto cctx = ZSTD_createCCtx_advanced(custom_mem(core::default_allocator()));
+    auto final_size = ZSTD_compressCCtx(cctx, out, ZSTD_compressBound(input_size),
+					input_buffer, input_size, level);
+    ZSTD_freeCCtx(cctx);
     
     if (ZSTD_isError(final_size))
 	throw zstd::error("{}", ZSTD_getErrorName(final_size));
-    
-    buffer.resize(final_size);
+    return final_size;
+}
+
+}; // anonymous
+
+std::string compress(const char *input_buffer, size_t input_size, int level)
+{
+    std::string buffer;
+    buffer.resize(ZSTD_compressBound(input_size));
+    buffer.resize(compress_into(&buffer[0], input_buffer, input_size, level));
+    return buffer;
+}
+
+std::string compress(const char *input_buffer, size_t input_size, size_t typesize,
+		     const shuffle::Options& options, int level)
+{
+    std::string filtered;
+    filtered.resize(input_size);
+    shuffle::encode(input_buffer, input_size, filtered.data(), typesize, options);
+
+    std::string buffer;
+    buffer.resize(shuffle::HeaderSize + ZSTD_compressBound(input_size));
+    shuffle::write_header({typesize, options}, buffer.data());
+    auto size = compress_into(buffer.data() + shuffle::HeaderSize, filtered.data(), input_size, level);
+    buffer.resize(shuffle::HeaderSize + size);
     return buffer;
 }
 
-std::string compress(std::string_view str)
+std::string compress(std::string_view str, int level)
 {
-    return compress(str.data(), str.size());
+    return compress(str.data(), str.size(), level);
 }
 
 template<class InStream, class OutStream>
+requires (not std::is_same_v<std::remove_const_t<OutStream>, shuffle::Options>)
 void compress(InStream& is, OutStream& os) {
     Compressor c{os};
-    auto n = ZSTD_CStreamInSize();
-    auto block = std::make_unique<char[]>(n);
-    auto ptr = block.get();
+    core::BufferedArea block(ZSTD_CStreamInSize());
+    auto ptr = block.begin();
+    auto n = block.capacity();
     while (auto count = InStreamAdapter<InStream>::read(is, ptr, n))
 	c.write(ptr, ptr + count);
 }
@@ -63,7 +93,8 @@ void compress(InStream& is, OutStream& os) {
 #define SINK() (std::ostream,				\
 		std::stringstream,			\
 		core::cc::queue::LockFreeSpSc<char>,	\
-		core::cc::queue::SinkSpSc<char>)
+		core::cc::queue::SinkSpSc<char>,	\
+		core::codec::ChunkSink)
 
 #define PRODUCT() CORE_PP_EVAL_CARTESIAN_PRODUCT_SEQ(SOURCE(), SINK())
 
@@ -0,0 +1,305 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <thread>
+#include "core/codec/zstd/compression_service.h"
+#include "core/codec/zstd/custom_mem.h"
+#include "core/codec/zstd/exception.h"
+#include "core/codec/util/buffer.h"
+#include "core/codec/util/parallel.h"
+
+namespace zstd
+{
+
+using Clock = std::chrono::steady_clock;
+
+// An input and its result. The compressed frame of part `k` is written
+// at `k * stride` of the uninitialized `output`, `stride` being the
+// bound of a part, and the frames are copied into a string of their
+// exact size once the last part is done.
+struct CompressionService::Request {
+    std::string input;
+    int level;
+    Callback done;
+    Clock::time_point start;
+    size_t part_size;
+    size_t stride;
+    core::BufferedArea output{0};
+    std::vector<size_t> sizes;
+    std::atomic<size_t> remaining;
+    std::mutex mutex;
+    std::exception_ptr error;
+};
+
+// A worker thread, its queue, its compression context and the
+// counters of the jobs it ran.
+struct CompressionService::Worker {
+    Worker(CompressionService& service, size_t id, core::Allocator& alloc)
+	: service(service)
+	, id(id)
+	, cctx(ZSTD_createCCtx_advanced(custom_mem(alloc))) {
+	if (cctx == nullptr)
+	    throw zstd::error("failed to create compression context");
+	latencies.reserve(LatencyWindow);
+    }
+
+    ~Worker() {
+	ZSTD_freeCCtx(cctx);
+    }
+
+    CompressionService& service;
+    size_t id;
+    ZSTD_CCtx *cctx;
+    std::thread thread;
+
+    std::mutex mutex;
+    std::deque<Job> jobs;
+
+    std::mutex stats_mutex;
+    ServiceStats stats;
+    std::vector<uint64_t> latencies;
+    size_t latency_next{0};
+};
+
+thread_local CompressionService::Worker *CompressionService::current_{nullptr};
+
+CompressionService::CompressionService(const ServiceOptions& options)
+    : options_(options) {
+    auto& alloc = options_.alloc ? *options_.alloc : core::default_allocator();
+    auto threads = options_.threads > 0 ? options_.threads : core::codec::hardware_threads();
+    for (size_t i = 0; i < threads; ++i)
+	workers_.push_back(std::make_unique<Worker>(*this, i, alloc));
+
+    // The workers steal from each other, so all exist before any starts.
+    for (auto& worker : workers_)
+	worker->thread = std::thread([this, &worker = *worker]() { work(worker); });
+}
+
+CompressionService::~CompressionService() {
+    {
+	std::lock_guard lock(mutex_);
+	stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_)
+	worker->thread.join();
+}
+
+std::future<std::string> CompressionService::compress(std::string input) {
+    return compress(std::move(input), options_.level);
+}
+
+std::future<std::string> CompressionService::compress(std::string input, int level) {
+    auto promise = std::make_shared<std::promise<std::string>>();
+    auto future = promise->get_future();
+    submit(std::move(input), level, [promise](std::string output, std::exception_ptr error) {
+	if (error)
+	    promise->set_exception(error);
+	else
+	    promise->set_value(std::move(output));
+    });
+    return future;
+}
+
+void CompressionService::compress(std::string input, Callback done) {
+    submit(std::move(input), options_.level, std::move(done));
+}
+
+void CompressionService::compress(std::string input, int level, Callback done) {
+    submit(std::move(input), level, std::move(done));
+}
+
+void CompressionService::drain() {
+    std::unique_lock lock(mutex_);
+    drained_.wait(lock, [&]() { return pending_ == 0; });
+}
+
+ServiceStats CompressionService::stats() const {
+    ServiceStats s;
+    s.submitted = submitted_;
+    s.split = split_;
+    s.queue_depth = queued_;
+    s.max_queue_depth = max_queue_depth_;
+
+    std::vector<uint64_t> latencies;
+    for (auto& worker : workers_) {
+	std::lock_guard lock(worker->stats_mutex);
+	s.completed += worker->stats.completed;
+	s.failed += worker->stats.failed;
+	s.jobs += worker->stats.jobs;
+	s.steals += worker->stats.steals;
+	s.bytes_in += worker->stats.bytes_in;
+	s.bytes_out += worker->stats.bytes_out;
+	latencies.insert(latencies.end(), worker->latencies.begin(), worker->latencies.end());
+    }
+
+    if (not latencies.empty()) {
+	auto percentile = [&](size_t p) {
+	    auto k = std::min(latencies.size() - 1, latencies.size() * p / 100);
+	    std::nth_element(latencies.begin(), latencies.begin() + k, latencies.end());
+	    return latencies[k];
+	};
+	s.latency_p50_ns = percentile(50);
+	s.latency_p90_ns = percentile(90);
+	s.latency_p99_ns = percentile(99);
+	s.latency_max_ns = *std::max_element(latencies.begin(), latencies.end());
+    }
+    return s;
+}
+
+void CompressionService::submit(std::string input, int level, Callback done) {
+    auto n = input.size();
+    auto split = options_.split_size > 0 and n > options_.split_size;
+    auto part_size = split ? options_.split_size : n;
+    auto parts = split ? (n + part_size - 1) / part_size : 1;
+
+    auto request = std::make_shared<Request>();
+    request->input = std::move(input);
+    request->level = level;
+    request->done = std::move(done);
+    request->start = Clock::now();
+    request->part_size = part_size;
+    request->stride = ZSTD_compressBound(part_size);
+    request->output = core::BufferedArea(parts * request->stride);
+    request->sizes.resize(parts);
+    request->remaining = parts;
+
+    ++submitted_;
+    if (split)
+	++split_;
+    ++pending_;
+
+    // An input submitted by a callback stays on the queue of its worker,
+    // the others are spread over the workers in turn.
+    auto& worker = current_ and &current_->service == this
+	? *current_ : *workers_[next_++ % workers_.size()];
+    for (size_t k = 0; k < parts; ++k)
+	push(worker, {request, k});
+}
+
+void CompressionService::push(Worker& worker, Job job) {
+    {
+	// The job is counted before it can be taken, so that `queued_`
+	// never goes below zero.
+	std::lock_guard lock(worker.mutex);
+	worker.jobs.push_back(std::move(job));
+	auto depth = ++queued_;
+	auto most = max_queue_depth_.load(std::memory_order_relaxed);
+	while (depth > most and not max_queue_depth_.compare_exchange_weak(most, depth));
+    }
+
+    // A worker about to sleep either sees the job queued or is woken.
+    if (sleeping_ > 0) {
+	{
+	    std::lock_guard lock(mutex_);
+	}
+	cv_.notify_one();
+    }
+}
+
+bool CompressionService::pop(Worker& worker, Job& job) {
+    std::lock_guard lock(worker.mutex);
+    if (worker.jobs.empty())
+	return false;
+    job = std::move(worker.jobs.back());
+    worker.jobs.pop_back();
+    --queued_;
+    return true;
+}
+
+bool CompressionService::steal(Worker& worker, Job& job) {
+    auto n = workers_.size();
+    for (size_t i = 1; i < n; ++i) {
+	auto& victim = *workers_[(worker.id + i) % n];
+	std::lock_guard lock(victim.mutex);
+	if (victim.jobs.empty())
+	    continue;
+	job = std::move(victim.jobs.front());
+	victim.jobs.pop_front();
+	--queued_;
+	std::lock_guard stats_lock(worker.stats_mutex);
+	++worker.stats.steals;
+	return true;
+    }
+    return false;
+}
+
+void CompressionService::run(Worker& worker, Job& job) {
+    auto& request = *job.request;
+    try {
+	auto begin = job.part * request.part_size;
+	auto count = std::min(request.part_size, request.input.size() - begin);
+	auto size = ZSTD_compressCCtx(worker.cctx, request.output.begin() + job.part * request.stride,
+				      request.stride, request.input.data() + begin, count, request.level);
+	if (ZSTD_isError(size))
+	    throw zstd::error("%s", ZSTD_getErrorName(size));
+	request.sizes[job.part] = size;
+    } catch (...) {
+	std::lock_guard lock(request.mutex);
+	if (not request.error)
+	    request.error = std::current_exception();
+    }
+
+    {
+	std::lock_guard lock(worker.stats_mutex);
+	++worker.stats.jobs;
+    }
+    if (--request.remaining == 0)
+	finish(worker, request);
+}
+
+void CompressionService::finish(Worker& worker, Request& request) {
+    std::string output;
+    if (not request.error) {
+	size_t size{0};
+	for (auto n : request.sizes)
+	    size += n;
+	output.reserve(size);
+	for (size_t k = 0; k < request.sizes.size(); ++k)
+	    output.append(request.output.begin() + k * request.stride, request.sizes[k]);
+    }
+    request.output = core::BufferedArea{0};
+
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - request.start).count();
+    {
+	std::lock_guard lock(worker.stats_mutex);
+	++worker.stats.completed;
+	if (request.error)
+	    ++worker.stats.failed;
+	worker.stats.bytes_in += request.input.size();
+	worker.stats.bytes_out += output.size();
+	if (worker.latencies.size() < LatencyWindow)
+	    worker.latencies.push_back(ns);
+	else
+	    worker.latencies[worker.latency_next++ % LatencyWindow] = ns;
+    }
+
+    request.done(std::move(output), request.error);
+    if (--pending_ == 0) {
+	std::lock_guard lock(mutex_);
+	drained_.notify_all();
+    }
+}
+
+void CompressionService::work(Worker& worker) {
+    current_ = &worker;
+    while (true) {
+	Job job;
+	if (pop(worker, job) or steal(worker, job)) {
+	    run(worker, job);
+	    continue;
+	}
+
+	std::unique_lock lock(mutex_);
+	++sleeping_;
+	cv_.wait(lock, [&]() { return stop_ or queued_ > 0; });
+	--sleeping_;
+	if (stop_ and queued_ == 0)
+	    return;
+    }
+}
+
+}; // zstd
@@ -1,22 +1,37 @@
 // Copyright (C) 2021, 2022 by Mark Melton
 //
 
+#include <chrono>
 #include <sstream>
 #include <fstream>
 #include "core/codec/zstd/compressor.h"
 #include "core/codec/zstd/adapter.h"
+#include "core/codec/zstd/custom_mem.h"
 #include "core/cc/queue/lockfree_spsc.h"
 #include "core/cc/queue/sink_spsc.h"
 #include "core/cc/queue/source_spsc.h"
+#include "core/codec/util/byte_io.h"
+#include "core/codec/util/chunk_sink.h"
 
 namespace zstd
 {
 
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t elapsed_ns(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+}; // anonymous
+
 template<class Sink>
-Compressor<Sink>::Compressor(std::add_rvalue_reference_t<Sink> os, size_t n)
+Compressor<Sink>::Compressor(std::add_rvalue_reference_t<Sink> os, size_t n,
+			     core::Allocator *alloc)
     : os_(std::forward<Sink>(os))
-    , zsc_(ZSTD_createCStream())
-    , get_(n > 0 ? n : ZSTD_CStreamOutSize())
+    , zsc_(ZSTD_createCStream_advanced(custom_mem(alloc ? *alloc : core::default_allocator())))
+    , get_(n > 0 ? n : ZSTD_CStreamOutSize(), alloc)
 { }
 
 template<class Sink>
@@ -25,7 +40,10 @@ Compressor<Sink>::Compressor(Compressor&& other)
     , zsc_(std::exchange(other.zsc_, nullptr))
     , put_(std::move(other.put_))
     , get_(std::move(other.get_))
-    , count_(other.count_) {
+    , count_(other.count_)
+    , adapter_(std::move(other.adapter_))
+    , frame_in_(other.frame_in_)
+    , stats_(other.stats_) {
 }
 
 template<class Sink>
@@ -34,41 +52,149 @@ Compressor<Sink>::~Compressor() {
 	close();
 }
 
+template<class Sink>
+void Compressor<Sink>::set_level(int level) {
+    if (zsc_ == nullptr)
+	throw zstd::error("attempt to set level of closed stream");
+    auto r = ZSTD_CCtx_setParameter(zsc_, ZSTD_c_compressionLevel, level);
+    if (ZSTD_isError(r))
+	throw zstd::error("set_level: %s", ZSTD_getErrorName(r));
+    stats_.level(level, false);
+}
+
+template<class Sink>
+void Compressor<Sink>::set_adaptive(const AdaptOptions& options) {
+    if (zsc_ == nullptr)
+	throw zstd::error("attempt to set adaptive level of closed stream");
+    if (count_ > 0 or frame_in_ > 0)
+	throw zstd::error("set_adaptive: must be called before the first write");
+
+    int level{0};
+    auto r = ZSTD_CCtx_getParameter(zsc_, ZSTD_c_compressionLevel, &level);
+    if (ZSTD_isError(r))
+	throw zstd::error("set_adaptive: %s", ZSTD_getErrorName(r));
+    adapter_ = std::make_unique<LevelAdapter>(options, level);
+    set_level(adapter_->level());
+}
+
 template<class Sink>
 void Compressor<Sink>::write(const char *begin, const char *end) {
     if (zsc_ == nullptr)
 	throw zstd::error("attempt to write to closed stream");
 
+    stats_.add_in(end - begin);
+    if (not adapter_) {
+	compress(begin, end);
+	return;
+    }
+
+    while (begin < end) {
+	auto n = std::min<size_t>(end - begin, adapter_->options().frame_size - frame_in_);
+	compress(begin, begin + n);
+	begin += n;
+	if (frame_in_ == adapter_->options().frame_size)
+	    end_frame();
+    }
+}
+
+template<class Sink>
+void Compressor<Sink>::compress(const char *begin, const char *end) {
     put().update(begin, end);
+    frame_in_ += end - begin;
+    stats_.add_frame_bytes(end - begin);
 
     while (not put().empty()) {
-	auto r = ZSTD_compressStream(zsc_, get().buffer(), put().buffer());
+	size_t r;
+	{
+	    auto timer = stats_.time_codec();
+	    auto start = adapter_ ? Clock::now() : Clock::time_point{};
+	    r = ZSTD_compressStream(zsc_, get().buffer(), put().buffer());
+	    if (adapter_)
+		adapter_->add_codec_time(elapsed_ns(start));
+	}
 	if (ZSTD_isError(r))
 	    throw zstd::error("write: ", ZSTD_getErrorName(r));
 	get().update();
-	OutStreamAdapter<Sink>::write(os_, get().data(), get().size());
-	count_ += get().size();
-	get().clear();
+	flush();
     }
     put().clear();
+    stats_.memory([&]() { return ZSTD_sizeof_CStream(zsc_) + get().capacity(); });
+}
+
+template<class Sink>
+void Compressor<Sink>::end_frame() {
+    ZSTD_inBuffer empty{nullptr, 0, 0};
+    while (true) {
+	size_t r;
+	{
+	    auto timer = stats_.time_codec();
+	    auto start = Clock::now();
+	    r = ZSTD_compressStream2(zsc_, get().buffer(), &empty, ZSTD_e_end);
+	    adapter_->add_codec_time(elapsed_ns(start));
+	}
+	if (ZSTD_isError(r))
+	    throw zstd::error("end_frame: %s", ZSTD_getErrorName(r));
+	get().update();
+	flush();
+	if (r == 0)
+	    break;
+    }
+    frame_in_ = 0;
+    stats_.end_frame();
+
+    // The level set between frames applies to the whole next frame.
+    auto level = adapter_->level();
+    if (adapter_->end_frame() != level) {
+	auto r = ZSTD_CCtx_setParameter(zsc_, ZSTD_c_compressionLevel, adapter_->level());
+	if (ZSTD_isError(r))
+	    throw zstd::error("end_frame: %s", ZSTD_getErrorName(r));
+	stats_.level(adapter_->level(), true);
+    }
+}
+
+template<class Sink>
+void Compressor<Sink>::flush() {
+    if (get().size() > 0) {
+	auto timer = stats_.time_sink(QueuePush<Sink>);
+	auto start = adapter_ ? Clock::now() : Clock::time_point{};
+	OutStreamAdapter<Sink>::write(os_, get().data(), get().size());
+	if (adapter_)
+	    adapter_->add_sink_time(elapsed_ns(start));
+    }
+    count_ += get().size();
+    stats_.add_out(get().size());
+    get().clear();
 }
 
 template<class Sink>
 void Compressor<Sink>::close() {
     if (zsc_ == nullptr)
 	throw zstd::error("attempt to close already closed stream");
-    
-    while (true) {
-	auto r = ZSTD_endStream(zsc_, get().buffer());
+
+    // Avoid appending an empty frame when the data ended exactly on a
+    // frame boundary.
+    auto ended = adapter_ and adapter_->frames() > 0 and frame_in_ == 0;
+    while (not ended) {
+	size_t r;
+	{
+	    auto timer = stats_.time_codec();
+	    r = ZSTD_endStream(zsc_, get().buffer());
+	}
 	if (ZSTD_isError(r))
 	    throw zstd::error("close: %s", ZSTD_getErrorName(r));
 	get().update();
-	OutStreamAdapter<Sink>::write(os_, get().data(), get().size());
-	get().clear();
+	flush();
 	if (r <= 0)
 	    break;
     }
-    OutStreamAdapter<Sink>::finish(os_);
+    if (not ended) {
+	stats_.memory([&]() { return ZSTD_sizeof_CStream(zsc_) + get().capacity(); });
+	stats_.end_frame();
+    }
+    {
+	auto timer = stats_.time_sink(QueuePush<Sink>);
+	OutStreamAdapter<Sink>::finish(os_);
+    }
     ZSTD_freeCStream(zsc_);
     zsc_ = nullptr;
 }
@@ -78,6 +204,8 @@ template class Compressor<std::ofstream&>;
 template class Compressor<std::stringstream&>;
 template class Compressor<core::cc::queue::LockFreeSpSc<char>&>;
 template class Compressor<core::cc::queue::SinkSpSc<char>&>;
+template class Compressor<core::codec::ByteSink&>;
+template class Compressor<core::codec::ChunkSink&>;
 
 template class Compressor<std::ofstream>;
 
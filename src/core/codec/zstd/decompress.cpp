@@ -2,12 +2,15 @@
 //
 
 #define ZSTD_STATIC_LINKING_ONLY
+#include <memory>
 #include <sstream>
 #include <zstd.h>
 #include "core/codec/zstd/decompress.h"
 #include "core/codec/zstd/decompressor.h"
 #include "core/codec/zstd/adapter.h"
+#include "core/codec/zstd/custom_mem.h"
 #include "core/codec/zstd/exception.h"
+#include "core/codec/util/chunk_sink.h"
 #include "core/cc/queue/lockfree_spsc.h"
 #include "core/cc/queue/source_spsc.h"
 #include "core/cc/queue/sink_spsc.h"
@@ -18,6 +21,38 @@
 namespace zstd
 {
 
+void decompress(const char *input_buffer, size_t input_size, core::codec::ChunkSink& sink)
+{
+    auto free_dctx = [](ZSTD_DCtx *dctx) { ZSTD_freeDCtx(dctx); };
+    std::unique_ptr<ZSTD_DCtx, decltype(free_dctx)> dctx
+	{ZSTD_createDCtx_advanced(custom_mem(core::default_allocator())), free_dctx};
+
+    // Decompress straight into the blocks of the sink, continuing
+    // while there is input or the last call filled its output within
+    // a frame.
+    ZSTD_inBuffer in{input_buffer, input_size, 0};
+    size_t r{0};
+    bool full{false};
+    while (in.pos < in.size or full) {
+	auto area = sink.prepare();
+	ZSTD_outBuffer out{area.data(), area.size(), 0};
+	r = ZSTD_decompressStream(dctx.get(), &out, &in);
+	if (ZSTD_isError(r))
+	    throw zstd::error("decompress: %s", ZSTD_getErrorName(r));
+	sink.commit(out.pos);
+	full = r != 0 and out.pos == out.size;
+    }
+    if (r != 0)
+	throw zstd::error("decompress: truncated input");
+}
+
+core::codec::ChunkSink decompress_chunks(std::string_view str)
+{
+    core::codec::ChunkSink sink;
+    decompress(str.data(), str.size(), sink);
+    return sink;
+}
+
 std::string decompress(const char *input_buffer, size_t input_size)
 {
     auto final_size = ZSTD_findDecompressedSize(input_buffer, input_size);
@@ -27,17 +62,17 @@ std::string decompress(const char *input_buffer, size_t input_size)
     
     if (final_size == ZSTD_CONTENTSIZE_UNKNOWN)
     {
-	std::string str{input_buffer, input_size};
-	std::stringstream ss{str};
-	core::cc::queue::SinkSpSc<char> sink;
-	decompress((std::istream&)ss, sink);
-	return sink.data();
+	core::codec::ChunkSink sink;
+	decompress(input_buffer, input_size, sink);
+	return sink.take();
     }
 
     std::string buffer;
     buffer.resize(final_size);
     
-    auto size = ZSTD_decompress(buffer.data(), buffer.size(), input_buffer, input_size);
+    auto dctx = ZSTD_createDCtx_advanced(custom_mem(core::default_allocator()));
+    auto size = ZSTD_decompressDCtx(dctx, buffer.data(), buffer.size(), input_buffer, input_size);
+    ZSTD_freeDCtx(dctx);
     if (size != final_size)
 	throw zstd::error("ZSTD_decompress: {}", ZSTD_getErrorName(size));
     
@@ -70,7 +105,8 @@ void decompress(InStream& is, OutStream&os) {
 
 #define SINK() (std::ostream,				\
 		std::stringstream,			\
-		core::cc::queue::SinkSpSc<char>)
+		core::cc::queue::SinkSpSc<char>,	\
+		core::codec::ChunkSink)
 
 #define PRODUCT() CORE_PP_EVAL_CARTESIAN_PRODUCT_SEQ(SOURCE(), SINK())
 
@@ -6,19 +6,23 @@
 #include <zstd.h>
 #include "core/codec/zstd/decompressor.h"
 #include "core/codec/zstd/adapter.h"
+#include "core/codec/zstd/custom_mem.h"
 #include "core/codec/zstd/exception.h"
 #include "core/cc/queue/lockfree_spsc.h"
 #include "core/cc/queue/source_spsc.h"
+#include "core/codec/util/byte_io.h"
+#include "core/codec/util/peek_source.h"
 
 namespace zstd
 {
 
 template<class Source>
-Decompressor<Source>::Decompressor(std::add_rvalue_reference_t<Source> is, size_t n)
+Decompressor<Source>::Decompressor(std::add_rvalue_reference_t<Source> is, size_t n,
+				   core::Allocator *alloc)
     : is_(std::forward<Source>(is))
-    , zsd_(ZSTD_createDStream())
-    , put_(n > 0 ? n : ZSTD_DStreamInSize())
-    , get_(n > 0 ? n : ZSTD_DStreamOutSize())
+    , zsd_(ZSTD_createDStream_advanced(custom_mem(alloc ? *alloc : core::default_allocator())))
+    , put_(n > 0 ? n : ZSTD_DStreamInSize(), alloc)
+    , get_(n > 0 ? n : ZSTD_DStreamOutSize(), alloc)
 { }
 
 template<class Source>
@@ -32,7 +36,8 @@ Decompressor<Source>::Decompressor(Decompressor&& other)
     : is_(std::forward<Source>(other.is_))
     , zsd_(std::exchange(other.zsd_, nullptr))
     , put_(std::move(other.put_))
-    , get_(std::move(other.get_)) {
+    , get_(std::move(other.get_))
+    , stats_(other.stats_) {
 }
 
 template<class Source>
@@ -40,7 +45,8 @@ Decompressor<Source>::Decompressor(Decompressor&& other, Source& is)
     : is_(std::forward<Source>(is))
     , zsd_(std::exchange(other.zsd_, nullptr))
     , put_(std::move(other.put_))
-    , get_(std::move(other.get_)) {
+    , get_(std::move(other.get_))
+    , stats_(other.stats_) {
 }
 
 template<class Source>
@@ -88,29 +94,62 @@ bool Decompressor<Source>::underflow() {
 	throw zstd::error("attempt to read from closed stream");
 
     while (true) {
-	if (put().empty()) {
-	    auto count = InStreamAdapter<Source>::read(is_, put().begin(), put().capacity());
-	    put().update(0, count);
-
-	    if (count == 0) {
-		close();
-		return false;
+	if (needs_input()) {
+	    size_t count;
+	    {
+		auto timer = stats_.time_source(QueuePop<Source>);
+		count = InStreamAdapter<Source>::read(is_, put().begin(), put().capacity());
 	    }
+	    if (not supply(count))
+		return false;
 	}
 
-	get().clear();
-						   
-	auto r = ZSTD_decompressStream(zsd_, get().buffer(), put().buffer());
-	if (ZSTD_isError(r))
-	    throw zstd::error("read: %s", ZSTD_getErrorName(r));
-						   
-	get().update();
-
-	if (get().available())
+	if (decompress())
 	    return true;
     }
 }
 
+template<class Source>
+bool Decompressor<Source>::supply(size_t count) {
+    if (zsd_ == nullptr)
+	throw zstd::error("attempt to read from closed stream");
+
+    put().update(0, count);
+    stats_.add_in(count);
+    if (count == 0) {
+	close();
+	return false;
+    }
+    return true;
+}
+
+template<class Source>
+bool Decompressor<Source>::decompress() {
+    if (zsd_ == nullptr)
+	throw zstd::error("attempt to read from closed stream");
+
+    get().clear();
+						   
+    size_t r;
+    {
+	auto timer = stats_.time_codec();
+	r = ZSTD_decompressStream(zsd_, get().buffer(), put().buffer());
+    }
+    if (ZSTD_isError(r))
+	throw zstd::error("read: %s", ZSTD_getErrorName(r));
+						   
+    get().update();
+    stats_.add_out(get().size());
+    stats_.add_frame_bytes(get().size());
+    stats_.memory([&]() {
+	return ZSTD_sizeof_DStream(zsd_) + put().capacity() + get().capacity();
+    });
+    if (r == 0)
+	stats_.end_frame();
+
+    return get().available();
+}
+
 template<class Source>
 void Decompressor<Source>::close() {
     if (zsd_ == nullptr)
@@ -124,8 +163,15 @@ template class Decompressor<std::ifstream&>;
 template class Decompressor<std::stringstream&>;
 template class Decompressor<core::cc::queue::LockFreeSpSc<char>&>;
 template class Decompressor<core::cc::queue::SourceSpSc<char>&>;
+template class Decompressor<core::PeekSource&>;
+template class Decompressor<core::codec::ByteSource&>;
 
 template class Decompressor<std::ifstream>;
+template class Decompressor<NoSource>;
+
+size_t NoSource::read_bytes(char*, size_t) {
+    throw zstd::error("attempt to read from a decompressor without a source");
+}
 
 }; // zstd
 
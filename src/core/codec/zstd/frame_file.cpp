@@ -0,0 +1,349 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utility>
+#include "core/codec/zstd/frame_file.h"
+#include "core/codec/zstd/custom_mem.h"
+#include "core/codec/zstd/exception.h"
+#include "core/codec/util/parallel.h"
+
+namespace zstd
+{
+
+namespace {
+
+// The decompression context and compressed frame buffer of the
+// calling thread, reused across frames.
+struct Context {
+    Context()
+	: dctx(ZSTD_createDCtx_advanced(custom_mem(core::default_allocator()))) {
+    }
+
+    ~Context() {
+	ZSTD_freeDCtx(dctx);
+    }
+
+    ZSTD_DCtx *dctx;
+    std::string frame;
+};
+
+// The bytes of a block header: the last block flag, the block type
+// and the block size.
+constexpr size_t BlockHeaderSize = 3;
+
+Context& context() {
+    static thread_local Context ctx;
+    return ctx;
+}
+
+uint32_t load_le32(const char *p) {
+    auto u = (const unsigned char*)p;
+    return u[0] | (u[1] << 8) | (u[2] << 16) | (uint32_t(u[3]) << 24);
+}
+
+// Read the `n` bytes at `offset` of the file `fd` into `out` or throw
+// zstd::error.
+void read_at(int fd, const std::string& path, uint64_t offset, char *out, size_t n) {
+    while (n > 0) {
+	auto count = ::pread(fd, out, n, offset);
+	if (count <= 0)
+	    throw zstd::error("%s: read error at %d", path, offset);
+	out += count;
+	offset += count;
+	n -= count;
+    }
+}
+
+// Return the frames of the file of `file_size` bytes at `path` by
+// walking the frame and block headers read by `read(offset, out, n)`.
+template<class Read>
+std::vector<FrameInfo> walk_frames(const std::string& path, uint64_t file_size, Read&& read) {
+    std::vector<FrameInfo> frames;
+    char header[ZSTD_FRAMEHEADERSIZE_MAX];
+    uint64_t offset{0};
+    while (offset < file_size) {
+	auto n = std::min<uint64_t>(sizeof(header), file_size - offset);
+	read(offset, header, n);
+	if (n < 8)
+	    throw zstd::error("%s: truncated frame at %d", path, offset);
+
+	// Skip skippable frames, e.g. seek tables.
+	auto magic = load_le32(header);
+	if ((magic & ZSTD_MAGIC_SKIPPABLE_MASK) == ZSTD_MAGIC_SKIPPABLE_START) {
+	    offset += ZSTD_SKIPPABLEHEADERSIZE + load_le32(header + 4);
+	    continue;
+	}
+
+	ZSTD_frameHeader fh;
+	if (ZSTD_getFrameHeader(&fh, header, n) != 0)
+	    throw zstd::error("%s: not a zstd frame at %d", path, offset);
+
+	// Walk the block headers to the end of the frame.
+	auto end = offset + fh.headerSize;
+	while (true) {
+	    char block[BlockHeaderSize];
+	    if (end + sizeof(block) > file_size)
+		throw zstd::error("%s: truncated frame at %d", path, offset);
+	    read(end, block, sizeof(block));
+	    auto bits = uint32_t((unsigned char)block[0]) | (uint32_t((unsigned char)block[1]) << 8)
+		| (uint32_t((unsigned char)block[2]) << 16);
+	    auto type = (bits >> 1) & 3;
+	    if (type == 3)
+		throw zstd::error("%s: corrupt block at %d", path, end);
+	    end += sizeof(block) + (type == 1 ? 1 : bits >> 3);
+	    if (bits & 1)
+		break;
+	}
+	if (fh.checksumFlag)
+	    end += 4;
+	if (end > file_size)
+	    throw zstd::error("%s: truncated frame at %d", path, offset);
+
+	auto size = fh.frameContentSize == ZSTD_CONTENTSIZE_UNKNOWN ? FrameInfo::UnknownSize : fh.frameContentSize;
+	frames.push_back({offset, end - offset, 0, size});
+	offset = end;
+    }
+    return frames;
+}
+
+// Set the decompressed sizes of `frames` from `layout`, its non-empty
+// frames in order, taking a frame of unknown size missing from the
+// layout but within the bytes it spans as empty. Return false, leaving
+// `frames` unchanged, if the layout does not describe the frames, e.g.
+// if frames were appended to the file after the layout was recorded.
+bool apply_layout(std::vector<FrameInfo>& frames, const std::vector<FrameInfo>& layout) {
+    auto end = layout.back().offset + layout.back().size;
+    std::vector<uint64_t> sizes(frames.size());
+    uint64_t position{0};
+    size_t j{0};
+    for (size_t k = 0; k < frames.size(); ++k) {
+	const auto& info = frames[k];
+	if (info.offset >= end and not (j < layout.size() and layout[j].offset == info.offset))
+	    return false;
+	uint64_t size{0};
+	if (j < layout.size() and layout[j].offset == info.offset) {
+	    if (layout[j].position != position)
+		return false;
+	    size = layout[j++].content_size;
+	}
+	if (info.content_size != FrameInfo::UnknownSize and info.content_size != size)
+	    return false;
+	sizes[k] = size;
+	position += size;
+    }
+    if (j != layout.size())
+	return false;
+    for (size_t k = 0; k < frames.size(); ++k)
+	frames[k].content_size = sizes[k];
+    return true;
+}
+
+}; // anonymous
+
+FrameFile::FrameFile(const std::string& path, core::codec::BlockCache& cache)
+    : FrameFile(path, {}, cache) {
+}
+
+FrameFile::FrameFile(const std::string& path, const std::vector<FrameInfo>& layout,
+		     core::codec::BlockCache& cache)
+    : path_(path)
+    , cache_(&cache)
+    , fd_(::open(path.c_str(), O_RDONLY))
+{
+    if (fd_ < 0)
+	throw zstd::error("FrameFile: cannot open %s", path);
+    try {
+	id_ = core::codec::BlockCache::file_id(path);
+	file_size_ = ::lseek(fd_, 0, SEEK_END);
+	index(layout);
+    } catch (...) {
+	::close(fd_);
+	throw;
+    }
+}
+
+FrameFile::~FrameFile() {
+    if (fd_ >= 0)
+	::close(fd_);
+}
+
+FrameFile::FrameFile(FrameFile&& other)
+    : path_(std::move(other.path_))
+    , cache_(other.cache_)
+    , fd_(std::exchange(other.fd_, -1))
+    , id_(other.id_)
+    , file_size_(other.file_size_)
+    , size_(other.size_)
+    , frames_(std::move(other.frames_)) {
+}
+
+size_t FrameFile::frame_at(uint64_t position) const {
+    auto iter = std::upper_bound(frames_.begin(), frames_.end(), position,
+				 [](uint64_t p, const FrameInfo& f) { return p < f.position; });
+    if (iter == frames_.begin())
+	return frames_.size();
+    auto k = size_t(iter - frames_.begin()) - 1;
+    return position < frames_[k].position + frames_[k].content_size ? k : frames_.size();
+}
+
+FrameFile::Block FrameFile::frame(size_t k) const {
+    return cache_->get({id_, frames_[k].offset}, [&]() { return decompress(k); });
+}
+
+size_t FrameFile::read(uint64_t position, char *out, size_t n) const {
+    size_t count{0};
+    for (auto k = frame_at(position); count < n and k < frames_.size(); ++k) {
+	const auto& info = frames_[k];
+	if (info.content_size == 0)
+	    continue;
+	auto block = frame(k);
+	auto begin = position + count - info.position;
+	auto m = std::min<uint64_t>(n - count, info.content_size - begin);
+	memcpy(out + count, block->data() + begin, m);
+	count += m;
+    }
+    return count;
+}
+
+std::string FrameFile::read(uint64_t position, size_t n) const {
+    std::string bytes(std::min<uint64_t>(n, position < size_ ? size_ - position : 0), '\0');
+    bytes.resize(read(position, bytes.data(), bytes.size()));
+    return bytes;
+}
+
+std::string FrameFile::decompress(size_t k) const {
+    const auto& info = frames_[k];
+    auto& frame = context().frame;
+    frame.resize(info.size);
+    pread(info.offset, frame.data(), info.size);
+    return decompress_frame(frame, info.content_size);
+}
+
+void FrameFile::pread(uint64_t offset, char *out, size_t n) const {
+    read_at(fd_, path_, offset, out, n);
+}
+
+void FrameFile::index(const std::vector<FrameInfo>& layout) {
+    frames_ = walk_frames(path_, file_size_, [&](uint64_t offset, char *out, size_t n) {
+	pread(offset, out, n);
+    });
+
+    // Decompress the frames whose header does not record their size,
+    // keeping them in the cache for the first reads, unless the layout
+    // supplies their sizes.
+    if (layout.empty() or not apply_layout(frames_, layout))
+	core::codec::parallel_for(frames_.size(), 0, [&](size_t k) {
+	    if (frames_[k].content_size == FrameInfo::UnknownSize)
+		frames_[k].content_size = frame(k)->size();
+	});
+    for (auto& info : frames_) {
+	info.position = size_;
+	size_ += info.content_size;
+    }
+}
+
+std::vector<FrameInfo> scan_frames(const std::string& path) {
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+	throw zstd::error("scan_frames: cannot open %s", path);
+    try {
+	auto frames = walk_frames(path, ::lseek(fd, 0, SEEK_END), [&](uint64_t offset, char *out, size_t n) {
+	    read_at(fd, path, offset, out, n);
+	});
+	::close(fd);
+	return frames;
+    } catch (...) {
+	::close(fd);
+	throw;
+    }
+}
+
+std::string decompress_frame(std::string_view frame, uint64_t content_size) {
+    auto& ctx = context();
+    if (content_size != FrameInfo::UnknownSize) {
+	std::string data(content_size, '\0');
+	auto size = ZSTD_decompressDCtx(ctx.dctx, data.data(), data.size(), frame.data(), frame.size());
+	if (ZSTD_isError(size))
+	    throw zstd::error("decompress_frame: %s", ZSTD_getErrorName(size));
+	if (size != data.size())
+	    throw zstd::error("decompress_frame: %d bytes instead of %d", size, data.size());
+	return data;
+    }
+
+    std::string data;
+    ZSTD_inBuffer in{frame.data(), frame.size(), 0};
+    ZSTD_DCtx_reset(ctx.dctx, ZSTD_reset_session_only);
+    while (true) {
+	auto have = data.size();
+	data.resize(have + ZSTD_DStreamOutSize());
+	ZSTD_outBuffer out{data.data(), data.size(), have};
+	auto r = ZSTD_decompressStream(ctx.dctx, &out, &in);
+	if (ZSTD_isError(r))
+	    throw zstd::error("decompress_frame: %s", ZSTD_getErrorName(r));
+	data.resize(out.pos);
+	if (r == 0)
+	    return data;
+	if (in.pos == in.size and out.pos < out.size)
+	    throw zstd::error("decompress_frame: truncated frame");
+    }
+}
+
+FrameReader::FrameReader(const FrameFile& file, uint64_t position)
+    : file_(&file)
+    , position_(position) {
+}
+
+void FrameReader::seek(uint64_t position) {
+    block_.reset();
+    pos_ = end_ = nullptr;
+    position_ = position;
+}
+
+bool FrameReader::read_line(std::string& line) {
+    line.clear();
+    bool found{false};
+    while (pos_ < end_ or underflow()) {
+	found = true;
+	auto nl = (const char*)memchr(pos_, '\n', end_ - pos_);
+	if (nl) {
+	    line.append(pos_, nl);
+	    pos_ = nl + 1;
+	    return true;
+	}
+	line.append(pos_, end_);
+	pos_ = end_;
+    }
+    return found;
+}
+
+size_t FrameReader::read_bytes(char *buffer, size_t count) {
+    size_t n{0};
+    while (n < count and (pos_ < end_ or underflow())) {
+	auto m = std::min<size_t>(count - n, end_ - pos_);
+	memcpy(buffer + n, pos_, m);
+	pos_ += m;
+	n += m;
+    }
+    return n;
+}
+
+bool FrameReader::underflow() {
+    auto k = file_->frame_at(position_);
+    if (k == file_->frames()) {
+	block_.reset();
+	pos_ = end_ = nullptr;
+	return false;
+    }
+    const auto& info = file_->frame_info(k);
+    block_ = file_->frame(k);
+    pos_ = block_->data() + (position_ - info.position);
+    end_ = block_->data() + block_->size();
+    position_ = info.position + info.content_size;
+    return true;
+}
+
+}; // zstd
@@ -5,8 +5,8 @@
 
 namespace zstd {
 
-GetArea::GetArea(size_t capacity)
-    : core::GetArea(capacity) {
+GetArea::GetArea(size_t capacity, core::Allocator *alloc)
+    : core::GetArea(capacity, alloc) {
     buffer_.dst = begin();
     clear();
 }
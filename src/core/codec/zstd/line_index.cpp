@@ -0,0 +1,290 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include "core/codec/zstd/line_index.h"
+#include "core/codec/zstd/exception.h"
+#include "core/codec/util/parallel.h"
+
+namespace zstd
+{
+
+namespace {
+
+// The index is a zstd skippable frame (magic number and payload size)
+// whose payload is the checkpoints followed by a footer, so an index
+// at the end of a file is found from its last bytes.
+constexpr uint32_t SkippableMagic = 0x184d2a5b;
+constexpr char Tag[4] = { 'L', 'I', 'D', 'X' };
+constexpr uint32_t Version = 1;
+constexpr size_t CheckpointSize = 24;
+
+// The footer: the number of lines, the decompressed size and the
+// compressed size of the indexed frames; the number of checkpoints,
+// the version and the tag.
+constexpr size_t FooterSize = 36;
+
+void put32(char *out, uint32_t value) {
+    for (int i = 0; i < 4; ++i)
+	out[i] = char(value >> (8 * i));
+}
+
+void put64(char *out, uint64_t value) {
+    for (int i = 0; i < 8; ++i)
+	out[i] = char(value >> (8 * i));
+}
+
+uint32_t get32(const char *in) {
+    uint32_t value{0};
+    for (int i = 0; i < 4; ++i)
+	value |= uint32_t((unsigned char)in[i]) << (8 * i);
+    return value;
+}
+
+uint64_t get64(const char *in) {
+    uint64_t value{0};
+    for (int i = 0; i < 8; ++i)
+	value |= uint64_t((unsigned char)in[i]) << (8 * i);
+    return value;
+}
+
+// Return the bytes of the frame holding `count` checkpoints.
+uint64_t frame_size(uint64_t count) {
+    return 8 + count * CheckpointSize + FooterSize;
+}
+
+// Return the compressed size of the frames of `file`.
+uint64_t data_size(const FrameFile& file) {
+    if (file.frames() == 0)
+	return 0;
+    const auto& last = file.frame_info(file.frames() - 1);
+    return last.offset + last.size;
+}
+
+}; // anonymous
+
+LineIndex LineIndex::build(const FrameFile& file, size_t threads) {
+    std::vector<size_t> frames;
+    for (size_t k = 0; k < file.frames(); ++k)
+	if (file.frame_info(k).content_size > 0)
+	    frames.push_back(k);
+
+    std::vector<uint64_t> newlines(frames.size());
+    char last{'\n'};
+    core::codec::parallel_for(frames.size(), threads, [&](size_t j) {
+	auto data = file.decompress(frames[j]);
+	newlines[j] = std::count(data.begin(), data.end(), '\n');
+	if (j + 1 == frames.size())
+	    last = data.back();
+    });
+
+    LineIndex index;
+    uint64_t line{0};
+    for (size_t j = 0; j < frames.size(); ++j) {
+	const auto& info = file.frame_info(frames[j]);
+	index.checkpoints_.push_back({info.offset, info.position, line});
+	line += newlines[j];
+    }
+    index.lines_ = line + (last != '\n');
+    index.size_ = file.size();
+    index.data_size_ = data_size(file);
+    return index;
+}
+
+LineIndex LineIndex::open(const FrameFile& file, size_t threads) {
+    if (auto index = read_trailer(file.path()); index and index->matches(file))
+	return std::move(*index);
+    if (auto index = load(sidecar(file.path())); index and index->matches(file))
+	return std::move(*index);
+    return build(file, threads);
+}
+
+std::optional<LineIndex> LineIndex::stored(const std::string& path) {
+    if (auto index = read_trailer(path))
+	return index;
+    return load(sidecar(path));
+}
+
+std::vector<FrameInfo> LineIndex::layout() const {
+    std::vector<FrameInfo> frames;
+    for (size_t j = 0; j < checkpoints_.size(); ++j) {
+	const auto& cp = checkpoints_[j];
+	const auto *next = j + 1 < checkpoints_.size() ? &checkpoints_[j + 1] : nullptr;
+	auto end = next ? next->offset : data_size_;
+	auto position = next ? next->position : size_;
+	frames.push_back({cp.offset, end - cp.offset, cp.position, position - cp.position});
+    }
+    return frames;
+}
+
+std::string LineIndex::serialize() const {
+    std::string bytes(frame_size(checkpoints_.size()), '\0');
+    auto out = bytes.data();
+    put32(out, SkippableMagic);
+    put32(out + 4, uint32_t(bytes.size() - 8));
+    out += 8;
+    for (const auto& cp : checkpoints_) {
+	put64(out, cp.offset);
+	put64(out + 8, cp.position);
+	put64(out + 16, cp.line);
+	out += CheckpointSize;
+    }
+    put64(out, lines_);
+    put64(out + 8, size_);
+    put64(out + 16, data_size_);
+    put32(out + 24, uint32_t(checkpoints_.size()));
+    put32(out + 28, Version);
+    memcpy(out + 32, Tag, sizeof(Tag));
+    return bytes;
+}
+
+std::optional<LineIndex> LineIndex::parse(std::string_view bytes) {
+    if (bytes.size() < frame_size(0) or bytes.substr(bytes.size() - 4) != std::string_view{Tag, 4}
+	or get32(bytes.data() + bytes.size() - 8) != Version)
+	return std::nullopt;
+    auto count = get32(bytes.data() + bytes.size() - 12);
+    auto size = frame_size(count);
+    if (size > bytes.size())
+	return std::nullopt;
+    bytes = bytes.substr(bytes.size() - size);
+    if (get32(bytes.data()) != SkippableMagic or get32(bytes.data() + 4) != size - 8)
+	return std::nullopt;
+
+    LineIndex index;
+    auto in = bytes.data() + 8;
+    for (uint32_t i = 0; i < count; ++i, in += CheckpointSize)
+	index.checkpoints_.push_back({get64(in), get64(in + 8), get64(in + 16)});
+    index.lines_ = get64(in);
+    index.size_ = get64(in + 8);
+    index.data_size_ = get64(in + 16);
+    return index;
+}
+
+void LineIndex::save(const std::string& path) const {
+    auto bytes = serialize();
+    std::ofstream os{path, std::ios::binary | std::ios::trunc};
+    os.write(bytes.data(), bytes.size());
+    if (not os)
+	throw zstd::error("LineIndex: cannot write %s", path);
+}
+
+std::optional<LineIndex> LineIndex::load(const std::string& path) {
+    std::ifstream is{path, std::ios::binary};
+    if (not is)
+	return std::nullopt;
+    std::string bytes{std::istreambuf_iterator<char>{is}, std::istreambuf_iterator<char>{}};
+    return parse(bytes);
+}
+
+void LineIndex::append_to(const std::string& path) const {
+    auto bytes = serialize();
+    std::ofstream os{path, std::ios::binary | std::ios::app};
+    os.write(bytes.data(), bytes.size());
+    if (not os)
+	throw zstd::error("LineIndex: cannot append to %s", path);
+}
+
+std::optional<LineIndex> LineIndex::read_trailer(const std::string& path) {
+    std::ifstream is{path, std::ios::binary};
+    if (not is)
+	return std::nullopt;
+    is.seekg(0, std::ios::end);
+    uint64_t file_size = is.tellg();
+    if (file_size < frame_size(0))
+	return std::nullopt;
+
+    char footer[12];
+    is.seekg(file_size - sizeof(footer));
+    is.read(footer, sizeof(footer));
+    if (not is or std::string_view{footer + 8, 4} != std::string_view{Tag, 4})
+	return std::nullopt;
+    auto size = frame_size(get32(footer));
+    if (size > file_size)
+	return std::nullopt;
+
+    std::string bytes(size, '\0');
+    is.seekg(file_size - size);
+    is.read(bytes.data(), bytes.size());
+    if (not is)
+	return std::nullopt;
+    return parse(bytes);
+}
+
+bool LineIndex::matches(const FrameFile& file) const {
+    if (size_ != file.size() or data_size_ != data_size(file))
+	return false;
+    size_t j{0};
+    for (size_t k = 0; k < file.frames(); ++k) {
+	const auto& info = file.frame_info(k);
+	if (info.content_size == 0)
+	    continue;
+	if (j == checkpoints_.size() or checkpoints_[j].offset != info.offset
+	    or checkpoints_[j].position != info.position)
+	    return false;
+	++j;
+    }
+    return j == checkpoints_.size();
+}
+
+const LineCheckpoint& LineIndex::checkpoint(uint64_t n) const {
+    auto iter = std::lower_bound(checkpoints_.begin(), checkpoints_.end(), n,
+				 [](const LineCheckpoint& cp, uint64_t n) { return cp.line < n; });
+    return *(iter - 1);
+}
+
+LineReader::LineReader(const FrameFile& file, const LineIndex& index)
+    : file_(&file)
+    , index_(&index)
+    , reader_(file) {
+}
+
+bool LineReader::seek_line(uint64_t n) {
+    if (n >= index_->lines()) {
+	reader_.seek(file_->size());
+	line_ = index_->lines();
+	return false;
+    }
+
+    line_ = n;
+    if (n == 0) {
+	reader_.seek(0);
+	return true;
+    }
+
+    // Skip the newlines between the checkpoint and the line.
+    const auto& cp = index_->checkpoint(n);
+    auto skip = n - cp.line;
+    for (auto k = file_->frame_at(cp.position); k < file_->frames(); ++k) {
+	auto block = file_->frame(k);
+	auto ptr = block->data(), end = ptr + block->size();
+	while (auto nl = (const char*)memchr(ptr, '\n', end - ptr)) {
+	    ptr = nl + 1;
+	    if (--skip == 0) {
+		reader_.seek(file_->frame_info(k).position + (ptr - block->data()));
+		return true;
+	    }
+	}
+    }
+    throw zstd::error("LineIndex: %s: line %d is not where the index has it", file_->path(), n);
+}
+
+bool LineReader::read_line(std::string& line) {
+    if (line_ >= index_->lines() or not reader_.read_line(line))
+	return false;
+    ++line_;
+    return true;
+}
+
+std::vector<std::string> LineReader::read_lines(uint64_t first, size_t count) {
+    std::vector<std::string> lines;
+    if (not seek_line(first))
+	return lines;
+    std::string line;
+    while (lines.size() < count and read_line(line))
+	lines.push_back(line);
+    return lines;
+}
+
+}; // zstd
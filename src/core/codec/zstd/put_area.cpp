@@ -6,8 +6,8 @@
 namespace zstd
 {
 
-PutArea::PutArea(size_t capacity)
-    : core::BufferedArea(capacity) {
+PutArea::PutArea(size_t capacity, core::Allocator *alloc)
+    : core::BufferedArea(capacity, alloc) {
     buffer_.src = begin();
     buffer_.pos = 0;
     buffer_.size = 0;
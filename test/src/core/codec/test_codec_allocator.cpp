@@ -0,0 +1,177 @@
+// Copyright 2022 by Mark Melton
+//
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <thread>
+#include "core/codec/util/allocator.h"
+#include "core/codec/util/buffer.h"
+#include "core/codec/bzip/compressor.h"
+#include "core/codec/bzip/decompressor.h"
+#include "core/codec/bzip/new_stream.h"
+#include "core/codec/zstd/compressor.h"
+#include "core/codec/zstd/custom_mem.h"
+#include "core/codec/zstd/decompressor.h"
+#include "coro/stream/stream.h"
+
+static const size_t NumberSamples = 8;
+
+class CountingAllocator : public core::Allocator {
+public:
+    void *allocate(size_t n) override {
+	++allocations;
+	return core::malloc_allocator().allocate(n);
+    }
+
+    void deallocate(void *ptr) override {
+	if (ptr)
+	    ++deallocations;
+	core::malloc_allocator().deallocate(ptr);
+    }
+
+    size_t allocations{0}, deallocations{0};
+};
+
+class ThrowingAllocator : public core::Allocator {
+public:
+    void *allocate(size_t) override {
+	throw std::bad_alloc{};
+    }
+
+    void deallocate(void *ptr) override {
+	core::malloc_allocator().deallocate(ptr);
+    }
+};
+
+std::string zstd_round_trip(const std::string& str, core::Allocator *alloc) {
+    std::stringstream ss;
+    zstd::Compressor c{ss, 256, alloc};
+    c.write(str.data(), str.size());
+    c.close();
+
+    zstd::Decompressor d{ss, 256, alloc};
+    std::string ustr;
+    while (d.underflow())
+	ustr += d.view();
+    return ustr;
+}
+
+std::string bzip_round_trip(const std::string& str, core::Allocator *alloc) {
+    std::stringstream ss;
+    bzip::Compressor c{ss, 256, alloc};
+    c.write(str.data(), str.size());
+    c.close();
+
+    bzip::Decompressor d{ss, 256, alloc};
+    std::string ustr;
+    while (d.underflow())
+	ustr += d.view();
+    return ustr;
+}
+
+TEST(Allocator, Arena)
+{
+    auto& arena = core::arena_allocator();
+    auto ptr = arena.allocate(1000);
+    arena.deallocate(ptr);
+    EXPECT_EQ(arena.allocate(1024), ptr);
+    arena.deallocate(ptr);
+
+    auto large = arena.allocate(size_t{1} << 30);
+    EXPECT_NE(large, nullptr);
+    arena.deallocate(large);
+}
+
+TEST(Allocator, ArenaCrossThread)
+{
+    auto& arena = core::arena_allocator();
+    void *ptr{nullptr};
+    std::thread([&]() { ptr = arena.allocate(4096); }).join();
+    arena.deallocate(ptr);
+    EXPECT_EQ(arena.allocate(4096), ptr);
+    arena.deallocate(ptr);
+}
+
+TEST(Allocator, HugePages)
+{
+    auto& pool = core::huge_page_allocator();
+    auto ptr = pool.allocate(100);
+    memset(ptr, 0xff, 100);
+    pool.deallocate(ptr);
+    EXPECT_EQ(pool.allocate(128), ptr);
+    pool.deallocate(ptr);
+
+    auto large = pool.allocate(size_t{64} << 20);
+    memset(large, 0xff, size_t{64} << 20);
+    pool.deallocate(large);
+}
+
+TEST(Allocator, Buffer)
+{
+    CountingAllocator alloc;
+    {
+	core::BufferedArea area(1024, &alloc);
+	core::BufferedArea other(std::move(area));
+	EXPECT_EQ(other.capacity(), 1024u);
+	EXPECT_EQ(area.capacity(), 0u);
+	EXPECT_EQ(other.allocator(), &alloc);
+    }
+    EXPECT_EQ(alloc.allocations, 1u);
+    EXPECT_EQ(alloc.deallocations, 1u);
+}
+
+TEST(Allocator, Zstd)
+{
+    for (auto str : coro::str::alpha(0, 4096) | coro::take(NumberSamples)) {
+	CountingAllocator alloc;
+	EXPECT_EQ(zstd_round_trip(str, &alloc), str);
+	EXPECT_GT(alloc.allocations, 2u);
+	EXPECT_EQ(alloc.allocations, alloc.deallocations);
+
+	EXPECT_EQ(zstd_round_trip(str, &core::arena_allocator()), str);
+	EXPECT_EQ(zstd_round_trip(str, &core::huge_page_allocator()), str);
+    }
+}
+
+TEST(Allocator, Bzip)
+{
+    for (auto str : coro::str::alpha(0, 4096) | coro::take(NumberSamples)) {
+	CountingAllocator alloc;
+	EXPECT_EQ(bzip_round_trip(str, &alloc), str);
+	EXPECT_GT(alloc.allocations, 2u);
+	EXPECT_EQ(alloc.allocations, alloc.deallocations);
+
+	EXPECT_EQ(bzip_round_trip(str, &core::arena_allocator()), str);
+	EXPECT_EQ(bzip_round_trip(str, &core::huge_page_allocator()), str);
+    }
+}
+
+TEST(Allocator, Throwing)
+{
+    // An allocator that throws fails the allocations of the libraries,
+    // which report an error instead of being unwound through.
+    ThrowingAllocator alloc;
+    EXPECT_EQ(ZSTD_createCCtx_advanced(zstd::custom_mem(alloc)), nullptr);
+    EXPECT_EQ(ZSTD_createDStream_advanced(zstd::custom_mem(alloc)), nullptr);
+
+    std::unique_ptr<bz_stream> stream{bzip::new_stream(&alloc)};
+    EXPECT_EQ(BZ2_bzCompressInit(stream.get(), 1, 0, 0), BZ_MEM_ERROR);
+    EXPECT_EQ(BZ2_bzDecompressInit(stream.get(), 0, 0), BZ_MEM_ERROR);
+}
+
+TEST(Allocator, Default)
+{
+    CountingAllocator alloc;
+    core::set_default_allocator(alloc);
+    std::string str = "abcdefghijklmnopqrstuvwxyz";
+    EXPECT_EQ(zstd_round_trip(str, nullptr), str);
+    core::set_default_allocator(core::malloc_allocator());
+    EXPECT_GT(alloc.allocations, 0u);
+    EXPECT_EQ(alloc.allocations, alloc.deallocations);
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
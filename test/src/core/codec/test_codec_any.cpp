@@ -0,0 +1,124 @@
+// Copyright 2022 by Mark Melton
+//
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include "core/codec/any_decompressor.h"
+#include "core/codec/any_stream.h"
+#include "core/codec/base64.h"
+#include "core/codec/bzip/compress.h"
+#include "core/codec/zstd/compress.h"
+#include "coro/stream/stream.h"
+
+static const size_t NumberSamples = 16;
+
+using core::codec::AnyDecompressor;
+using core::codec::Format;
+
+std::string read_all(std::stringstream& ss, Format expected, bool base64) {
+    AnyDecompressor d{ss, 64};
+    EXPECT_EQ(d.format(), expected);
+    EXPECT_EQ(d.base64(), base64);
+    std::string str;
+    while (d.underflow())
+	str += d.view();
+    return str;
+}
+
+TEST(Any, Detect)
+{
+    for (auto str : coro::str::alpha(0, 4096) | coro::take(NumberSamples)) {
+	std::stringstream zss{zstd::compress(str)};
+	EXPECT_EQ(read_all(zss, Format::Zstd, false), str);
+
+	std::stringstream bss{bzip::compress(str)};
+	EXPECT_EQ(read_all(bss, Format::Bzip, false), str);
+
+	std::stringstream rss{str};
+	EXPECT_EQ(read_all(rss, Format::Raw, false), str);
+    }
+}
+
+TEST(Any, Base64)
+{
+    for (auto str : coro::str::any(0, 4096) | coro::take(NumberSamples)) {
+	std::stringstream zss{base64_encode(zstd::compress(str))};
+	EXPECT_EQ(read_all(zss, Format::Zstd, true), str);
+
+	std::stringstream bss{base64_encode_mime(bzip::compress(str))};
+	EXPECT_EQ(read_all(bss, Format::Bzip, true), str);
+
+	std::stringstream uss{"\n" + base64_encode(zstd::compress(str), true)};
+	EXPECT_EQ(read_all(uss, Format::Zstd, true), str);
+    }
+}
+
+TEST(Any, PlainBase64)
+{
+    std::string str = "YWJjZGVmZ2hpamtsbW5vcA==";
+    std::stringstream ss{str};
+    EXPECT_EQ(read_all(ss, Format::Raw, false), str);
+}
+
+TEST(Any, Empty)
+{
+    std::stringstream ss;
+    AnyDecompressor d{ss};
+    std::string line;
+    EXPECT_EQ(d.format(), Format::Raw);
+    EXPECT_FALSE(d.read_line(line));
+    EXPECT_FALSE(d.underflow());
+}
+
+TEST(Any, Lines)
+{
+    std::string text = "abc\n\ndef\nghi";
+    for (auto data : { text, zstd::compress(text), bzip::compress(text), base64_encode_pem(zstd::compress(text)) }) {
+	std::stringstream ss{data};
+	AnyDecompressor d{ss, 4};
+	std::string line;
+	EXPECT_TRUE(d.read_line(line));
+	EXPECT_EQ(line, "abc");
+	EXPECT_TRUE(d.read_line(line));
+	EXPECT_EQ(line, "");
+	EXPECT_TRUE(d.read_line(line));
+	EXPECT_EQ(line, "def");
+	EXPECT_TRUE(d.read_line(line));
+	EXPECT_EQ(line, "ghi");
+	EXPECT_FALSE(d.read_line(line));
+    }
+}
+
+TEST(Any, Visit)
+{
+    std::string str(100000, 'x');
+    std::stringstream ss{zstd::compress(str)};
+    AnyDecompressor d{ss};
+    size_t count{0};
+    d.visit([&](auto& engine) {
+	while (engine.underflow())
+	    count += engine.view().size();
+    });
+    EXPECT_EQ(count, str.size());
+}
+
+TEST(Any, Stream)
+{
+    std::string text = "abc\ndef\n";
+    std::stringstream ss{base64_encode(bzip::compress(text))};
+    core::any_istream in{ss};
+    EXPECT_EQ(in.format(), Format::Bzip);
+
+    std::string line;
+    EXPECT_TRUE((bool)std::getline(in, line));
+    EXPECT_EQ(line, "abc");
+    EXPECT_TRUE((bool)std::getline(in, line));
+    EXPECT_EQ(line, "def");
+    EXPECT_FALSE((bool)std::getline(in, line));
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
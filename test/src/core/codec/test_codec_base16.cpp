@@ -0,0 +1,130 @@
+// Copyright 2022 by Mark Melton
+//
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include "core/codec/base16.h"
+#include "core/codec/base16/decoder.h"
+#include "core/codec/base16/encoder.h"
+#include "core/codec/base16/kernels.h"
+#include "core/codec/corpus/corpus.h"
+#include "coro/stream/stream.h"
+
+namespace corpus = core::codec::corpus;
+
+static const size_t NumberSamples = 64;
+
+TEST(Base16, Vectors)
+{
+    EXPECT_EQ(base16_encode(""), "");
+    EXPECT_EQ(base16_encode("f"), "66");
+    EXPECT_EQ(base16_encode("foobar"), "666f6f626172");
+    EXPECT_EQ(base16_encode("\x01\xab\xff", true), "01ABFF");
+
+    EXPECT_EQ(base16_decode("666f6f626172"), "foobar");
+    EXPECT_EQ(base16_decode("01AbfF"), "\x01\xab\xff");
+}
+
+TEST(Base16, Into)
+{
+    using base16::Status;
+    auto str = corpus::random_bytes(1000);
+    auto encoded = base16_encode(str);
+    EXPECT_EQ(base16::validate(encoded).count, str.size());
+
+    std::string out(str.size() - 1, '\0');
+    EXPECT_EQ(base16::decode_into(encoded, out).status, Status::OutputTooSmall);
+    EXPECT_EQ(base16::encode_into(str, out).status, Status::OutputTooSmall);
+    EXPECT_EQ(base16::decode_into("abc", out).status, Status::InvalidLength);
+    EXPECT_THROW(base16_decode("abc"), std::runtime_error);
+
+    for (auto c : {'g', 'G', ' ', '\0', '\x80', '/', ':', '`', '@'}) {
+	for (auto pos : {0ul, 17ul, 500ul, encoded.size() - 1}) {
+	    auto bad = encoded;
+	    bad[pos] = c;
+	    auto r = base16::validate(bad);
+	    EXPECT_EQ(r.status, Status::InvalidCharacter);
+	    EXPECT_EQ(r.count, pos / 2);
+	    EXPECT_THROW(base16_decode(bad), std::runtime_error);
+	}
+    }
+}
+
+TEST(Base16, RoundTrip)
+{
+    for (auto str : coro::str::any(0, 2048) | coro::take(NumberSamples)) {
+	for (auto upper : {false, true}) {
+	    auto encoded = base16_encode(str, upper);
+	    EXPECT_EQ(encoded.size(), 2 * str.size());
+	    EXPECT_EQ(base16_decode(encoded), str);
+	}
+    }
+}
+
+TEST(Base16, Kernels)
+{
+    EXPECT_TRUE(base16::supported(base16::Isa::Scalar));
+    EXPECT_EQ(base16::kernels().isa, base16::best_isa());
+    const auto& scalar = base16::kernels(base16::Isa::Scalar);
+
+    for (size_t n = 0; n < 300; ++n) {
+	auto str = corpus::random_bytes(n, n);
+	auto in = reinterpret_cast<const unsigned char*>(str.data());
+	for (auto upper : {false, true}) {
+	    std::string expected(2 * n, '\0');
+	    scalar.encode(in, n, expected.data(), upper);
+
+	    for (auto isa : base16::Isas) {
+		if (not base16::supported(isa))
+		    continue;
+		const auto& k = base16::kernels(isa);
+		std::string encoded(2 * n, '\0');
+		k.encode(in, n, encoded.data(), upper);
+		EXPECT_EQ(encoded, expected) << base16::name(isa);
+
+		std::string decoded(n, '\0');
+		auto out = reinterpret_cast<unsigned char*>(decoded.data());
+		EXPECT_EQ(k.decode(encoded.data(), encoded.size(), out), encoded.size());
+		EXPECT_EQ(decoded, str) << base16::name(isa);
+
+		if (encoded.size() > 0) {
+		    auto pos = (n * 7) % encoded.size();
+		    encoded[pos] = 'x';
+		    EXPECT_EQ(k.decode(encoded.data(), encoded.size(), out), pos / 2 * 2)
+			<< base16::name(isa);
+		}
+	    }
+	}
+    }
+}
+
+TEST(Base16, Stream)
+{
+    for (auto str : coro::str::any(0, 1024) | coro::take(NumberSamples)) {
+	std::stringstream ss;
+	base16::Encoder e{ss, {.upper = true}, 7};
+	for (size_t i = 0; i < str.size(); i += 5)
+	    e.write(str.data() + i, std::min<size_t>(5, str.size() - i));
+	e.close();
+	EXPECT_EQ(ss.str(), base16_encode(str, true));
+	EXPECT_EQ(e.count(), ss.str().size());
+
+	std::stringstream in{ss.str() + "\n"};
+	base16::Decoder d{in, {}, 3};
+	std::string decoded(str.size() + 1, '\0');
+	EXPECT_EQ(d.read_bytes(decoded.data(), decoded.size()), str.size());
+	decoded.resize(str.size());
+	EXPECT_EQ(decoded, str);
+    }
+
+    std::string line;
+    std::stringstream bad{"6f6"};
+    base16::Decoder d{bad};
+    EXPECT_THROW(d.read_line(line), std::runtime_error);
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,146 @@
+// Copyright 2022 by Mark Melton
+//
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include "core/codec/base32.h"
+#include "core/codec/base32/decoder.h"
+#include "core/codec/base32/encoder.h"
+#include "core/codec/base32/kernels.h"
+#include "core/codec/corpus/corpus.h"
+#include "coro/stream/stream.h"
+
+namespace corpus = core::codec::corpus;
+
+static const size_t NumberSamples = 64;
+
+TEST(Base32, Vectors)
+{
+    // RFC 4648, section 10.
+    const char *strs[] = { "", "f", "fo", "foo", "foob", "fooba", "foobar" };
+    const char *standard[] = { "", "MY======", "MZXQ====", "MZXW6===", "MZXW6YQ=", "MZXW6YTB",
+			       "MZXW6YTBOI======" };
+    const char *hex[] = { "", "CO======", "CPNG====", "CPNMU===", "CPNMUOG=", "CPNMUOJ1",
+			  "CPNMUOJ1E8======" };
+    for (size_t i = 0; i < std::size(strs); ++i) {
+	EXPECT_EQ(base32_encode(strs[i]), standard[i]);
+	EXPECT_EQ(base32_encode(strs[i], true), hex[i]);
+	EXPECT_EQ(base32_decode(standard[i]), strs[i]);
+	EXPECT_EQ(base32_decode(hex[i], true), strs[i]);
+
+	// Unpadded and lower case.
+	std::string unpadded{standard[i]};
+	unpadded.erase(unpadded.find_first_of('=') == std::string::npos
+		       ? unpadded.size() : unpadded.find_first_of('='));
+	EXPECT_EQ(base32_decode(unpadded), strs[i]);
+	for (auto& c : unpadded)
+	    c = std::tolower(c);
+	EXPECT_EQ(base32_decode(unpadded), strs[i]);
+    }
+}
+
+TEST(Base32, Into)
+{
+    using base32::Status;
+    for (auto size : {0ul, 1ul, 2ul, 3ul, 4ul, 5ul, 99ul, 5000ul}) {
+	auto str = corpus::random_bytes(size, size);
+	for (auto options : {base32::Options{}, base32::Options{true, false}}) {
+	    auto length = base32::encoded_length(size, options);
+	    std::string encoded(length, '\0');
+	    EXPECT_EQ(base32::encode_into(str, encoded, options).count, length);
+	    EXPECT_EQ(base32::decoded_length(encoded), size);
+	    EXPECT_EQ(base32::validate(encoded, options).count, size);
+
+	    std::string decoded(size, '\0');
+	    EXPECT_EQ(base32::decode_into(encoded, decoded, options).count, size);
+	    EXPECT_EQ(decoded, str);
+	    if (size > 0) {
+		std::span<char> small{decoded.data(), size - 1};
+		EXPECT_EQ(base32::decode_into(encoded, small, options).status, Status::OutputTooSmall);
+	    }
+	}
+    }
+
+    for (auto bad : {"M", "MZX", "MZXW6Y", "MZXW6YTBO", "M=======", "MZXW6===M", "MZXW6=="})
+	EXPECT_EQ(base32::validate(bad).status, Status::InvalidLength) << bad;
+    EXPECT_EQ(base32::validate("MZ=W6===").status, Status::InvalidCharacter);
+
+    auto encoded = base32_encode(corpus::random_bytes(1000));
+    for (auto c : {'1', '8', '=', ' ', '\0', '\x80'}) {
+	for (auto pos : {0ul, 17ul, 500ul, encoded.size() - 20}) {
+	    auto bad = encoded;
+	    bad[pos] = c;
+	    auto r = base32::validate(bad);
+	    EXPECT_EQ(r.status, Status::InvalidCharacter);
+	    EXPECT_EQ(r.count, pos / 8 * 5);
+	    EXPECT_THROW(base32_decode(bad), std::runtime_error);
+	}
+    }
+}
+
+TEST(Base32, Kernels)
+{
+    EXPECT_TRUE(base32::supported(base32::Isa::Scalar));
+    EXPECT_EQ(base32::kernels().isa, base32::best_isa());
+    const auto& scalar = base32::kernels(base32::Isa::Scalar);
+
+    for (size_t n = 0; n < 600; n += 5) {
+	auto str = corpus::random_bytes(n, n);
+	auto in = reinterpret_cast<const unsigned char*>(str.data());
+	for (auto hex : {false, true}) {
+	    std::string expected(n / 5 * 8, '\0');
+	    scalar.encode(in, n, expected.data(), hex);
+	    EXPECT_EQ(expected, base32_encode(str, hex));
+
+	    for (auto isa : base32::Isas) {
+		if (not base32::supported(isa))
+		    continue;
+		const auto& k = base32::kernels(isa);
+		std::string encoded(n / 5 * 8, '\0');
+		k.encode(in, n, encoded.data(), hex);
+		EXPECT_EQ(encoded, expected) << base32::name(isa);
+
+		std::string decoded(n, '\0');
+		auto out = reinterpret_cast<unsigned char*>(decoded.data());
+		EXPECT_EQ(k.decode(encoded.data(), encoded.size(), out, hex), encoded.size());
+		EXPECT_EQ(decoded, str) << base32::name(isa);
+
+		if (encoded.size() > 0) {
+		    auto pos = (n * 7) % encoded.size();
+		    encoded[pos] = '=';
+		    EXPECT_EQ(k.decode(encoded.data(), encoded.size(), out, hex), pos / 8 * 8)
+			<< base32::name(isa);
+		}
+	    }
+	}
+    }
+}
+
+TEST(Base32, Stream)
+{
+    for (auto str : coro::str::any(0, 1024) | coro::take(NumberSamples)) {
+	for (auto options : {base32::Options{}, base32::Options{true, false}}) {
+	    std::stringstream ss;
+	    base32::Encoder e{ss, options, 13};
+	    for (size_t i = 0; i < str.size(); i += 7)
+		e.write(str.data() + i, std::min<size_t>(7, str.size() - i));
+	    e.close();
+	    std::string expected(base32::encoded_length(str.size(), options), '\0');
+	    base32::encode_into(str, expected, options);
+	    EXPECT_EQ(ss.str(), expected);
+
+	    std::stringstream in{ss.str()};
+	    base32::Decoder d{in, options, 5};
+	    std::string decoded(str.size() + 1, '\0');
+	    EXPECT_EQ(d.read_bytes(decoded.data(), decoded.size()), str.size());
+	    decoded.resize(str.size());
+	    EXPECT_EQ(decoded, str);
+	}
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
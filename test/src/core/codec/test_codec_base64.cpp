@@ -0,0 +1,244 @@
+// Copyright 2022 by Mark Melton
+//
+
+#include <gtest/gtest.h>
+#include "core/codec/base64.h"
+#include "core/codec/base64/codec.h"
+#include "core/codec/base64/kernels.h"
+#include "core/codec/corpus/corpus.h"
+#include "coro/stream/stream.h"
+
+namespace corpus = core::codec::corpus;
+
+static const size_t NumberSamples = 64;
+
+TEST(Base64, Vectors)
+{
+    EXPECT_EQ(base64_encode(std::string_view{""}), "");
+    EXPECT_EQ(base64_encode(std::string_view{"f"}), "Zg==");
+    EXPECT_EQ(base64_encode(std::string_view{"fo"}), "Zm8=");
+    EXPECT_EQ(base64_encode(std::string_view{"foo"}), "Zm9v");
+    EXPECT_EQ(base64_encode(std::string_view{"foob"}), "Zm9vYg==");
+    EXPECT_EQ(base64_encode(std::string_view{"fooba"}), "Zm9vYmE=");
+    EXPECT_EQ(base64_encode(std::string_view{"foobar"}), "Zm9vYmFy");
+    EXPECT_EQ(base64_encode(std::string_view{"\xfb\xff\xbf"}), "+/+/");
+    EXPECT_EQ(base64_encode(std::string_view{"\xfb\xff\xbf\xfb"}, true), "-_-_-w..");
+
+    EXPECT_EQ(base64_decode(std::string_view{"Zm9vYmFy"}), "foobar");
+    EXPECT_EQ(base64_decode(std::string_view{"Zm9vYg=="}), "foob");
+    EXPECT_EQ(base64_decode(std::string_view{"Zm9vYg.."}), "foob");
+    EXPECT_EQ(base64_decode(std::string_view{"Zm9vYg"}), "foob");
+    EXPECT_EQ(base64_decode(std::string_view{"Zm9vYmE"}), "fooba");
+}
+
+TEST(Base64, Liberal)
+{
+    // Either alphabet, or a mix, is accepted.
+    std::string str(300, '\xff');
+    auto encoded = base64_encode(str);
+    auto url = base64_encode(str, true);
+    EXPECT_EQ(base64_decode(encoded), str);
+    EXPECT_EQ(base64_decode(url), str);
+    for (size_t i = 0; i < encoded.size(); i += 3)
+	encoded[i] = url[i];
+    EXPECT_EQ(base64_decode(encoded), str);
+
+    // Padded quanta within the input, i.e. concatenated encodings.
+    auto a = corpus::random_bytes(100, 1), b = corpus::random_bytes(200, 2);
+    EXPECT_EQ(base64_decode(base64_encode(a) + base64_encode(b)), a + b);
+}
+
+TEST(Base64, Invalid)
+{
+    auto encoded = base64_encode(corpus::random_bytes(1000));
+    for (auto c : {'*', '\n', ' ', '\0', '\x80'}) {
+	for (auto pos : {0ul, 17ul, 500ul, encoded.size() - 3}) {
+	    auto bad = encoded;
+	    bad[pos] = c;
+	    EXPECT_THROW(base64_decode(bad), std::runtime_error);
+	}
+    }
+    EXPECT_THROW(base64_decode(std::string_view{"Zm9vY"}), std::runtime_error);
+    EXPECT_EQ(base64_decode(base64_encode_mime(encoded), true), encoded);
+}
+
+TEST(Base64, LineBreaks)
+{
+    for (auto size : {0ul, 1ul, 47ul, 48ul, 49ul, 56ul, 57ul, 58ul, 1000ul, 10000ul}) {
+	auto str = corpus::random_bytes(size, size);
+	auto encoded = base64_encode(str);
+	for (auto [line_length, wrapped] : {std::pair{64ul, base64_encode_pem(str)},
+					    std::pair{76ul, base64_encode_mime(str)}}) {
+	    std::string expected;
+	    for (size_t i = 0; i < encoded.size(); i += line_length) {
+		if (i > 0)
+		    expected += '\n';
+		expected += encoded.substr(i, line_length);
+	    }
+	    EXPECT_EQ(wrapped, expected);
+	    EXPECT_EQ(base64_decode(wrapped, true), str);
+	}
+
+	// Quanta split by line breaks, CRLF and blank lines.
+	std::string odd;
+	for (size_t i = 0; i < encoded.size(); i += 7)
+	    odd += encoded.substr(i, 7) + (i % 2 ? "\r\n" : "\n\n");
+	EXPECT_EQ(base64_decode(odd, true), str);
+    }
+
+    EXPECT_EQ(base64_decode(std::string_view{"Zm9v\nYmE\n"}, true), "fooba");
+    EXPECT_THROW(base64_decode(std::string_view{"Zm9v\nY\n"}, true), std::runtime_error);
+    EXPECT_THROW(base64_decode(std::string_view{"Zm\r9v\n"}, true), std::runtime_error);
+}
+
+TEST(Base64, Into)
+{
+    using base64::Status;
+    for (auto size : {0ul, 1ul, 2ul, 3ul, 4ul, 100ul, 5000ul}) {
+	auto str = corpus::random_bytes(size, size);
+	for (auto options : {base64::Options{}, base64::Options{true, 0},
+			     base64::Options::pem(), base64::Options{true, 8}}) {
+	    auto length = base64::encoded_length(size, options);
+	    std::string encoded(length, '\0');
+	    auto r = base64::encode_into(str, encoded, options);
+	    EXPECT_TRUE(r);
+	    EXPECT_EQ(r.count, length);
+	    if (options.line_length == 0) {
+		EXPECT_EQ(encoded, base64_encode(str, options.url));
+		EXPECT_EQ(base64::decoded_length(encoded), size);
+	    }
+
+	    // Exact and one byte short buffers.
+	    auto skip = options.line_length > 0;
+	    std::string decoded(size, '\0');
+	    r = base64::decode_into(encoded, decoded, skip);
+	    EXPECT_TRUE(r);
+	    EXPECT_EQ(r.count, size);
+	    EXPECT_EQ(decoded, str);
+	    EXPECT_EQ(base64::validate(encoded, skip).count, size);
+	    if (size > 0) {
+		std::span<char> small{decoded.data(), size - 1};
+		EXPECT_EQ(base64::decode_into(encoded, small, skip).status, Status::OutputTooSmall);
+		EXPECT_EQ(base64::encode_into(str, {encoded.data(), length - 1}, options).status,
+			  Status::OutputTooSmall);
+	    }
+	}
+    }
+
+    std::string out(100, '\0');
+    EXPECT_EQ(base64::encode_into("foo", out, {false, 10}).status, Status::InvalidLineLength);
+    EXPECT_EQ(base64::decode_into("Zm9vY", out).status, Status::InvalidLength);
+    EXPECT_EQ(base64::validate("Zm9vY").status, Status::InvalidLength);
+    EXPECT_EQ(base64::decoded_length("Zm9vYg=="), 4u);
+    EXPECT_EQ(base64::decoded_length("Zm9vYmE"), 5u);
+
+    auto encoded = base64_encode(corpus::random_bytes(10000));
+    encoded[5000] = '*';
+    auto r = base64::decode_into(encoded, out = std::string(10000, '\0'));
+    EXPECT_EQ(r.status, Status::InvalidCharacter);
+    EXPECT_EQ(r.count, 3750u);
+    EXPECT_EQ(base64::validate(encoded).status, Status::InvalidCharacter);
+    EXPECT_EQ(base64::validate(encoded).count, 3750u);
+    EXPECT_EQ(base64::name(Status::InvalidCharacter), "invalid character");
+}
+
+TEST(Base64, Parallel)
+{
+    // Large enough for several chunks per thread.
+    base64::ParallelOptions parallel{4, 0};
+    for (auto size : {(1ul << 21) + 1, (1ul << 21) + 2, 3ul << 20}) {
+	auto str = corpus::random_bytes(size, size);
+	for (auto options : {base64::Options{}, base64::Options::mime(), base64::Options{true, 8}}) {
+	    std::string encoded(base64::encoded_length(size, options), '\0');
+	    EXPECT_TRUE(base64::parallel_encode_into(str, encoded, options, parallel));
+	    std::string expected(encoded.size(), '\0');
+	    base64::encode_into(str, expected, options);
+	    EXPECT_EQ(encoded, expected);
+
+	    auto skip = options.line_length > 0;
+	    std::string decoded(base64::max_decoded_length(encoded.size()), '\0');
+	    auto r = base64::parallel_decode_into(encoded, decoded, skip, parallel);
+	    EXPECT_TRUE(r);
+	    decoded.resize(r.count);
+	    EXPECT_EQ(decoded, str);
+	}
+
+	// Irregular lines, CRLF and concatenated encodings.
+	auto concat = base64_encode(str.substr(0, size / 3)) + base64_encode(str.substr(size / 3));
+	std::string odd;
+	for (size_t i = 0; i < concat.size(); i += 1 + i % 101) {
+	    odd += concat.substr(i, 1 + i % 101);
+	    odd += i % 3 ? "\n" : "\r\n";
+	}
+	for (auto [encoded, skip] : {std::pair{concat, false}, std::pair{odd, true}}) {
+	    std::string decoded(base64::max_decoded_length(encoded.size()), '\0');
+	    auto r = base64::parallel_decode_into(encoded, decoded, skip, parallel);
+	    EXPECT_TRUE(r);
+	    decoded.resize(r.count);
+	    EXPECT_EQ(decoded, str);
+	}
+
+	auto bad = concat;
+	bad[bad.size() * 2 / 3] = '*';
+	std::string decoded(base64::max_decoded_length(bad.size()), '\0');
+	auto r = base64::parallel_decode_into(bad, decoded, false, parallel);
+	EXPECT_EQ(r.status, base64::Status::InvalidCharacter);
+	EXPECT_EQ(r.count, base64::decode_into(bad, decoded).count);
+    }
+}
+
+TEST(Base64, RoundTrip)
+{
+    for (auto str : coro::str::any(0, 2048) | coro::take(NumberSamples)) {
+	for (auto url : {false, true}) {
+	    auto encoded = base64_encode(str, url);
+	    EXPECT_EQ(encoded.size(), (str.size() + 2) / 3 * 4);
+	    EXPECT_EQ(base64_decode(encoded), str);
+	}
+    }
+}
+
+TEST(Base64, Kernels)
+{
+    EXPECT_TRUE(base64::supported(base64::Isa::Scalar));
+    EXPECT_TRUE(base64::supported(base64::best_isa()));
+    EXPECT_EQ(base64::kernels().isa, base64::best_isa());
+    const auto& scalar = base64::kernels(base64::Isa::Scalar);
+
+    for (size_t n = 0; n < 600; n += 3) {
+	auto str = corpus::random_bytes(n, n);
+	auto in = reinterpret_cast<const unsigned char*>(str.data());
+	for (auto url : {false, true}) {
+	    std::string expected(n / 3 * 4, '\0');
+	    scalar.encode(in, n, expected.data(), url);
+	    EXPECT_EQ(expected, base64_encode(str, url));
+
+	    for (auto isa : base64::Isas) {
+		if (not base64::supported(isa))
+		    continue;
+		const auto& k = base64::kernels(isa);
+		std::string encoded(n / 3 * 4, '\0');
+		k.encode(in, n, encoded.data(), url);
+		EXPECT_EQ(encoded, expected) << base64::name(isa);
+
+		std::string decoded(n, '\0');
+		auto out = reinterpret_cast<unsigned char*>(decoded.data());
+		EXPECT_EQ(k.decode(encoded.data(), encoded.size(), out), encoded.size());
+		EXPECT_EQ(decoded, str) << base64::name(isa);
+
+		if (encoded.size() > 0) {
+		    auto pos = (n * 7) % encoded.size();
+		    encoded[pos] = '=';
+		    EXPECT_EQ(k.decode(encoded.data(), encoded.size(), out), pos / 4 * 4)
+			<< base64::name(isa);
+		}
+	    }
+	}
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,121 @@
+// Copyright 2022 by Mark Melton
+//
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include "core/codec/base64.h"
+#include "core/codec/base64/base64_stream.h"
+#include "core/codec/corpus/corpus.h"
+#include "core/codec/zstd/adapter.h"
+#include "core/cc/queue/sink_spsc.h"
+#include "core/cc/queue/source_spsc.h"
+#include "coro/stream/stream.h"
+
+namespace corpus = core::codec::corpus;
+
+static const size_t NumberSamples = 64;
+
+std::string encode(std::string_view str, const base64::Options& options, size_t block,
+		   size_t n = 0) {
+    std::stringstream ss;
+    base64::Encoder e{ss, options, n};
+    for (size_t i = 0; i < str.size(); i += block)
+	e.write(str.data() + i, std::min(block, str.size() - i));
+    e.close();
+    EXPECT_EQ(e.count(), ss.str().size());
+    return ss.str();
+}
+
+TEST(Base64Stream, Encoder)
+{
+    for (auto str : coro::str::any(0, 1024) | coro::take(NumberSamples)) {
+	for (auto block : {1ul, 2ul, 5ul, 1000ul}) {
+	    EXPECT_EQ(encode(str, {}, block), base64_encode(str));
+	    EXPECT_EQ(encode(str, {true, 0}, block, 7), base64_encode(str, true));
+	}
+    }
+}
+
+TEST(Base64Stream, LineWrapping)
+{
+    for (auto size : {0ul, 1ul, 47ul, 48ul, 49ul, 57ul, 1000ul, 100000ul}) {
+	auto str = corpus::random_bytes(size, size);
+	for (auto block : {1ul, 13ul, 4096ul}) {
+	    EXPECT_EQ(encode(str, base64::Options::pem(), block), base64_encode_pem(str));
+	    EXPECT_EQ(encode(str, base64::Options::mime(), block, 100), base64_encode_mime(str));
+	}
+    }
+
+    std::stringstream ss;
+    EXPECT_THROW(base64::Encoder(ss, {false, 10}), std::runtime_error);
+}
+
+TEST(Base64Stream, Decoder)
+{
+    for (auto str : coro::str::any(0, 1024) | coro::take(NumberSamples)) {
+	for (auto encoded : {base64_encode(str), base64_encode(str, true), base64_encode_mime(str)}) {
+	    std::stringstream ss{encoded};
+	    base64::Decoder d{ss, 5};
+	    std::string decoded(str.size() + 1, '\0');
+	    EXPECT_EQ(d.read_bytes(decoded.data(), decoded.size()), str.size());
+	    decoded.resize(str.size());
+	    EXPECT_EQ(decoded, str);
+	}
+    }
+
+    // Short final quantum.
+    std::stringstream ss{"Zm9v\nYmE"};
+    base64::Decoder d{ss, 1};
+    std::string line;
+    EXPECT_TRUE(d.read_line(line));
+    EXPECT_EQ(line, "fooba");
+    EXPECT_FALSE(d.read_line(line));
+
+    std::stringstream bad{"Zm9vY"};
+    base64::Decoder d2{bad};
+    EXPECT_THROW(d2.read_line(line), std::runtime_error);
+}
+
+TEST(Base64Stream, Queue)
+{
+    auto str = corpus::log_text(100000);
+    core::cc::queue::SourceSpSc<char> source(str);
+    core::cc::queue::SinkSpSc<char> sink;
+    {
+	base64::Encoder e{sink, base64::Options::mime()};
+	char buffer[1000];
+	while (auto n = zstd::InStreamAdapter<decltype(source)>::read(source, buffer, sizeof(buffer)))
+	    e.write(buffer, n);
+    }
+    EXPECT_EQ(sink.data(), base64_encode_mime(str));
+
+    core::cc::queue::SourceSpSc<char> encoded(sink.data());
+    base64::Decoder d{encoded};
+    std::string decoded(str.size(), '\0');
+    EXPECT_EQ(d.read_bytes(decoded.data(), decoded.size()), str.size());
+    EXPECT_EQ(decoded, str);
+    EXPECT_FALSE(d.underflow());
+}
+
+TEST(Base64Stream, Stream)
+{
+    for (auto str : coro::str::alpha(0, 1024) | coro::take(NumberSamples)) {
+	std::stringstream ss;
+	{
+	    core::base64_ostream bout(ss, base64::Options::pem(), 32);
+	    bout << str;
+	}
+	EXPECT_EQ(ss.str(), base64_encode_pem(str));
+
+	std::string result_str;
+	core::base64_istream bin(ss, 32);
+	bin >> result_str;
+	EXPECT_EQ(str, result_str);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
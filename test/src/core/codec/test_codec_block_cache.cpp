@@ -0,0 +1,211 @@
+// Copyright 2022 by Mark Melton
+//
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <thread>
+#include "core/codec/util/block_cache.h"
+#include "core/codec/zstd/compress.h"
+#include "core/codec/zstd/compressor.h"
+#include "core/codec/zstd/frame_file.h"
+#include "core/codec/corpus/corpus.h"
+
+namespace fs = std::filesystem;
+using core::codec::BlockCache;
+
+// Return the path of a temporary file holding `bytes`.
+static std::string write_file(const std::string& name, std::string_view bytes) {
+    auto path = fs::temp_directory_path() / fmt::format("block_cache.{}.{}", getpid(), name);
+    std::ofstream{path, std::ios::binary}.write(bytes.data(), bytes.size());
+    return path.string();
+}
+
+// Return `text` compressed as a file of frames of diverse kinds: with
+// and without their decompressed size, empty, and a skippable frame.
+static std::string frames(const std::string& text) {
+    auto n = text.size() / 4;
+    std::string bytes = zstd::compress(text.substr(0, n));
+    bytes += zstd::compress(std::string_view{});
+    bytes += std::string{"\x50\x2a\x4d\x18\x04\x00\x00\x00skip", 12};
+
+    std::stringstream ss;
+    zstd::Compressor c{ss};
+    c.set_adaptive({.min_level = 1, .max_level = 1, .frame_size = 10000});
+    c.write(text.data() + n, 2 * n);
+    c.close();
+    bytes += ss.str();
+    bytes += zstd::compress(text.substr(3 * n));
+    return bytes;
+}
+
+TEST(BlockCache, Basic)
+{
+    BlockCache cache{100};
+    size_t loads{0};
+    auto load = [&](size_t n) { return [&, n]() { ++loads; return std::string(n, 'x'); }; };
+
+    EXPECT_EQ(cache.find({1, 0}), nullptr);
+    EXPECT_EQ(cache.get({1, 0}, load(40))->size(), 40u);
+    EXPECT_EQ(cache.get({1, 0}, load(40))->size(), 40u);
+    EXPECT_EQ(loads, 1u);
+    EXPECT_NE(cache.find({1, 0}), nullptr);
+
+    // Block {1, 0} is the most recently used when {1, 80} overflows
+    // the budget, so {1, 40} is evicted.
+    cache.get({1, 40}, load(40));
+    cache.get({1, 0}, load(40));
+    auto held = cache.get({1, 80}, load(40));
+    EXPECT_EQ(cache.find({1, 40}), nullptr);
+    EXPECT_NE(cache.find({1, 0}), nullptr);
+    EXPECT_EQ(loads, 3u);
+
+    auto stats = cache.stats();
+    EXPECT_EQ(stats.misses, 3u);
+    EXPECT_EQ(stats.hits, 4u);
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(stats.blocks, 2u);
+    EXPECT_EQ(stats.bytes, 80u);
+
+    // `insert` keeps the cached block; a block over the budget is
+    // returned but not kept; evicted blocks stay valid.
+    EXPECT_EQ(cache.insert({1, 0}, "y")->size(), 40u);
+    EXPECT_EQ(*cache.insert({2, 0}, std::string(200, 'z')), std::string(200, 'z'));
+    EXPECT_EQ(cache.find({2, 0}), nullptr);
+    EXPECT_EQ(cache.stats().bytes, 0u);
+    EXPECT_EQ(held->size(), 40u);
+
+    cache.set_capacity(1000);
+    cache.insert({3, 0}, "a");
+    cache.insert({3, 1}, "b");
+    cache.insert({4, 0}, "c");
+    cache.erase(3);
+    EXPECT_EQ(cache.stats().blocks, 1u);
+    cache.clear();
+    EXPECT_EQ(cache.stats().blocks, 0u);
+    cache.reset_stats();
+    EXPECT_EQ(cache.stats().hits + cache.stats().misses, 0u);
+}
+
+TEST(BlockCache, LoadOnce)
+{
+    BlockCache cache;
+    std::atomic<size_t> loads{0};
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < 4; ++i) {
+	threads.emplace_back([&]() {
+	    auto block = cache.get({7, 7}, [&]() {
+		++loads;
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		return std::string{"block"};
+	    });
+	    EXPECT_EQ(*block, "block");
+	});
+    }
+    for (auto& thread : threads)
+	thread.join();
+    EXPECT_EQ(loads, 1u);
+    EXPECT_EQ(cache.stats().misses, 1u);
+    EXPECT_EQ(cache.stats().hits, 3u);
+
+    // A failed load is not cached.
+    auto fail = []() -> std::string { throw std::runtime_error("load"); };
+    EXPECT_THROW(cache.get({8, 0}, fail), std::runtime_error);
+    EXPECT_EQ(*cache.get({8, 0}, []() { return std::string{"ok"}; }), "ok");
+}
+
+TEST(BlockCache, FileId)
+{
+    auto a = write_file("a", "a"), b = write_file("b", "b");
+    EXPECT_EQ(BlockCache::file_id(a), BlockCache::file_id(a));
+    EXPECT_NE(BlockCache::file_id(a), BlockCache::file_id(b));
+    EXPECT_THROW(BlockCache::file_id(a + ".missing"), std::runtime_error);
+    fs::remove(a);
+    fs::remove(b);
+}
+
+TEST(FrameFile, RandomAccess)
+{
+    auto text = core::codec::corpus::log_text(100000);
+    auto path = write_file("frames", frames(text));
+    BlockCache cache;
+    zstd::FrameFile file{path, cache};
+    EXPECT_EQ(file.size(), text.size());
+    EXPECT_GT(file.frames(), 4u);
+    EXPECT_EQ(file.read(0, text.size() + 10), text);
+
+    for (size_t i = 0; i < 200; ++i) {
+	auto position = (i * 7919) % text.size();
+	EXPECT_EQ(file.read(position, 5000), text.substr(position, 5000));
+    }
+    EXPECT_EQ(file.read(text.size(), 10), "");
+    EXPECT_EQ(file.frame_at(text.size()), file.frames());
+
+    // A second reader of the file decompresses nothing.
+    auto misses = cache.stats().misses;
+    zstd::FrameFile other{path, cache};
+    EXPECT_EQ(other.read(0, text.size()), text);
+    EXPECT_EQ(cache.stats().misses, misses);
+
+    // Concurrent readers.
+    std::vector<std::thread> threads;
+    std::atomic<size_t> errors{0};
+    cache.clear();
+    for (size_t t = 0; t < 4; ++t) {
+	threads.emplace_back([&, t]() {
+	    for (size_t i = 0; i < 100; ++i) {
+		auto position = (i * 104729 + t * 13) % text.size();
+		errors += file.read(position, 1000) != text.substr(position, 1000);
+	    }
+	});
+    }
+    for (auto& thread : threads)
+	thread.join();
+    EXPECT_EQ(errors, 0u);
+    fs::remove(path);
+}
+
+TEST(FrameFile, Reader)
+{
+    auto text = core::codec::corpus::log_text(50000);
+    auto path = write_file("reader", frames(text));
+    zstd::FrameFile file{path};
+    zstd::FrameReader reader{file};
+
+    std::stringstream ss{text};
+    std::string expected, line;
+    while (std::getline(ss, expected)) {
+	ASSERT_TRUE(reader.read_line(line));
+	EXPECT_EQ(line, expected);
+    }
+    EXPECT_FALSE(reader.read_line(line));
+
+    reader.seek(12345);
+    EXPECT_EQ(reader.tell(), 12345u);
+    std::string bytes(20000, '\0');
+    EXPECT_EQ(reader.read_bytes(bytes.data(), bytes.size()), bytes.size());
+    EXPECT_EQ(bytes, text.substr(12345, 20000));
+    EXPECT_EQ(reader.tell(), 32345u);
+    fs::remove(path);
+}
+
+TEST(FrameFile, Errors)
+{
+    auto path = write_file("bad", "not a zstd file");
+    EXPECT_THROW(zstd::FrameFile{path}, zstd::error);
+    auto truncated = zstd::compress(std::string(100000, 'a') + core::codec::corpus::log_text(1000));
+    truncated.resize(truncated.size() / 2);
+    auto other = write_file("truncated", truncated);
+    EXPECT_THROW(zstd::FrameFile{other}, zstd::error);
+    EXPECT_THROW(zstd::FrameFile{path + ".missing"}, zstd::error);
+    fs::remove(path);
+    fs::remove(other);
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
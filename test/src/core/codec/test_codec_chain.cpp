@@ -0,0 +1,149 @@
+// Copyright 2022 by Mark Melton
+//
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include "core/codec/base64.h"
+#include "core/codec/chain.h"
+#include "core/codec/zstd/compress.h"
+#include "core/codec/zstd/decompress.h"
+#include "core/codec/corpus/corpus.h"
+#include "coro/stream/stream.h"
+
+using namespace core::codec;
+
+static const size_t NumberSamples = 32;
+
+// A sink recording the largest single write.
+class MaxWriteSink : public ByteSink {
+public:
+    void write(const char *, size_t count) override {
+	max_write = std::max(max_write, count);
+	total += count;
+    }
+    void close() override { closed = true; }
+
+    size_t max_write{0}, total{0};
+    bool closed{false};
+};
+
+std::string zstd_base64(std::string_view str, size_t block) {
+    std::string out;
+    StringSink sink{out};
+    Base64Sink b64{sink};
+    ZstdSink zstd{b64};
+    for (size_t i = 0; i < str.size(); i += block)
+	zstd.write(str.data() + i, std::min(block, str.size() - i));
+    zstd.close();
+    return out;
+}
+
+std::string unzstd_base64(std::string_view str) {
+    StringSource source{str};
+    Base64Source b64{source};
+    ZstdSource zstd{b64};
+    std::string out;
+    pipe(zstd, StringSink{out});
+    return out;
+}
+
+TEST(Chain, Base64)
+{
+    for (auto str : coro::str::any(0, 256) | coro::take(NumberSamples)) {
+	for (auto url : {false, true}) {
+	    std::string out;
+	    {
+		StringSink sink{out};
+		Base64Sink b64{sink, url};
+		for (char c : str)
+		    b64.write(&c, 1);
+	    }
+	    EXPECT_EQ(out, base64_encode(str, url));
+
+	    StringSource source{out};
+	    Base64Source b64{source};
+	    std::string decoded;
+	    pipe(b64, StringSink{decoded}, 7);
+	    EXPECT_EQ(decoded, str);
+	}
+    }
+}
+
+TEST(Chain, Base64LineBreaks)
+{
+    auto str = corpus::random_bytes(10000);
+    auto encoded = base64_encode_mime(str);
+    StringSource source{encoded};
+    Base64Source b64{source};
+    std::string decoded;
+    pipe(b64, StringSink{decoded});
+    EXPECT_EQ(decoded, str);
+}
+
+TEST(Chain, ZstdBase64)
+{
+    for (auto str : coro::str::any(0, 4096) | coro::take(NumberSamples)) {
+	auto out = zstd_base64(str, 100);
+	EXPECT_EQ(zstd::decompress(base64_decode(out)), str);
+	EXPECT_EQ(unzstd_base64(out), str);
+    }
+}
+
+TEST(Chain, Bzip)
+{
+    auto str = corpus::log_text(100000);
+    std::string out;
+    {
+	StringSink sink{out};
+	Base64Sink b64{sink, true};
+	BzipSink bzip{b64};
+	bzip.write(str.data(), str.size());
+	bzip.close();
+    }
+
+    StringSource source{out};
+    Base64Source b64{source};
+    BzipSource bzip{b64};
+    std::string decoded;
+    pipe(bzip, StringSink{decoded});
+    EXPECT_EQ(decoded, str);
+}
+
+TEST(Chain, Bounded)
+{
+    auto str = corpus::log_text(1 << 22);
+    MaxWriteSink sink;
+    {
+	Base64Sink b64{sink};
+	ZstdSink zstd{b64};
+	zstd.write(str.data(), str.size());
+	EXPECT_GT(sink.total, 0u);
+	zstd.close();
+    }
+    EXPECT_TRUE(sink.closed);
+    EXPECT_LE(sink.max_write, 4096u);
+}
+
+TEST(Chain, Refs)
+{
+    auto str = corpus::json_records(50000);
+    std::stringstream ss;
+    {
+	SinkRef<std::ostream> sink{ss};
+	ZstdSink zstd{sink, 9};
+	zstd.write(str.data(), str.size());
+    }
+    EXPECT_EQ(zstd::decompress(ss.str()), str);
+
+    SourceRef<std::istream> source{ss};
+    ZstdSource zstd{source};
+    std::string decoded;
+    pipe(zstd, StringSink{decoded});
+    EXPECT_EQ(decoded, str);
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
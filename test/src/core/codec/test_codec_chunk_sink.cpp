@@ -0,0 +1,153 @@
+// Copyright 2022 by Mark Melton
+//
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include "core/codec/util/chunk_sink.h"
+#include "core/codec/corpus/corpus.h"
+#include "core/codec/zstd/adapter.h"
+#include "core/codec/zstd/compress.h"
+#include "core/codec/zstd/compressor.h"
+#include "core/codec/zstd/decompress.h"
+#include "core/codec/zstd/decompressor.h"
+
+using core::codec::ChunkSink;
+namespace corpus = core::codec::corpus;
+
+class CountingAllocator : public core::Allocator {
+public:
+    void *allocate(size_t n) override {
+	++allocations;
+	return core::malloc_allocator().allocate(n);
+    }
+
+    void deallocate(void *ptr) override {
+	if (ptr)
+	    ++deallocations;
+	core::malloc_allocator().deallocate(ptr);
+    }
+
+    size_t allocations{0}, deallocations{0};
+};
+
+TEST(ChunkSink, Write)
+{
+    auto str = corpus::log_text(100000);
+    for (auto block_size : { 1, 7, 4096, 1 << 20 }) {
+	ChunkSink sink{size_t(block_size)};
+	for (size_t i = 0; i < str.size(); i += 333)
+	    sink.write(str.data() + i, std::min<size_t>(333, str.size() - i));
+	EXPECT_EQ(sink.size(), str.size());
+	EXPECT_EQ(sink.blocks(), (str.size() + block_size - 1) / block_size);
+	EXPECT_EQ(sink.str(), str);
+
+	std::string joined;
+	sink.for_each([&](std::string_view b) { joined.append(b); });
+	EXPECT_EQ(joined, str);
+
+	size_t total{0};
+	for (const auto& v : sink.iovecs())
+	    total += v.iov_len;
+	EXPECT_EQ(total, str.size());
+
+	std::string part(1000, '\0');
+	sink.copy(5000, part.data(), part.size());
+	EXPECT_EQ(part, str.substr(5000, 1000));
+	EXPECT_THROW(sink.copy(str.size() - 10, part.data(), 11), std::out_of_range);
+
+	EXPECT_EQ(sink.take(), str);
+	EXPECT_TRUE(sink.empty());
+	EXPECT_EQ(sink.blocks(), 0u);
+    }
+    EXPECT_THROW(ChunkSink{0}, std::invalid_argument);
+}
+
+TEST(ChunkSink, PrepareCommit)
+{
+    ChunkSink sink{16};
+    auto area = sink.prepare();
+    EXPECT_EQ(area.size(), 16u);
+    memcpy(area.data(), "abcde", 5);
+    sink.commit(5);
+    EXPECT_EQ(sink.prepare().size(), 11u);
+    EXPECT_THROW(sink.commit(12), std::out_of_range);
+    sink.commit(0);
+    sink.write("0123456789abcdef");
+    EXPECT_EQ(sink.str(), "abcde0123456789abcdef");
+    EXPECT_EQ(sink.blocks(), 2u);
+    EXPECT_EQ(sink.block(1), "bcdef");
+}
+
+TEST(ChunkSink, Allocator)
+{
+    CountingAllocator alloc;
+    {
+	ChunkSink sink{1024, &alloc};
+	sink.write(std::string(10000, 'x'));
+	EXPECT_EQ(alloc.allocations, 10u);
+
+	ChunkSink moved{std::move(sink)};
+	EXPECT_TRUE(sink.empty());
+	EXPECT_EQ(moved.size(), 10000u);
+	moved.take();
+	EXPECT_EQ(alloc.deallocations, 10u);
+	moved.write("abc");
+    }
+    EXPECT_EQ(alloc.allocations, alloc.deallocations);
+}
+
+TEST(ChunkSink, WriteTo)
+{
+    auto str = corpus::log_text(1 << 20);
+    ChunkSink sink{100};
+    sink.write(str);
+
+    char path[] = "/tmp/test_chunk_sink.XXXXXX";
+    auto fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    sink.write_to(fd);
+    close(fd);
+
+    std::ifstream ifs{path, std::ios::binary};
+    std::string contents{std::istreambuf_iterator<char>{ifs}, std::istreambuf_iterator<char>{}};
+    EXPECT_EQ(contents, str);
+    std::remove(path);
+
+    EXPECT_THROW(sink.write_to(-1), std::system_error);
+}
+
+TEST(ChunkSink, Zstd)
+{
+    auto str = corpus::log_text(1 << 20);
+
+    // As the sink of a compressor.
+    ChunkSink zsink;
+    zstd::Compressor c{zsink};
+    c.write(str.data(), str.size());
+    c.close();
+    auto zdata = zsink.str();
+    EXPECT_EQ(zstd::decompress(zdata), str);
+
+    // As the sink of the stream decompressor.
+    std::stringstream ss{zdata};
+    ChunkSink sink;
+    zstd::decompress(ss, sink);
+    EXPECT_EQ(sink.str(), str);
+
+    // In place, of frames of known and unknown size.
+    auto known = zstd::compress(str);
+    EXPECT_EQ(zstd::decompress_chunks(known).str(), str);
+    EXPECT_EQ(zstd::decompress_chunks(zdata + known).str(), str + str);
+    EXPECT_EQ(zstd::decompress(zdata + known), str + str);
+    EXPECT_THROW(zstd::decompress_chunks(zdata.substr(0, zdata.size() - 1)), zstd::error);
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
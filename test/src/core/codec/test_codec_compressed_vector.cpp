@@ -0,0 +1,134 @@
+// Copyright 2022 by Mark Melton
+//
+
+#include <gtest/gtest.h>
+#include <numeric>
+#include <thread>
+#include "core/codec/compressed_vector.h"
+#include "core/codec/corpus/corpus.h"
+#include "core/codec/zstd/exception.h"
+
+namespace corpus = core::codec::corpus;
+using core::codec::compressed_vector;
+using core::codec::CompressedVectorOptions;
+
+TEST(CompressedVector, Access)
+{
+    auto values = corpus::timestamps(10000);
+    for (auto chunk : {1ul, 7ul, 1000ul, 1ul << 14}) {
+	CompressedVectorOptions options;
+	options.chunk = chunk;
+	options.cache = 2;
+	compressed_vector<int64_t> vec{values, options};
+	EXPECT_EQ(vec.size(), values.size());
+
+	// Sequential, strided and random access.
+	for (size_t i = 0; i < values.size(); i += 3)
+	    EXPECT_EQ(vec[i], values[i]);
+	for (size_t i = 0; i < 1000; ++i) {
+	    auto j = (i * 7919) % values.size();
+	    EXPECT_EQ(vec[j], values[j]);
+	}
+	EXPECT_EQ(vec.front(), values.front());
+	EXPECT_EQ(vec.back(), values.back());
+	EXPECT_THROW(vec.at(values.size()), std::out_of_range);
+
+	EXPECT_TRUE(std::equal(vec.begin(), vec.end(), values.begin(), values.end()));
+	EXPECT_EQ(vec.to_vector(), values);
+	std::vector<int64_t> part(3000);
+	vec.copy(4321, 7321, part.data());
+	EXPECT_TRUE(std::equal(part.begin(), part.end(), values.begin() + 4321));
+    }
+}
+
+TEST(CompressedVector, Compression)
+{
+    // A timestamp series takes under a third of its size.
+    auto values = corpus::timestamps(1 << 18);
+    compressed_vector<int64_t> vec{values, {4096, 4, 1, shuffle::Options::time_series()}};
+    EXPECT_LT(vec.storage_size() * 3, values.size() * sizeof(int64_t));
+    EXPECT_EQ(vec.to_vector(), values);
+
+    // Without a pre-filter and with an uncached chunk.
+    auto floats = corpus::floats(5000);
+    compressed_vector<double> f{floats, {512, 0, 3, std::nullopt}};
+    for (size_t i = 0; i < floats.size(); ++i)
+	EXPECT_EQ(f[i], floats[i]);
+}
+
+TEST(CompressedVector, Errors)
+{
+    // A corrupt or mis-sized chunk throws with the reason formatted
+    // into the message.
+    core::codec::ChunkCodec codec{sizeof(int64_t), {}};
+    std::string out(160, '\0');
+    try {
+	codec.decompress("not a zstd frame", out.data(), out.size());
+	FAIL();
+    } catch (const zstd::error& e) {
+	EXPECT_EQ(std::string{e.what()}, std::string{"zstd:compressed_vector: "}
+		  + ZSTD_getErrorName(ZSTD_decompress(nullptr, 0, "not a zstd frame", 16)));
+    }
+
+    auto chunk = codec.compress(out.data(), 80);
+    try {
+	codec.decompress(chunk, out.data(), out.size());
+	FAIL();
+    } catch (const zstd::error& e) {
+	EXPECT_STREQ(e.what(), "zstd:compressed_vector: chunk of 80 bytes instead of 160");
+    }
+}
+
+TEST(CompressedVector, PushBack)
+{
+    std::vector<uint32_t> values(2500);
+    std::iota(values.begin(), values.end(), 7);
+    CompressedVectorOptions options;
+    options.chunk = 1000;
+
+    compressed_vector<uint32_t> vec{options};
+    EXPECT_TRUE(vec.empty());
+    for (size_t i = 0; i < 1500; ++i)
+	vec.push_back(values[i]);
+    EXPECT_EQ(vec[999], values[999]);
+    EXPECT_EQ(vec[1499], values[1499]);
+
+    // Reopen the partial chunk compressed by `shrink_to_fit`.
+    vec.shrink_to_fit();
+    EXPECT_EQ(vec[1200], values[1200]);
+    for (size_t i = 1500; i < values.size(); ++i)
+	vec.push_back(values[i]);
+    EXPECT_EQ(vec.size(), values.size());
+    EXPECT_EQ(vec.to_vector(), values);
+    EXPECT_TRUE(std::equal(vec.begin(), vec.end(), values.begin(), values.end()));
+
+    compressed_vector<uint32_t> from{std::span{values}.first(1500), options};
+    for (size_t i = 1500; i < values.size(); ++i)
+	from.push_back(values[i]);
+    EXPECT_EQ(from.to_vector(), values);
+}
+
+TEST(CompressedVector, Concurrent)
+{
+    auto values = corpus::sorted_ints(100000);
+    compressed_vector<int64_t> vec{values, {1024, 3, 1, shuffle::Options{}, 4}};
+    std::vector<std::thread> threads;
+    std::atomic<size_t> errors{0};
+    for (size_t t = 0; t < 4; ++t) {
+	threads.emplace_back([&, t]() {
+	    for (size_t i = 0; i < 20000; ++i) {
+		auto j = (i * 104729 + t * 7) % values.size();
+		errors += vec[j] != values[j];
+	    }
+	});
+    }
+    for (auto& thread : threads)
+	thread.join();
+    EXPECT_EQ(errors, 0u);
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
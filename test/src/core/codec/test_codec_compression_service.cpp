@@ -0,0 +1,109 @@
+// Copyright 2022 by Mark Melton
+//
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include "core/codec/corpus/corpus.h"
+#include "core/codec/zstd/compress.h"
+#include "core/codec/zstd/compression_service.h"
+#include "core/codec/zstd/decompress.h"
+
+namespace corpus = core::codec::corpus;
+
+TEST(CompressionService, Futures)
+{
+    zstd::CompressionService service{{.threads = 3}};
+    EXPECT_EQ(service.size(), 3u);
+
+    std::vector<std::string> inputs;
+    std::vector<std::future<std::string>> futures;
+    for (size_t i = 0; i < 500; ++i) {
+	inputs.push_back(corpus::log_text(100 + 13 * i, i));
+	futures.push_back(service.compress(inputs.back(), i % 2 ? 1 : 9));
+    }
+    futures.push_back(service.compress(std::string{}));
+
+    for (size_t i = 0; i < inputs.size(); ++i)
+	EXPECT_EQ(zstd::decompress(futures[i].get()), inputs[i]);
+    EXPECT_EQ(zstd::decompress(futures.back().get()), "");
+
+    service.drain();
+    auto stats = service.stats();
+    EXPECT_EQ(stats.submitted, 501u);
+    EXPECT_EQ(stats.completed, 501u);
+    EXPECT_EQ(stats.jobs, 501u);
+    EXPECT_EQ(stats.failed, 0u);
+    EXPECT_EQ(stats.split, 0u);
+    EXPECT_EQ(stats.queue_depth, 0u);
+    EXPECT_GT(stats.max_queue_depth, 0u);
+    EXPECT_GT(stats.bytes_in, stats.bytes_out);
+    EXPECT_GT(stats.latency_max_ns, 0u);
+    EXPECT_LE(stats.latency_p50_ns, stats.latency_p90_ns);
+    EXPECT_LE(stats.latency_p90_ns, stats.latency_p99_ns);
+    EXPECT_LE(stats.latency_p99_ns, stats.latency_max_ns);
+}
+
+TEST(CompressionService, Callbacks)
+{
+    zstd::CompressionService service{{.threads = 2}};
+    auto input = corpus::log_text(5000);
+    auto expected = zstd::compress(input);
+
+    std::atomic<size_t> count{0};
+    std::atomic<size_t> bad{0};
+    for (size_t i = 0; i < 1000; ++i)
+	service.compress(input, [&](std::string zstr, std::exception_ptr error) {
+	    if (error or zstr != expected)
+		++bad;
+	    ++count;
+	});
+    service.drain();
+    EXPECT_EQ(count, 1000u);
+    EXPECT_EQ(bad, 0u);
+}
+
+TEST(CompressionService, Split)
+{
+    // A large input is compressed as one frame per part, which
+    // decompress as the whole input.
+    zstd::CompressionService service{{.threads = 2, .split_size = 64 << 10}};
+    auto input = corpus::log_text(1 << 20);
+    auto zstr = service.compress(input).get();
+    EXPECT_EQ(zstd::decompress(zstr), input);
+
+    // The result holds the compressed bytes only, not their bound.
+    EXPECT_LT(zstr.capacity(), zstr.size() + 64);
+
+    auto stats = service.stats();
+    EXPECT_EQ(stats.split, 1u);
+    EXPECT_EQ(stats.completed, 1u);
+    EXPECT_EQ(stats.jobs, (input.size() + (64 << 10) - 1) / (64 << 10));
+}
+
+TEST(CompressionService, Steal)
+{
+    // The parts of an input submitted by a callback are queued on the
+    // worker of the callback, which then waits for them, so the other
+    // worker must steal every part. The outer input itself may be
+    // stolen too, depending on which worker wakes first.
+    zstd::CompressionService service{{.threads = 2, .split_size = 16 << 10}};
+    auto input = corpus::log_text(256 << 10);
+    std::string inner;
+    service.compress("outer", [&](std::string, std::exception_ptr) {
+	inner = service.compress(input).get();
+    });
+    service.drain();
+    EXPECT_EQ(zstd::decompress(inner), input);
+
+    auto stats = service.stats();
+    EXPECT_EQ(stats.completed, 2u);
+    EXPECT_EQ(stats.jobs, 17u);
+    EXPECT_GE(stats.steals, 16u);
+    EXPECT_LE(stats.steals, 17u);
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,91 @@
+// Copyright 2022 by Mark Melton
+//
+
+#include <gtest/gtest.h>
+#include "core/codec/corpus/corpus.h"
+#include "core/codec/zstd/compress.h"
+
+namespace corpus = core::codec::corpus;
+
+TEST(Corpus, Size)
+{
+    for (auto kind : corpus::Kinds)
+	for (auto size : { 0, 1, 7, 8, 4095, 100000 })
+	    EXPECT_EQ(corpus::generate(kind, size).size(), size_t(size));
+}
+
+TEST(Corpus, Deterministic)
+{
+    for (auto kind : corpus::Kinds) {
+	EXPECT_EQ(corpus::generate(kind, 10000, 1), corpus::generate(kind, 10000, 1));
+	EXPECT_NE(corpus::generate(kind, 10000, 1), corpus::generate(kind, 10000, 2));
+
+	auto prefix = corpus::generate(kind, 1000, 3);
+	EXPECT_EQ(corpus::generate(kind, 5000, 3).substr(0, 1000), prefix);
+    }
+}
+
+// The checksums are part of the contract: benchmark results are only
+// comparable across machines and commits if these never change.
+TEST(Corpus, Checksums)
+{
+    EXPECT_EQ(corpus::checksum(corpus::Kind::Log, 1000), 0xfb2c66213f6bfbdbu);
+    EXPECT_EQ(corpus::checksum(corpus::Kind::Json, 1000), 0x883c3ee2b08f267eu);
+    EXPECT_EQ(corpus::checksum(corpus::Kind::SortedInts, 1000), 0x8a82053f026520fcu);
+    EXPECT_EQ(corpus::checksum(corpus::Kind::Floats, 1000), 0x5cde262004b517b5u);
+    EXPECT_EQ(corpus::checksum(corpus::Kind::Timestamps, 1000), 0x7e6b3dd8fa775367u);
+    EXPECT_EQ(corpus::checksum(corpus::Kind::Random, 1000), 0x4747f9954916cab5u);
+    EXPECT_EQ(corpus::checksum(corpus::Kind::Repetitive, 1000), 0x68cc21794e73cad8u);
+
+    EXPECT_EQ(corpus::checksum(corpus::Kind::Log, 1 << 20, 42), 0x62d4acecbe3c731fu);
+    EXPECT_EQ(corpus::checksum(corpus::Kind::Json, 1 << 20, 42), 0x7683a1c0ce3afb9bu);
+    EXPECT_EQ(corpus::checksum(corpus::Kind::SortedInts, 1 << 20, 42), 0x9de767ffe73b555fu);
+    EXPECT_EQ(corpus::checksum(corpus::Kind::Floats, 1 << 20, 42), 0xdee1f7ef73cd5748u);
+    EXPECT_EQ(corpus::checksum(corpus::Kind::Timestamps, 1 << 20, 42), 0x445f1814404636dfu);
+    EXPECT_EQ(corpus::checksum(corpus::Kind::Random, 1 << 20, 42), 0xe5d2ee95ab2a6e4bu);
+    EXPECT_EQ(corpus::checksum(corpus::Kind::Repetitive, 1 << 20, 42), 0x1dd4132b836ade86u);
+}
+
+TEST(Corpus, Shape)
+{
+    auto ints = corpus::sorted_ints(10000, 5);
+    EXPECT_TRUE(std::is_sorted(ints.begin(), ints.end()));
+
+    auto stamps = corpus::timestamps(10000, 5);
+    EXPECT_TRUE(std::is_sorted(stamps.begin(), stamps.end()));
+
+    for (auto x : corpus::floats(10000, 5))
+	EXPECT_GT(x, 0.0);
+
+    auto text = corpus::log_text(10000, 5);
+    EXPECT_EQ(text.find('\0'), std::string::npos);
+    EXPECT_EQ(text.substr(0, 11), "2022-03-14T");
+
+    auto json = corpus::json_records(10000, 5);
+    EXPECT_EQ(json.substr(0, 7), "{\"id\":1");
+}
+
+TEST(Corpus, Compressibility)
+{
+    const size_t size = 1 << 18;
+    auto ratio = [](const std::string& data) {
+	return double(data.size()) / zstd::compress(data).size();
+    };
+    EXPECT_LT(ratio(corpus::random_bytes(size)), 1.01);
+    EXPECT_GT(ratio(corpus::repetitive(size)), 20.0);
+    EXPECT_GT(ratio(corpus::log_text(size)), 2.0);
+    EXPECT_GT(ratio(corpus::json_records(size)), 2.0);
+}
+
+TEST(Corpus, Names)
+{
+    for (auto kind : corpus::Kinds)
+	EXPECT_EQ(corpus::parse_kind(corpus::name(kind)), kind);
+    EXPECT_THROW(corpus::parse_kind("nope"), std::runtime_error);
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
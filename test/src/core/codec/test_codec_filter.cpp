@@ -5,6 +5,10 @@
 #include <sstream>
 #include "core/codec/filter.h"
 #include "core/codec/filter_comments.h"
+#include "core/codec/parallel_filter.h"
+#include "core/codec/util/thread_pool.h"
+#include "core/codec/zstd/compress.h"
+#include "core/codec/zstd/decompressor.h"
 #include "coro/stream/stream.h"
 
 static const int NumberSamples = 64;
@@ -38,6 +42,94 @@ TEST(Codex, Filter)
     }
 }
 
+TEST(Codex, FilterBlocks)
+{
+    // Lines shorter and longer than the block, with and without a
+    // final newline.
+    std::string lines, expected;
+    for (auto str : coro::str::alpha(0, 40) | coro::take(200)) {
+	str += '\n';
+	lines += str;
+	if (str.size() % 3 != 0)
+	    expected += str;
+    }
+    auto accept = [](std::string_view s) { return s.size() % 3 != 0; };
+    for (auto tail : {"", "no newline"}) {
+	auto input = lines + tail;
+	auto output = expected + (std::string_view{tail}.size() % 3 != 0 ? tail : "");
+	for (auto n : {1ul, 7ul, 64ul, 0ul}) {
+	    std::stringstream ss{input};
+	    core::filter_istream fin(ss, accept, n);
+	    std::string str{std::istreambuf_iterator<char>(fin), {}};
+	    EXPECT_EQ(str, output) << n;
+	}
+    }
+
+    // A source that is not a std::istream.
+    std::stringstream compressed{zstd::compress(lines)};
+    zstd::Decompressor d{compressed};
+    core::filter_istream fin(d, accept, 100);
+    std::string str{std::istreambuf_iterator<char>(fin), {}};
+    EXPECT_EQ(str, expected);
+}
+
+TEST(Codex, ParallelFilter)
+{
+    std::string lines, expected;
+    for (auto str : coro::str::alpha(0, 100) | coro::take(5000)) {
+	str += '\n';
+	lines += str;
+	if (str.size() % 3 != 0)
+	    expected += str;
+    }
+    auto accept = [](std::string_view s) { return s.size() % 3 != 0; };
+    for (auto tail : {"", "no newline"}) {
+	auto input = lines + tail;
+	auto output = expected + (std::string_view{tail}.size() % 3 != 0 ? tail : "");
+	for (auto [threads, chunk, window] : {std::tuple{1ul, 1ul, 2ul}, std::tuple{4ul, 7ul, 3ul},
+					      std::tuple{3ul, 4096ul, 0ul}, std::tuple{0ul, 0ul, 0ul}}) {
+	    std::stringstream ss{input};
+	    core::parallel_filter_istream fin(ss, accept, {threads, chunk, window});
+	    std::string str{std::istreambuf_iterator<char>(fin), {}};
+	    EXPECT_EQ(str, output) << threads << " " << chunk << " " << window;
+	}
+    }
+
+    // An editing filter, a compressed source and early destruction.
+    auto cpp = core::CommentSyntax::cpp();
+    std::stringstream compressed{zstd::compress(lines + "a // b\n")};
+    zstd::Decompressor d{compressed};
+    core::parallel_filter_istream fin(d, core::CommentFilter{cpp}, {2, 1000, 4});
+    std::string str{std::istreambuf_iterator<char>(fin), {}};
+    EXPECT_EQ(str, lines + "a\n");
+
+    std::stringstream ss{lines};
+    core::parallel_filter_istream partial(ss, accept, {2, 100, 2});
+    std::string line;
+    EXPECT_TRUE(std::getline(partial, line));
+
+    // The workers return to the pool while the consumer pauses.
+    auto& pool = core::codec::ThreadPool::global();
+    pool.resize(2);
+    std::stringstream paused_source{lines};
+    core::parallel_filter_istream paused(paused_source, accept, {2, 100, 4});
+    EXPECT_TRUE(std::getline(paused, line));
+    auto task = pool.async([]() { return 1; });
+    ASSERT_EQ(task.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    std::string rest{std::istreambuf_iterator<char>(paused), {}};
+    EXPECT_EQ(line + "\n" + rest, expected);
+
+    // An exception thrown by the filter.
+    std::stringstream bad{lines};
+    core::parallel_filter_istream fbad(bad, [](std::string_view s) -> bool {
+	if (s.size() > 90)
+	    throw std::runtime_error("too long");
+	return true;
+    }, {2, 256, 2});
+    fbad.exceptions(std::ios::badbit);
+    EXPECT_THROW(std::string(std::istreambuf_iterator<char>(fbad), {}), std::runtime_error);
+}
+
 size_t count_lines(const std::string& str) {
     std::stringstream ss{str};
     auto sin = core::filter_comments(ss);
@@ -110,6 +202,80 @@ TEST(CodexFilter, CommentsCommentNewline)
 }
 
 
+// Return `str` filtered by `filter_comments` with `syntax` in blocks
+// of `n` characters.
+std::string strip(const std::string& str, core::CommentSyntax syntax, size_t n = 0) {
+    std::stringstream ss{str};
+    auto fin = core::filter_comments(ss, std::move(syntax), n);
+    return std::string{std::istreambuf_iterator<char>(fin), {}};
+}
+
+TEST(CodexFilter, CommentsLeading)
+{
+    // By default, only lines starting with "//" are dropped.
+    auto str = "a\n  // b\n\t//\nc // d\n\n\"//\"\n/* e */\n";
+    EXPECT_EQ(strip(str, {}), "a\nc // d\n\n\"//\"\n/* e */\n");
+    EXPECT_EQ(strip("# a\r\nb\r\n# c", {{"#"}}), "b\r\n");
+}
+
+TEST(CodexFilter, CommentsTrailing)
+{
+    auto cpp = core::CommentSyntax::cpp();
+    EXPECT_EQ(strip("a = 1; // one\n", cpp), "a = 1;\n");
+    EXPECT_EQ(strip("s = \"// not\"; // yes\n", cpp), "s = \"// not\";\n");
+    EXPECT_EQ(strip("s = \"\\\" // not\"\n", cpp), "s = \"\\\" // not\"\n");
+    EXPECT_EQ(strip("c = '/'; /* x */ d\n", cpp), "c = '/';  d\n");
+    EXPECT_EQ(strip("a / b /c\r\n", cpp), "a / b /c\r\n");
+
+    auto shell = core::CommentSyntax::shell();
+    EXPECT_EQ(strip("# header\nkey = value  # note\necho '#'\n", shell), "key = value\necho '#'\n");
+
+    auto sql = core::CommentSyntax::sql();
+    EXPECT_EQ(strip("select 'it''s -- no' -- yes\nfrom t; -- x\n--\n", sql),
+	      "select 'it''s -- no'\nfrom t;\n");
+    EXPECT_EQ(strip("x = 1 - -1\n", sql), "x = 1 - -1\n");
+}
+
+TEST(CodexFilter, CommentsBlock)
+{
+    auto cpp = core::CommentSyntax::cpp();
+    auto str = "a /* b\n c\n\n d */ e\n/*\n*/\nf /**/ /* g */ // h\n  /* i */  \nj\n";
+    auto expected = "a\n e\nf\nj\n";
+    for (auto n : {1ul, 5ul, 16ul, 0ul})
+	EXPECT_EQ(strip(str, cpp, n), expected) << n;
+
+    core::CommentFilter filter{cpp};
+    std::string out(16, '\0');
+    EXPECT_EQ(filter("x /* y\n", out.data()), 2u);
+    EXPECT_TRUE(filter.in_block());
+    EXPECT_EQ(filter("z\n", out.data()), 0u);
+    EXPECT_EQ(filter("*/ w", out.data()), 2u);
+    EXPECT_FALSE(filter.in_block());
+}
+
+TEST(CodexFilter, CommentsLarge)
+{
+    // Many blocks of commented lines and a compressed source.
+    std::string str, expected;
+    size_t i{0};
+    for (auto line : coro::str::alpha(0, 60) | coro::take(5000)) {
+	switch (i++ % 4) {
+	case 0: str += "  // " + line + "\n"; break;
+	case 1: str += "x" + line + " /* " + line + "\n" + line + " */\n"; expected += "x" + line + "\n"; break;
+	case 2: str += "\"" + line + "//\" // " + line + "\n"; expected += "\"" + line + "//\"\n"; break;
+	default: str += line + "\n"; expected += line + "\n";
+	}
+    }
+    auto cpp = core::CommentSyntax::cpp();
+    EXPECT_EQ(strip(str, cpp), expected);
+
+    std::stringstream compressed{zstd::compress(str)};
+    zstd::Decompressor d{compressed};
+    auto fin = core::filter_comments(d, cpp);
+    EXPECT_EQ(std::string(std::istreambuf_iterator<char>(fin), {}), expected);
+}
+
+
 int main(int argc, char *argv[])
 {
     ::testing::InitGoogleTest(&argc, argv);
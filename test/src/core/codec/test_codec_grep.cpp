@@ -0,0 +1,205 @@
+// Copyright 2022 by Mark Melton
+//
+
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <regex>
+#include <thread>
+#include "core/codec/grep.h"
+#include "core/codec/util/thread_pool.h"
+#include "core/codec/zstd/compress.h"
+#include "core/codec/zstd/compressor.h"
+#include "core/codec/corpus/corpus.h"
+
+namespace fs = std::filesystem;
+
+struct Found {
+    uint64_t line, position;
+    std::string text;
+    bool operator==(const Found&) const = default;
+};
+
+// Return the lines of `text` matching `re`, one at a time.
+static std::vector<Found> reference(std::string_view text, const std::regex& re) {
+    std::vector<Found> found;
+    uint64_t line{0}, pos{0};
+    while (pos < text.size()) {
+	auto end = std::min(text.find('\n', pos), text.size());
+	auto str = std::string{text.substr(pos, end - pos)};
+	if (std::regex_search(str, re))
+	    found.push_back({line, pos, str});
+	pos = end + 1;
+	++line;
+    }
+    return found;
+}
+
+static grep::OnMatch collect(std::vector<Found>& found) {
+    return [&](const grep::Match& m) { found.push_back({m.line, m.position, std::string{m.text}}); };
+}
+
+static const char *Patterns[] = {
+    "error", "ERROR|WARN", "user=[0-9]+", "GET /api/v[0-9]", "req.*ms$", "^$", "[aeiou]{4}", "zzzz",
+    "\\x45RROR", "\\u0057ARN", "\\d\\x20ms", "shard=\\cJ?3",
+};
+
+TEST(Grep, Literals)
+{
+    using grep::Matcher;
+    EXPECT_EQ(Matcher{"error"}.literals(), std::vector<std::string>{"error"});
+    EXPECT_FALSE(Matcher{"error"}.uses_regex());
+    EXPECT_EQ(Matcher{"foo|bar"}.literals(), (std::vector<std::string>{"foo", "bar"}));
+    EXPECT_EQ(Matcher{"a\\.b"}.literals(), std::vector<std::string>{"a.b"});
+    EXPECT_FALSE(Matcher{"a\\.b"}.uses_regex());
+    EXPECT_EQ((Matcher{"a.b", true}.literals()), std::vector<std::string>{"a.b"});
+
+    EXPECT_EQ(Matcher{"ab.*cde"}.literals(), std::vector<std::string>{"cde"});
+    EXPECT_TRUE(Matcher{"ab.*cde"}.uses_regex());
+    EXPECT_EQ(Matcher{"\\d+ms"}.literals(), std::vector<std::string>{"ms"});
+    EXPECT_EQ(Matcher{"xyz?w"}.literals(), std::vector<std::string>{"xy"});
+    EXPECT_EQ(Matcher{"[abc]def(gh|ij)"}.literals(), std::vector<std::string>{"def"});
+    EXPECT_TRUE(Matcher{"(foo|bar)"}.literals().empty());
+    EXPECT_TRUE(Matcher{"a|b.c"}.literals().empty());
+    EXPECT_EQ(Matcher{"\\x41bc"}.literals(), std::vector<std::string>{"bc"});
+    EXPECT_EQ(Matcher{"ab\\u0041"}.literals(), std::vector<std::string>{"ab"});
+    EXPECT_TRUE(Matcher{"\\x41"}.match("A"));
+
+    Matcher m{"user=[0-9]+"};
+    EXPECT_TRUE(m.match("x user=12 y"));
+    EXPECT_FALSE(m.match("x user=y"));
+    std::string_view text = "a\nuser=1\nb\nuser=\nuser=2";
+    EXPECT_EQ(m.find(text), 2u);
+    EXPECT_EQ(m.find(text, 9), 17u);
+    EXPECT_EQ(m.find(text, 18), std::string_view::npos);
+    EXPECT_TRUE(Matcher{""}.match("anything"));
+}
+
+TEST(Grep, Kernels)
+{
+    auto data = core::codec::corpus::random_bytes(100000);
+    for (auto& c : data)
+	c = 'a' + (unsigned char)c % 8;
+    grep::LiteralSet one{{"abcd"}}, many{{"hhh", "gfe", "ccccc", "b"}}, none{{"zz"}};
+    const auto& scalar = grep::kernels(grep::Isa::Scalar);
+    for (auto isa : grep::Isas) {
+	if (not grep::supported(isa))
+	    continue;
+	const auto& k = grep::kernels(isa);
+	for (size_t i = 0; i < 2000; i += 37) {
+	    auto n = data.size() - i * 40;
+	    auto p = data.data() + i * 40;
+	    EXPECT_EQ(k.find(p, n, one), scalar.find(p, n, one)) << grep::name(isa);
+	    EXPECT_EQ(k.find(p, n, many), scalar.find(p, n, many)) << grep::name(isa);
+	    EXPECT_EQ(k.count(p, n, 'c'), scalar.count(p, n, 'c')) << grep::name(isa);
+	}
+	EXPECT_EQ(k.find(data.data(), data.size(), none), data.size()) << grep::name(isa);
+	EXPECT_EQ(k.find("xxab", 4, many), 3u) << grep::name(isa);
+    }
+}
+
+TEST(Grep, Text)
+{
+    auto text = core::codec::corpus::log_text(300000) + "\n\nlast error without newline";
+    for (auto pattern : Patterns) {
+	auto expected = reference(text, std::regex{pattern});
+	for (size_t chunk : {7ul, 1000ul, 1ul << 20}) {
+	    std::vector<Found> found;
+	    auto count = grep::search(text, grep::Matcher{pattern}, collect(found), {3, chunk});
+	    EXPECT_EQ(count, expected.size()) << pattern << " " << chunk;
+	    EXPECT_EQ(found, expected) << pattern << " " << chunk;
+	}
+    }
+
+    // Stop after `max_count` lines.
+    std::vector<Found> found;
+    auto expected = reference(text, std::regex{"ERROR"});
+    ASSERT_GT(expected.size(), 10u);
+    grep::Options options;
+    options.chunk = 4096;
+    options.max_count = 10;
+    EXPECT_EQ(grep::search(text, grep::Matcher{"ERROR"}, collect(found), options), 10u);
+    EXPECT_EQ(found, std::vector<Found>(expected.begin(), expected.begin() + 10));
+}
+
+TEST(Grep, Files)
+{
+    auto text = core::codec::corpus::log_text(500000);
+    auto base = fs::temp_directory_path() / fmt::format("grep.{}", getpid());
+    auto frames = base.string() + ".frames.zst", single = base.string() + ".zst", plain = base.string() + ".txt";
+    {
+	std::ofstream os{frames, std::ios::binary};
+	zstd::Compressor c{os};
+	c.set_adaptive({.min_level = 1, .max_level = 1, .frame_size = 30000});
+	c.write(text.data(), text.size());
+    }
+    std::ofstream{single, std::ios::binary} << zstd::compress(text);
+    std::ofstream{plain, std::ios::binary} << text;
+
+    for (auto pattern : Patterns) {
+	auto expected = reference(text, std::regex{pattern});
+	for (const auto& path : {frames, single, plain}) {
+	    std::vector<Found> found;
+	    grep::search_file(path, grep::Matcher{pattern}, collect(found), {2, 10000});
+	    EXPECT_EQ(found, expected) << pattern << " " << path;
+	}
+    }
+
+    std::vector<Found> found;
+    grep::Matcher any{std::vector<std::string>{"user=17", "user=42"}};
+    grep::search_file(frames, any, collect(found));
+    EXPECT_EQ(found, reference(text, std::regex{"user=17|user=42"}));
+    EXPECT_THROW(grep::search_file(plain + ".missing", any, collect(found)), std::runtime_error);
+
+    fs::remove(frames);
+    fs::remove(single);
+    fs::remove(plain);
+}
+
+TEST(Grep, ReadError)
+{
+    // A failed read is rethrown by the search, whichever thread waits
+    // for the turn of the next read.
+    auto text = core::codec::corpus::log_text(1000);
+    for (size_t trial = 0; trial < 50; ++trial) {
+	size_t calls{0}, pos{0};
+	auto read = [&](char *ptr, size_t count) -> size_t {
+	    if (++calls == 3) {
+		// Let another thread claim the next chunk meanwhile.
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		throw std::runtime_error("read");
+	    }
+	    auto n = std::min(count, text.size() - pos);
+	    memcpy(ptr, text.data() + pos, n);
+	    pos += n;
+	    return n;
+	};
+	std::vector<Found> found;
+	EXPECT_THROW(grep::search_reader(read, grep::Matcher{"ERROR"}, collect(found), {3, 8}),
+		     std::runtime_error);
+    }
+}
+
+TEST(Grep, Paused)
+{
+    // The helper returns to the pool, of a single worker, while the
+    // caller is held up in the callback.
+    auto& pool = core::codec::ThreadPool::global();
+    pool.resize(1);
+    auto text = core::codec::corpus::log_text(100000);
+    bool ready{false};
+    auto count = grep::search(text, grep::Matcher{"ERROR"}, [&](const grep::Match&) {
+	if (not ready) {
+	    auto task = pool.async([]() { return 1; });
+	    ready = task.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+	}
+    }, {2, 1000, 4});
+    EXPECT_EQ(count, reference(text, std::regex{"ERROR"}).size());
+    EXPECT_TRUE(ready);
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
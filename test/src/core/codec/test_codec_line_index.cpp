@@ -0,0 +1,182 @@
+// Copyright 2022 by Mark Melton
+//
+
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include "core/codec/util/block_cache.h"
+#include "core/codec/zstd/compressor.h"
+#include "core/codec/zstd/decompress.h"
+#include "core/codec/zstd/line_index.h"
+#include "core/codec/corpus/corpus.h"
+
+namespace fs = std::filesystem;
+using zstd::LineIndex;
+
+// Return the path of a temporary file holding `text` compressed as
+// frames of `frame_size` bytes.
+static std::string write_file(const std::string& name, const std::string& text, size_t frame_size) {
+    auto path = fs::temp_directory_path() / fmt::format("line_index.{}.{}", getpid(), name);
+    std::ofstream os{path, std::ios::binary};
+    zstd::Compressor c{os};
+    c.set_adaptive({.min_level = 1, .max_level = 1, .frame_size = frame_size});
+    c.write(text.data(), text.size());
+    c.close();
+    return path.string();
+}
+
+static std::vector<std::string> split(const std::string& text) {
+    std::vector<std::string> lines;
+    std::stringstream ss{text};
+    std::string line;
+    while (std::getline(ss, line))
+	lines.push_back(line);
+    return lines;
+}
+
+static void check_lines(const zstd::FrameFile& file, const LineIndex& index,
+			const std::vector<std::string>& expected) {
+    ASSERT_EQ(index.lines(), expected.size());
+    zstd::LineReader reader{file, index};
+    std::string line;
+    for (size_t i = 0; i < 300; ++i) {
+	auto n = (i * 7919) % expected.size();
+	ASSERT_TRUE(reader.seek_line(n));
+	ASSERT_TRUE(reader.read_line(line));
+	EXPECT_EQ(line, expected[n]);
+	EXPECT_EQ(reader.line(), n + 1);
+    }
+
+    auto lines = reader.read_lines(expected.size() - 5, 10);
+    EXPECT_EQ(lines, std::vector<std::string>(expected.end() - 5, expected.end()));
+    EXPECT_FALSE(reader.read_line(line));
+    EXPECT_FALSE(reader.seek_line(expected.size()));
+    EXPECT_TRUE(reader.read_lines(expected.size(), 1).empty());
+
+    // Reading every line from the start.
+    reader.seek_line(0);
+    size_t n{0};
+    while (reader.read_line(line))
+	EXPECT_EQ(line, expected[n++]);
+    EXPECT_EQ(n, expected.size());
+}
+
+TEST(LineIndex, Build)
+{
+    auto text = core::codec::corpus::log_text(200000);
+    auto path = write_file("build", text, 4096);
+    zstd::FrameFile file{path};
+    auto index = LineIndex::build(file);
+    EXPECT_EQ(index.size(), text.size());
+    EXPECT_GT(index.checkpoints().size(), 40u);
+    EXPECT_TRUE(index.matches(file));
+    check_lines(file, index, split(text));
+
+    // A last line without a newline.
+    auto partial = text + "last line";
+    auto other = write_file("partial", partial, 4096);
+    zstd::FrameFile pfile{other};
+    check_lines(pfile, LineIndex::build(pfile, 1), split(partial));
+    fs::remove(path);
+    fs::remove(other);
+}
+
+TEST(LineIndex, Storage)
+{
+    auto text = core::codec::corpus::log_text(100000);
+    auto path = write_file("storage", text, 8192);
+    auto index = LineIndex::build(zstd::FrameFile{path});
+
+    auto parsed = LineIndex::parse("prefix" + index.serialize());
+    ASSERT_TRUE(parsed);
+    EXPECT_EQ(parsed->lines(), index.lines());
+    EXPECT_EQ(parsed->checkpoints().size(), index.checkpoints().size());
+    EXPECT_FALSE(LineIndex::parse("not an index"));
+
+    // A sidecar file, ignored once it no longer matches the file.
+    auto sidecar = LineIndex::sidecar(path);
+    index.save(sidecar);
+    {
+	zstd::FrameFile file{path};
+	EXPECT_FALSE(LineIndex::read_trailer(path));
+	EXPECT_TRUE(LineIndex::load(sidecar)->matches(file));
+	check_lines(file, LineIndex::open(file), split(text));
+    }
+    auto stale = write_file("stale", text.substr(0, 50000), 8192);
+    zstd::FrameFile stale_file{stale};
+    fs::copy_file(sidecar, LineIndex::sidecar(stale));
+    EXPECT_FALSE(LineIndex::load(LineIndex::sidecar(stale))->matches(stale_file));
+    EXPECT_EQ(LineIndex::open(stale_file).lines(), split(text.substr(0, 50000)).size());
+
+    // A trailing skippable frame, skipped by the decompressors.
+    fs::remove(sidecar);
+    index.append_to(path);
+    zstd::FrameFile file{path};
+    auto trailer = LineIndex::read_trailer(path);
+    ASSERT_TRUE(trailer);
+    EXPECT_TRUE(trailer->matches(file));
+    check_lines(file, LineIndex::open(file), split(text));
+    std::ifstream is{path, std::ios::binary};
+    std::string bytes{std::istreambuf_iterator<char>{is}, std::istreambuf_iterator<char>{}};
+    EXPECT_EQ(zstd::decompress(bytes), text);
+
+    // A stored index supplies the frame sizes, so the file is opened
+    // without decompressing any frame, where otherwise every frame is.
+    core::codec::BlockCache cache;
+    auto stored = LineIndex::stored(path);
+    ASSERT_TRUE(stored);
+    zstd::FrameFile indexed{path, stored->layout(), cache};
+    EXPECT_EQ(indexed.size(), text.size());
+    auto indexed_index = LineIndex::open(indexed);
+    EXPECT_EQ(cache.stats().misses, 0u);
+    check_lines(indexed, indexed_index, split(text));
+
+    core::codec::BlockCache other;
+    zstd::FrameFile unindexed{path, other};
+    EXPECT_EQ(other.stats().misses, unindexed.frames());
+
+    // The layout of another file is ignored.
+    zstd::FrameFile mismatched{stale, stored->layout(), other};
+    EXPECT_EQ(mismatched.size(), 50000u);
+
+    fs::remove(path);
+    fs::remove(stale);
+    fs::remove(LineIndex::sidecar(stale));
+}
+
+TEST(LineIndex, Append)
+{
+    // Frames appended to a file after its index was saved are read
+    // through a new index, the layout of the saved one being ignored.
+    auto text = core::codec::corpus::log_text(100000);
+    auto path = write_file("append", text, 8192);
+    auto sidecar = LineIndex::sidecar(path);
+    LineIndex::build(zstd::FrameFile{path}).save(sidecar);
+
+    auto more = core::codec::corpus::log_text(50000, 1);
+    {
+	std::ofstream os{path, std::ios::binary | std::ios::app};
+	zstd::Compressor c{os};
+	c.set_adaptive({.min_level = 1, .max_level = 1, .frame_size = 8192});
+	c.write(more.data(), more.size());
+	c.close();
+    }
+
+    auto stored = LineIndex::stored(path);
+    ASSERT_TRUE(stored);
+    zstd::FrameFile file{path, stored->layout()};
+    EXPECT_EQ(file.size(), text.size() + more.size());
+    auto index = LineIndex::open(file);
+    EXPECT_FALSE(stored->matches(file));
+    check_lines(file, index, split(text + more));
+
+    fs::remove(path);
+    fs::remove(sidecar);
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,149 @@
+// Copyright 2022 by Mark Melton
+//
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include "core/codec/shuffle.h"
+#include "core/codec/shuffle/kernels.h"
+#include "core/codec/corpus/corpus.h"
+#include "core/codec/zstd/compress.h"
+#include "core/codec/zstd/decompress.h"
+#include "core/codec/zstd/decompress_to.h"
+
+namespace corpus = core::codec::corpus;
+using shuffle::Delta;
+using shuffle::Shuffle;
+
+TEST(Shuffle, Planes)
+{
+    // The bytes and bits of each significance are gathered.
+    std::string in{"\x01\x02\x03\x04\x05\x06\x07\x08", 8};
+    std::string out(8, '\0');
+    shuffle::encode(in.data(), in.size(), out.data(), 2, {Shuffle::Byte});
+    EXPECT_EQ(out, std::string("\x01\x03\x05\x07\x02\x04\x06\x08", 8));
+
+    in = std::string(8, '\x80');
+    in[3] = '\x81';
+    shuffle::encode(in.data(), in.size(), out.data(), 1, {Shuffle::Bit});
+    EXPECT_EQ(out, std::string("\x08\0\0\0\0\0\0\xff", 8));
+
+    std::vector<uint32_t> series{100, 101, 103, 99};
+    shuffle::encode((const char*)series.data(), 16, out.data(), 4, {Shuffle::None, Delta::Sub});
+    std::vector<uint32_t> deltas(4);
+    memcpy(deltas.data(), out.data(), 16);
+    EXPECT_EQ(deltas, (std::vector<uint32_t>{100, 1, 2, uint32_t(-4)}));
+}
+
+TEST(Shuffle, RoundTrip)
+{
+    for (auto typesize : {1ul, 2ul, 3ul, 4ul, 8ul, 16ul}) {
+	for (auto n : {0ul, 1ul, 7ul, 64ul, 1000ul, 4099ul, 100000ul}) {
+	    auto in = corpus::random_bytes(n, n + typesize);
+	    for (auto s : {Shuffle::None, Shuffle::Byte, Shuffle::Bit}) {
+		for (auto d : {Delta::None, Delta::Sub, Delta::Xor}) {
+		    for (auto block : {256ul, 65536ul}) {
+			shuffle::Options options{s, d, block};
+			std::string encoded(n, '\0'), decoded(n, '\0');
+			shuffle::encode(in.data(), n, encoded.data(), typesize, options);
+			shuffle::decode(encoded.data(), n, decoded.data(), typesize, options);
+			EXPECT_EQ(decoded, in) << typesize << " " << n << " " << int(s) << " " << int(d);
+
+			// In place.
+			auto str = in;
+			shuffle::encode(str.data(), n, str.data(), typesize, options);
+			EXPECT_EQ(str, encoded);
+			shuffle::decode(str.data(), n, str.data(), typesize, options);
+			EXPECT_EQ(str, in);
+		    }
+		}
+	    }
+	}
+    }
+}
+
+TEST(Shuffle, Kernels)
+{
+    EXPECT_TRUE(shuffle::supported(shuffle::Isa::Scalar));
+    EXPECT_EQ(shuffle::kernels().isa, shuffle::best_isa());
+    const auto& scalar = shuffle::kernels(shuffle::Isa::Scalar);
+
+    for (auto typesize : {2ul, 4ul, 8ul}) {
+	for (auto n : {0ul, 8ul, 32ul, 40ul, 96ul, 1000ul}) {
+	    auto in = corpus::random_bytes(n * typesize, n);
+	    std::string expected(in.size(), '\0'), bits(in.size(), '\0');
+	    scalar.shuffle(in.data(), n, expected.data(), typesize);
+	    scalar.bit_transpose(in.data(), in.size() / 8 * 8, bits.data());
+
+	    for (auto isa : shuffle::Isas) {
+		if (not shuffle::supported(isa))
+		    continue;
+		const auto& k = shuffle::kernels(isa);
+		std::string out(in.size(), '\0'), back(in.size(), '\0');
+		k.shuffle(in.data(), n, out.data(), typesize);
+		EXPECT_EQ(out, expected) << shuffle::name(isa);
+		k.unshuffle(out.data(), n, back.data(), typesize);
+		EXPECT_EQ(back, in) << shuffle::name(isa);
+
+		auto m = in.size() / 8 * 8;
+		k.bit_transpose(in.data(), m, out.data());
+		EXPECT_EQ(out.substr(0, m), bits.substr(0, m)) << shuffle::name(isa);
+		k.bit_untranspose(out.data(), m, back.data());
+		EXPECT_EQ(back.substr(0, m), in.substr(0, m)) << shuffle::name(isa);
+	    }
+	}
+    }
+}
+
+TEST(Shuffle, Header)
+{
+    std::string buffer(shuffle::HeaderSize, '\0');
+    shuffle::write_header({8, {Shuffle::Bit, Delta::Xor, 1000}}, buffer.data());
+    auto header = shuffle::read_header(buffer);
+    ASSERT_TRUE(header);
+    EXPECT_EQ(header->typesize, 8u);
+    EXPECT_EQ(header->options.shuffle, Shuffle::Bit);
+    EXPECT_EQ(header->options.delta, Delta::Xor);
+    EXPECT_EQ(header->options.block, 960u);
+
+    EXPECT_FALSE(shuffle::read_header(buffer.substr(0, shuffle::HeaderSize - 1)));
+    EXPECT_FALSE(shuffle::read_header(zstd::compress(std::string_view{"abc"})));
+    buffer[14] = 7;
+    EXPECT_FALSE(shuffle::read_header(buffer));
+    EXPECT_THROW(shuffle::write_header({256, {}}, buffer.data()), std::runtime_error);
+}
+
+TEST(Shuffle, Zstd)
+{
+    auto stamps = corpus::timestamps(100000);
+    auto floats = corpus::floats(100000);
+    auto options = shuffle::Options::time_series();
+
+    auto plain = zstd::compress(stamps);
+    auto filtered = zstd::compress(stamps, options);
+    EXPECT_LT(filtered.size(), plain.size());
+    EXPECT_EQ(zstd::decompress_as<int64_t>(filtered), stamps);
+    EXPECT_EQ(zstd::decompress_as<int64_t>(plain), stamps);
+    EXPECT_EQ(zstd::decompress(filtered).size(), stamps.size() * sizeof(int64_t));
+    EXPECT_THROW(zstd::decompress_as<int32_t>(filtered), std::runtime_error);
+
+    for (auto s : {Shuffle::Byte, Shuffle::Bit}) {
+	auto compressed = zstd::compress(floats, {s, Delta::Xor});
+	EXPECT_EQ(zstd::decompress_as<double>(compressed), floats);
+
+	std::stringstream ss{compressed};
+	std::vector<double> vec;
+	zstd::decompress_to(ss, vec);
+	EXPECT_EQ(vec, floats);
+    }
+
+    std::stringstream ss{plain};
+    std::vector<int64_t> vec;
+    zstd::decompress_to(ss, vec);
+    EXPECT_EQ(vec, stamps);
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
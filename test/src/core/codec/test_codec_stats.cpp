@@ -0,0 +1,144 @@
+// Copyright 2022 by Mark Melton
+//
+
+#include <gtest/gtest.h>
+#include <map>
+#include <sstream>
+#include "core/codec/util/stats.h"
+#include "core/codec/bzip/compressor.h"
+#include "core/codec/bzip/decompressor.h"
+#include "core/codec/zstd/compressor.h"
+#include "core/codec/zstd/decompressor.h"
+#include "core/cc/scoped_task.h"
+#include "core/cc/queue/lockfree_spsc.h"
+#include "core/codec/corpus/corpus.h"
+
+namespace corpus = core::codec::corpus;
+
+static const size_t InputSize = 1 << 18;
+
+TEST(Stats, Visit)
+{
+    core::codec::Stats stats;
+    stats.bytes_in = 1;
+    stats.peak_memory = 2;
+    stats.frames = 3;
+
+    std::map<std::string, uint64_t> fields;
+    stats.visit([&](const char *name, uint64_t value) { fields[name] = value; });
+    EXPECT_EQ(fields.size(), 12u);
+    EXPECT_EQ(fields["bytes_in"], 1u);
+    EXPECT_EQ(fields["peak_memory"], 2u);
+    EXPECT_EQ(fields["frames"], 3u);
+}
+
+TEST(Stats, Accumulate)
+{
+    core::codec::Stats a, b;
+    a.bytes_in = 10;
+    a.peak_memory = 100;
+    b.bytes_in = 5;
+    b.peak_memory = 200;
+    a += b;
+    EXPECT_EQ(a.bytes_in, 15u);
+    EXPECT_EQ(a.peak_memory, 200u);
+}
+
+#ifdef CODEC_STATS
+
+TEST(Stats, Zstd)
+{
+    auto str = corpus::log_text(InputSize);
+    std::stringstream ss;
+    zstd::Compressor c{ss};
+    c.write(str.data(), str.size());
+    EXPECT_EQ(c.stats().frame_bytes, str.size());
+    c.close();
+
+    auto& cs = c.stats();
+    EXPECT_EQ(cs.bytes_in, str.size());
+    EXPECT_EQ(cs.bytes_out, ss.str().size());
+    EXPECT_EQ(cs.bytes_out, c.count());
+    EXPECT_GT(cs.codec_calls, 0u);
+    EXPECT_GT(cs.codec_ns, 0u);
+    EXPECT_EQ(cs.stall_ns, 0u);
+    EXPECT_GT(cs.peak_memory, ZSTD_CStreamOutSize());
+    EXPECT_EQ(cs.frames, 1u);
+    EXPECT_EQ(cs.frame_bytes, 0u);
+
+    auto zsize = ss.str().size();
+    zstd::Decompressor d{ss};
+    std::string ustr;
+    while (d.underflow())
+	ustr += d.view();
+    EXPECT_EQ(ustr, str);
+
+    auto& ds = d.stats();
+    EXPECT_EQ(ds.bytes_in, zsize);
+    EXPECT_EQ(ds.bytes_out, str.size());
+    EXPECT_GT(ds.codec_calls, 0u);
+    EXPECT_GT(ds.source_ns, 0u);
+    EXPECT_GT(ds.peak_memory, ZSTD_DStreamOutSize());
+    EXPECT_EQ(ds.frames, 1u);
+}
+
+TEST(Stats, Bzip)
+{
+    auto str = corpus::log_text(InputSize);
+    std::stringstream ss;
+    bzip::Compressor c{ss};
+    c.write(str.data(), str.size());
+    c.close();
+
+    auto& cs = c.stats();
+    EXPECT_EQ(cs.bytes_in, str.size());
+    EXPECT_EQ(cs.bytes_out, ss.str().size());
+    EXPECT_GT(cs.codec_calls, 0u);
+    EXPECT_GT(cs.peak_memory, 0u);
+    EXPECT_EQ(cs.frames, 1u);
+
+    auto zsize = ss.str().size();
+    bzip::Decompressor d{ss};
+    std::string ustr;
+    while (d.underflow())
+	ustr += d.view();
+    EXPECT_EQ(ustr, str);
+
+    auto& ds = d.stats();
+    EXPECT_EQ(ds.bytes_in, zsize);
+    EXPECT_EQ(ds.bytes_out, str.size());
+    EXPECT_EQ(ds.frames, 1u);
+}
+
+TEST(Stats, QueueStall)
+{
+    auto str = corpus::log_text(InputSize);
+    core::cc::queue::LockFreeSpSc<char> connector;
+
+    core::codec::Stats cs, ds;
+    auto task1 = core::cc::scoped_task([&]() {
+	zstd::Compressor c{connector};
+	c.write(str.data(), str.size());
+	c.close();
+	cs = c.stats();
+    });
+    auto task2 = core::cc::scoped_task([&]() {
+	zstd::Decompressor d{connector};
+	while (d.underflow());
+	ds = d.stats();
+    });
+    task1.wait();
+    task2.wait();
+
+    EXPECT_EQ(ds.bytes_out, str.size());
+    EXPECT_EQ(cs.stall_ns, cs.sink_ns);
+    EXPECT_EQ(ds.stall_ns, ds.source_ns);
+}
+
+#endif
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
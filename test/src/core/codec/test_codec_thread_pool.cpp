@@ -0,0 +1,126 @@
+// Copyright 2022 by Mark Melton
+//
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <numeric>
+#include <set>
+#include <thread>
+#include "core/codec/util/parallel.h"
+#include "core/codec/util/thread_pool.h"
+
+using core::codec::ThreadPool;
+using core::codec::TaskGroup;
+
+TEST(ThreadPool, Submit)
+{
+    ThreadPool pool{3};
+    EXPECT_EQ(pool.size(), 3u);
+
+    std::vector<std::future<size_t>> futures;
+    for (size_t i = 0; i < 100; ++i)
+	futures.push_back(pool.async([i]() { return i * i; }));
+    for (size_t i = 0; i < futures.size(); ++i)
+	EXPECT_EQ(futures[i].get(), i * i);
+
+    auto failed = pool.async([]() -> int { throw std::runtime_error("task"); });
+    EXPECT_THROW(failed.get(), std::runtime_error);
+}
+
+TEST(ThreadPool, Resize)
+{
+    ThreadPool pool{1};
+    std::atomic<size_t> count{0};
+    for (size_t i = 0; i < 10; ++i)
+	pool.submit([&]() { ++count; });
+
+    pool.resize(4);
+    EXPECT_EQ(pool.size(), 4u);
+    for (size_t i = 0; i < 10; ++i)
+	pool.submit([&]() { ++count; });
+
+    // Shrinking to no workers runs any task left on the caller, and
+    // later tasks run inline.
+    pool.resize(0);
+    EXPECT_EQ(count, 20u);
+    auto id = pool.async([]() { return std::this_thread::get_id(); }).get();
+    EXPECT_EQ(id, std::this_thread::get_id());
+}
+
+TEST(ThreadPool, Reuse)
+{
+    // The workers run many calls, no thread is created per call.
+    ThreadPool pool{2};
+    std::mutex mutex;
+    std::set<std::thread::id> ids;
+    for (size_t i = 0; i < 200; ++i)
+	pool.async([&]() {
+	    std::lock_guard lock(mutex);
+	    ids.insert(std::this_thread::get_id());
+	}).get();
+    EXPECT_LE(ids.size(), 2u);
+}
+
+TEST(TaskGroup, Close)
+{
+    // A group closed before its tasks start drops them, so it does
+    // not wait for a busy pool.
+    ThreadPool pool{1};
+    std::promise<void> release;
+    auto blocker = pool.async([future = release.get_future().share()]() { future.wait(); });
+
+    std::atomic<size_t> count{0};
+    {
+	TaskGroup group{pool};
+	for (size_t i = 0; i < 4; ++i)
+	    group.run([&]() { ++count; });
+	EXPECT_EQ(group.size(), 4u);
+	group.close();
+	group.run([&]() { ++count; });
+	EXPECT_EQ(group.size(), 4u);
+    }
+    release.set_value();
+    blocker.get();
+    EXPECT_EQ(count, 0u);
+
+    TaskGroup group{pool};
+    group.run([]() { throw std::runtime_error("task"); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_THROW(group.close(), std::runtime_error);
+
+    // Without workers, the tasks are not run.
+    ThreadPool empty{0};
+    TaskGroup none{empty};
+    none.run([&]() { ++count; });
+    none.close();
+    EXPECT_EQ(none.size(), 0u);
+    EXPECT_EQ(count, 0u);
+}
+
+TEST(ThreadPool, ParallelFor)
+{
+    for (auto threads : { 0, 1, 2, 8 }) {
+	std::vector<size_t> out(1000);
+	core::codec::parallel_for(out.size(), threads, [&](size_t i) { out[i] = i + 1; });
+	EXPECT_EQ(std::accumulate(out.begin(), out.end(), size_t{0}), 1000u * 1001 / 2);
+    }
+
+    // Nested loops complete even though the inner loops find the pool
+    // busy with the outer one.
+    std::atomic<size_t> count{0};
+    core::codec::parallel_for(16, 8, [&](size_t) {
+	core::codec::parallel_for(16, 8, [&](size_t) { ++count; });
+    });
+    EXPECT_EQ(count, 256u);
+
+    EXPECT_THROW(core::codec::parallel_for(10, 4, [](size_t i) {
+	if (i == 7)
+	    throw std::runtime_error("index");
+    }), std::runtime_error);
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,136 @@
+// Copyright 2022 by Mark Melton
+//
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include "core/codec/z85.h"
+#include "core/codec/z85/decoder.h"
+#include "core/codec/z85/encoder.h"
+#include "core/codec/z85/kernels.h"
+#include "core/codec/corpus/corpus.h"
+#include "coro/stream/stream.h"
+
+namespace corpus = core::codec::corpus;
+
+static const size_t NumberSamples = 64;
+
+TEST(Z85, Vectors)
+{
+    // ZeroMQ RFC 32.
+    std::string hello{"\x86\x4f\xd2\x6f\xb5\x59\xf7\x5b"};
+    EXPECT_EQ(z85_encode(hello), "HelloWorld");
+    EXPECT_EQ(z85_decode("HelloWorld"), hello);
+    EXPECT_EQ(z85_encode(std::string(4, '\0')), "00000");
+    EXPECT_EQ(z85_encode(std::string(4, '\xff')), "%nSc0");
+    EXPECT_EQ(z85_decode("%nSc0"), std::string(4, '\xff'));
+
+    // Short final quanta.
+    for (size_t n = 0; n < 12; ++n) {
+	auto str = hello.substr(0, n % 9);
+	auto encoded = z85_encode(str);
+	EXPECT_EQ(encoded.size(), z85::encoded_length(str.size()));
+	EXPECT_EQ(z85_decode(encoded), str);
+    }
+}
+
+TEST(Z85, Into)
+{
+    using z85::Status;
+    for (auto size : {0ul, 1ul, 2ul, 3ul, 4ul, 99ul, 5000ul}) {
+	auto str = corpus::random_bytes(size, size);
+	auto length = z85::encoded_length(size);
+	std::string encoded(length, '\0');
+	EXPECT_EQ(z85::encode_into(str, encoded).count, length);
+	EXPECT_EQ(z85::decoded_length(encoded), size);
+	EXPECT_EQ(z85::validate(encoded).count, size);
+	if (size > 0) {
+	    std::string small(size - 1, '\0');
+	    EXPECT_EQ(z85::decode_into(encoded, small).status, Status::OutputTooSmall);
+	    EXPECT_EQ(z85::encode_into(str, {encoded.data(), length - 1}).status, Status::OutputTooSmall);
+	}
+    }
+
+    EXPECT_EQ(z85::validate("Hello0").status, Status::InvalidLength);
+    EXPECT_THROW(z85_decode("Hello0"), std::runtime_error);
+
+    // Values that do not fit in 32 bits.
+    EXPECT_EQ(z85::validate("%nSc1").status, Status::InvalidCharacter);
+    EXPECT_EQ(z85::validate("#####").status, Status::InvalidCharacter);
+
+    auto encoded = z85_encode(corpus::random_bytes(1000));
+    for (auto c : {'"', '\'', ',', ';', '\\', '_', '`', '|', '~', ' ', '\0', '\x80'}) {
+	for (auto pos : {0ul, 17ul, 500ul, encoded.size() - 1}) {
+	    auto bad = encoded;
+	    bad[pos] = c;
+	    auto r = z85::validate(bad);
+	    EXPECT_EQ(r.status, Status::InvalidCharacter);
+	    EXPECT_EQ(r.count, pos / 5 * 4);
+	    EXPECT_THROW(z85_decode(bad), std::runtime_error);
+	}
+    }
+}
+
+TEST(Z85, Kernels)
+{
+    EXPECT_TRUE(z85::supported(z85::Isa::Scalar));
+    EXPECT_EQ(z85::kernels().isa, z85::best_isa());
+    const auto& scalar = z85::kernels(z85::Isa::Scalar);
+
+    for (size_t n = 0; n < 600; n += 4) {
+	auto str = n % 3 ? corpus::random_bytes(n, n) : std::string(n, '\xff');
+	auto in = reinterpret_cast<const unsigned char*>(str.data());
+	std::string expected(n / 4 * 5, '\0');
+	scalar.encode(in, n, expected.data());
+	EXPECT_EQ(expected, z85_encode(str));
+
+	for (auto isa : z85::Isas) {
+	    if (not z85::supported(isa))
+		continue;
+	    const auto& k = z85::kernels(isa);
+	    std::string encoded(n / 4 * 5, '\0');
+	    k.encode(in, n, encoded.data());
+	    EXPECT_EQ(encoded, expected) << z85::name(isa);
+
+	    std::string decoded(n, '\0');
+	    auto out = reinterpret_cast<unsigned char*>(decoded.data());
+	    EXPECT_EQ(k.decode(encoded.data(), encoded.size(), out), encoded.size());
+	    EXPECT_EQ(decoded, str) << z85::name(isa);
+
+	    // An invalid character and a value that overflows.
+	    if (encoded.size() > 0) {
+		auto pos = (n * 7) % encoded.size();
+		auto bad = encoded;
+		bad[pos] = '~';
+		EXPECT_EQ(k.decode(bad.data(), bad.size(), out), pos / 5 * 5) << z85::name(isa);
+		bad = encoded;
+		bad[pos / 5 * 5] = '#';
+		EXPECT_EQ(k.decode(bad.data(), bad.size(), out), pos / 5 * 5) << z85::name(isa);
+	    }
+	}
+    }
+}
+
+TEST(Z85, Stream)
+{
+    for (auto str : coro::str::any(0, 1024) | coro::take(NumberSamples)) {
+	std::stringstream ss;
+	z85::Encoder e{ss, {}, 11};
+	for (size_t i = 0; i < str.size(); i += 3)
+	    e.write(str.data() + i, std::min<size_t>(3, str.size() - i));
+	e.close();
+	EXPECT_EQ(ss.str(), z85_encode(str));
+
+	std::stringstream in{ss.str()};
+	z85::Decoder d{in, {}, 7};
+	std::string decoded(str.size() + 1, '\0');
+	EXPECT_EQ(d.read_bytes(decoded.data(), decoded.size()), str.size());
+	decoded.resize(str.size());
+	EXPECT_EQ(decoded, str);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -3,6 +3,7 @@
 
 #include <filesystem>
 #include <gtest/gtest.h>
+#include <thread>
 #include "core/codec/zstd/compress.h"
 #include "core/codec/zstd/compressor.h"
 #include "core/codec/zstd/decompress.h"
@@ -15,6 +16,7 @@
 #include "core/cc/queue/lockfree_spsc.h"
 #include "core/cc/queue/sink_spsc.h"
 #include "core/cc/queue/source_spsc.h"
+#include "core/codec/corpus/corpus.h"
 #include "coro/stream/stream.h"
 
 static const size_t NumberSamples = 32;
@@ -193,6 +195,80 @@ TEST(Zstd, FileDecompressor)
     }
 }
 
+// A string buffer that sleeps on every write to emulate a slow sink.
+class SlowBuf : public std::stringbuf {
+protected:
+    std::streamsize xsputn(const char *s, std::streamsize n) override {
+	std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	return std::stringbuf::xsputn(s, n);
+    }
+};
+
+size_t count_frames(std::string_view zstr) {
+    size_t frames{0};
+    while (zstr.size() > 0) {
+	auto n = ZSTD_findFrameCompressedSize(zstr.data(), zstr.size());
+	EXPECT_FALSE(ZSTD_isError(n));
+	if (ZSTD_isError(n))
+	    break;
+	zstr.remove_prefix(n);
+	++frames;
+    }
+    return frames;
+}
+
+TEST(Zstd, AdaptiveSlowSink)
+{
+    auto str = core::codec::corpus::log_text(1 << 20);
+    SlowBuf buf;
+    std::ostream os{&buf};
+    zstd::Compressor c{os};
+    c.set_adaptive({.min_level = 1, .max_level = 6, .frame_size = 1 << 16});
+    c.write(str.data(), str.size());
+    EXPECT_EQ(c.adapter()->level(), 6);
+    EXPECT_GT(c.adapter()->history().size(), 1u);
+    EXPECT_EQ(c.adapter()->history().back().level, 6);
+    c.close();
+
+    auto zstr = buf.str();
+    EXPECT_EQ(count_frames(zstr), 16u);
+    EXPECT_EQ(zstd::decompress(zstr), str);
+}
+
+TEST(Zstd, AdaptiveFastSink)
+{
+    auto str = core::codec::corpus::log_text(1 << 20);
+    std::stringstream ss;
+    zstd::Compressor c{ss};
+    c.set_level(5);
+    c.set_adaptive({.min_level = 1, .max_level = 9, .frame_size = 1 << 16});
+    EXPECT_EQ(c.adapter()->level(), 5);
+    for (size_t i = 0; i < str.size(); i += 1000)
+	c.write(str.data() + i, std::min<size_t>(1000, str.size() - i));
+    EXPECT_EQ(c.adapter()->level(), 1);
+    c.close();
+
+    auto& history = c.adapter()->history();
+    for (size_t i = 1; i < history.size(); ++i) {
+	EXPECT_EQ(history[i].level, history[i - 1].level - 1);
+	EXPECT_GT(history[i].frame, history[i - 1].frame);
+    }
+    EXPECT_EQ(zstd::decompress(ss.str()), str);
+}
+
+TEST(Zstd, AdaptivePartialFrame)
+{
+    auto str = core::codec::corpus::log_text(100000);
+    std::stringstream ss;
+    zstd::Compressor c{ss};
+    c.set_adaptive({.frame_size = 30000});
+    c.write(str.data(), str.size());
+    c.close();
+    EXPECT_EQ(count_frames(ss.str()), 4u);
+    EXPECT_EQ(zstd::decompress(ss.str()), str);
+    EXPECT_THROW(c.set_adaptive(), zstd::error);
+}
+
 int main(int argc, char *argv[])
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,214 @@
+// Copyright 2022 by Mark Melton
+//
+
+#include <gtest/gtest.h>
+#include <deque>
+#include <sstream>
+#include "core/codec/corpus/corpus.h"
+#include "core/codec/zstd/async.h"
+#include "core/codec/zstd/compress.h"
+#include "core/codec/zstd/decompress.h"
+
+using core::codec::Task;
+using core::codec::sync_wait;
+namespace corpus = core::codec::corpus;
+
+// A single-threaded event loop resuming the coroutines suspended by
+// the asynchronous sources and sinks in turn.
+class Loop {
+public:
+    struct Yield {
+	Loop& loop;
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(std::coroutine_handle<> h) { loop.ready_.push_back(h); }
+	void await_resume() const noexcept { }
+    };
+
+    Yield yield() { return {*this}; }
+
+    // Resume the suspended coroutines until none is left, returning the
+    // largest number suspended at once.
+    size_t run() {
+	size_t most{0};
+	while (not ready_.empty()) {
+	    most = std::max(most, ready_.size());
+	    auto h = ready_.front();
+	    ready_.pop_front();
+	    h.resume();
+	}
+	return most;
+    }
+
+private:
+    std::deque<std::coroutine_handle<>> ready_;
+};
+
+// Start a coroutine eagerly, running to its first suspension.
+struct Spawn {
+    struct promise_type {
+	Spawn get_return_object() { return {}; }
+	std::suspend_never initial_suspend() noexcept { return {}; }
+	std::suspend_never final_suspend() noexcept { return {}; }
+	void return_void() { }
+	void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// A source of a string suspending on every read and reading at most
+// `step` bytes at a time, e.g. as a socket.
+class AsyncStringSource {
+public:
+    AsyncStringSource(Loop& loop, std::string_view data, size_t step)
+	: loop_(loop), data_(data), step_(step) { }
+
+    Task<size_t> async_read(char *ptr, size_t count) {
+	size_t n{0};
+	while (n < count and pos_ < data_.size()) {
+	    co_await loop_.yield();
+	    auto k = std::min({count - n, step_, data_.size() - pos_});
+	    memcpy(ptr + n, data_.data() + pos_, k);
+	    pos_ += k;
+	    n += k;
+	}
+	co_return n;
+    }
+
+private:
+    Loop& loop_;
+    std::string_view data_;
+    size_t step_, pos_{0};
+};
+
+// A sink appending to a string suspending on every write.
+class AsyncStringSink {
+public:
+    AsyncStringSink(Loop& loop) : loop_(loop) { }
+
+    Task<> async_write(const char *ptr, size_t count) {
+	co_await loop_.yield();
+	data.append(ptr, count);
+    }
+
+    Task<> async_close() {
+	co_await loop_.yield();
+	closed = true;
+    }
+
+    std::string data;
+    bool closed{false};
+
+private:
+    Loop& loop_;
+};
+
+template<class D>
+Task<std::string> read_all(D& d) {
+    std::string out;
+    while (co_await d.async_underflow())
+	out += d.view();
+    co_return out;
+}
+
+TEST(ZstdAsync, SyncStreams)
+{
+    auto str = corpus::log_text(1 << 20);
+
+    // Synchronous sources and sinks complete each step immediately.
+    std::stringstream ss;
+    zstd::AsyncCompressor c{ss};
+    for (size_t i = 0; i < str.size(); i += 10000)
+	sync_wait(c.async_write(str.data() + i, std::min<size_t>(10000, str.size() - i)));
+    sync_wait(c.async_close());
+    EXPECT_EQ(zstd::decompress(ss.str()), str);
+    EXPECT_EQ(c.count(), ss.str().size());
+
+    std::stringstream zs{zstd::compress(str)};
+    zstd::AsyncDecompressor d{zs};
+    EXPECT_EQ(sync_wait(read_all(d)), str);
+    EXPECT_FALSE(d.decompressor().is_open());
+    EXPECT_THROW(sync_wait(d.async_underflow()), zstd::error);
+
+    std::stringstream ls{zstd::compress(std::string_view{"one\n\nthree"})};
+    zstd::AsyncDecompressor lines{ls};
+    std::string line;
+    EXPECT_TRUE(sync_wait(lines.async_read_line(line)));
+    EXPECT_EQ(line, "one");
+    EXPECT_TRUE(sync_wait(lines.async_read_line(line)));
+    EXPECT_EQ(line, "");
+    EXPECT_TRUE(sync_wait(lines.async_read_line(line)));
+    EXPECT_EQ(line, "three");
+    EXPECT_FALSE(sync_wait(lines.async_read_line(line)));
+}
+
+TEST(ZstdAsync, Multiplexed)
+{
+    // Compress and decompress many streams concurrently on one thread,
+    // each suspending on every read and write.
+    constexpr size_t Streams = 200;
+    Loop loop;
+    std::vector<std::string> inputs, outputs(Streams);
+    std::vector<std::unique_ptr<AsyncStringSink>> sinks;
+    for (size_t i = 0; i < Streams; ++i) {
+	inputs.push_back(corpus::log_text(1000 + 97 * i, i));
+	sinks.push_back(std::make_unique<AsyncStringSink>(loop));
+    }
+
+    size_t finished{0};
+    auto stream = [&](size_t i) -> Spawn {
+	const auto& in = inputs[i];
+	{
+	    zstd::AsyncCompressor c{*sinks[i], 256};
+	    for (size_t j = 0; j < in.size(); j += 500)
+		co_await c.async_write(in.data() + j, std::min<size_t>(500, in.size() - j));
+	    co_await c.async_close();
+	}
+
+	AsyncStringSource source{loop, sinks[i]->data, 17};
+	zstd::AsyncDecompressor d{source, 256};
+	std::vector<char> buffer(333);
+	while (auto n = co_await d.async_read_bytes(buffer.data(), buffer.size()))
+	    outputs[i].append(buffer.data(), n);
+	++finished;
+    };
+    for (size_t i = 0; i < Streams; ++i)
+	stream(i);
+
+    EXPECT_EQ(finished, 0u);
+    EXPECT_EQ(loop.run(), Streams);
+    EXPECT_EQ(finished, Streams);
+    for (size_t i = 0; i < Streams; ++i) {
+	EXPECT_TRUE(sinks[i]->closed);
+	EXPECT_EQ(zstd::decompress(sinks[i]->data), inputs[i]);
+	EXPECT_EQ(outputs[i], inputs[i]);
+    }
+}
+
+TEST(ZstdAsync, Errors)
+{
+    Loop loop;
+    auto zstr = zstd::compress(corpus::log_text(10000));
+    zstr[0] ^= 0x5a;
+
+    bool caught{false};
+    auto run = [&]() -> Spawn {
+	AsyncStringSource source{loop, zstr, 64};
+	zstd::AsyncDecompressor d{source};
+	try {
+	    co_await read_all(d);
+	} catch (const zstd::error&) {
+	    caught = true;
+	}
+    };
+    run();
+    loop.run();
+    EXPECT_TRUE(caught);
+
+    zstd::Decompressor<zstd::NoSource> d{zstd::NoSource{}};
+    EXPECT_THROW(d.underflow(), zstd::error);
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
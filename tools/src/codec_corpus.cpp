@@ -0,0 +1,46 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include "core/codec/corpus/corpus.h"
+
+namespace corpus = core::codec::corpus;
+
+static int usage() {
+    std::cerr << "usage: codec-corpus <kind> <size> [seed]  write a corpus to stdout" << std::endl;
+    std::cerr << "       codec-corpus --checksums <size> [seed]  list the corpus checksums" << std::endl;
+    std::cerr << "kinds:";
+    for (auto kind : corpus::Kinds)
+	std::cerr << " " << corpus::name(kind);
+    std::cerr << std::endl;
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3 or argc > 4)
+	return usage();
+
+    try {
+	std::string what{argv[1]};
+	size_t size = std::stoull(argv[2]);
+	uint64_t seed = argc > 3 ? std::stoull(argv[3]) : 0;
+
+	if (what == "--checksums") {
+	    for (auto kind : corpus::Kinds)
+		printf("%-12s %zu %llu %016llx\n", std::string{corpus::name(kind)}.c_str(), size,
+		       (unsigned long long)seed,
+		       (unsigned long long)corpus::checksum(kind, size, seed));
+	    return 0;
+	}
+
+	auto data = corpus::generate(corpus::parse_kind(what), size, seed);
+	std::cout.write(data.data(), data.size());
+	return std::cout ? 0 : 1;
+    } catch (const std::exception& e) {
+	std::cerr << "codec-corpus: " << e.what() << std::endl;
+	return usage();
+    }
+}
@@ -0,0 +1,82 @@
+// Copyright (C) 2022 by Mark Melton
+//
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "core/codec/grep.h"
+
+static int usage() {
+    std::cerr << "usage: codec-grep [-F] [-n] [-b] [-c] [-m count] [-j threads] <pattern> <file>..."
+	      << std::endl;
+    std::cerr << "  -F  the pattern is a fixed string" << std::endl;
+    std::cerr << "  -n  print the line number of each match" << std::endl;
+    std::cerr << "  -b  print the (decompressed) offset of each match" << std::endl;
+    std::cerr << "  -c  print the number of matching lines only" << std::endl;
+    std::cerr << "  -m  stop after `count` matching lines per file" << std::endl;
+    std::cerr << "  -j  the number of threads (default: hardware threads)" << std::endl;
+    return 2;
+}
+
+int main(int argc, char *argv[])
+{
+    bool fixed{false}, numbers{false}, offsets{false}, count_only{false};
+    grep::Options options;
+
+    int i = 1;
+    try {
+	for (; i < argc and argv[i][0] == '-' and argv[i][1] != '\0'; ++i) {
+	    std::string arg{argv[i]};
+	    if (arg == "--") {
+		++i;
+		break;
+	    } else if (arg == "-F") fixed = true;
+	    else if (arg == "-n") numbers = true;
+	    else if (arg == "-b") offsets = true;
+	    else if (arg == "-c") count_only = true;
+	    else if (arg == "-m" and i + 1 < argc) options.max_count = std::stoull(argv[++i]);
+	    else if (arg == "-j" and i + 1 < argc) options.threads = std::stoull(argv[++i]);
+	    else return usage();
+	}
+    } catch (const std::exception&) {
+	return usage();
+    }
+    if (argc - i < 2)
+	return usage();
+
+    std::vector<std::string> files{argv + i + 1, argv + argc};
+    bool prefix = files.size() > 1, found{false}, failed{false};
+    try {
+	grep::Matcher matcher{argv[i], fixed};
+	for (const auto& path : files) {
+	    try {
+		auto n = grep::search_file(path, matcher, [&](const grep::Match& m) {
+		    if (count_only)
+			return;
+		    if (prefix)
+			std::cout << path << ':';
+		    if (numbers)
+			std::cout << m.line + 1 << ':';
+		    if (offsets)
+			std::cout << m.position << ':';
+		    std::cout << m.text << '\n';
+		}, options);
+		if (count_only) {
+		    if (prefix)
+			std::cout << path << ':';
+		    std::cout << n << '\n';
+		}
+		found = found or n > 0;
+	    } catch (const std::exception& e) {
+		std::cerr << "codec-grep: " << path << ": " << e.what() << std::endl;
+		failed = true;
+	    }
+	}
+    } catch (const std::exception& e) {
+	std::cerr << "codec-grep: " << e.what() << std::endl;
+	return 2;
+    }
+    std::cout.flush();
+    return failed ? 2 : (found ? 0 : 1);
+}